@@ -0,0 +1,102 @@
+/**
+ * @file chunk_reader.hpp
+ *
+ * Defines the ChunkReader class, which reads points from a dataset on disk
+ * without loading the whole dataset into memory.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_DATA_CHUNK_READER_HPP
+#define MLPACK_CORE_DATA_CHUNK_READER_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <fstream>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The ChunkReader class gives access to the points of a dataset that is stored
+ * in Armadillo's binary format (arma_binary), reading only the points that are
+ * asked for.  This lets streaming algorithms process datasets that do not fit
+ * in memory, one chunk of points at a time.
+ *
+ * The file must hold one point per column, as written by
+ * arma::Mat<eT>::save(filename, arma::arma_binary).  Note that data::Save()
+ * transposes the matrix by default, so pass transpose = false to it when
+ * writing a file for a ChunkReader.
+ *
+ * A ChunkReader is not thread-safe; only one thread should read from it at a
+ * time.
+ *
+ * @code
+ * data::ChunkReader<> reader("dataset.bin");
+ * arma::mat chunk;
+ * for (size_t begin = 0; begin < reader.NumPoints(); begin += 10000)
+ * {
+ *   reader.Read(begin, std::min((size_t) 10000, reader.NumPoints() - begin),
+ *       chunk);
+ *   // Process the chunk...
+ * }
+ * @endcode
+ *
+ * @tparam eT Type of the elements of the dataset (double or float).
+ */
+template<typename eT = double>
+class ChunkReader
+{
+ public:
+  static_assert(std::is_same<eT, double>::value ||
+      std::is_same<eT, float>::value, "ChunkReader: the element type must be "
+      "double or float.");
+
+  /**
+   * Open the given file and read its header.  An std::runtime_error is thrown
+   * if the file cannot be opened or is not an Armadillo binary file with
+   * elements of type eT.
+   *
+   * @param filename Name of the file to read from.
+   */
+  ChunkReader(const std::string& filename);
+
+  /**
+   * Read the points begin, ..., begin + count - 1 into the given matrix, which
+   * is resized to hold them.
+   *
+   * @param begin Index of the first point to read.
+   * @param count Number of points to read.
+   * @param chunk Matrix to store the points in.
+   */
+  void Read(const size_t begin, const size_t count, arma::Mat<eT>& chunk);
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get the number of points in the dataset.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the name of the file.
+  const std::string& Filename() const { return filename; }
+
+ private:
+  //! The name of the file.
+  std::string filename;
+  //! The stream to read from.
+  std::ifstream stream;
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points.
+  size_t numPoints;
+  //! The position of the first element in the file.
+  std::streamoff dataOffset;
+};
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "chunk_reader_impl.hpp"
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * @file chunk_reader_impl.hpp
+ *
+ * Implementation of the ChunkReader class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+#define MLPACK_CORE_DATA_CHUNK_READER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunk_reader.hpp"
+
+namespace mlpack {
+namespace data {
+
+template<typename eT>
+ChunkReader<eT>::ChunkReader(const std::string& filename) :
+    filename(filename),
+    stream(filename.c_str(), std::ios::in | std::ios::binary),
+    dimensionality(0),
+    numPoints(0),
+    dataOffset(0)
+{
+  if (!stream.is_open())
+  {
+    std::ostringstream oss;
+    oss << "ChunkReader::ChunkReader(): cannot open file '" << filename
+        << "'!";
+    throw std::runtime_error(oss.str());
+  }
+
+  // This is the header that Armadillo writes for matrices of this type.
+  const std::string expectedHeader = std::is_same<eT, double>::value ?
+      "ARMA_MAT_BIN_FN008" : "ARMA_MAT_BIN_FN004";
+
+  std::string header;
+  stream >> header >> dimensionality >> numPoints;
+  if (!stream.good() || header != expectedHeader)
+  {
+    std::ostringstream oss;
+    oss << "ChunkReader::ChunkReader(): '" << filename << "' is not an "
+        << "Armadillo binary file of " << (std::is_same<eT, double>::value ?
+        "doubles" : "floats") << "!";
+    throw std::runtime_error(oss.str());
+  }
+
+  // A single newline separates the header from the data.
+  stream.get();
+  dataOffset = stream.tellg();
+}
+
+template<typename eT>
+void ChunkReader<eT>::Read(const size_t begin,
+                           const size_t count,
+                           arma::Mat<eT>& chunk)
+{
+  if (begin + count > numPoints)
+  {
+    std::ostringstream oss;
+    oss << "ChunkReader::Read(): cannot read points " << begin << " to "
+        << (begin + count) << " of '" << filename << "', which has only "
+        << numPoints << " points!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  chunk.set_size(dimensionality, count);
+  if (count == 0)
+    return;
+
+  // The points are stored one after another, so the chunk is contiguous.
+  stream.clear();
+  stream.seekg(dataOffset + (std::streamoff) (begin * dimensionality *
+      sizeof(eT)));
+  stream.read(reinterpret_cast<char*>(chunk.memptr()),
+      count * dimensionality * sizeof(eT));
+  if (!stream.good())
+  {
+    std::ostringstream oss;
+    oss << "ChunkReader::Read(): error reading points " << begin << " to "
+        << (begin + count) << " of '" << filename << "'!";
+    throw std::runtime_error(oss.str());
+  }
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -41,6 +41,20 @@ class CosineDistance
   template<typename VecTypeA, typename VecTypeB>
   static double Evaluate(const VecTypeA& a, const VecTypeB& b);
 
+  /**
+   * Computes the cosine distance between each column of a and each column of b
+   * with one matrix multiplication, so that
+   * kernels(i, j) = d(a.col(i), b.col(j)).
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernels Matrix to store the cosine distances in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  static void EvaluateBlock(const MatTypeA& a,
+                            const MatTypeB& b,
+                            arma::mat& kernels);
+
   //! Serialize the class (there's nothing to save).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -56,6 +70,9 @@ class KernelTraits<CosineDistance>
 
   //! The cosine kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+
+  //! The cosine kernel is computed from the inner product and the norms.
+  static const bool UsesInnerProduct = true;
 };
 
 } // namespace kernel
@@ -32,6 +32,27 @@ double CosineDistance::Evaluate(const VecTypeA& a, const VecTypeB& b)
     return dot(a, b) / denominator;
 }
 
+template<typename MatTypeA, typename MatTypeB>
+void CosineDistance::EvaluateBlock(const MatTypeA& a,
+                                   const MatTypeB& b,
+                                   arma::mat& kernels)
+{
+  kernels = a.t() * b;
+
+  const arma::rowvec aNorms = arma::sqrt(arma::sum(arma::square(a), 0));
+  const arma::rowvec bNorms = arma::sqrt(arma::sum(arma::square(b), 0));
+  for (size_t j = 0; j < kernels.n_cols; ++j)
+  {
+    for (size_t i = 0; i < kernels.n_rows; ++i)
+    {
+      // As in Evaluate(), the cosine similarity with a zero vector is 0.
+      const double denominator = aNorms[i] * bNorms[j];
+      kernels(i, j) = (denominator == 0.0) ? 0.0 :
+          kernels(i, j) / denominator;
+    }
+  }
+}
+
 } // namespace kernel
 } // namespace mlpack
 
@@ -112,6 +112,8 @@ class KernelTraits<EpanechnikovKernel>
   static const bool IsNormalized = true;
   //! The Epanechnikov kernel includes a squared distance.
   static const bool UsesSquaredDistance = true;
+  //! The Epanechnikov kernel is not computed from an inner product.
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
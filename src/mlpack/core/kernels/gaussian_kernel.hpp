@@ -171,6 +171,8 @@ class KernelTraits<GaussianKernel>
   static const bool IsNormalized = true;
   //! The Gaussian kernel includes a squared distance.
   static const bool UsesSquaredDistance = true;
+  //! The Gaussian kernel is not computed from an inner product.
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
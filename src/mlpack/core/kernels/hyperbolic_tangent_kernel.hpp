@@ -13,6 +13,7 @@
 #define MLPACK_CORE_KERNELS_HYPERBOLIC_TANGENT_KERNEL_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/kernels/kernel_traits.hpp>
 
 namespace mlpack {
 namespace kernel {
@@ -62,6 +63,23 @@ class HyperbolicTangentKernel
     return tanh(scale * arma::dot(a, b) + offset);
   }
 
+  /**
+   * Evaluate the kernel between each column of a and each column of b with one
+   * matrix multiplication, so that kernels(i, j) = K(a.col(i), b.col(j)).
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernels Matrix to store the kernel values in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  void EvaluateBlock(const MatTypeA& a,
+                     const MatTypeB& b,
+                     arma::mat& kernels) const
+  {
+    kernels = a.t() * b;
+    kernels = arma::tanh(scale * kernels + offset);
+  }
+
   //! Get scale factor.
   double Scale() const { return scale; }
   //! Modify scale factor.
@@ -85,6 +103,19 @@ class HyperbolicTangentKernel
   double offset;
 };
 
+//! Kernel traits for the hyperbolic tangent kernel.
+template<>
+class KernelTraits<HyperbolicTangentKernel>
+{
+ public:
+  //! The hyperbolic tangent kernel is not normalized.
+  static const bool IsNormalized = false;
+  //! The hyperbolic tangent kernel doesn't include a squared distance.
+  static const bool UsesSquaredDistance = false;
+  //! The hyperbolic tangent kernel is computed from the inner product.
+  static const bool UsesInnerProduct = true;
+};
+
 } // namespace kernel
 } // namespace mlpack
 
@@ -36,6 +36,17 @@ class KernelTraits
    * If true, then the kernel include a squared distance, ||x - y||^2 .
    */
   static const bool UsesSquaredDistance = false;
+
+  /**
+   * If true, then the kernel is computed from the inner product x^T y (and
+   * possibly the norms ||x|| and ||y||), and the kernel class provides a method
+   *
+   *   void EvaluateBlock(const MatTypeA& a, const MatTypeB& b, arma::mat& k)
+   *
+   * that sets k(i, j) = K(a.col(i), b.col(j)) for all columns of a and b with
+   * one matrix multiplication.
+   */
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
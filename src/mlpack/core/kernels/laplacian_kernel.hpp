@@ -117,6 +117,8 @@ class KernelTraits<LaplacianKernel>
   static const bool IsNormalized = true;
   //! The Laplacian kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The Laplacian kernel is not computed from an inner product.
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
@@ -13,6 +13,7 @@
 #define MLPACK_CORE_KERNELS_POLYNOMIAL_KERNEL_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/kernels/kernel_traits.hpp>
 
 namespace mlpack {
 namespace kernel {
@@ -57,6 +58,23 @@ class PolynomialKernel
     return pow((arma::dot(a, b) + offset), degree);
   }
 
+  /**
+   * Evaluate the kernel between each column of a and each column of b with one
+   * matrix multiplication, so that kernels(i, j) = K(a.col(i), b.col(j)).
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param kernels Matrix to store the kernel values in.
+   */
+  template<typename MatTypeA, typename MatTypeB>
+  void EvaluateBlock(const MatTypeA& a,
+                     const MatTypeB& b,
+                     arma::mat& kernels) const
+  {
+    kernels = a.t() * b;
+    kernels = arma::pow(kernels + offset, degree);
+  }
+
   //! Get the degree of the polynomial.
   const double& Degree() const { return degree; }
   //! Modify the degree of the polynomial.
@@ -82,6 +100,19 @@ class PolynomialKernel
   double offset;
 };
 
+//! Kernel traits for the polynomial kernel.
+template<>
+class KernelTraits<PolynomialKernel>
+{
+ public:
+  //! The polynomial kernel is not normalized.
+  static const bool IsNormalized = false;
+  //! The polynomial kernel doesn't include a squared distance.
+  static const bool UsesSquaredDistance = false;
+  //! The polynomial kernel is computed from the inner product.
+  static const bool UsesInnerProduct = true;
+};
+
 } // namespace kernel
 } // namespace mlpack
 
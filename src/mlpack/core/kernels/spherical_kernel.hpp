@@ -126,6 +126,8 @@ class KernelTraits<SphericalKernel>
   static const bool IsNormalized = true;
   //! The spherical kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The spherical kernel is not computed from an inner product.
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
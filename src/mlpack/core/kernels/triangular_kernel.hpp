@@ -106,6 +106,8 @@ class KernelTraits<TriangularKernel>
   static const bool IsNormalized = true;
   //! The triangular kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The triangular kernel is not computed from an inner product.
+  static const bool UsesInnerProduct = false;
 };
 
 } // namespace kernel
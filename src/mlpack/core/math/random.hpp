@@ -104,17 +104,22 @@ inline double RandNormal(const double mean, const double variance)
 
 /**
  * Obtains no more than maxNumSamples distinct samples. Each sample belongs to
- * [loInclusive, hiExclusive).
+ * [loInclusive, hiExclusive).  The samples are drawn with the given random
+ * number generator instead of the global one, so that several threads can
+ * draw samples at the same time (each with its own generator).
  *
  * @param loInclusive The lower bound (inclusive).
  * @param hiExclusive The high bound (exclusive).
  * @param maxNumSamples The maximum number of samples to obtain.
  * @param distinctSamples The samples that will be obtained.
+ * @param generator The random number generator to use.
  */
+template<typename GeneratorType>
 inline void ObtainDistinctSamples(const size_t loInclusive,
                                   const size_t hiExclusive,
                                   const size_t maxNumSamples,
-                                  arma::uvec& distinctSamples)
+                                  arma::uvec& distinctSamples,
+                                  GeneratorType& generator)
 {
   const size_t samplesRangeSize = hiExclusive - loInclusive;
 
@@ -124,8 +129,10 @@ inline void ObtainDistinctSamples(const size_t loInclusive,
 
     samples.zeros(samplesRangeSize);
 
+    std::uniform_real_distribution<> uniformDist;
     for (size_t i = 0; i < maxNumSamples; i++)
-      samples [ (size_t) math::RandInt(samplesRangeSize) ]++;
+      samples [ (size_t) std::floor((double) samplesRangeSize *
+          uniformDist(generator)) ]++;
 
     distinctSamples = arma::find(samples > 0);
 
@@ -140,6 +147,24 @@ inline void ObtainDistinctSamples(const size_t loInclusive,
   }
 }
 
+/**
+ * Obtains no more than maxNumSamples distinct samples. Each sample belongs to
+ * [loInclusive, hiExclusive).
+ *
+ * @param loInclusive The lower bound (inclusive).
+ * @param hiExclusive The high bound (exclusive).
+ * @param maxNumSamples The maximum number of samples to obtain.
+ * @param distinctSamples The samples that will be obtained.
+ */
+inline void ObtainDistinctSamples(const size_t loInclusive,
+                                  const size_t hiExclusive,
+                                  const size_t maxNumSamples,
+                                  arma::uvec& distinctSamples)
+{
+  ObtainDistinctSamples(loInclusive, hiExclusive, maxNumSamples,
+      distinctSamples, randGen);
+}
+
 } // namespace math
 } // namespace mlpack
 
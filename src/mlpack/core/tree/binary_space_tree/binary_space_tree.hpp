@@ -88,6 +88,11 @@ class BinarySpaceTree
   //! The dataset.  If we are the root of the tree, we own the dataset and must
   //! delete it.
   MatType* dataset;
+  //! If Linearize() has been called on this node, this is the pool holding
+  //! all of the descendants of this node in breadth-first order, and we must
+  //! delete it.
+  //! Otherwise, this is NULL.
+  std::vector<BinarySpaceTree>* nodeBlock;
 
  public:
   //! A single-tree traverser for binary space trees; see
@@ -300,6 +305,30 @@ class BinarySpaceTree
    */
   ~BinarySpaceTree();
 
+  /**
+   * Move all of the descendants of this node into a single contiguous pool of
+   * node objects, in breadth-first order.  By default every node of the tree
+   * is allocated separately; after this is called, the node objects of
+   * siblings are adjacent in memory and each level of the tree is stored
+   * contiguously.  Nothing else about the layout changes: nodes are still
+   * linked by ordinary parent and child pointers, and each bound still keeps
+   * its own separately allocated storage, so this only avoids scattering the
+   * node objects themselves across the heap.  The tree (and the order of the
+   * points in the dataset) is unchanged, so all of the traversers work as
+   * before.  No tree is linearized automatically; callers that want this must
+   * call it once the tree is built.
+   *
+   * This can only be called on the root of the tree.  Pointers to descendant
+   * nodes obtained before the call are invalidated, and nodes of a linearized
+   * tree must not be deleted individually.  Copying a linearized tree gives a
+   * tree that is not linearized.
+   */
+  void Linearize();
+
+  //! Return whether or not the descendants of this node are stored
+  //! contiguously (see Linearize()).
+  bool IsLinearized() const { return nodeBlock != NULL; }
+
   //! Return the bound object for this node.
   const BoundType<MetricType>& Bound() const { return bound; }
   //! Return the bound object for this node.
@@ -514,6 +543,40 @@ class BinarySpaceTree
                  const size_t maxLeafSize,
                  SplitType<BoundType<MetricType>, MatType>& splitter);
 
+  /**
+   * Create the children of this node, which hold the points in
+   * [begin, splitCol) and [splitCol, begin + count).  With OpenMP, the two
+   * subtrees of a large node are built concurrently when that gives the same
+   * tree as the serial build.
+   *
+   * @param splitCol Index of the first point of the right child.
+   * @param oldFromNew Vector holding permuted indices, or NULL if the
+   *     permutation is not needed.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  void BuildChildren(const size_t splitCol,
+                     std::vector<size_t>* oldFromNew,
+                     const size_t maxLeafSize,
+                     SplitType<BoundType<MetricType>, MatType>& splitter);
+
+  /**
+   * Create a child of this node holding the given points.
+   *
+   * @param childBegin Index of the first point of the child.
+   * @param childCount Number of points in the child.
+   * @param oldFromNew Vector holding permuted indices, or NULL if the
+   *     permutation is not needed.
+   * @param maxLeafSize Maximum number of points held in a leaf.
+   * @param splitter Instantiated SplitType object.
+   */
+  BinarySpaceTree* BuildChild(const size_t childBegin,
+                              const size_t childCount,
+                              std::vector<size_t>* oldFromNew,
+                              const size_t maxLeafSize,
+                              SplitType<BoundType<MetricType>, MatType>&
+                                  splitter);
+
   /**
    * Update the bound of the current node. This method does not take into
    * account bound-specific properties.
@@ -531,6 +594,20 @@ class BinarySpaceTree
    */
   void UpdateBound(bound::HollowBallBound<MetricType>& boundToUpdate);
 
+  /**
+   * Update the bound of the current node.  This method is designed for
+   * HRectBound only; for large nodes, the bound is computed in parallel.
+   *
+   * @param boundToUpdate The bound to update.
+   */
+  void UpdateBound(bound::HRectBound<MetricType>& boundToUpdate);
+
+  /**
+   * If the descendants of this node are stored contiguously (see Linearize()),
+   * delete them and set the children of this node to NULL.
+   */
+  void DeleteNodeBlock();
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
@@ -543,6 +620,10 @@ class BinarySpaceTree
   //! Friend access is given for the default constructor.
   friend class boost::serialization::access;
 
+  //! FlatTreeFile rebuilds trees from their flat representation on disk.
+  template<typename TreeType>
+  friend class FlatTreeFile;
+
  public:
   /**
    * Serialize the tree.
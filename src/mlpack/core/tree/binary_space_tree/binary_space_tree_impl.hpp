@@ -13,6 +13,7 @@
 
 // In case it wasn't included already for some reason.
 #include "binary_space_tree.hpp"
+#include "mean_split.hpp"
 
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/util/log.hpp>
@@ -21,6 +22,32 @@
 namespace mlpack {
 namespace tree {
 
+/**
+ * The subtrees of a node can only be built in parallel if the split gives the
+ * same result no matter the order in which the nodes are split.  This holds for
+ * MidpointSplit and MeanSplit; the random projection and vantage point splits
+ * draw random numbers, and UBTreeSplit holds the addresses of all points.
+ */
+template<typename SplitType>
+struct IsParallelSplit
+{
+  static const bool value = false;
+};
+
+//! MidpointSplit is deterministic and stateless.
+template<typename BoundType, typename MatType>
+struct IsParallelSplit<MidpointSplit<BoundType, MatType>>
+{
+  static const bool value = true;
+};
+
+//! MeanSplit is deterministic and stateless.
+template<typename BoundType, typename MatType>
+struct IsParallelSplit<MeanSplit<BoundType, MatType>>
+{
+  static const bool value = true;
+};
+
 // Each of these overloads is kept as a separate function to keep the overhead
 // from the two std::vectors out, if possible.
 template<typename MetricType,
@@ -40,7 +67,8 @@ BinarySpaceTree(
     count(data.n_cols), /* and spans all of the dataset. */
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    nodeBlock(NULL)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -68,7 +96,8 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    nodeBlock(NULL)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(data.n_cols);
@@ -102,7 +131,8 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(data)) // Copies the dataset.
+    dataset(new MatType(data)), // Copies the dataset.
+    nodeBlock(NULL)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(data.n_cols);
@@ -137,7 +167,8 @@ BinarySpaceTree(MatType&& data, const size_t maxLeafSize) :
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    nodeBlock(NULL)
 {
   // Do the actual splitting of this node.
   SplitType<BoundType<MetricType>, MatType> splitter;
@@ -165,7 +196,8 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    nodeBlock(NULL)
 {
   // Initialize oldFromNew correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -199,7 +231,8 @@ BinarySpaceTree(
     count(data.n_cols),
     bound(data.n_rows),
     parentDistance(0), // Parent distance for the root is 0: it has no parent.
-    dataset(new MatType(std::move(data)))
+    dataset(new MatType(std::move(data))),
+    nodeBlock(NULL)
 {
   // Initialize the oldFromNew vector correctly.
   oldFromNew.resize(dataset->n_cols);
@@ -238,7 +271,8 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset()) // Point to the parent's dataset.
+    dataset(&parent->Dataset()), // Point to the parent's dataset.
+    nodeBlock(NULL)
 {
   // Perform the actual splitting.
   SplitNode(maxLeafSize, splitter);
@@ -267,7 +301,8 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset().n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    nodeBlock(NULL)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -301,7 +336,8 @@ BinarySpaceTree(
     begin(begin),
     count(count),
     bound(parent->Dataset()->n_rows),
-    dataset(&parent->Dataset())
+    dataset(&parent->Dataset()),
+    nodeBlock(NULL)
 {
   // Hopefully the vector is initialized correctly!  We can't check that
   // entirely but we can do a minor sanity check.
@@ -342,7 +378,8 @@ BinarySpaceTree(
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
     // Copy matrix, but only if we are the root.
-    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL)
+    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL),
+    nodeBlock(NULL)
 {
   // Create left and right children (if any).
   if (other.Left())
@@ -400,7 +437,8 @@ BinarySpaceTree(BinarySpaceTree&& other) :
     parentDistance(other.parentDistance),
     furthestDescendantDistance(other.furthestDescendantDistance),
     minimumBoundDistance(other.minimumBoundDistance),
-    dataset(other.dataset)
+    dataset(other.dataset),
+    nodeBlock(other.nodeBlock)
 {
   // Now we are a clone of the other tree.  But we must also clear the other
   // tree's contents, so it doesn't delete anything when it is destructed.
@@ -412,6 +450,7 @@ BinarySpaceTree(BinarySpaceTree&& other) :
   other.furthestDescendantDistance = 0.0;
   other.minimumBoundDistance = 0.0;
   other.dataset = NULL;
+  other.nodeBlock = NULL;
 
   //Set new parent.
   if (left)
@@ -455,6 +494,9 @@ template<typename MetricType,
 BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     ~BinarySpaceTree()
 {
+  // If our descendants are stored contiguously, they are deleted all at once.
+  DeleteNodeBlock();
+
   delete left;
   delete right;
 
@@ -463,6 +505,92 @@ BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     delete dataset;
 }
 
+/**
+ * Move all of the descendants of this node into one contiguous array, in
+ * breadth-first order.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    Linearize()
+{
+  if (parent != NULL)
+    throw std::invalid_argument("BinarySpaceTree::Linearize(): can only be "
+        "called on the root of the tree");
+
+  if (nodeBlock)
+    return; // Nothing to do.
+
+  // Collect the descendants in breadth-first order.
+  std::vector<BinarySpaceTree*> nodes;
+  if (left)
+    nodes.push_back(left);
+  if (right)
+    nodes.push_back(right);
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (nodes[i]->left)
+      nodes.push_back(nodes[i]->left);
+    if (nodes[i]->right)
+      nodes.push_back(nodes[i]->right);
+  }
+
+  if (nodes.empty())
+    return; // A single leaf has no descendants.
+
+  // Move each node into the block.  The move constructor points the children
+  // of the node at its new location, but the child pointer of its parent must
+  // be fixed here.  Because the order is breadth-first, the parent of each node
+  // has already been moved when we reach it.
+  nodeBlock = new std::vector<BinarySpaceTree>();
+  nodeBlock->reserve(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    nodeBlock->push_back(std::move(*nodes[i]));
+    BinarySpaceTree* node = &nodeBlock->back();
+    if (node->parent->left == nodes[i])
+      node->parent->left = node;
+    else
+      node->parent->right = node;
+
+    // The moved-from node no longer holds anything.
+    delete nodes[i];
+  }
+}
+
+/**
+ * Delete the contiguous block of descendants, if there is one.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    DeleteNodeBlock()
+{
+  if (!nodeBlock)
+    return;
+
+  // The nodes in the block must not delete their children, since those are in
+  // the block too.
+  for (size_t i = 0; i < nodeBlock->size(); ++i)
+  {
+    (*nodeBlock)[i].left = NULL;
+    (*nodeBlock)[i].right = NULL;
+  }
+
+  delete nodeBlock;
+  nodeBlock = NULL;
+  left = NULL;
+  right = NULL;
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -783,10 +911,7 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
 
   // Now that we know the split column, we will recursively split the children
   // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
-      maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      splitter, maxLeafSize);
+  BuildChildren(splitCol, NULL, maxLeafSize, splitter);
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -850,10 +975,7 @@ SplitNode(std::vector<size_t>& oldFromNew,
 
   // Now that we know the split column, we will recursively split the children
   // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
-      splitter, maxLeafSize);
-  right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      oldFromNew, splitter, maxLeafSize);
+  BuildChildren(splitCol, &oldFromNew, maxLeafSize, splitter);
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -869,6 +991,81 @@ SplitNode(std::vector<size_t>& oldFromNew,
   right->ParentDistance() = rightParentDistance;
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BuildChildren(const size_t splitCol,
+              std::vector<size_t>* oldFromNew,
+              const size_t maxLeafSize,
+              SplitType<BoundType<MetricType>, MatType>& splitter)
+{
+#if defined(HAS_OPENMP) && (_OPENMP >= 200805)
+  // The two subtrees work on disjoint parts of the dataset (and of
+  // oldFromNew), so if the split gives the same result no matter the order in
+  // which the nodes are split, they can be built at the same time.  The
+  // HollowBallBound of a right child depends on its left sibling, though.
+  // Small subtrees are not worth a task.
+  const bool parallelSplit = IsParallelSplit<Split>::value &&
+      !std::is_same<BoundType<MetricType>,
+                    bound::HollowBallBound<MetricType>>::value;
+  if (parallelSplit && count >= 10000)
+  {
+    if (omp_in_parallel())
+    {
+      #pragma omp task default(shared)
+      left = BuildChild(begin, splitCol - begin, oldFromNew, maxLeafSize,
+          splitter);
+      right = BuildChild(splitCol, begin + count - splitCol, oldFromNew,
+          maxLeafSize, splitter);
+      #pragma omp taskwait
+      return;
+    }
+    else if (omp_get_max_threads() > 1)
+    {
+      // Start a team of threads; this node is built by one of them, and the
+      // others pick up the tasks for the subtrees.
+      #pragma omp parallel
+      {
+        #pragma omp single
+        BuildChildren(splitCol, oldFromNew, maxLeafSize, splitter);
+      }
+      return;
+    }
+  }
+#endif
+
+  left = BuildChild(begin, splitCol - begin, oldFromNew, maxLeafSize,
+      splitter);
+  right = BuildChild(splitCol, begin + count - splitCol, oldFromNew,
+      maxLeafSize, splitter);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>*
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+BuildChild(const size_t childBegin,
+           const size_t childCount,
+           std::vector<size_t>* oldFromNew,
+           const size_t maxLeafSize,
+           SplitType<BoundType<MetricType>, MatType>& splitter)
+{
+  if (oldFromNew)
+    return new BinarySpaceTree(this, childBegin, childCount, *oldFromNew,
+        splitter, maxLeafSize);
+  else
+    return new BinarySpaceTree(this, childBegin, childCount, splitter,
+        maxLeafSize);
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -883,6 +1080,53 @@ UpdateBound(BoundType2& boundToUpdate)
     boundToUpdate |= dataset->cols(begin, begin + count - 1);
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType, typename...> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+UpdateBound(bound::HRectBound<MetricType>& boundToUpdate)
+{
+  if (count == 0)
+    return;
+
+#ifdef HAS_OPENMP
+  // For large nodes, compute the bounds of chunks of the points in parallel
+  // and then combine them.  Minima and maxima do not depend on the order of
+  // evaluation, so this gives exactly the same bound as the serial loop.
+  if (count >= 100000 && !omp_in_parallel() && omp_get_max_threads() > 1)
+  {
+    const size_t numChunks = omp_get_max_threads();
+    std::vector<bound::HRectBound<MetricType>> chunkBounds(numChunks,
+        bound::HRectBound<MetricType>(dataset->n_rows));
+
+#ifdef _WIN32
+    // Visual Studio only implements OpenMP 2.0, which doesn't support
+    // unsigned loop variables.
+    #pragma omp parallel for
+    for (intmax_t chunk = 0; chunk < (intmax_t) numChunks; ++chunk)
+#else
+    #pragma omp parallel for
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+#endif
+    {
+      const size_t chunkBegin = begin + chunk * count / numChunks;
+      const size_t chunkEnd = begin + (chunk + 1) * count / numChunks;
+      if (chunkEnd > chunkBegin)
+        chunkBounds[chunk] |= dataset->cols(chunkBegin, chunkEnd - 1);
+    }
+
+    for (size_t chunk = 0; chunk < numChunks; ++chunk)
+      boundToUpdate |= chunkBounds[chunk];
+    return;
+  }
+#endif
+
+  boundToUpdate |= dataset->cols(begin, begin + count - 1);
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -926,7 +1170,8 @@ BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     stat(*this),
     parentDistance(0),
     furthestDescendantDistance(0),
-    dataset(NULL)
+    dataset(NULL),
+    nodeBlock(NULL)
 {
   // Nothing to do.
 }
@@ -949,6 +1194,7 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
   // If we're loading, and we have children, they need to be deleted.
   if (Archive::is_loading::value)
   {
+    DeleteNodeBlock();
     if (left)
       delete left;
     if (right)
@@ -19,6 +19,7 @@
 #include <queue>
 
 #include "../binary_space_tree.hpp"
+#include "../block_base_case.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -103,6 +104,10 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  //! The query points of the current leaf-leaf block of base cases, held in
+  //! the class so that it isn't continually being reallocated.
+  std::vector<size_t> blockQueries;
 };
 
 } // namespace tree
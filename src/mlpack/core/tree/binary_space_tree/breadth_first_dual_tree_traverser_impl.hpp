@@ -132,20 +132,34 @@ BreadthFirstDualTreeTraverser<RuleType>::Traverse(
       // Loop through each of the points in each node.
       const size_t queryEnd = queryNode.Begin() + queryNode.Count();
       const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
-      for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+      if (HasBaseCaseBlock<RuleType>::value)
       {
-        // See if we need to investigate this point (this function should be
-        // implemented for the single-tree recursion too).  Restore the
-        // traversal information first.
-//        const double childScore = rule.Score(query, referenceNode);
+        // The rules can compute the whole block of base cases at once.
+        blockQueries.clear();
+        for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+          blockQueries.push_back(query);
+
+        BaseCaseBlock(rule, blockQueries, referenceNode.Begin(),
+            referenceNode.Count());
+        numBaseCases += queryNode.Count() * referenceNode.Count();
+      }
+      else
+      {
+        for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+        {
+          // See if we need to investigate this point (this function should be
+          // implemented for the single-tree recursion too).  Restore the
+          // traversal information first.
+//          const double childScore = rule.Score(query, referenceNode);
 
-//        if (childScore == DBL_MAX)
-//          continue; // We can't improve this particular point.
+//          if (childScore == DBL_MAX)
+//            continue; // We can't improve this particular point.
 
-        for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
-          rule.BaseCase(query, ref);
+          for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
+            rule.BaseCase(query, ref);
 
-        numBaseCases += referenceNode.Count();
+          numBaseCases += referenceNode.Count();
+        }
       }
     }
     else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
@@ -18,6 +18,8 @@
 #include <mlpack/prereqs.hpp>
 
 #include "binary_space_tree.hpp"
+#include "../block_base_case.hpp"
+#include "../tree_profile.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -68,7 +70,33 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Modify the number of times a base case was calculated.
   size_t& NumBaseCases() { return numBaseCases; }
 
+  //! Get the depth that the next call to Traverse() starts at.
+  size_t Depth() const { return depth; }
+  //! Modify the depth that the next call to Traverse() starts at.  Set this
+  //! when the traversal starts below the root of the query tree, so that the
+  //! profile counts each node combination at the same depth as a traversal
+  //! from the root would.
+  size_t& Depth() { return depth; }
+
  private:
+  //! Record the given number of pruned child combinations of the current node
+  //! combination.
+  void Prune(const size_t count)
+  {
+    numPrunes += count;
+    profile.Prune(depth, count);
+  }
+
+  //! Call the rules' Rescore(), and record the call in the profile.
+  double Rescore(BinarySpaceTree& queryNode,
+                 BinarySpaceTree& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryNode, referenceNode, oldScore);
+    profile.Rescore(score == DBL_MAX);
+    return score;
+  }
+
   //! Reference to the rules with which the trees will be traversed.
   RuleType& rule;
 
@@ -87,6 +115,16 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  //! The query points of the current leaf-leaf block of base cases, held in
+  //! the class so that it isn't continually being reallocated.
+  std::vector<size_t> blockQueries;
+
+  //! The depth of the children of the node combination being traversed.
+  size_t depth;
+
+  //! Profiling counters (only recorded if counters are enabled).
+  TraversalProfile profile;
 };
 
 } // namespace tree
@@ -33,7 +33,9 @@ DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
     numPrunes(0),
     numVisited(0),
     numScores(0),
-    numBaseCases(0)
+    numBaseCases(0),
+    depth(0),
+    profile("dual_tree")
 { /* Nothing to do. */ }
 
 template<typename MetricType,
@@ -52,6 +54,7 @@ DualTreeTraverser<RuleType>::Traverse(
 {
   // Increment the visit counter.
   ++numVisited;
+  profile.Visit(depth++);
 
   // Store the current traversal info.
   traversalInfo = rule.TraversalInfo();
@@ -59,25 +62,48 @@ DualTreeTraverser<RuleType>::Traverse(
   // If both are leaves, we must evaluate the base case.
   if (queryNode.IsLeaf() && referenceNode.IsLeaf())
   {
+    profile.StartBaseCases();
+
     // Loop through each of the points in each node.
     const size_t queryEnd = queryNode.Begin() + queryNode.Count();
     const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
-    for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+    if (HasBaseCaseBlock<RuleType>::value)
     {
-      // See if we need to investigate this point (this function should be
-      // implemented for the single-tree recursion too).  Restore the traversal
-      // information first.
-      rule.TraversalInfo() = traversalInfo;
-      const double childScore = rule.Score(query, referenceNode);
+      // The rules can compute all of the base cases between the query points
+      // that can't be pruned and the reference node at once.
+      blockQueries.clear();
+      for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+      {
+        rule.TraversalInfo() = traversalInfo;
+        if (rule.Score(query, referenceNode) != DBL_MAX)
+          blockQueries.push_back(query);
+      }
 
-      if (childScore == DBL_MAX)
-        continue; // We can't improve this particular point.
+      BaseCaseBlock(rule, blockQueries, referenceNode.Begin(),
+          referenceNode.Count());
+      numBaseCases += blockQueries.size() * referenceNode.Count();
+    }
+    else
+    {
+      for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+      {
+        // See if we need to investigate this point (this function should be
+        // implemented for the single-tree recursion too).  Restore the
+        // traversal information first.
+        rule.TraversalInfo() = traversalInfo;
+        const double childScore = rule.Score(query, referenceNode);
+
+        if (childScore == DBL_MAX)
+          continue; // We can't improve this particular point.
 
-      for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
-        rule.BaseCase(query, ref);
+        for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
+          rule.BaseCase(query, ref);
 
-      numBaseCases += referenceNode.Count();
+        numBaseCases += referenceNode.Count();
+      }
     }
+
+    profile.StopBaseCases();
   }
   else if (((!queryNode.IsLeaf()) && referenceNode.IsLeaf()) ||
            (queryNode.NumDescendants() > 3 * referenceNode.NumDescendants() &&
@@ -91,7 +117,7 @@ DualTreeTraverser<RuleType>::Traverse(
     if (leftScore != DBL_MAX)
       Traverse(*queryNode.Left(), referenceNode);
     else
-      ++numPrunes;
+      Prune(1);
 
     // Before recursing, we have to set the traversal information correctly.
     rule.TraversalInfo() = traversalInfo;
@@ -101,7 +127,7 @@ DualTreeTraverser<RuleType>::Traverse(
     if (rightScore != DBL_MAX)
       Traverse(*queryNode.Right(), referenceNode);
     else
-      ++numPrunes;
+      Prune(1);
   }
   else if (queryNode.IsLeaf() && (!referenceNode.IsLeaf()))
   {
@@ -123,7 +149,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(queryNode, *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(queryNode, *referenceNode.Right(), rightScore);
+      rightScore = Rescore(queryNode, *referenceNode.Right(), rightScore);
 
       if (rightScore != DBL_MAX)
       {
@@ -132,7 +158,7 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(queryNode, *referenceNode.Right());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else if (rightScore < leftScore)
     {
@@ -140,7 +166,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(queryNode, *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(queryNode, *referenceNode.Left(), leftScore);
+      leftScore = Rescore(queryNode, *referenceNode.Left(), leftScore);
 
       if (leftScore != DBL_MAX)
       {
@@ -149,13 +175,13 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(queryNode, *referenceNode.Left());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else // leftScore is equal to rightScore.
     {
       if (leftScore == DBL_MAX)
       {
-        numPrunes += 2;
+        Prune(2);
       }
       else
       {
@@ -165,7 +191,7 @@ DualTreeTraverser<RuleType>::Traverse(
         rule.TraversalInfo() = leftInfo;
         Traverse(queryNode, *referenceNode.Left());
 
-        rightScore = rule.Rescore(queryNode, *referenceNode.Right(),
+        rightScore = Rescore(queryNode, *referenceNode.Right(),
             rightScore);
 
         if (rightScore != DBL_MAX)
@@ -175,7 +201,7 @@ DualTreeTraverser<RuleType>::Traverse(
           Traverse(queryNode, *referenceNode.Right());
         }
         else
-          ++numPrunes;
+          Prune(1);
       }
     }
   }
@@ -201,7 +227,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Left(), *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
+      rightScore = Rescore(*queryNode.Left(), *referenceNode.Right(),
           rightScore);
 
       if (rightScore != DBL_MAX)
@@ -211,7 +237,7 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Left(), *referenceNode.Right());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else if (rightScore < leftScore)
     {
@@ -219,7 +245,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Left(), *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(*queryNode.Left(), *referenceNode.Left(),
+      leftScore = Rescore(*queryNode.Left(), *referenceNode.Left(),
           leftScore);
 
       if (leftScore != DBL_MAX)
@@ -229,13 +255,13 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Left(), *referenceNode.Left());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else
     {
       if (leftScore == DBL_MAX)
       {
-        numPrunes += 2;
+        Prune(2);
       }
       else
       {
@@ -246,7 +272,7 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Left(), *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
+        rightScore = Rescore(*queryNode.Left(), *referenceNode.Right(),
             rightScore);
 
         if (rightScore != DBL_MAX)
@@ -256,7 +282,7 @@ DualTreeTraverser<RuleType>::Traverse(
           Traverse(*queryNode.Left(), *referenceNode.Right());
         }
         else
-          ++numPrunes;
+          Prune(1);
       }
     }
 
@@ -279,7 +305,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Right(), *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
+      rightScore = Rescore(*queryNode.Right(), *referenceNode.Right(),
           rightScore);
 
       if (rightScore != DBL_MAX)
@@ -289,7 +315,7 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Right(), *referenceNode.Right());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else if (rightScore < leftScore)
     {
@@ -297,7 +323,7 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Right(), *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(*queryNode.Right(), *referenceNode.Left(),
+      leftScore = Rescore(*queryNode.Right(), *referenceNode.Left(),
           leftScore);
 
       if (leftScore != DBL_MAX)
@@ -307,13 +333,13 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Right(), *referenceNode.Left());
       }
       else
-        ++numPrunes;
+        Prune(1);
     }
     else
     {
       if (leftScore == DBL_MAX)
       {
-        numPrunes += 2;
+        Prune(2);
       }
       else
       {
@@ -324,7 +350,7 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Right(), *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
+        rightScore = Rescore(*queryNode.Right(), *referenceNode.Right(),
             rightScore);
 
         if (rightScore != DBL_MAX)
@@ -334,10 +360,12 @@ DualTreeTraverser<RuleType>::Traverse(
           Traverse(*queryNode.Right(), *referenceNode.Right());
         }
         else
-          ++numPrunes;
+          Prune(1);
       }
     }
   }
+
+  --depth;
 }
 
 } // namespace tree
@@ -0,0 +1,211 @@
+/**
+ * @file flat_tree_file.hpp
+ *
+ * Definition of FlatTreeFile, which stores a BinarySpaceTree in a flat,
+ * pointer-free binary file that can be memory-mapped when it is loaded.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_TREE_FILE_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_TREE_FILE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/tree/hrectbound.hpp>
+#include <mlpack/core/tree/ballbound.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * FlatTreeFile stores a BinarySpaceTree (and the dataset it was built on) in a
+ * flat binary file with no pointers in it, and loads such a file by
+ * memory-mapping it.  This avoids the cost of rebuilding the tree (or of
+ * deserializing it with boost::serialization) every time a model is used.
+ *
+ * The file holds a fixed-size header, one record for each node (in
+ * breadth-first order, with children referenced by index), one fixed-size
+ * record for the bound of each node, the reordered dataset, and the mapping
+ * from the new point indices to the old point indices.
+ *
+ * When the file is loaded, the dataset of the tree aliases the mapped memory,
+ * so no copy of the data is made and several processes that load the same
+ * file share the same pages of the operating system's page cache.  The file is
+ * mapped copy-on-write, so the file is never modified.  The nodes themselves
+ * are rebuilt in a single linear pass over the node and bound records, and the
+ * statistic of each node is initialized from the node (as if the tree had just
+ * been built).
+ *
+ * Only HRectBound and BallBound are supported as bound types, and the dataset
+ * must be a dense Armadillo matrix.  The file is not portable between machines
+ * of different endianness.
+ *
+ * @code
+ * KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+ *     arma::mat> tree(dataset, oldFromNew);
+ * FlatTreeFile<decltype(tree)>::Save("tree.bin", tree, oldFromNew);
+ *
+ * // Later, possibly in another process.
+ * FlatTreeFile<decltype(tree)> file("tree.bin");
+ * KNN knn(std::move(file.Tree()));
+ * @endcode
+ *
+ * The tree returned by Tree() may be moved elsewhere (for instance, into a
+ * NeighborSearch object), but the FlatTreeFile object must then outlive it,
+ * because the dataset of the tree points into the mapped file.
+ *
+ * @tparam TreeType Type of BinarySpaceTree to store.
+ */
+template<typename TreeType>
+class FlatTreeFile
+{
+ public:
+  //! The type of element held in the dataset.
+  typedef typename TreeType::ElemType ElemType;
+  //! The type of the dataset.
+  typedef typename TreeType::Mat MatType;
+
+  /**
+   * Save the given tree to the given file.  The tree must be the root of the
+   * tree.  If the tree was built with a mapping from new point indices to old
+   * point indices, that mapping can be given so it is stored too.
+   *
+   * @param filename Name of the file to write.
+   * @param tree Root of the tree to save.
+   * @param oldFromNew Mapping from new point indices to old point indices (may
+   *     be empty).
+   */
+  static void Save(const std::string& filename,
+                   const TreeType& tree,
+                   const std::vector<size_t>& oldFromNew =
+                       std::vector<size_t>());
+
+  /**
+   * Memory-map the given file and reconstruct the tree stored in it.  A
+   * std::runtime_error is thrown if the file cannot be mapped or does not hold
+   * a tree of type TreeType.
+   *
+   * @param filename Name of the file to load.
+   */
+  FlatTreeFile(const std::string& filename);
+
+  //! Copying is not allowed, since the tree aliases the mapped file.
+  FlatTreeFile(const FlatTreeFile& other) = delete;
+  //! Copying is not allowed, since the tree aliases the mapped file.
+  FlatTreeFile& operator=(const FlatTreeFile& other) = delete;
+
+  /**
+   * Delete the tree (and its dataset alias) and unmap the file.
+   */
+  ~FlatTreeFile();
+
+  //! Get the loaded tree.
+  const TreeType& Tree() const { return *tree; }
+  //! Modify the loaded tree.
+  TreeType& Tree() { return *tree; }
+
+  //! Get the mapping from new point indices to old point indices.
+  const std::vector<size_t>& OldFromNew() const { return oldFromNew; }
+
+ private:
+  //! The header at the start of every file.
+  struct Header
+  {
+    //! Identifies the file format.
+    char magic[8];
+    //! Version of the file format.
+    uint64_t version;
+    //! Size of one element of the dataset, in bytes.
+    uint64_t elemSize;
+    //! Dimensionality of the dataset.
+    uint64_t dim;
+    //! Number of points in the dataset.
+    uint64_t numPoints;
+    //! Number of nodes in the tree.
+    uint64_t numNodes;
+    //! Number of doubles in the record of a single bound.
+    uint64_t boundSize;
+    //! Number of entries in the oldFromNew mapping.
+    uint64_t numMappings;
+    //! Offset of the node records in the file, in bytes.
+    uint64_t nodeOffset;
+    //! Offset of the bound records in the file, in bytes.
+    uint64_t boundOffset;
+    //! Offset of the dataset in the file, in bytes.
+    uint64_t datasetOffset;
+    //! Offset of the oldFromNew mapping in the file, in bytes.
+    uint64_t mappingOffset;
+    //! Total size of the file, in bytes.
+    uint64_t fileSize;
+  };
+
+  //! The record of a single node.  Child and parent links are node indices;
+  //! the root (index 0) is never a child, so 0 means "no child", and the parent
+  //! index of the root is itself.
+  struct NodeRecord
+  {
+    uint64_t begin;
+    uint64_t count;
+    uint64_t parent;
+    uint64_t left;
+    uint64_t right;
+    double parentDistance;
+    double furthestDescendantDistance;
+    double minimumBoundDistance;
+  };
+
+  //! Compute the number of doubles needed to store a bound.
+  template<typename MetricType, typename BoundElemType>
+  static size_t BoundSize(const bound::HRectBound<MetricType, BoundElemType>&,
+                          const size_t dim) { return 2 * dim + 1; }
+  //! Compute the number of doubles needed to store a bound.
+  template<typename MetricType, typename VecType>
+  static size_t BoundSize(const bound::BallBound<MetricType, VecType>&,
+                          const size_t dim) { return dim + 1; }
+
+  //! Write a hyperrectangle bound into the given record.
+  template<typename MetricType, typename BoundElemType>
+  static void WriteBound(
+      const bound::HRectBound<MetricType, BoundElemType>& bound,
+      double* record);
+  //! Write a ball bound into the given record.
+  template<typename MetricType, typename VecType>
+  static void WriteBound(const bound::BallBound<MetricType, VecType>& bound,
+                         double* record);
+
+  //! Read a hyperrectangle bound from the given record.
+  template<typename MetricType, typename BoundElemType>
+  static void ReadBound(const double* record,
+                        const size_t dim,
+                        bound::HRectBound<MetricType, BoundElemType>& bound);
+  //! Read a ball bound from the given record.
+  template<typename MetricType, typename VecType>
+  static void ReadBound(const double* record,
+                        const size_t dim,
+                        bound::BallBound<MetricType, VecType>& bound);
+
+  //! Round the given offset up to a multiple of the cache line size.
+  static size_t Align(const size_t offset) { return (offset + 63) & ~63; }
+
+  //! The mapping of the file.
+  boost::interprocess::file_mapping mapping;
+  //! The mapped region of the file.
+  boost::interprocess::mapped_region region;
+  //! The reconstructed tree.
+  TreeType* tree;
+  //! Mapping from new point indices to old point indices.
+  std::vector<size_t> oldFromNew;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "flat_tree_file_impl.hpp"
+
+#endif
@@ -0,0 +1,349 @@
+/**
+ * @file flat_tree_file_impl.hpp
+ *
+ * Implementation of FlatTreeFile, which stores a BinarySpaceTree in a flat,
+ * pointer-free binary file that can be memory-mapped when it is loaded.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_TREE_FILE_IMPL_HPP
+#define MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_TREE_FILE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "flat_tree_file.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace mlpack {
+namespace tree {
+
+//! The magic bytes at the start of every flat tree file.
+static const char flatTreeFileMagic[8] = { 'M', 'L', 'P', 'K', 'T', 'R',
+    'E', 'E' };
+//! The current version of the flat tree file format.
+static const uint64_t flatTreeFileVersion = 1;
+
+template<typename TreeType>
+void FlatTreeFile<TreeType>::Save(const std::string& filename,
+                                  const TreeType& tree,
+                                  const std::vector<size_t>& oldFromNew)
+{
+  if (tree.Parent() != NULL)
+    throw std::invalid_argument("FlatTreeFile::Save(): the given node is not "
+        "the root of the tree");
+
+  const size_t dim = tree.Dataset().n_rows;
+  const size_t boundSize = BoundSize(tree.Bound(), dim);
+
+  // Collect the nodes in breadth-first order, recording the index of the
+  // children of each node as they are collected.
+  std::vector<const TreeType*> nodes;
+  std::vector<NodeRecord> records;
+  nodes.push_back(&tree);
+  records.push_back(NodeRecord());
+  records[0].parent = 0;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    const TreeType* node = nodes[i];
+    records[i].begin = node->Begin();
+    records[i].count = node->Count();
+    records[i].left = 0;
+    records[i].right = 0;
+    records[i].parentDistance = node->ParentDistance();
+    records[i].furthestDescendantDistance = node->FurthestDescendantDistance();
+    records[i].minimumBoundDistance = node->MinimumBoundDistance();
+
+    if (node->Left())
+    {
+      records[i].left = nodes.size();
+      nodes.push_back(node->Left());
+      records.push_back(NodeRecord());
+      records.back().parent = i;
+    }
+
+    if (node->Right())
+    {
+      records[i].right = nodes.size();
+      nodes.push_back(node->Right());
+      records.push_back(NodeRecord());
+      records.back().parent = i;
+    }
+  }
+
+  // Flatten the bounds.
+  std::vector<double> bounds(nodes.size() * boundSize);
+  for (size_t i = 0; i < nodes.size(); ++i)
+    WriteBound(nodes[i]->Bound(), bounds.data() + i * boundSize);
+
+  // Lay out the file.  Every section starts on a cache line boundary, so that
+  // the dataset is suitably aligned once the file is mapped.
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.magic, flatTreeFileMagic, sizeof(header.magic));
+  header.version = flatTreeFileVersion;
+  header.elemSize = sizeof(ElemType);
+  header.dim = dim;
+  header.numPoints = tree.Dataset().n_cols;
+  header.numNodes = nodes.size();
+  header.boundSize = boundSize;
+  header.numMappings = oldFromNew.size();
+  header.nodeOffset = Align(sizeof(Header));
+  header.boundOffset = Align(header.nodeOffset +
+      nodes.size() * sizeof(NodeRecord));
+  header.datasetOffset = Align(header.boundOffset +
+      bounds.size() * sizeof(double));
+  header.mappingOffset = Align(header.datasetOffset +
+      tree.Dataset().n_elem * sizeof(ElemType));
+  header.fileSize = header.mappingOffset +
+      oldFromNew.size() * sizeof(uint64_t);
+
+  std::ofstream ofs(filename.c_str(), std::ios::out | std::ios::binary |
+      std::ios::trunc);
+  if (!ofs.is_open())
+    throw std::runtime_error("FlatTreeFile::Save(): cannot open '" + filename +
+        "' for writing");
+
+  // Write zeros until the stream reaches the given offset.
+  const char padding[64] = { 0 };
+  size_t position = 0;
+  auto writeSection = [&](const size_t offset, const void* data,
+                          const size_t size)
+  {
+    ofs.write(padding, offset - position);
+    ofs.write(static_cast<const char*>(data), size);
+    position = offset + size;
+  };
+
+  std::vector<uint64_t> mappings(oldFromNew.begin(), oldFromNew.end());
+  writeSection(0, &header, sizeof(Header));
+  writeSection(header.nodeOffset, records.data(),
+      records.size() * sizeof(NodeRecord));
+  writeSection(header.boundOffset, bounds.data(),
+      bounds.size() * sizeof(double));
+  writeSection(header.datasetOffset, tree.Dataset().memptr(),
+      tree.Dataset().n_elem * sizeof(ElemType));
+  writeSection(header.mappingOffset, mappings.data(),
+      mappings.size() * sizeof(uint64_t));
+
+  if (!ofs.good())
+    throw std::runtime_error("FlatTreeFile::Save(): error writing to '" +
+        filename + "'");
+}
+
+template<typename TreeType>
+FlatTreeFile<TreeType>::FlatTreeFile(const std::string& filename) :
+    tree(NULL)
+{
+  using namespace boost::interprocess;
+
+  // Map the file copy-on-write: the pages are shared with every other process
+  // mapping the file until somebody writes to them, and the file on disk is
+  // never modified.
+  try
+  {
+    file_mapping fileMapping(filename.c_str(), read_only);
+    mapped_region mappedRegion(fileMapping, copy_on_write);
+    mapping.swap(fileMapping);
+    region.swap(mappedRegion);
+  }
+  catch (interprocess_exception& e)
+  {
+    throw std::runtime_error("FlatTreeFile::FlatTreeFile(): cannot map '" +
+        filename + "': " + e.what());
+  }
+
+  char* base = static_cast<char*>(region.get_address());
+  if (region.get_size() < sizeof(Header))
+    throw std::runtime_error("FlatTreeFile::FlatTreeFile(): '" + filename +
+        "' is too small to be a flat tree file");
+
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  if (std::memcmp(header.magic, flatTreeFileMagic, sizeof(header.magic)) != 0)
+    throw std::runtime_error("FlatTreeFile::FlatTreeFile(): '" + filename +
+        "' is not a flat tree file");
+  if (header.version != flatTreeFileVersion)
+    throw std::runtime_error("FlatTreeFile::FlatTreeFile(): '" + filename +
+        "' has unsupported version " + std::to_string(header.version));
+
+  // Make sure that the file holds the same type of tree that we have.
+  typedef typename std::remove_reference<decltype(
+      std::declval<TreeType&>().Bound())>::type BoundType;
+  typedef typename std::remove_reference<decltype(
+      std::declval<TreeType&>().Stat())>::type StatisticType;
+  if (header.elemSize != sizeof(ElemType) ||
+      header.boundSize != BoundSize(BoundType(), header.dim))
+    throw std::runtime_error("FlatTreeFile::FlatTreeFile(): '" + filename +
+        "' holds a different type of tree");
+
+  const std::string corrupt = "FlatTreeFile::FlatTreeFile(): '" + filename +
+      "' is truncated or corrupt";
+  if (header.numNodes == 0 || region.get_size() < header.fileSize)
+    throw std::runtime_error(corrupt);
+
+  // Make sure that every section lies inside the mapped region, and is aligned
+  // for its type, before anything is read from it.  The sizes come from the
+  // file, so the products are checked for overflow.
+  const uint64_t regionSize = region.get_size();
+  auto fits = [regionSize](const uint64_t offset, const uint64_t count,
+                           const uint64_t size, const uint64_t alignment)
+  {
+    return (offset % alignment == 0) && (offset <= regionSize) &&
+        (size == 0 || count <= (regionSize - offset) / size);
+  };
+  const uint64_t pointSize = header.dim * header.elemSize;
+  if ((header.elemSize != 0 && pointSize / header.elemSize != header.dim) ||
+      !fits(header.nodeOffset, header.numNodes, sizeof(NodeRecord),
+          alignof(NodeRecord)) ||
+      (header.boundSize != 0 && header.numNodes >
+          std::numeric_limits<uint64_t>::max() / header.boundSize) ||
+      !fits(header.boundOffset, header.numNodes * header.boundSize,
+          sizeof(double), alignof(double)) ||
+      !fits(header.datasetOffset, header.numPoints, pointSize,
+          alignof(ElemType)) ||
+      !fits(header.mappingOffset, header.numMappings, sizeof(uint64_t),
+          alignof(uint64_t)))
+    throw std::runtime_error(corrupt);
+
+  const NodeRecord* records =
+      reinterpret_cast<const NodeRecord*>(base + header.nodeOffset);
+  const double* bounds =
+      reinterpret_cast<const double*>(base + header.boundOffset);
+  ElemType* data = reinterpret_cast<ElemType*>(base + header.datasetOffset);
+
+  // Make sure that the nodes form a tree: every node holds points of the
+  // dataset, every child comes after its parent and names it as its parent,
+  // and every node but the root is a child of its parent.
+  for (size_t i = 0; i < header.numNodes; ++i)
+  {
+    const NodeRecord& record = records[i];
+    if (record.count > header.numPoints ||
+        record.begin > header.numPoints - record.count)
+      throw std::runtime_error(corrupt);
+
+    const uint64_t children[2] = { record.left, record.right };
+    for (size_t c = 0; c < 2; ++c)
+    {
+      if (children[c] != 0 && (children[c] <= i ||
+          children[c] >= header.numNodes || records[children[c]].parent != i))
+        throw std::runtime_error(corrupt);
+    }
+    if (record.left != 0 && record.left == record.right)
+      throw std::runtime_error(corrupt);
+
+    if (i > 0 && (record.parent >= i || (records[record.parent].left != i &&
+        records[record.parent].right != i)))
+      throw std::runtime_error(corrupt);
+  }
+
+  // Rebuild the nodes in one pass.  Every parent precedes its children, so the
+  // parent of each node already exists when we reach it.
+  std::vector<TreeType*> nodes(header.numNodes);
+  for (size_t i = 0; i < header.numNodes; ++i)
+  {
+    TreeType* node = new TreeType();
+    nodes[i] = node;
+    node->begin = records[i].begin;
+    node->count = records[i].count;
+    node->parentDistance = ElemType(records[i].parentDistance);
+    node->furthestDescendantDistance =
+        ElemType(records[i].furthestDescendantDistance);
+    node->minimumBoundDistance = ElemType(records[i].minimumBoundDistance);
+    ReadBound(bounds + i * header.boundSize, header.dim, node->bound);
+
+    if (i == 0)
+    {
+      // The dataset is an alias of the mapped memory.
+      node->dataset = new MatType(data, header.dim, header.numPoints, false,
+          true);
+      tree = node;
+    }
+    else
+    {
+      TreeType* parent = nodes[records[i].parent];
+      node->parent = parent;
+      node->dataset = parent->dataset;
+      if (records[records[i].parent].left == i)
+        parent->left = node;
+      else
+        parent->right = node;
+    }
+  }
+
+  // Initialize the statistics bottom-up, as the tree constructor does.
+  for (size_t i = header.numNodes; i > 0; --i)
+    nodes[i - 1]->stat = StatisticType(*nodes[i - 1]);
+
+  const uint64_t* mappings =
+      reinterpret_cast<const uint64_t*>(base + header.mappingOffset);
+  oldFromNew.assign(mappings, mappings + header.numMappings);
+}
+
+template<typename TreeType>
+FlatTreeFile<TreeType>::~FlatTreeFile()
+{
+  // The tree must be deleted before the file is unmapped.
+  delete tree;
+}
+
+template<typename TreeType>
+template<typename MetricType, typename BoundElemType>
+void FlatTreeFile<TreeType>::WriteBound(
+    const bound::HRectBound<MetricType, BoundElemType>& bound,
+    double* record)
+{
+  for (size_t d = 0; d < bound.Dim(); ++d)
+  {
+    record[2 * d] = bound[d].Lo();
+    record[2 * d + 1] = bound[d].Hi();
+  }
+  record[2 * bound.Dim()] = bound.MinWidth();
+}
+
+template<typename TreeType>
+template<typename MetricType, typename VecType>
+void FlatTreeFile<TreeType>::WriteBound(
+    const bound::BallBound<MetricType, VecType>& bound,
+    double* record)
+{
+  for (size_t d = 0; d < bound.Dim(); ++d)
+    record[d] = bound.Center()[d];
+  record[bound.Dim()] = bound.Radius();
+}
+
+template<typename TreeType>
+template<typename MetricType, typename BoundElemType>
+void FlatTreeFile<TreeType>::ReadBound(
+    const double* record,
+    const size_t dim,
+    bound::HRectBound<MetricType, BoundElemType>& bound)
+{
+  bound = bound::HRectBound<MetricType, BoundElemType>(dim);
+  for (size_t d = 0; d < dim; ++d)
+    bound[d] = math::RangeType<BoundElemType>(record[2 * d],
+        record[2 * d + 1]);
+  bound.MinWidth() = record[2 * dim];
+}
+
+template<typename TreeType>
+template<typename MetricType, typename VecType>
+void FlatTreeFile<TreeType>::ReadBound(
+    const double* record,
+    const size_t dim,
+    bound::BallBound<MetricType, VecType>& bound)
+{
+  bound.Center().set_size(dim);
+  for (size_t d = 0; d < dim; ++d)
+    bound.Center()[d] = record[d];
+  bound.Radius() = record[dim];
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -17,6 +17,7 @@
 #include <mlpack/prereqs.hpp>
 
 #include "binary_space_tree.hpp"
+#include "../tree_profile.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -52,11 +53,34 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   size_t& NumPrunes() { return numPrunes; }
 
  private:
+  //! Record the given number of pruned children of the current node.
+  void Prune(const size_t count)
+  {
+    numPrunes += count;
+    profile.Prune(depth, count);
+  }
+
+  //! Call the rules' Rescore(), and record the call in the profile.
+  double Rescore(const size_t queryIndex,
+                 BinarySpaceTree& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryIndex, referenceNode, oldScore);
+    profile.Rescore(score == DBL_MAX);
+    return score;
+  }
+
   //! Reference to the rules with which the tree will be traversed.
   RuleType& rule;
 
   //! The number of nodes which have been pruned during traversal.
   size_t numPrunes;
+
+  //! The depth of the children of the node being traversed.
+  size_t depth;
+
+  //! Profiling counters (only recorded if counters are enabled).
+  TraversalProfile profile;
 };
 
 } // namespace tree
@@ -32,7 +32,9 @@ template<typename RuleType>
 BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
 SingleTreeTraverser<RuleType>::SingleTreeTraverser(RuleType& rule) :
     rule(rule),
-    numPrunes(0)
+    numPrunes(0),
+    depth(0),
+    profile("single_tree")
 { /* Nothing to do. */ }
 
 template<typename MetricType,
@@ -48,12 +50,16 @@ SingleTreeTraverser<RuleType>::Traverse(
     BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
         referenceNode)
 {
+  profile.Visit(depth++);
+
   // If we are a leaf, run the base case as necessary.
   if (referenceNode.IsLeaf())
   {
+    profile.StartBaseCases();
     const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
     for (size_t i = referenceNode.Begin(); i < refEnd; ++i)
       rule.BaseCase(queryIndex, i);
+    profile.StopBaseCases();
   }
   else
   {
@@ -67,12 +73,12 @@ SingleTreeTraverser<RuleType>::Traverse(
       Traverse(queryIndex, *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(queryIndex, *referenceNode.Right(), rightScore);
+      rightScore = Rescore(queryIndex, *referenceNode.Right(), rightScore);
 
       if (rightScore != DBL_MAX)
         Traverse(queryIndex, *referenceNode.Right()); // Recurse to the right.
       else
-        ++numPrunes;
+        Prune(1);
     }
     else if (rightScore < leftScore)
     {
@@ -80,18 +86,18 @@ SingleTreeTraverser<RuleType>::Traverse(
       Traverse(queryIndex, *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(queryIndex, *referenceNode.Left(), leftScore);
+      leftScore = Rescore(queryIndex, *referenceNode.Left(), leftScore);
 
       if (leftScore != DBL_MAX)
         Traverse(queryIndex, *referenceNode.Left()); // Recurse to the left.
       else
-        ++numPrunes;
+        Prune(1);
     }
     else // leftScore is equal to rightScore.
     {
       if (leftScore == DBL_MAX)
       {
-        numPrunes += 2; // Pruned both left and right.
+        Prune(2); // Pruned both left and right.
       }
       else
       {
@@ -99,16 +105,18 @@ SingleTreeTraverser<RuleType>::Traverse(
         Traverse(queryIndex, *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(queryIndex, *referenceNode.Right(),
+        rightScore = Rescore(queryIndex, *referenceNode.Right(),
             rightScore);
 
         if (rightScore != DBL_MAX)
           Traverse(queryIndex, *referenceNode.Right());
         else
-          ++numPrunes;
+          Prune(1);
       }
     }
   }
+
+  --depth;
 }
 
 } // namespace tree
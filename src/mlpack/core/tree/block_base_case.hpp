@@ -0,0 +1,73 @@
+/**
+ * @file block_base_case.hpp
+ *
+ * Utilities that let tree traversers evaluate the base cases between a set of
+ * query points and a contiguous range of reference points in one call, when the
+ * RuleType supports it.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_BLOCK_BASE_CASE_HPP
+#define MLPACK_CORE_TREE_BLOCK_BASE_CASE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace tree {
+
+HAS_MEM_FUNC(BaseCaseBlock, HasBaseCaseBlockCheck);
+
+/**
+ * 'value' is true if the RuleType class has a member
+ * void BaseCaseBlock(const std::vector<size_t>& queryIndices,
+ *                    const size_t referenceBegin,
+ *                    const size_t referenceCount).
+ *
+ * Such a method must have the same effect as calling BaseCase(q, r) for each
+ * query index q in queryIndices and each reference index r in
+ * [referenceBegin, referenceBegin + referenceCount), but it may compute the
+ * whole block at once (for instance, with a matrix multiplication).
+ */
+template<typename RuleType>
+struct HasBaseCaseBlock
+{
+  static const bool value = HasBaseCaseBlockCheck<RuleType,
+      void(RuleType::*)(const std::vector<size_t>&,
+                        const size_t,
+                        const size_t)>::value;
+};
+
+//! Evaluate the base cases of a block with the rules' BaseCaseBlock() method.
+template<typename RuleType>
+inline typename std::enable_if<HasBaseCaseBlock<RuleType>::value>::type
+BaseCaseBlock(RuleType& rule,
+              const std::vector<size_t>& queryIndices,
+              const size_t referenceBegin,
+              const size_t referenceCount)
+{
+  rule.BaseCaseBlock(queryIndices, referenceBegin, referenceCount);
+}
+
+//! Evaluate the base cases of a block one at a time, since the rules have no
+//! BaseCaseBlock() method.
+template<typename RuleType>
+inline typename std::enable_if<!HasBaseCaseBlock<RuleType>::value>::type
+BaseCaseBlock(RuleType& rule,
+              const std::vector<size_t>& queryIndices,
+              const size_t referenceBegin,
+              const size_t referenceCount)
+{
+  const size_t referenceEnd = referenceBegin + referenceCount;
+  for (size_t i = 0; i < queryIndices.size(); ++i)
+    for (size_t ref = referenceBegin; ref < referenceEnd; ++ref)
+      rule.BaseCase(queryIndices[i], ref);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -18,6 +18,8 @@
 #include "../statistic.hpp"
 #include "first_point_is_root.hpp"
 
+#include <deque>
+
 namespace mlpack {
 namespace tree {
 
@@ -446,13 +448,84 @@ class CoverTree
   MetricType* metric;
 
   /**
-   * Create the children for this node.
+   * Scratch space for tree construction.  The index and distance arrays of the
+   * children that are being built at each depth of the recursion, and the
+   * buffers used by SortPointSet(), only ever grow, so they are allocated a
+   * handful of times for the whole tree instead of once for each node.
+   */
+  struct BuildScratch
+  {
+    //! The index arrays for each depth of the recursion.
+    std::deque<arma::Col<size_t>> indices;
+    //! The distance arrays for each depth of the recursion.
+    std::deque<arma::vec> distances;
+    //! The first depth whose arrays are not in use.
+    size_t depth;
+    //! Buffer for the indices in SortPointSet().
+    arma::Col<size_t> indicesBuffer;
+    //! Buffer for the distances in SortPointSet().
+    arma::vec distancesBuffer;
+
+    BuildScratch() : depth(0) { }
+  };
+
+  /**
+   * A child whose subtree is built in a separate task (see CreateChildren()).
+   * It holds its own copy of its point set.
+   */
+  struct IndependentChild
+  {
+    //! The position of the child in the list of children.
+    size_t index;
+    //! The point of the child.
+    size_t point;
+    //! The distance between the point of the child and the point of this node.
+    ElemType parentDistance;
+    //! The near set of the child, followed by the point of the child.
+    arma::Col<size_t> indices;
+    //! The distances to the point of the child, ordered like the indices.
+    arma::vec distances;
+    //! The child, once it is built.
+    CoverTree* node;
+  };
+
+  /**
+   * Create a node and its subtree with the given scratch space; see the public
+   * constructor with the same parameters.
+   */
+  CoverTree(const MatType& dataset,
+            const ElemType base,
+            const size_t pointIndex,
+            const int scale,
+            CoverTree* parent,
+            const ElemType parentDistance,
+            arma::Col<size_t>& indices,
+            arma::vec& distances,
+            size_t nearSetSize,
+            size_t& farSetSize,
+            size_t& usedSetSize,
+            MetricType& metric,
+            BuildScratch& scratch);
+
+  /**
+   * Create the children of the root node, from the given indices and distances
+   * of all other points.  With OpenMP, this starts a team of threads that
+   * builds independent subtrees in parallel (see CreateChildren()).
+   */
+  void CreateRootChildren(arma::Col<size_t>& indices, arma::vec& distances);
+
+  /**
+   * Create the children for this node.  With OpenMP, inside a parallel region,
+   * the subtrees of large children that are independent of the other children
+   * are built in separate tasks; the tree is the same as the serially built
+   * tree.
    */
   void CreateChildren(arma::Col<size_t>& indices,
                       arma::vec& distances,
                       size_t nearSetSize,
                       size_t& farSetSize,
-                      size_t& usedSetSize);
+                      size_t& usedSetSize,
+                      BuildScratch& scratch);
 
   /**
    * Fill the vector of distances with the distances between the point specified
@@ -506,12 +579,14 @@ class CoverTree
    * @param childFarSetSize Number of points in child far set (childFarSet).
    * @param childUsedSetSize Number of points in child used set (childUsedSet).
    * @param farSetSize Number of points in far set (farSet).
+   * @param scratch Scratch space holding the buffers for the reordering.
    */
   size_t SortPointSet(arma::Col<size_t>& indices,
                       arma::vec& distances,
                       const size_t childFarSetSize,
                       const size_t childUsedSetSize,
-                      const size_t farSetSize);
+                      const size_t farSetSize,
+                      BuildScratch& scratch);
 
   void MoveToUsedSet(arma::Col<size_t>& indices,
                      arma::vec& distances,
@@ -528,10 +603,12 @@ class CoverTree
                      const size_t pointSetSize);
 
   /**
-   * Take a look at the last child (the most recently created one) and remove
-   * any implicit nodes that have been created.
+   * Take a look at the given child (usually the most recently created one) and
+   * remove any implicit nodes that have been created.
+   *
+   * @param child Index of the child to look at.
    */
-  void RemoveNewImplicitNodes();
+  void RemoveNewImplicitNodes(const size_t child);
 
  protected:
   /**
@@ -70,10 +70,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   ComputeDistances(point, indices, distances, dataset.n_cols - 1);
 
   // Create the children.
-  size_t farSetSize = 0;
-  size_t usedSetSize = 0;
-  CreateChildren(indices, distances, dataset.n_cols - 1, farSetSize,
-      usedSetSize);
+  CreateRootChildren(indices, distances);
 
   // If we ended up creating only one child, remove the implicit node.
   while (children.size() == 1)
@@ -161,10 +158,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   ComputeDistances(point, indices, distances, dataset.n_cols - 1);
 
   // Create the children.
-  size_t farSetSize = 0;
-  size_t usedSetSize = 0;
-  CreateChildren(indices, distances, dataset.n_cols - 1, farSetSize,
-      usedSetSize);
+  CreateRootChildren(indices, distances);
 
   // If we ended up creating only one child, remove the implicit node.
   while (children.size() == 1)
@@ -254,10 +248,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   ComputeDistances(point, indices, distances, dataset->n_cols - 1);
 
   // Create the children.
-  size_t farSetSize = 0;
-  size_t usedSetSize = 0;
-  CreateChildren(indices, distances, dataset->n_cols - 1, farSetSize,
-      usedSetSize);
+  CreateRootChildren(indices, distances);
 
   // If we ended up creating only one child, remove the implicit node.
   while (children.size() == 1)
@@ -345,10 +336,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   ComputeDistances(point, indices, distances, dataset->n_cols - 1);
 
   // Create the children.
-  size_t farSetSize = 0;
-  size_t usedSetSize = 0;
-  CreateChildren(indices, distances, dataset->n_cols - 1, farSetSize,
-      usedSetSize);
+  CreateRootChildren(indices, distances);
 
   // If we ended up creating only one child, remove the implicit node.
   while (children.size() == 1)
@@ -433,7 +421,59 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
   }
 
   // Otherwise, create the children.
-  CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize);
+  BuildScratch scratch;
+  CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize,
+      scratch);
+
+  // Initialize statistic.
+  stat = StatisticType(*this);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    const MatType& dataset,
+    const ElemType base,
+    const size_t pointIndex,
+    const int scale,
+    CoverTree* parent,
+    const ElemType parentDistance,
+    arma::Col<size_t>& indices,
+    arma::vec& distances,
+    size_t nearSetSize,
+    size_t& farSetSize,
+    size_t& usedSetSize,
+    MetricType& metric,
+    BuildScratch& scratch) :
+    dataset(&dataset),
+    point(pointIndex),
+    scale(scale),
+    base(base),
+    numDescendants(0),
+    parent(parent),
+    parentDistance(parentDistance),
+    furthestDescendantDistance(0),
+    localMetric(false),
+    localDataset(false),
+    metric(&metric),
+    distanceComps(0)
+{
+  // If the size of the near set is 0, this is a leaf.
+  if (nearSetSize == 0)
+  {
+    this->scale = INT_MIN;
+    numDescendants = 1;
+    stat = StatisticType(*this);
+    return;
+  }
+
+  // Otherwise, create the children.
+  CreateChildren(indices, distances, nearSetSize, farSetSize, usedSetSize,
+      scratch);
 
   // Initialize statistic.
   stat = StatisticType(*this);
@@ -973,6 +1013,41 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
                      distance + furthestDescendantDistance);
 }
 
+//! Create the children of the root node.
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+    CreateRootChildren(arma::Col<size_t>& indices, arma::vec& distances)
+{
+  size_t farSetSize = 0;
+  size_t usedSetSize = 0;
+  BuildScratch scratch;
+
+#if defined(HAS_OPENMP) && (_OPENMP >= 201307)
+  // Start a team of threads for large datasets; the tree is built by one of
+  // them, and the others pick up the tasks for independent subtrees and for
+  // distance computations.
+  if (indices.n_elem >= 10000 && !omp_in_parallel() &&
+      omp_get_max_threads() > 1)
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      CreateChildren(indices, distances, indices.n_elem, farSetSize,
+          usedSetSize, scratch);
+    }
+    return;
+  }
+#endif
+
+  CreateChildren(indices, distances, indices.n_elem, farSetSize, usedSetSize,
+      scratch);
+}
+
 //! For a newly initialized node, create children using the near and far set.
 template<
     typename MetricType,
@@ -986,7 +1061,8 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     arma::vec& distances,
     size_t nearSetSize,
     size_t& farSetSize,
-    size_t& usedSetSize)
+    size_t& usedSetSize,
+    BuildScratch& scratch)
 {
   // Determine the next scale level.  This should be the first level where there
   // are any points in the far set.  So, if we know the maximum distance in the
@@ -1004,7 +1080,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     // This should not modify farSetSize or usedSetSize.
     size_t tempSize = 0;
     children.push_back(new CoverTree(*dataset, base, point, INT_MIN, this, 0,
-        indices, distances, 0, tempSize, usedSetSize, *metric));
+        indices, distances, 0, tempSize, usedSetSize, *metric, scratch));
     distanceComps += children.back()->DistanceComps();
 
     // Every point in the near set should be a leaf.
@@ -1013,7 +1089,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
       // farSetSize and usedSetSize will not be modified.
       children.push_back(new CoverTree(*dataset, base, indices[i],
           INT_MIN, this, distances[i], indices, distances, 0, tempSize,
-          usedSetSize, *metric));
+          usedSetSize, *metric, scratch));
       distanceComps += children.back()->DistanceComps();
       usedSetSize++;
     }
@@ -1026,7 +1102,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     // [ used | far | other used ]
     // and we want
     // [ far | all used ].
-    SortPointSet(indices, distances, 0, usedSetSize, farSetSize);
+    SortPointSet(indices, distances, 0, usedSetSize, farSetSize, scratch);
 
     return;
   }
@@ -1045,7 +1121,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
   size_t childUsedSetSize = 0;
   children.push_back(new CoverTree(*dataset, base, point, nextScale, this, 0,
       indices, distances, childNearSetSize, childFarSetSize, childUsedSetSize,
-      *metric));
+      *metric, scratch));
   // Don't double-count the self-child (so, subtract one).
   numDescendants += children[0]->NumDescendants();
 
@@ -1054,7 +1130,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
   furthestDescendantDistance = children[0]->FurthestDescendantDistance();
 
   // Remove any implicit nodes we may have created.
-  RemoveNewImplicitNodes();
+  RemoveNewImplicitNodes(0);
 
   distanceComps += children[0]->DistanceComps();
 
@@ -1066,7 +1142,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
   // [ near | far | childUsed + used ]
   // is what we are trying to make.
   SortPointSet(indices, distances, childFarSetSize, childUsedSetSize,
-      farSetSize);
+      farSetSize, scratch);
 
   // Update size of near set and used set.
   nearSetSize -= childUsedSetSize;
@@ -1076,6 +1152,10 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
   // computation later, we'll create an array holding the points in the near
   // set, and then after each run we'll check which of those (if any) were used
   // and we will remove them.  ...if that's faster.  I think it is.
+#if defined(HAS_OPENMP) && (_OPENMP >= 201307)
+  // The children whose subtrees are built in separate tasks.
+  std::deque<IndependentChild> independentChildren;
+#endif
   while (nearSetSize > 0)
   {
     size_t newPointIndex = nearSetSize - 1;
@@ -1103,7 +1183,7 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
       size_t childNearSetSize = 0;
       children.push_back(new CoverTree(*dataset, base, indices[0], nextScale,
           this, distances[0], indices, distances, childNearSetSize, farSetSize,
-          usedSetSize, *metric));
+          usedSetSize, *metric, scratch));
       distanceComps += children.back()->DistanceComps();
       numDescendants += children.back()->NumDescendants();
 
@@ -1117,11 +1197,22 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     }
 
     // Create the near and far set indices and distance vectors.  We don't fill
-    // in the self-point, yet.
-    arma::Col<size_t> childIndices(nearSetSize + farSetSize);
+    // in the self-point, yet.  The vectors are taken from the scratch space at
+    // the current depth, so they may be larger than needed.
+    if (scratch.indices.size() == scratch.depth)
+    {
+      scratch.indices.push_back(arma::Col<size_t>());
+      scratch.distances.push_back(arma::vec());
+    }
+    arma::Col<size_t>& childIndices = scratch.indices[scratch.depth];
+    arma::vec& childDistances = scratch.distances[scratch.depth];
+    if (childIndices.n_elem < nearSetSize + farSetSize)
+    {
+      childIndices.set_size(nearSetSize + farSetSize);
+      childDistances.set_size(nearSetSize + farSetSize);
+    }
     childIndices.rows(0, (nearSetSize + farSetSize - 2)) = indices.rows(1,
         nearSetSize + farSetSize - 1);
-    arma::vec childDistances(nearSetSize + farSetSize);
 
     // Build distances for the child.
     ComputeDistances(indices[0], childIndices, childDistances, nearSetSize
@@ -1141,15 +1232,55 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
     childIndices(childNearSetSize + childFarSetSize) = indices[0];
     childDistances(childNearSetSize + childFarSetSize) = 0;
 
-    // Build this child (recursively).
+#if defined(HAS_OPENMP) && (_OPENMP >= 201307)
+    // If the far set of the child is empty, the child uses exactly the points
+    // of its near set and its own point, no matter what its subtree looks
+    // like.  So we can move those points to our used set right away and build
+    // the subtree in a task while we create the other children; the tree is
+    // the same as if it were built serially.  The task gets its own copy of
+    // the point set and its own scratch space.  Small subtrees are not worth a
+    // task.
+    if (childFarSetSize == 0 && childNearSetSize >= 1000 && omp_in_parallel())
+    {
+      independentChildren.push_back(IndependentChild());
+      IndependentChild* child = &independentChildren.back();
+      child->index = children.size();
+      child->point = indices[0];
+      child->parentDistance = distances[0];
+      child->indices = childIndices.rows(0, childNearSetSize);
+      child->distances = childDistances.rows(0, childNearSetSize);
+      child->node = NULL;
+      children.push_back(NULL);
+
+      #pragma omp task firstprivate(child)
+      {
+        BuildScratch childScratch;
+        size_t taskFarSetSize = 0;
+        size_t taskUsedSetSize = 1; // Mark self point as used.
+        child->node = new CoverTree(*dataset, base, child->point, nextScale,
+            this, child->parentDistance, child->indices, child->distances,
+            child->indices.n_elem - 1, taskFarSetSize, taskUsedSetSize,
+            *metric, childScratch);
+      }
+
+      MoveToUsedSet(indices, distances, nearSetSize, farSetSize, usedSetSize,
+          childIndices, 0, childNearSetSize + 1);
+      continue;
+    }
+#endif
+
+    // Build this child (recursively).  Its point set is held at the current
+    // depth of the scratch space, so its own children use the next depth.
     childUsedSetSize = 1; // Mark self point as used.
+    ++scratch.depth;
     children.push_back(new CoverTree(*dataset, base, indices[0], nextScale,
         this, distances[0], childIndices, childDistances, childNearSetSize,
-        childFarSetSize, childUsedSetSize, *metric));
+        childFarSetSize, childUsedSetSize, *metric, scratch));
+    --scratch.depth;
     numDescendants += children.back()->NumDescendants();
 
     // Remove any implicit nodes.
-    RemoveNewImplicitNodes();
+    RemoveNewImplicitNodes(children.size() - 1);
 
     distanceComps += children.back()->DistanceComps();
 
@@ -1162,6 +1293,20 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CreateChildren(
         childIndices, childFarSetSize, childUsedSetSize);
   }
 
+#if defined(HAS_OPENMP) && (_OPENMP >= 201307)
+  // Wait for the independent children, and account for them just like for the
+  // other children.
+  #pragma omp taskwait
+  for (size_t i = 0; i < independentChildren.size(); ++i)
+  {
+    const IndependentChild& child = independentChildren[i];
+    children[child.index] = child.node;
+    numDescendants += child.node->NumDescendants();
+    RemoveNewImplicitNodes(child.index);
+    distanceComps += children[child.index]->DistanceComps();
+  }
+#endif
+
   // Calculate furthest descendant.
   for (size_t i = (nearSetSize + farSetSize); i < (nearSetSize + farSetSize +
       usedSetSize); ++i)
@@ -1242,7 +1387,40 @@ void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   // For each point, rebuild the distances.  The indices do not need to be
   // modified.
   distanceComps += pointSetSize;
+
+  // The distances are independent, so large point sets are split between
+  // threads; this does not change the tree that is built.
+#if defined(HAS_OPENMP) && (_OPENMP >= 201307)
+  // During a parallel tree build, the other threads of the team are busy with
+  // (or waiting for) tasks, so split the distances into tasks too.
+  if (pointSetSize >= 10000 && omp_in_parallel())
+  {
+    #pragma omp taskgroup
+    {
+      for (size_t begin = 0; begin < pointSetSize; begin += 5000)
+      {
+        size_t end = std::min(begin + 5000, pointSetSize);
+        #pragma omp task firstprivate(begin, end) shared(indices, distances)
+        for (size_t i = begin; i < end; ++i)
+        {
+          distances[i] = metric->Evaluate(dataset->col(pointIndex),
+              dataset->col(indices[i]));
+        }
+      }
+    }
+    return;
+  }
+#endif
+
+#ifdef _WIN32
+  // Visual Studio only implements OpenMP 2.0, which doesn't support unsigned
+  // loop variables.
+  #pragma omp parallel for if (pointSetSize >= 10000)
+  for (intmax_t i = 0; i < (intmax_t) pointSetSize; ++i)
+#else
+  #pragma omp parallel for if (pointSetSize >= 10000)
   for (size_t i = 0; i < pointSetSize; ++i)
+#endif
   {
     distances[i] = metric->Evaluate(dataset->col(pointIndex),
         dataset->col(indices[i]));
@@ -1260,11 +1438,13 @@ size_t CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
                  arma::vec& distances,
                  const size_t childFarSetSize,
                  const size_t childUsedSetSize,
-                 const size_t farSetSize)
+                 const size_t farSetSize,
+                 BuildScratch& scratch)
 {
   // We'll use low-level memcpy calls ourselves, just to ensure it's done
   // quickly and the way we want it to be.  Unfortunately this takes up more
-  // memory than one-element swaps, but there's not a great way around that.
+  // memory than one-element swaps, but there's not a great way around that;
+  // at least the buffers are reused.
   const size_t bufferSize = std::min(farSetSize, childUsedSetSize);
   const size_t bigCopySize = std::max(farSetSize, childUsedSetSize);
 
@@ -1273,8 +1453,13 @@ size_t CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   if (bufferSize == 0)
     return (childFarSetSize + farSetSize);
 
-  size_t* indicesBuffer = new size_t[bufferSize];
-  ElemType* distancesBuffer = new ElemType[bufferSize];
+  if (scratch.indicesBuffer.n_elem < bufferSize)
+  {
+    scratch.indicesBuffer.set_size(bufferSize);
+    scratch.distancesBuffer.set_size(bufferSize);
+  }
+  size_t* indicesBuffer = scratch.indicesBuffer.memptr();
+  double* distancesBuffer = scratch.distancesBuffer.memptr();
 
   // The start of the memory region to copy to the buffer.
   const size_t bufferFromLocation = ((bufferSize == farSetSize) ?
@@ -1293,22 +1478,19 @@ size_t CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   memcpy(indicesBuffer, indices.memptr() + bufferFromLocation,
       sizeof(size_t) * bufferSize);
   memcpy(distancesBuffer, distances.memptr() + bufferFromLocation,
-      sizeof(ElemType) * bufferSize);
+      sizeof(double) * bufferSize);
 
   // Now move the other memory.
   memmove(indices.memptr() + directToLocation,
       indices.memptr() + directFromLocation, sizeof(size_t) * bigCopySize);
   memmove(distances.memptr() + directToLocation,
-      distances.memptr() + directFromLocation, sizeof(ElemType) * bigCopySize);
+      distances.memptr() + directFromLocation, sizeof(double) * bigCopySize);
 
   // Now copy the temporary memory to the right place.
   memcpy(indices.memptr() + bufferToLocation, indicesBuffer,
       sizeof(size_t) * bufferSize);
   memcpy(distances.memptr() + bufferToLocation, distancesBuffer,
-      sizeof(ElemType) * bufferSize);
-
-  delete[] indicesBuffer;
-  delete[] distancesBuffer;
+      sizeof(double) * bufferSize);
 
   // This returns the complete size of the far set.
   return (childFarSetSize + farSetSize);
@@ -1503,8 +1685,8 @@ size_t CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
 }
 
 /**
- * Take a look at the last child (the most recently created one) and remove any
- * implicit nodes that have been created.
+ * Take a look at the given child (usually the most recently created one) and
+ * remove any implicit nodes that have been created.
  */
 template<
     typename MetricType,
@@ -1513,17 +1695,16 @@ template<
     typename RootPointPolicy
 >
 inline void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
-    RemoveNewImplicitNodes()
+    RemoveNewImplicitNodes(const size_t child)
 {
   // If we created an implicit node, take its self-child instead (this could
   // happen multiple times).
-  while (children[children.size() - 1]->NumChildren() == 1)
+  while (children[child]->NumChildren() == 1)
   {
-    CoverTree* old = children[children.size() - 1];
-    children.erase(children.begin() + children.size() - 1);
+    CoverTree* old = children[child];
 
     // Now take its child.
-    children.push_back(&(old->Child(0)));
+    children[child] = &(old->Child(0));
 
     // Set its parent and parameters correctly, and rebuild the statistic.
     old->Child(0).Parent() = this;
@@ -508,8 +508,13 @@ inline HRectBound<MetricType, ElemType>& HRectBound<MetricType, ElemType>::opera
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::Col<ElemType> mins(min(data, 1));
-  arma::Col<ElemType> maxs(max(data, 1));
+  // The data may hold a different element type than the bound (for instance,
+  // single-precision points in a double-precision bound).
+  typedef typename MatType::elem_type DataElemType;
+  arma::Col<ElemType> mins(arma::conv_to<arma::Col<ElemType>>::from(
+      arma::Mat<DataElemType>(min(data, 1))));
+  arma::Col<ElemType> maxs(arma::conv_to<arma::Col<ElemType>>::from(
+      arma::Mat<DataElemType>(max(data, 1))));
 
   minWidth = std::numeric_limits<ElemType>::max();
   for (size_t i = 0; i < dim; i++)
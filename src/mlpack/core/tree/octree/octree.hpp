@@ -425,6 +425,41 @@ class Octree
                  std::vector<size_t>& oldFromNew,
                  const size_t maxLeafSize);
 
+  /**
+   * Create the children of this node, once the dataset has been reordered.
+   * With OpenMP, the children of large nodes are built concurrently; this
+   * gives the same tree as the serial build.
+   *
+   * @param childBegins Index of the first point of each child (and one past
+   *     the last point of the node).
+   * @param center Center of the node.
+   * @param width Width of the current node.
+   * @param oldFromNew Mappings from old to new, or NULL if not needed.
+   * @param maxLeafSize Maximum number of points allowed in a leaf.
+   */
+  void BuildChildren(const arma::Col<size_t>& childBegins,
+                     const arma::vec& center,
+                     const double width,
+                     std::vector<size_t>* oldFromNew,
+                     const size_t maxLeafSize);
+
+  /**
+   * Create a child of this node holding the given points.
+   *
+   * @param childBegin Index of the first point of the child.
+   * @param childCount Number of points in the child.
+   * @param childCenter Center of the child.
+   * @param childWidth Width of the child.
+   * @param oldFromNew Mappings from old to new, or NULL if not needed.
+   * @param maxLeafSize Maximum number of points allowed in a leaf.
+   */
+  Octree* BuildChild(const size_t childBegin,
+                     const size_t childCount,
+                     const arma::vec& childCenter,
+                     const double childWidth,
+                     std::vector<size_t>* oldFromNew,
+                     const size_t maxLeafSize);
+
   /**
    * This is used for sorting points while splitting.
    */
@@ -780,28 +780,7 @@ void Octree<MetricType, StatisticType, MatType>::SplitNode(
   }
 
   // Now that the dataset is reordered, we can create the children.
-  arma::vec childCenter(center.n_elem);
-  const double childWidth = width / 2.0;
-  for (size_t i = 0; i < childBegins.n_elem - 1; ++i)
-  {
-    // If the child has no points, don't create it.
-    if (childBegins[i + 1] - childBegins[i] == 0)
-      continue;
-
-    // Create the correct center.
-    for (size_t d = 0; d < center.n_elem; ++d)
-    {
-      // Is the dimension "right" (1) or "left" (0)?
-      if (((i >> d) & 1) == 0)
-        childCenter[d] = center[d] - childWidth;
-      else
-        childCenter[d] = center[d] + childWidth;
-    }
-
-    children.push_back(new Octree(this, childBegins[i],
-        childBegins[i + 1] - childBegins[i], childCenter, childWidth,
-        maxLeafSize));
-  }
+  BuildChildren(childBegins, center, width, NULL, maxLeafSize);
 }
 
 //! Split the node, and store mappings.
@@ -882,30 +861,101 @@ void Octree<MetricType, StatisticType, MatType>::SplitNode(
   }
 
   // Now that the dataset is reordered, we can create the children.
-  arma::vec childCenter(center.n_elem);
-  const double childWidth = width / 2.0;
+  BuildChildren(childBegins, center, width, &oldFromNew, maxLeafSize);
+}
+
+//! Create the children of the node.
+template<typename MetricType, typename StatisticType, typename MatType>
+void Octree<MetricType, StatisticType, MatType>::BuildChildren(
+    const arma::Col<size_t>& childBegins,
+    const arma::vec& center,
+    const double width,
+    std::vector<size_t>* oldFromNew,
+    const size_t maxLeafSize)
+{
+  // Compute the center of each child that has points; children with no points
+  // are not created.
+  std::vector<size_t> childIndices;
   for (size_t i = 0; i < childBegins.n_elem - 1; ++i)
-  {
-    // If the child has no points, don't create it.
-    if (childBegins[i + 1] - childBegins[i] == 0)
-      continue;
+    if (childBegins[i + 1] - childBegins[i] > 0)
+      childIndices.push_back(i);
 
+  const double childWidth = width / 2.0;
+  std::vector<arma::vec> childCenters(childIndices.size(),
+      arma::vec(center.n_elem));
+  for (size_t c = 0; c < childIndices.size(); ++c)
+  {
     // Create the correct center.
     for (size_t d = 0; d < center.n_elem; ++d)
     {
       // Is the dimension "right" (1) or "left" (0)?
-      if (((i >> d) & 1) == 0)
-        childCenter[d] = center[d] - childWidth;
+      if (((childIndices[c] >> d) & 1) == 0)
+        childCenters[c][d] = center[d] - childWidth;
       else
-        childCenter[d] = center[d] + childWidth;
+        childCenters[c][d] = center[d] + childWidth;
+    }
+  }
+
+  children.resize(childIndices.size(), NULL);
+
+#if defined(HAS_OPENMP) && (_OPENMP >= 200805)
+  // The children work on disjoint parts of the dataset (and of oldFromNew), so
+  // the children of large nodes can be built as concurrent tasks; the tree is
+  // the same as the serially built tree.
+  if (count >= 10000 && (omp_in_parallel() || omp_get_max_threads() > 1))
+  {
+    if (!omp_in_parallel())
+    {
+      // Start a team of threads; this node is built by one of them, and the
+      // others pick up the tasks for the children.
+      children.clear();
+      #pragma omp parallel
+      {
+        #pragma omp single
+        BuildChildren(childBegins, center, width, oldFromNew, maxLeafSize);
+      }
+      return;
+    }
+
+    for (size_t c = 0; c < childIndices.size(); ++c)
+    {
+      #pragma omp task default(shared) firstprivate(c)
+      children[c] = BuildChild(childBegins[childIndices[c]],
+          childBegins[childIndices[c] + 1] - childBegins[childIndices[c]],
+          childCenters[c], childWidth, oldFromNew, maxLeafSize);
     }
+    #pragma omp taskwait
+    return;
+  }
+#endif
 
-    children.push_back(new Octree(this, childBegins[i],
-        childBegins[i + 1] - childBegins[i], oldFromNew, childCenter,
-        childWidth, maxLeafSize));
+  for (size_t c = 0; c < childIndices.size(); ++c)
+  {
+    children[c] = BuildChild(childBegins[childIndices[c]],
+        childBegins[childIndices[c] + 1] - childBegins[childIndices[c]],
+        childCenters[c], childWidth, oldFromNew, maxLeafSize);
   }
 }
 
+//! Create a child of the node.
+template<typename MetricType, typename StatisticType, typename MatType>
+Octree<MetricType, StatisticType, MatType>*
+Octree<MetricType, StatisticType, MatType>::BuildChild(
+    const size_t childBegin,
+    const size_t childCount,
+    const arma::vec& childCenter,
+    const double childWidth,
+    std::vector<size_t>* oldFromNew,
+    const size_t maxLeafSize)
+{
+  if (oldFromNew)
+    return new Octree(this, childBegin, childCount, *oldFromNew, childCenter,
+        childWidth, maxLeafSize);
+  else
+    return new Octree(this, childBegin, childCount, childCenter, childWidth,
+        maxLeafSize);
+}
+
 } // namespace tree
 } // namespace mlpack
 
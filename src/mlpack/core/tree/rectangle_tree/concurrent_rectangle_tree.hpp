@@ -0,0 +1,177 @@
+/**
+ * @file concurrent_rectangle_tree.hpp
+ *
+ * Definition of the ConcurrentRectangleTree class, which lets queries run on a
+ * RectangleTree while a writer inserts and deletes points.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_RECTANGLE_TREE_CONCURRENT_RECTANGLE_TREE_HPP
+#define MLPACK_CORE_TREE_RECTANGLE_TREE_CONCURRENT_RECTANGLE_TREE_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The ConcurrentRectangleTree class wraps a RectangleTree (or any other tree
+ * that supports InsertPoint() and DeletePoint()) so that any number of readers
+ * can query the tree while a single writer inserts and deletes points, without
+ * the readers ever waiting for the writer.
+ *
+ * Two copies of the tree are kept (this is the "left-right" technique).
+ * Readers always use the published copy.  The writer applies an update to the
+ * other copy, publishes it, waits until the readers of the previously published
+ * copy are done, and then applies the same update to that copy too.  A reader
+ * pins the copy it uses with a Reader object, and the copy does not change (and
+ * neither does its dataset) for as long as the Reader exists.  Queries thus
+ * run at full speed during writes; the price is twice the memory and twice the
+ * work for each update.
+ *
+ * Updates should be batched when possible, since each update waits for the
+ * readers of the previously published copy once.
+ *
+ * @code
+ * ConcurrentRectangleTree<RStarTree<>> tree(RStarTree<>(dataset));
+ *
+ * // In a reader thread:
+ * {
+ *   ConcurrentRectangleTree<RStarTree<>>::Reader reader = tree.Read();
+ *   RuleType rules(reader.Tree().Dataset(), querySet, k, metric);
+ *   RStarTree<>::SingleTreeTraverser<RuleType> traverser(rules);
+ *   for (size_t i = 0; i < querySet.n_cols; ++i)
+ *     traverser.Traverse(i, reader.Tree());
+ * }
+ *
+ * // In the writer thread:
+ * const size_t firstIndex = tree.Insert(newPoints);
+ * tree.Delete(oldIndices);
+ * @endcode
+ *
+ * @tparam TreeType The type of tree.
+ */
+template<typename TreeType>
+class ConcurrentRectangleTree
+{
+ public:
+  //! The type of the dataset held by the tree.
+  typedef typename TreeType::Mat MatType;
+
+  /**
+   * A Reader pins the copy of the tree that is published when it is created;
+   * the copy is not modified until the Reader is destroyed.  Readers should be
+   * short-lived, because the writer waits for them.  A thread must not hold a
+   * Reader while it inserts or deletes points.
+   */
+  class Reader
+  {
+   public:
+    //! Move the pin from another Reader.
+    Reader(Reader&& other);
+
+    //! Release the pinned copy of the tree.
+    ~Reader();
+
+    //! Get the pinned copy of the tree.
+    const TreeType& Tree() const { return *tree; }
+
+   private:
+    //! Pin the published copy of the tree of the given object.
+    Reader(const ConcurrentRectangleTree& owner);
+
+    Reader(const Reader& other) = delete;
+    Reader& operator=(const Reader& other) = delete;
+
+    //! The reader count of the pinned copy.
+    std::atomic<size_t>* readers;
+    //! The pinned copy.
+    const TreeType* tree;
+
+    friend class ConcurrentRectangleTree;
+  };
+
+  /**
+   * Take ownership of the given tree, and make the second copy of it.
+   *
+   * @param tree The tree to use.
+   */
+  ConcurrentRectangleTree(TreeType&& tree);
+
+  /**
+   * Copy the given tree twice.
+   *
+   * @param tree The tree to use.
+   */
+  ConcurrentRectangleTree(const TreeType& tree);
+
+  /**
+   * Delete both copies of the tree.  There must not be any Reader left.
+   */
+  ~ConcurrentRectangleTree();
+
+  /**
+   * Pin the published copy of the tree, for querying.  This never waits for
+   * the writer.
+   */
+  Reader Read() const { return Reader(*this); }
+
+  /**
+   * Append the given points to the dataset and insert them into the tree.
+   * Only one thread may insert or delete points at a time; other calls wait.
+   *
+   * @param points The points to insert.
+   * @return The index of the first inserted point in the dataset.
+   */
+  size_t Insert(const MatType& points);
+
+  /**
+   * Delete the given points from the tree.  The points stay in the dataset, so
+   * the indices of the other points do not change.  Only one thread may insert
+   * or delete points at a time; other calls wait.
+   *
+   * @param indices The indices of the points to delete.
+   * @return The number of points that were found and deleted.
+   */
+  size_t Delete(const arma::Col<size_t>& indices);
+
+ private:
+  /**
+   * Apply an update to both copies of the tree, one at a time, so that readers
+   * always find an unmodified copy.
+   *
+   * @param update The update to apply to each copy.
+   */
+  template<typename UpdateType>
+  void Update(UpdateType update);
+
+  //! Wait until no reader uses the given copy of the tree.
+  void WaitForReaders(const size_t copy) const;
+
+  //! The two copies of the tree.
+  TreeType* trees[2];
+  //! The copy that new readers use.
+  mutable std::atomic<size_t> published;
+  //! The number of readers of each copy.
+  mutable std::atomic<size_t> readers[2];
+  //! Held by the writer.
+  std::mutex writerMutex;
+
+  ConcurrentRectangleTree(const ConcurrentRectangleTree& other) = delete;
+  ConcurrentRectangleTree& operator=(const ConcurrentRectangleTree& other) =
+      delete;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "concurrent_rectangle_tree_impl.hpp"
+
+#endif
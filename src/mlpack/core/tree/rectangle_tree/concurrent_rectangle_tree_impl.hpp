@@ -0,0 +1,158 @@
+/**
+ * @file concurrent_rectangle_tree_impl.hpp
+ *
+ * Implementation of the ConcurrentRectangleTree class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_RECTANGLE_TREE_CONCURRENT_RECTANGLE_TREE_IMPL_HPP
+#define MLPACK_CORE_TREE_RECTANGLE_TREE_CONCURRENT_RECTANGLE_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "concurrent_rectangle_tree.hpp"
+
+#include <thread>
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::Reader::Reader(
+    const ConcurrentRectangleTree& owner)
+{
+  // Announce the reader on the published copy, and make sure that the copy was
+  // still published afterwards.  If it was not, the writer may already have
+  // started to modify it, so try again.
+  while (true)
+  {
+    const size_t copy = owner.published.load();
+    owner.readers[copy]++;
+    if (owner.published.load() == copy)
+    {
+      readers = &owner.readers[copy];
+      tree = owner.trees[copy];
+      return;
+    }
+
+    owner.readers[copy]--;
+  }
+}
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::Reader::Reader(Reader&& other) :
+    readers(other.readers),
+    tree(other.tree)
+{
+  other.readers = NULL;
+  other.tree = NULL;
+}
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::Reader::~Reader()
+{
+  if (readers)
+    (*readers)--;
+}
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::ConcurrentRectangleTree(TreeType&& tree) :
+    published(0)
+{
+  trees[0] = new TreeType(std::move(tree));
+  trees[1] = new TreeType(*trees[0]);
+  readers[0] = 0;
+  readers[1] = 0;
+}
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::ConcurrentRectangleTree(
+    const TreeType& tree) :
+    published(0)
+{
+  trees[0] = new TreeType(tree);
+  trees[1] = new TreeType(tree);
+  readers[0] = 0;
+  readers[1] = 0;
+}
+
+template<typename TreeType>
+ConcurrentRectangleTree<TreeType>::~ConcurrentRectangleTree()
+{
+  delete trees[0];
+  delete trees[1];
+}
+
+template<typename TreeType>
+size_t ConcurrentRectangleTree<TreeType>::Insert(const MatType& points)
+{
+  if (points.n_rows != trees[0]->Dataset().n_rows)
+  {
+    std::ostringstream oss;
+    oss << "ConcurrentRectangleTree::Insert(): dimensionality of points ("
+        << points.n_rows << ") is not equal to the dimensionality of the tree ("
+        << trees[0]->Dataset().n_rows << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  size_t firstIndex = 0;
+  Update([&points, &firstIndex](TreeType& tree)
+      {
+        // Each copy has its own dataset, so resizing it is safe too.
+        firstIndex = tree.Dataset().n_cols;
+        tree.Dataset().insert_cols(firstIndex, points);
+        for (size_t i = 0; i < points.n_cols; ++i)
+          tree.InsertPoint(firstIndex + i);
+      });
+
+  return firstIndex;
+}
+
+template<typename TreeType>
+size_t ConcurrentRectangleTree<TreeType>::Delete(
+    const arma::Col<size_t>& indices)
+{
+  size_t numDeleted = 0;
+  Update([&indices, &numDeleted](TreeType& tree)
+      {
+        numDeleted = 0;
+        for (size_t i = 0; i < indices.n_elem; ++i)
+          if (tree.DeletePoint(indices[i]))
+            ++numDeleted;
+      });
+
+  return numDeleted;
+}
+
+template<typename TreeType>
+template<typename UpdateType>
+void ConcurrentRectangleTree<TreeType>::Update(UpdateType update)
+{
+  std::lock_guard<std::mutex> lock(writerMutex);
+
+  // New readers can't pin the unpublished copy, but readers that pinned it
+  // before the last update was published may still be using it.
+  const size_t copy = 1 - published.load();
+  WaitForReaders(copy);
+  update(*trees[copy]);
+
+  // Publish the updated copy, then bring the other copy up to date once its
+  // readers are done.
+  published.store(copy);
+  WaitForReaders(1 - copy);
+  update(*trees[1 - copy]);
+}
+
+template<typename TreeType>
+void ConcurrentRectangleTree<TreeType>::WaitForReaders(const size_t copy) const
+{
+  while (readers[copy].load() != 0)
+    std::this_thread::yield();
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -197,6 +197,27 @@ class DiscreteHilbertValue
   template<typename TreeType>
   void UpdateLargestValue(TreeType* node);
 
+  /**
+   * Set up the Hilbert values of a node of a bulk-loaded tree.  If the node is
+   * a leaf, the Hilbert values of its points are computed and stored in the
+   * local dataset (which the node then owns); otherwise the largest Hilbert
+   * value is taken from the last child.
+   *
+   * @param node The node that has been bulk-loaded.
+   */
+  template<typename TreeType>
+  void UpdateBulkLoadedValues(TreeType* node);
+
+  /**
+   * Sort the given points by their Hilbert values.  The Hilbert value of each
+   * point is only computed once.
+   *
+   * @param dataset The dataset that holds the points.
+   * @param points The indices of the points to sort.
+   */
+  template<typename MatType>
+  static void SortPoints(const MatType& dataset, std::vector<size_t>& points);
+
   /**
    * This method updates the largest Hilbert value of a leaf node and
    * redistributes the Hilbert values of points according to their new position
@@ -50,7 +50,8 @@ DiscreteHilbertValue<TreeElemType>::DiscreteHilbertValue(const TreeType* tree) :
   // Calculate the Hilbert value for all points.
   if (!tree->Parent()) // This is the root node.
     ownsLocalHilbertValues = true;
-  else if (tree->Parent()->Child(0).IsLeaf())
+  else if (tree->Parent()->NumChildren() > 0 &&
+           tree->Parent()->Child(0).IsLeaf())
   {
     // This is a leaf node.
     assert(tree->Parent()->NumChildren() > 0);
@@ -465,6 +466,55 @@ void DiscreteHilbertValue<TreeElemType>::UpdateLargestValue(TreeType* node)
   }
 }
 
+template<typename TreeElemType>
+template<typename TreeType>
+void DiscreteHilbertValue<TreeElemType>::UpdateBulkLoadedValues(TreeType* node)
+{
+  // While the tree is bulk-loaded, nodes are created before it is known
+  // whether they will be leaves, so fix the ownership of the local dataset.
+  if (node->IsLeaf())
+  {
+    if (!ownsLocalHilbertValues)
+    {
+      localHilbertValues = new arma::Mat<HilbertElemType>(
+          node->Dataset().n_rows, node->MaxLeafSize() + 1);
+      ownsLocalHilbertValues = true;
+    }
+
+    for (size_t i = 0; i < node->NumPoints(); i++)
+      localHilbertValues->col(i) =
+          CalculateValue(node->Dataset().col(node->Point(i)));
+    numValues = node->NumPoints();
+  }
+  else
+  {
+    if (ownsLocalHilbertValues)
+    {
+      delete localHilbertValues;
+      ownsLocalHilbertValues = false;
+    }
+
+    UpdateLargestValue(node);
+  }
+}
+
+template<typename TreeElemType>
+template<typename MatType>
+void DiscreteHilbertValue<TreeElemType>::SortPoints(
+    const MatType& dataset,
+    std::vector<size_t>& points)
+{
+  arma::Mat<HilbertElemType> values(dataset.n_rows, dataset.n_cols);
+  for (size_t i = 0; i < points.size(); i++)
+    values.col(points[i]) = CalculateValue(dataset.col(points[i]));
+
+  std::stable_sort(points.begin(), points.end(),
+      [&values](const size_t a, const size_t b)
+      {
+        return CompareValues(values.unsafe_col(a), values.unsafe_col(b)) < 0;
+      });
+}
+
 template<typename TreeElemType>
 template<typename TreeType>
 void DiscreteHilbertValue<TreeElemType>::RedistributeHilbertValues(
@@ -109,6 +109,29 @@ class HilbertRTreeAuxiliaryInformation
    */
   bool HandleNodeRemoval(TreeType* node, const size_t nodeIndex);
 
+  /**
+   * The Hilbert R tree is bulk-loaded by sorting the points by their Hilbert
+   * values, so that the points in each node and the children of each node are
+   * arranged according to their Hilbert values.  This method sorts the points
+   * and returns true.
+   *
+   * @param node The root node that is being bulk-loaded.
+   * @param points The indices of all the points in the dataset.
+   */
+  bool HandleBulkLoadOrder(TreeType* node, std::vector<size_t>& points);
+
+  /**
+   * Compute the Hilbert values of the points of a bulk-loaded leaf, or the
+   * largest Hilbert value of a bulk-loaded intermediate node.
+   *
+   * @param node The node that has been bulk-loaded.
+   * @param region The region of space that was assigned to the node (not used
+   *     here).
+   */
+  void HandleBulkLoad(TreeType* node,
+                      const bound::HRectBound<metric::EuclideanDistance,
+                          ElemType>& /* region */);
+
   /**
    * Update the auxiliary information in the node. The method returns true if
    * the update should be propagated downward.
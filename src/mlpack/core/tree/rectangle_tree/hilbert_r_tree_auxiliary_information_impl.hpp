@@ -150,6 +150,25 @@ HandleNodeRemoval(TreeType* node, const size_t nodeIndex)
   return true;
 }
 
+template<typename TreeType,
+         template<typename> class HilbertValueType>
+bool HilbertRTreeAuxiliaryInformation<TreeType, HilbertValueType>::
+HandleBulkLoadOrder(TreeType* node, std::vector<size_t>& points)
+{
+  HilbertValueType<ElemType>::SortPoints(node->Dataset(), points);
+  return true;
+}
+
+template<typename TreeType,
+         template<typename> class HilbertValueType>
+void HilbertRTreeAuxiliaryInformation<TreeType, HilbertValueType>::
+HandleBulkLoad(TreeType* node,
+               const bound::HRectBound<metric::EuclideanDistance,
+                                       ElemType>& /* region */)
+{
+  hilbertValue.UpdateBulkLoadedValues(node);
+}
+
 template<typename TreeType,
          template<typename> class HilbertValueType>
 bool HilbertRTreeAuxiliaryInformation<TreeType, HilbertValueType>::
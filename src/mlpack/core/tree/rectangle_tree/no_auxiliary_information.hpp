@@ -101,6 +101,35 @@ class NoAuxiliaryInformation
     return false;
   }
 
+  /**
+   * Some tree types require the points to be bulk-loaded in a particular
+   * order.  If the auxiliary information sorts the points, the method should
+   * return true and the points are packed into the nodes in that order; if the
+   * method returns false the RectangleTree tiles the points with
+   * Sort-Tile-Recursive.
+   *
+   * @param node The root node that is being bulk-loaded.
+   * @param points The indices of all the points in the dataset.
+   */
+  bool HandleBulkLoadOrder(TreeType* /* node */,
+                           std::vector<size_t>& /* points */)
+  {
+    return false;
+  }
+
+  /**
+   * Some tree types require to set up the auxiliary information of the nodes of
+   * a bulk-loaded tree.  This method is called for each node once its points
+   * or children are in place, from the leaves up.
+   *
+   * @param node The node that has been bulk-loaded.
+   * @param region The region of space that was assigned to the node.
+   */
+  void HandleBulkLoad(TreeType* /* node */,
+                      const bound::HRectBound<metric::EuclideanDistance,
+                          typename TreeType::ElemType>& /* region */)
+  { }
+
   /**
    * Some tree types require to propagate the information upward.
    * This method should return false if this is not the case. If true is
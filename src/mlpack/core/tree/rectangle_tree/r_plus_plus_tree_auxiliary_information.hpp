@@ -114,6 +114,26 @@ class RPlusPlusTreeAuxiliaryInformation
   bool HandleNodeRemoval(TreeType* /* node */, const size_t /* nodeIndex */);
 
 
+  /**
+   * The R++ tree is bulk-loaded with Sort-Tile-Recursive, so this method does
+   * nothing and returns false.
+   *
+   * @param node The root node that is being bulk-loaded.
+   * @param points The indices of all the points in the dataset.
+   */
+  bool HandleBulkLoadOrder(TreeType* /* node */,
+                           std::vector<size_t>& /* points */);
+
+  /**
+   * Set the maximum bounding rectangle of a bulk-loaded node to the tile that
+   * was assigned to it.  The tiles of the children of a node partition the
+   * tile of the node.
+   *
+   * @param node The node that has been bulk-loaded.
+   * @param region The region of space that was assigned to the node.
+   */
+  void HandleBulkLoad(TreeType* /* node */, const BoundType& region);
+
   /**
    * Some tree types require to propagate the information upward.
    * This method should return false if this is not the case. If true is
@@ -24,11 +24,19 @@
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
 
+/**
+ * Pass an object of this type to the RectangleTree constructor to bulk-load the
+ * tree from the dataset, instead of inserting the points one at a time.
+ */
+struct BulkLoad { };
+
 /**
  * A rectangle type tree tree, such as an R-tree or X-tree.  Once the
  * bound and type of dataset is defined, the tree will construct itself.  Call
  * the constructor with the dataset to build the tree on, and the entire tree
- * will be built.
+ * will be built.  If the BulkLoad constructor is used, the tree is packed from
+ * the whole dataset at once; this is much faster than inserting the points one
+ * at a time, and the nodes are almost completely full.
  *
  * This tree does allow growth, so you can add and delete nodes from it.
  *
@@ -155,6 +163,55 @@ class RectangleTree
                 const size_t minNumChildren = 2,
                 const size_t firstDataIndex = 0);
 
+  /**
+   * Construct this as the root node of a rectangle type tree by bulk-loading
+   * the given dataset.  The points are split top-down into nodes that are as
+   * full as possible: for the Hilbert R tree the points are sorted by their
+   * Hilbert values and cut into consecutive runs, and for the other trees the
+   * points are partitioned with Sort-Tile-Recursive (STR), cutting the points
+   * of each node into slabs along the dimension in which they are most spread
+   * out.  The STR tiles do not overlap, so this can also be used for the R+
+   * and R++ trees.  Points can be inserted and deleted afterwards as usual.
+   *
+   * All the leaves are at the same depth, and the fill requirements are met as
+   * long as minLeafSize <= maxLeafSize / 2 and minNumChildren <= maxNumChildren
+   * / 2.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(const MatType& data,
+                const BulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
+  /**
+   * Construct this as the root node of a rectangle type tree by bulk-loading
+   * the given dataset, and taking ownership of the given dataset.  See the
+   * other BulkLoad constructor for details.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(MatType&& data,
+                const BulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
   /**
    * Construct this as an empty node with the specified parent.  Copying the
    * parameters (maxLeafSize, minLeafSize, maxNumChildren, minNumChildren,
@@ -541,6 +598,53 @@ class RectangleTree
    */
   void SplitNode(std::vector<bool>& relevels);
 
+  /**
+   * Bulk-load all of the points of the dataset into this (empty) root node.
+   */
+  void PackPoints();
+
+  /**
+   * Build this node (and its descendants) from the given range of points.  The
+   * points in the range are reordered.
+   *
+   * @param indices The indices of the points.
+   * @param first The first point of the range.
+   * @param numPoints The number of points in the range.
+   * @param height The number of levels below this node.
+   * @param ordered If true, the points are already in the order in which they
+   *     should be packed; otherwise they are tiled with STR.
+   * @param region The region of space assigned to this node.
+   */
+  void PackNode(std::vector<size_t>& indices,
+                const size_t first,
+                const size_t numPoints,
+                const size_t height,
+                const bool ordered,
+                const bound::HRectBound<metric::EuclideanDistance,
+                                        ElemType>& region);
+
+  /**
+   * Reorder the given range of points so that the given groups of consecutive
+   * points are Sort-Tile-Recursive tiles, and shrink the region of each group
+   * to its tile.
+   *
+   * @param indices The indices of the points.
+   * @param first The first point of the range.
+   * @param sizes The sizes of all the groups.
+   * @param firstGroup The first group of the range.
+   * @param lastGroup One past the last group of the range.
+   * @param numCuts The number of times the range has already been cut.
+   * @param regions The regions of all the groups.
+   */
+  void TilePoints(std::vector<size_t>& indices,
+                  const size_t first,
+                  const std::vector<size_t>& sizes,
+                  const size_t firstGroup,
+                  const size_t lastGroup,
+                  const size_t numCuts,
+                  std::vector<bound::HRectBound<metric::EuclideanDistance,
+                                                ElemType>>& regions);
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
@@ -101,6 +101,74 @@ RectangleTree(MatType&& data,
     root->InsertPoint(i);
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType,
+         template<typename> class AuxiliaryInformationType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
+              AuxiliaryInformationType>::
+RectangleTree(const MatType& data,
+              const BulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    numDescendants(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    parentDistance(0),
+    dataset(new MatType(data)),
+    ownsDataset(true),
+    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
+    auxiliaryInfo(this)
+{
+  PackPoints();
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType,
+         template<typename> class AuxiliaryInformationType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
+              AuxiliaryInformationType>::
+RectangleTree(MatType&& data,
+              const BulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    numDescendants(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    parentDistance(0),
+    dataset(new MatType(std::move(data))),
+    ownsDataset(true),
+    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
+    auxiliaryInfo(this)
+{
+  PackPoints();
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -898,6 +966,219 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
   }
 }
 
+/**
+ * Bulk-load the whole dataset into this root node.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType,
+         template<typename> class AuxiliaryInformationType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
+                   AuxiliaryInformationType>::
+    PackPoints()
+{
+  if (maxLeafSize == 0 || maxNumChildren < 2)
+  {
+    std::ostringstream oss;
+    oss << "RectangleTree::RectangleTree(): cannot bulk-load a tree with a "
+        << "maximum leaf size of " << maxLeafSize << " and a maximum number of "
+        << "children of " << maxNumChildren << "!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  std::vector<size_t> indices(dataset->n_cols);
+  for (size_t i = 0; i < indices.size(); i++)
+    indices[i] = i;
+
+  // Find the smallest height at which completely full nodes can hold all of
+  // the points.
+  size_t height = 0;
+  size_t capacity = maxLeafSize;
+  while (capacity < indices.size())
+  {
+    capacity *= maxNumChildren;
+    height++;
+  }
+
+  // Some trees (e.g. the Hilbert R tree) need the points to be in a particular
+  // order; the others are tiled with STR while they are packed.
+  const bool ordered = auxiliaryInfo.HandleBulkLoadOrder(this, indices);
+
+  // The root is responsible for all of space.
+  bound::HRectBound<metric::EuclideanDistance, ElemType> region(bound.Dim());
+  for (size_t k = 0; k < region.Dim(); k++)
+  {
+    region[k].Lo() = std::numeric_limits<ElemType>::lowest();
+    region[k].Hi() = std::numeric_limits<ElemType>::max();
+  }
+
+  PackNode(indices, 0, indices.size(), height, ordered, region);
+}
+
+/**
+ * Build this node and its descendants from a range of points.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType,
+         template<typename> class AuxiliaryInformationType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
+                   AuxiliaryInformationType>::
+    PackNode(std::vector<size_t>& indices,
+             const size_t first,
+             const size_t numPoints,
+             const size_t height,
+             const bool ordered,
+             const bound::HRectBound<metric::EuclideanDistance,
+                                     ElemType>& region)
+{
+  if (height == 0)
+  {
+    // This is a leaf, so it simply holds the points.
+    for (size_t i = 0; i < numPoints; i++)
+    {
+      points[i] = indices[first + i];
+      bound |= dataset->col(points[i]);
+    }
+
+    count = numPoints;
+    numDescendants = numPoints;
+  }
+  else
+  {
+    // Every child gets as many points as a full subtree holds, except for the
+    // last two, which share the remaining points evenly so that neither of
+    // them ends up less than half full.
+    size_t capacity = maxLeafSize;
+    for (size_t i = 1; i < height; i++)
+      capacity *= maxNumChildren;
+
+    const size_t numGroups = std::max((numPoints + capacity - 1) / capacity,
+        (size_t) 1);
+    std::vector<size_t> sizes(numGroups, capacity);
+    if (numGroups == 1)
+    {
+      sizes[0] = numPoints;
+    }
+    else
+    {
+      const size_t rest = numPoints - (numGroups - 2) * capacity;
+      sizes[numGroups - 2] = rest - rest / 2;
+      sizes[numGroups - 1] = rest / 2;
+    }
+
+    std::vector<bound::HRectBound<metric::EuclideanDistance, ElemType>>
+        regions(numGroups, region);
+    if (!ordered)
+      TilePoints(indices, first, sizes, 0, numGroups, 0, regions);
+
+    size_t childFirst = first;
+    for (size_t i = 0; i < numGroups; i++)
+    {
+      RectangleTree* child = new RectangleTree(this);
+      children[numChildren++] = child;
+      child->PackNode(indices, childFirst, sizes[i], height - 1, ordered,
+          regions[i]);
+
+      bound |= child->Bound();
+      numDescendants += child->NumDescendants();
+      childFirst += sizes[i];
+    }
+  }
+
+  auxiliaryInfo.HandleBulkLoad(this, region);
+
+  // The statistic can only be computed once the node is complete.
+  stat = StatisticType(*this);
+}
+
+/**
+ * Tile a range of points with Sort-Tile-Recursive.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType,
+         template<typename> class AuxiliaryInformationType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType,
+                   AuxiliaryInformationType>::
+    TilePoints(std::vector<size_t>& indices,
+               const size_t first,
+               const std::vector<size_t>& sizes,
+               const size_t firstGroup,
+               const size_t lastGroup,
+               const size_t numCuts,
+               std::vector<bound::HRectBound<metric::EuclideanDistance,
+                                             ElemType>>& regions)
+{
+  const size_t numGroups = lastGroup - firstGroup;
+  if (numGroups <= 1)
+    return;
+
+  size_t numPoints = 0;
+  for (size_t i = firstGroup; i < lastGroup; i++)
+    numPoints += sizes[i];
+
+  // Cut along the dimension in which the points are most spread out.
+  bound::HRectBound<metric::EuclideanDistance, ElemType> pointBound(
+      dataset->n_rows);
+  for (size_t i = first; i < first + numPoints; i++)
+    pointBound |= dataset->col(indices[i]);
+
+  size_t dim = 0;
+  for (size_t k = 1; k < pointBound.Dim(); k++)
+    if (pointBound[k].Width() > pointBound[dim].Width())
+      dim = k;
+
+  // As in STR, the number of slabs is chosen so that the groups would be
+  // tiled evenly if each of the remaining dimensions were cut once; each slab
+  // holds a whole number of groups.
+  const size_t remainingDims = (numCuts + 1 < dataset->n_rows) ?
+      dataset->n_rows - numCuts : 1;
+  const size_t numSlabs = std::min((size_t) std::ceil(std::pow(
+      (double) numGroups, 1.0 / remainingDims)), numGroups);
+  const size_t groupsPerSlab = (numGroups + numSlabs - 1) / numSlabs;
+
+  const MatType& data = *dataset;
+  size_t slabFirst = first;
+  for (size_t g = firstGroup; g < lastGroup; g += groupsPerSlab)
+  {
+    const size_t slabLastGroup = std::min(g + groupsPerSlab, lastGroup);
+    size_t slabSize = 0;
+    for (size_t i = g; i < slabLastGroup; i++)
+      slabSize += sizes[i];
+
+    if (slabLastGroup < lastGroup)
+    {
+      // Move the points of this slab to the front of what is left.
+      std::nth_element(indices.begin() + slabFirst,
+          indices.begin() + slabFirst + slabSize,
+          indices.begin() + first + numPoints,
+          [&data, dim](const size_t a, const size_t b)
+          {
+            return data(dim, a) < data(dim, b);
+          });
+
+      // The cut lies on the smallest coordinate of the next slab, so the
+      // regions of the slabs only touch.
+      const ElemType cut = data(dim, indices[slabFirst + slabSize]);
+      for (size_t i = g; i < slabLastGroup; i++)
+        regions[i][dim].Hi() = cut;
+      for (size_t i = slabLastGroup; i < lastGroup; i++)
+        regions[i][dim].Lo() = cut;
+    }
+
+    TilePoints(indices, slabFirst, sizes, g, slabLastGroup, numCuts + 1,
+        regions);
+    slabFirst += slabSize;
+  }
+}
+
 //! Default constructor for boost::serialization.
 template<typename MetricType,
          typename StatisticType,
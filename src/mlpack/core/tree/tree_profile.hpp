@@ -0,0 +1,234 @@
+/**
+ * @file tree_profile.hpp
+ *
+ * Utilities that record profiling counters (see Counter) for tree building and
+ * tree traversals.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_TREE_TREE_PROFILE_HPP
+#define MLPACK_CORE_TREE_TREE_PROFILE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/counters.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+#include <chrono>
+#include <queue>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * TraversalProfile collects the profiling counters of one traverser: the number
+ * of node combinations visited and pruned at each recursion depth of the
+ * traversal, how many calls to Rescore() actually pruned something, and the
+ * time spent in base cases.  The counts are kept locally and added to the
+ * global counters when the TraversalProfile is destroyed, so a traverser only
+ * pays for a check of Enabled() when counters are disabled.
+ *
+ * The counters are named "<name>_visits", "<name>_prunes" (both indexed by
+ * depth, where the root combination has depth 0), "<name>_rescores",
+ * "<name>_rescore_prunes" and "<name>_base_case_time" (in seconds).
+ */
+class TraversalProfile
+{
+ public:
+  /**
+   * Create the TraversalProfile.  It records counters only if Counter::Enabled()
+   * is true when it is created.
+   *
+   * @param name Prefix of the names of the counters.
+   */
+  TraversalProfile(const std::string& name) :
+      name(name),
+      enabled(Counter::Enabled()),
+      rescores(0.0),
+      rescorePrunes(0.0),
+      baseCaseTime(0.0)
+  { }
+
+  //! Add the collected counts to the global counters.
+  ~TraversalProfile()
+  {
+    if (!enabled)
+      return;
+
+    Counter::Add(name + "_visits", visits);
+    Counter::Add(name + "_prunes", prunes);
+    Counter::Add(name + "_rescores", rescores);
+    Counter::Add(name + "_rescore_prunes", rescorePrunes);
+    Counter::Add(name + "_base_case_time", baseCaseTime);
+  }
+
+  //! Return whether or not counts are being recorded.
+  bool Enabled() const { return enabled; }
+
+  //! Record a visit of a node combination at the given depth.
+  void Visit(const size_t depth)
+  {
+    if (enabled)
+      Increment(visits, depth, 1);
+  }
+
+  //! Record the given number of pruned node combinations at the given depth.
+  void Prune(const size_t depth, const size_t count)
+  {
+    if (enabled)
+      Increment(prunes, depth, count);
+  }
+
+  //! Record a call to Rescore(), and whether it pruned the node combination.
+  void Rescore(const bool pruned)
+  {
+    if (enabled)
+    {
+      ++rescores;
+      if (pruned)
+        ++rescorePrunes;
+    }
+  }
+
+  //! Start timing base cases.
+  void StartBaseCases()
+  {
+    if (enabled)
+      baseCaseStart = std::chrono::high_resolution_clock::now();
+  }
+
+  //! Stop timing base cases, and add the elapsed time to the total.
+  void StopBaseCases()
+  {
+    if (enabled)
+    {
+      baseCaseTime += std::chrono::duration<double>(
+          std::chrono::high_resolution_clock::now() - baseCaseStart).count();
+    }
+  }
+
+ private:
+  //! Add the given count to the given element of the given counts.
+  static void Increment(std::vector<double>& counts,
+                        const size_t depth,
+                        const size_t count)
+  {
+    if (counts.size() <= depth)
+      counts.resize(depth + 1, 0.0);
+    counts[depth] += count;
+  }
+
+  //! The prefix of the counter names.
+  std::string name;
+  //! Whether or not counts are being recorded.
+  bool enabled;
+  //! The number of visited node combinations at each depth.
+  std::vector<double> visits;
+  //! The number of pruned node combinations at each depth.
+  std::vector<double> prunes;
+  //! The number of calls to Rescore().
+  double rescores;
+  //! The number of calls to Rescore() that pruned a node combination.
+  double rescorePrunes;
+  //! The time spent in base cases, in seconds.
+  double baseCaseTime;
+  //! The time at which the current base cases started.
+  std::chrono::high_resolution_clock::time_point baseCaseStart;
+};
+
+HAS_MEM_FUNC(Depth, HasTraversalDepthCheck);
+
+/**
+ * 'value' is true if the TraverserType class has a member size_t& Depth(),
+ * which sets the depth that its traversal starts at (see TraversalProfile).
+ */
+template<typename TraverserType>
+struct HasTraversalDepth
+{
+  static const bool value = HasTraversalDepthCheck<TraverserType,
+      size_t&(TraverserType::*)()>::value;
+};
+
+//! Set the depth that the traversal of the given traverser starts at.
+template<typename TraverserType>
+inline typename std::enable_if<HasTraversalDepth<TraverserType>::value>::type
+SetTraversalDepth(TraverserType& traverser, const size_t depth)
+{
+  traverser.Depth() = depth;
+}
+
+//! Do nothing, since the traverser does not record depths.
+template<typename TraverserType>
+inline typename std::enable_if<!HasTraversalDepth<TraverserType>::value>::type
+SetTraversalDepth(TraverserType& /* traverser */, const size_t /* depth */)
+{ }
+
+/**
+ * Record profiling counters that describe the shape of the given tree, if
+ * counters are enabled:
+ *
+ *  - "<name>_nodes": the number of nodes at each depth;
+ *  - "<name>_leaf_sizes": a histogram of the number of points held in each
+ *    leaf (element i is the number of leaves holding i points);
+ *  - "<name>_radius_ratio": for each depth, the sum over the nodes at that
+ *    depth of the ratio between the furthest descendant distance of the node
+ *    and the furthest descendant distance of its parent.  Divided by the
+ *    number of nodes at that depth, this shows how quickly the bounds tighten;
+ *    ratios close to 1 mean that splits do little to shrink the bounds.
+ *
+ * Counters of several trees with the same name are added together.
+ *
+ * @param tree Root of the tree to describe.
+ * @param name Prefix of the names of the counters.
+ */
+template<typename TreeType>
+void ProfileTree(const TreeType& tree, const std::string& name)
+{
+  if (!Counter::Enabled())
+    return;
+
+  std::vector<double> nodes, leafSizes, radiusRatios;
+  std::queue<std::pair<const TreeType*, size_t>> queue;
+  queue.push(std::make_pair(&tree, 0));
+  while (!queue.empty())
+  {
+    const TreeType* node = queue.front().first;
+    const size_t depth = queue.front().second;
+    queue.pop();
+
+    if (nodes.size() <= depth)
+    {
+      nodes.resize(depth + 1, 0.0);
+      radiusRatios.resize(depth + 1, 0.0);
+    }
+    ++nodes[depth];
+
+    if (node->Parent() != NULL &&
+        node->Parent()->FurthestDescendantDistance() > 0)
+    {
+      radiusRatios[depth] += node->FurthestDescendantDistance() /
+          node->Parent()->FurthestDescendantDistance();
+    }
+
+    if (node->NumChildren() == 0)
+    {
+      if (leafSizes.size() <= node->NumPoints())
+        leafSizes.resize(node->NumPoints() + 1, 0.0);
+      ++leafSizes[node->NumPoints()];
+    }
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      queue.push(std::make_pair(&node->Child(i), depth + 1));
+  }
+
+  Counter::Add(name + "_nodes", nodes);
+  Counter::Add(name + "_leaf_sizes", leafSizes);
+  Counter::Add(name + "_radius_ratio", radiusRatios);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -13,6 +13,7 @@
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <iostream>
+#include <fstream>
 
 #include "cli.hpp"
 #include "log.hpp"
@@ -105,6 +106,20 @@ CLI::~CLI()
     }
   }
 
+  // Did the user ask for a profile?  If so, write the timers and the counters
+  // to the given file.
+  if (parameters.count("profile_file") && HasParam("profile_file") &&
+      !HasParam("help") && !HasParam("info"))
+  {
+    const std::string profileFile = GetParam<std::string>("profile_file");
+    std::ofstream ofs(profileFile.c_str());
+    if (ofs.is_open())
+      counters.WriteJSON(ofs, timer.GetAllTimers());
+    else
+      Log::Warn << "Cannot open profile file '" << profileFile << "' for "
+          << "writing." << std::endl;
+  }
+
   // Notify the user if we are debugging, but only if we actually parsed the
   // options.  This way this output doesn't show up inexplicably for someone who
   // may not have wanted it there, such as in Boost unit tests.
@@ -321,6 +336,11 @@ void CLI::ParseCommandLine(int argc, char** line)
     Log::Info.ignoreInput = false;
   }
 
+  // Record profiling counters if the user wants them.
+  if (GetSingleton().parameters.count("profile_file") &&
+      HasParam("profile_file"))
+    Counter::Enable();
+
   // Notify the user if we are debugging.  This is not done in the constructor
   // because the output streams may not be set up yet.  We also don't want this
   // message twice if the user just asked for help or information.
@@ -509,3 +529,6 @@ PARAM_STRING_IN("info", "Get help on a specific module or option.", "", "");
 PARAM_FLAG("verbose", "Display informational messages and the full list of "
     "parameters and timers at the end of execution.", "v");
 PARAM_FLAG("version", "Display the version of mlpack.", "V");
+PARAM_STRING_IN("profile_file", "If specified, record profiling counters (such "
+    "as the number of nodes visited and pruned at each depth of a tree "
+    "traversal) and write them and the timers to this file as JSON.", "", "");
@@ -25,6 +25,7 @@
 #include <mlpack/prereqs.hpp>
 
 #include "timers.hpp"
+#include "counters.hpp"
 #include "cli_deleter.hpp" // To make sure we can delete the singleton.
 #include "version.hpp"
 #include "param.hpp"
@@ -328,6 +329,12 @@ class CLI
   //! So that Timer::Start() and Timer::Stop() can access the timer variable.
   friend class Timer;
 
+  //! Holds the profiling counters.
+  Counters counters;
+
+  //! So that Counter::Add() can access the counters variable.
+  friend class Counter;
+
  public:
   //! Pointer to the ProgramDoc object.
   util::ProgramDoc *doc;
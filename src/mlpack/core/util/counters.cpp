@@ -0,0 +1,135 @@
+/**
+ * @file counters.cpp
+ *
+ * Implementation of profiling counters.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include "counters.hpp"
+#include "cli.hpp"
+
+#include <iomanip>
+
+using namespace mlpack;
+
+void Counter::Enable(const bool enable)
+{
+  CLI::GetSingleton().counters.Enabled() = enable;
+}
+
+bool Counter::Enabled()
+{
+  return CLI::GetSingleton().counters.Enabled();
+}
+
+void Counter::Add(const std::string& name,
+                  const double value,
+                  const size_t index)
+{
+  Counters& counters = CLI::GetSingleton().counters;
+  if (!counters.Enabled())
+    return;
+
+  #pragma omp critical(counters)
+  {
+    std::vector<double>& counter = counters.GetAllCounters()[name];
+    if (counter.size() <= index)
+      counter.resize(index + 1, 0.0);
+    counter[index] += value;
+  }
+}
+
+void Counter::Add(const std::string& name, const std::vector<double>& values)
+{
+  Counters& counters = CLI::GetSingleton().counters;
+  if (!counters.Enabled())
+    return;
+
+  #pragma omp critical(counters)
+  {
+    std::vector<double>& counter = counters.GetAllCounters()[name];
+    if (counter.size() < values.size())
+      counter.resize(values.size(), 0.0);
+    for (size_t i = 0; i < values.size(); ++i)
+      counter[i] += values[i];
+  }
+}
+
+std::vector<double> Counter::Get(const std::string& name)
+{
+  std::map<std::string, std::vector<double>>& counters =
+      CLI::GetSingleton().counters.GetAllCounters();
+  std::map<std::string, std::vector<double>>::const_iterator it =
+      counters.find(name);
+
+  return (it == counters.end()) ? std::vector<double>() : it->second;
+}
+
+void Counter::Reset()
+{
+  CLI::GetSingleton().counters.GetAllCounters().clear();
+}
+
+std::map<std::string, std::vector<double>>& Counters::GetAllCounters()
+{
+  return counters;
+}
+
+//! Write the given string to the stream as a JSON string.
+static void WriteJSONString(std::ostream& stream, const std::string& str)
+{
+  stream << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"' || str[i] == '\\')
+      stream << '\\';
+    stream << str[i];
+  }
+  stream << '"';
+}
+
+void Counters::WriteJSON(
+    std::ostream& stream,
+    const std::map<std::string, std::chrono::microseconds>& timers)
+{
+  const std::streamsize oldPrecision = stream.precision(15);
+
+  stream << "{" << std::endl << "  \"timers\": {";
+  std::map<std::string, std::chrono::microseconds>::const_iterator it;
+  for (it = timers.begin(); it != timers.end(); ++it)
+  {
+    stream << ((it == timers.begin()) ? "" : ",") << std::endl << "    ";
+    WriteJSONString(stream, it->first);
+    stream << ": " << (it->second.count() / 1e6);
+  }
+  stream << std::endl << "  }," << std::endl << "  \"counters\": {";
+
+  // Counters with one value are written as numbers, and all other counters as
+  // arrays.
+  std::map<std::string, std::vector<double>>::const_iterator it2;
+  for (it2 = counters.begin(); it2 != counters.end(); ++it2)
+  {
+    stream << ((it2 == counters.begin()) ? "" : ",") << std::endl << "    ";
+    WriteJSONString(stream, it2->first);
+    stream << ": ";
+
+    const std::vector<double>& values = it2->second;
+    if (values.size() == 1)
+    {
+      stream << values[0];
+    }
+    else
+    {
+      stream << "[";
+      for (size_t i = 0; i < values.size(); ++i)
+        stream << ((i == 0) ? "" : ", ") << values[i];
+      stream << "]";
+    }
+  }
+  stream << std::endl << "  }" << std::endl << "}" << std::endl;
+
+  stream.precision(oldPrecision);
+}
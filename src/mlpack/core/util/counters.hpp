@@ -0,0 +1,118 @@
+/**
+ * @file counters.hpp
+ *
+ * Profiling counters for mlpack.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_CORE_UTILITIES_COUNTERS_HPP
+#define MLPACK_CORE_UTILITIES_COUNTERS_HPP
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace mlpack {
+
+/**
+ * The Counter class provides a way for mlpack methods to record profiling
+ * information, such as the number of node combinations visited at each depth
+ * of a tree traversal.  Each counter is a vector of values, indexed for
+ * instance by depth or by histogram bucket; counters holding a single value
+ * have one element.  Values are additive: adding to a counter twice gives the
+ * sum of both values.
+ *
+ * Collecting this information can take time, so counters are disabled by
+ * default, and Add() does nothing until Enable() is called.  Methods that need
+ * to do extra work to compute their counters should check Enabled() first.
+ * The command-line programs enable the counters when the --profile_file option
+ * is given, and write them (and the timers) to that file as JSON.
+ */
+class Counter
+{
+ public:
+  /**
+   * Enable or disable the counters.
+   *
+   * @param enable Whether or not counters should be recorded.
+   */
+  static void Enable(const bool enable = true);
+
+  //! Return whether or not counters are being recorded.
+  static bool Enabled();
+
+  /**
+   * Add the given value to the given element of the given counter.  The
+   * counter is enlarged if necessary.  This is safe to call from several
+   * threads at once.
+   *
+   * @param name Name of the counter.
+   * @param value Value to add.
+   * @param index Element of the counter to add the value to.
+   */
+  static void Add(const std::string& name,
+                  const double value,
+                  const size_t index = 0);
+
+  /**
+   * Add the given values, element by element, to the given counter.  The
+   * counter is enlarged if necessary.  This is safe to call from several
+   * threads at once.
+   *
+   * @param name Name of the counter.
+   * @param values Values to add.
+   */
+  static void Add(const std::string& name, const std::vector<double>& values);
+
+  /**
+   * Get the values of the given counter.  If the counter has never been added
+   * to, an empty vector is returned.
+   *
+   * @param name Name of the counter.
+   */
+  static std::vector<double> Get(const std::string& name);
+
+  //! Reset all counters (but not whether they are enabled).
+  static void Reset();
+};
+
+class Counters
+{
+ public:
+  //! Counters are disabled when they are created.
+  Counters() : enabled(false) { }
+
+  //! Return whether counters are being recorded.
+  bool Enabled() const { return enabled; }
+  //! Modify whether counters are being recorded.
+  bool& Enabled() { return enabled; }
+
+  //! Returns all of the counters.
+  std::map<std::string, std::vector<double>>& GetAllCounters();
+
+  /**
+   * Write all counters, and the given timers, to the given stream as a JSON
+   * object with the members "timers" (in seconds) and "counters".
+   *
+   * @param stream Stream to write to.
+   * @param timers Map of timer names to the values of the timers.
+   */
+  void WriteJSON(std::ostream& stream,
+                 const std::map<std::string, std::chrono::microseconds>&
+                     timers);
+
+ private:
+  //! Whether or not counters are being recorded.
+  bool enabled;
+  //! A map of all the counters.
+  std::map<std::string, std::vector<double>> counters;
+};
+
+} // namespace mlpack
+
+#endif // MLPACK_CORE_UTILITIES_COUNTERS_HPP
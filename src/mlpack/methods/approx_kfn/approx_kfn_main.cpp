@@ -50,6 +50,12 @@ PROGRAM_INFO("Approximate furthest neighbor search",
     "input model may be loaded instead of specifying a reference set with "
     "--input_model_file (-m)."
     "\n\n"
+    "A reference set that does not fit in memory may be given instead with "
+    "--streaming_reference_file (-S).  It must be an Armadillo binary file "
+    "holding one point per column, and it is read --chunk_size (-c) points at "
+    "a time.  In this case, a query set or --exact_distances_file must be "
+    "given for search or error calculation."
+    "\n\n"
     "Results for each query point are stored in the files specified by "
     "--neighbors_file and --distances_file.  This is in the same format as the "
     "mlpack_kfn and mlpack_knn programs: each row holds the k distances or "
@@ -57,6 +63,11 @@ PROGRAM_INFO("Approximate furthest neighbor search",
 
 PARAM_MATRIX_IN("reference", "Matrix containing the reference dataset.", "r");
 PARAM_MATRIX_IN("query", "Matrix containing query points.", "q");
+PARAM_STRING_IN("streaming_reference_file", "Armadillo binary file (with one "
+    "point per column) containing the reference dataset, which is read in "
+    "chunks.", "S", "");
+PARAM_INT_IN("chunk_size", "Number of points to read at a time from "
+    "--streaming_reference_file.", "c", 100000);
 
 PARAM_INT_IN("k", "Number of furthest neighbors to search for.", "k", 0);
 
@@ -112,12 +123,15 @@ int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
-  if (!CLI::HasParam("reference") && !CLI::HasParam("input_model"))
-    Log::Fatal << "Either --reference_file (-r) or --input_model_file (-m) must"
-        << " be specified!" << endl;
-  if (CLI::HasParam("reference") && CLI::HasParam("input_model"))
-    Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
-        << " can be specified!" << endl;
+  const size_t numReferenceOptions = CLI::HasParam("reference") +
+      CLI::HasParam("streaming_reference_file") + CLI::HasParam("input_model");
+  if (numReferenceOptions == 0)
+    Log::Fatal << "Either --reference_file (-r), --streaming_reference_file "
+        << "(-S) or --input_model_file (-m) must be specified!" << endl;
+  if (numReferenceOptions > 1)
+    Log::Fatal << "Only one of --reference_file (-r), "
+        << "--streaming_reference_file (-S) or --input_model_file (-m) can be "
+        << "specified!" << endl;
   if (!CLI::HasParam("output_model") && !CLI::HasParam("k"))
     Log::Warn << "Neither --output_model_file (-M) nor --k (-k) are specified;"
         << " no task will be performed." << endl;
@@ -143,6 +157,10 @@ int main(int argc, char** argv)
     Log::Fatal << "Invalid --num_projections value ("
         << CLI::GetParam<int>("num_projections") << "); must be greater than 0!"
         << endl;
+  if (CLI::GetParam<int>("chunk_size") <= 0)
+    Log::Fatal << "Invalid --chunk_size value ("
+        << CLI::GetParam<int>("chunk_size") << "); must be greater than 0!"
+        << endl;
 
   if (CLI::HasParam("calculate_error") && !CLI::HasParam("k"))
     Log::Warn << "--calculate_error ignored because --k is not specified."
@@ -186,6 +204,39 @@ int main(int argc, char** argv)
     }
     Log::Info << "Model built." << endl;
   }
+  else if (CLI::HasParam("streaming_reference_file"))
+  {
+    data::ChunkReader<> reader(
+        CLI::GetParam<string>("streaming_reference_file"));
+
+    const size_t numTables = (size_t) CLI::GetParam<int>("num_tables");
+    const size_t numProjections =
+        (size_t) CLI::GetParam<int>("num_projections");
+    const size_t chunkSize = (size_t) CLI::GetParam<int>("chunk_size");
+    const string algorithm = CLI::GetParam<string>("algorithm");
+
+    if (algorithm == "ds")
+    {
+      Timer::Start("drusilla_select_construct");
+      Log::Info << "Building DrusillaSelect model from "
+          << reader.NumPoints() << " streamed points..." << endl;
+      m.type = 0;
+      m.ds = DrusillaSelect<>(numTables, numProjections);
+      m.ds.Train(reader, 0, 0, chunkSize);
+      Timer::Stop("drusilla_select_construct");
+    }
+    else
+    {
+      Timer::Start("qdafn_construct");
+      Log::Info << "Building QDAFN model from " << reader.NumPoints()
+          << " streamed points..." << endl;
+      m.type = 1;
+      m.qdafn = QDAFN<>(numTables, numProjections);
+      m.qdafn.Train(reader, 0, 0, chunkSize);
+      Timer::Stop("qdafn_construct");
+    }
+    Log::Info << "Model built." << endl;
+  }
   else
   {
     // We must load the model from file.
@@ -31,10 +31,26 @@
 #define MLPACK_METHODS_APPROX_KFN_DRUSILLA_SELECT_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
+
+#include <queue>
 
 namespace mlpack {
 namespace neighbor {
 
+/**
+ * The DrusillaSelect class finds a candidate set of the reference points,
+ * which is searched exhaustively at query time.  The candidates are chosen
+ * one projection at a time, since each projection depends on the candidates
+ * of the previous ones; with OpenMP, the points are scored in parallel for each
+ * projection, and query points are searched in parallel.
+ *
+ * A model can also be trained on a dataset on disk that does not fit in
+ * memory, with a data::ChunkReader; the reference set is then read in chunks,
+ * in l + 2 passes.
+ *
+ * @tparam MatType Type of matrix to use.
+ */
 template<typename MatType = arma::mat>
 class DrusillaSelect
 {
@@ -74,6 +90,23 @@ class DrusillaSelect
              const size_t l = 0,
              const size_t m = 0);
 
+  /**
+   * Build the set of candidate points on the reference set held by the given
+   * reader, reading it in chunks of the given number of points, so that the
+   * reference set never needs to be held in memory.  Apart from one chunk,
+   * this takes about 8.125 bytes per reference point.  If l and m are left
+   * unspecified, then the values set in the constructor will be used instead.
+   *
+   * @param reader Reader holding the set to extract candidate points from.
+   * @param l Number of projections.
+   * @param m Number of elements to store for each projection.
+   * @param chunkSize Number of points to read at a time.
+   */
+  void Train(data::ChunkReader<typename MatType::elem_type>& reader,
+             const size_t l = 0,
+             const size_t m = 0,
+             const size_t chunkSize = 100000);
+
   /**
    * Search for the k furthest neighbors of the given query set.  (The query set
    * can contain just one point: that is okay.)  The results will be stored in
@@ -119,6 +152,63 @@ class DrusillaSelect
   size_t l;
   //! The number of points in each projection.
   size_t m;
+
+  //! Candidate represents a possible candidate point (score, index).
+  typedef std::pair<double, size_t> Candidate;
+
+  //! Compare two candidates based on the score.
+  struct CandidateCmp
+  {
+    bool operator()(const Candidate& c1, const Candidate& c2) const
+    {
+      return c2.first < c1.first;
+    }
+  };
+
+  //! A min-heap holding the best m candidates for a projection.
+  typedef std::priority_queue<Candidate, std::vector<Candidate>, CandidateCmp>
+      CandidateQueue;
+
+  //! Set the sizes of the candidate set and check the values of l and m.
+  void Initialize(const size_t dimensionality,
+                  const size_t numPoints,
+                  const size_t lIn,
+                  const size_t mIn);
+
+  /**
+   * Center the given block of points, which are the points begin, ...,
+   * begin + block.n_cols - 1 of the reference set, and store their norms.
+   *
+   * @param block Block of points to center.
+   * @param begin Index of the first point of the block.
+   * @param dataMean Mean of the reference set.
+   * @param norms Norms of all reference points.
+   */
+  static void CenterBlock(MatType& block,
+                          const size_t begin,
+                          const arma::vec& dataMean,
+                          arma::vec& norms);
+
+  /**
+   * Score the given block of centered points, which are the points begin, ...,
+   * begin + block.n_cols - 1 of the reference set, against the given line.
+   * Candidates that are better than the worst candidate in the queue replace
+   * it, and the points that are at a close angle to the line are marked.
+   *
+   * @param block Block of centered points to score.
+   * @param begin Index of the first point of the block.
+   * @param norms Norms of all reference points.
+   * @param line Unit vector to project onto.
+   * @param queue Best m candidates for this projection.
+   * @param closeAngle Whether each reference point is at a close angle to the
+   *     line.
+   */
+  static void ScoreBlock(const MatType& block,
+                         const size_t begin,
+                         const arma::vec& norms,
+                         const arma::vec& line,
+                         CandidateQueue& queue,
+                         std::vector<bool>& closeAngle);
 };
 
 } // namespace neighbor
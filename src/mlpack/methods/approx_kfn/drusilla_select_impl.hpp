@@ -67,29 +67,13 @@ void DrusillaSelect<MatType>::Train(
     const size_t lIn,
     const size_t mIn)
 {
-  // Did the user specify a new size?  If so, use it.
-  if (lIn > 0)
-    l = lIn;
-  if (mIn > 0)
-    m = mIn;
-
-  if ((l * m) > referenceSet.n_cols)
-    throw std::invalid_argument("DrusillaSelect::Train(): l and m are too "
-        "large!  Choose smaller values.  l*m must be smaller than the number "
-        "of points in the dataset.");
-
-  candidateSet.set_size(referenceSet.n_rows, l * m);
-  candidateIndices.set_size(l * m);
+  Initialize(referenceSet.n_rows, referenceSet.n_cols, lIn, mIn);
 
   arma::vec dataMean(arma::mean(referenceSet, 1));
   arma::vec norms(referenceSet.n_cols);
 
-  MatType refCopy(referenceSet.n_rows, referenceSet.n_cols);
-  for (size_t i = 0; i < refCopy.n_cols; ++i)
-  {
-    refCopy.col(i) = referenceSet.col(i) - dataMean;
-    norms[i] = arma::norm(refCopy.col(i));
-  }
+  MatType refCopy(referenceSet);
+  CenterBlock(refCopy, 0, dataMean, norms);
 
   // Find the top m points for each of the l projections...
   for (size_t i = 0; i < l; ++i)
@@ -100,63 +84,98 @@ void DrusillaSelect<MatType>::Train(
 
     arma::vec line(refCopy.col(maxIndex) / arma::norm(refCopy.col(maxIndex)));
 
-    // Calculate distortion and offset and make scores.
+    // Calculate distortion and offset and make scores, and find the top m
+    // elements using a priority queue.
     std::vector<bool> closeAngle(referenceSet.n_cols, false);
-    arma::vec sums(referenceSet.n_cols);
-    for (size_t j = 0; j < referenceSet.n_cols; ++j)
+    std::vector<Candidate> clist(m, std::make_pair(double(-DBL_MAX),
+        size_t(-1)));
+    CandidateQueue pq(CandidateCmp(), std::move(clist));
+    ScoreBlock(refCopy, 0, norms, line, pq, closeAngle);
+
+    // Take the top m elements for this table.
+    for (size_t j = 0; j < m; ++j)
     {
-      if (norms[j] > 0.0)
-      {
-        const double offset = arma::dot(refCopy.col(j), line);
-        const double distortion = arma::norm(refCopy.col(j) - offset * line);
-        sums[j] = std::abs(offset) - std::abs(distortion);
-        closeAngle[j] =
-            (std::atan(distortion / std::abs(offset)) < (M_PI / 8.0));
-      }
-      else
-      {
-        sums[j] = norms[j];
-      }
+      const size_t index = pq.top().second;
+      pq.pop();
+      candidateSet.col(i * m + j) = referenceSet.col(index);
+      candidateIndices[i * m + j] = index;
+
+      // Mark the norm as -1 so we don't see this point again.
+      norms[index] = -1.0;
     }
 
-    // Find the top m elements using a priority queue.
-    typedef std::pair<double, size_t> Candidate;
-    struct CandidateCmp
-    {
-      bool operator()(const Candidate& c1, const Candidate& c2)
-      {
-        return c2.first < c1.first;
-      }
-    };
+    // Calculate angles from the current projection.  Anything close enough,
+    // mark the norm as 0.
+    for (size_t j = 0; j < norms.n_elem; ++j)
+      if (norms[j] > 0.0 && closeAngle[j])
+        norms[j] = 0.0;
+  }
+}
 
-    std::vector<Candidate> clist(m, std::make_pair(double(-DBL_MAX), size_t(-1)));
-    std::priority_queue<Candidate, std::vector<Candidate>, CandidateCmp>
-        pq(CandidateCmp(), std::move(clist));
+// Train the model on a reference set that is read in chunks.
+template<typename MatType>
+void DrusillaSelect<MatType>::Train(
+    data::ChunkReader<typename MatType::elem_type>& reader,
+    const size_t lIn,
+    const size_t mIn,
+    const size_t chunkSize)
+{
+  if (chunkSize == 0)
+    throw std::invalid_argument("DrusillaSelect::Train(): chunk size must be "
+        "greater than 0!");
+
+  const size_t numPoints = reader.NumPoints();
+  Initialize(reader.Dimensionality(), numPoints, lIn, mIn);
+
+  // The first pass computes the mean, and the second pass the norms of the
+  // centered points.
+  MatType chunk;
+  arma::vec dataMean(reader.Dimensionality(), arma::fill::zeros);
+  for (size_t begin = 0; begin < numPoints; begin += chunkSize)
+  {
+    reader.Read(begin, std::min(chunkSize, numPoints - begin), chunk);
+    dataMean += arma::sum(chunk, 1);
+  }
+  dataMean /= numPoints;
 
-    for (size_t j = 0; j < sums.n_elem; ++j)
+  arma::vec norms(numPoints);
+  for (size_t begin = 0; begin < numPoints; begin += chunkSize)
+  {
+    reader.Read(begin, std::min(chunkSize, numPoints - begin), chunk);
+    CenterBlock(chunk, begin, dataMean, norms);
+  }
+
+  // Then there is one pass for each projection.
+  for (size_t i = 0; i < l; ++i)
+  {
+    arma::uword maxIndex;
+    norms.max(maxIndex);
+
+    reader.Read(maxIndex, 1, chunk);
+    arma::vec line(chunk.col(0) - dataMean);
+    line /= arma::norm(line);
+
+    std::vector<bool> closeAngle(numPoints, false);
+    std::vector<Candidate> clist(m, std::make_pair(double(-DBL_MAX),
+        size_t(-1)));
+    CandidateQueue pq(CandidateCmp(), std::move(clist));
+    for (size_t begin = 0; begin < numPoints; begin += chunkSize)
     {
-      Candidate c = std::make_pair(sums[j], j);
-      if (CandidateCmp()(c, pq.top()))
-      {
-        pq.pop();
-        pq.push(c);
-      }
+      reader.Read(begin, std::min(chunkSize, numPoints - begin), chunk);
+      chunk.each_col() -= dataMean;
+      ScoreBlock(chunk, begin, norms, line, pq, closeAngle);
     }
 
-    // Take the top m elements for this table.
     for (size_t j = 0; j < m; ++j)
     {
       const size_t index = pq.top().second;
       pq.pop();
-      candidateSet.col(i * m + j) = referenceSet.col(index);
+      reader.Read(index, 1, chunk);
+      candidateSet.col(i * m + j) = chunk.col(0);
       candidateIndices[i * m + j] = index;
-
-      // Mark the norm as -1 so we don't see this point again.
       norms[index] = -1.0;
     }
 
-    // Calculate angles from the current projection.  Anything close enough,
-    // mark the norm as 0.
     for (size_t j = 0; j < norms.n_elem; ++j)
       if (norms[j] > 0.0 && closeAngle[j])
         norms[j] = 0.0;
@@ -182,13 +201,33 @@ void DrusillaSelect<MatType>::Search(const MatType& querySet,
   // Note that we aren't using trees for our search, so we can use 'int' as a
   // TreeType.
   metric::EuclideanDistance metric;
-  NeighborSearchRules<FurthestNeighborSort, metric::EuclideanDistance,
+  typedef NeighborSearchRules<FurthestNeighborSort, metric::EuclideanDistance,
       tree::KDTree<metric::EuclideanDistance, tree::EmptyStatistic, MatType>>
-      rules(candidateSet, querySet, k, metric, 0, false);
+      RuleType;
+  RuleType rules(candidateSet, querySet, k, metric, 0, false);
 
-  for (size_t q = 0; q < querySet.n_cols; ++q)
-    for (size_t r = 0; r < candidateSet.n_cols; ++r)
-      rules.BaseCase(q, r);
+  // Armadillo's sparse matrices are not safe to access from several threads.
+  #pragma omp parallel if(!arma::is_SpMat<MatType>::value)
+  {
+    // Each thread searches for its own query points, so the rules objects can
+    // share the candidate lists.
+    RuleType threadRules(rules);
+
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio, use
+    // the intmax_t type instead.
+    #pragma omp for schedule(static)
+    for (intmax_t q = 0; q < (intmax_t) querySet.n_cols; ++q)
+#else
+    #pragma omp for schedule(static)
+    for (size_t q = 0; q < querySet.n_cols; ++q)
+#endif
+    {
+      for (size_t r = 0; r < candidateSet.n_cols; ++r)
+        threadRules.BaseCase(q, r);
+    }
+  }
 
   rules.GetResults(neighbors, distances);
 
@@ -197,6 +236,109 @@ void DrusillaSelect<MatType>::Search(const MatType& querySet,
     neighbors[i] = candidateIndices[neighbors[i]];
 }
 
+template<typename MatType>
+void DrusillaSelect<MatType>::Initialize(const size_t dimensionality,
+                                         const size_t numPoints,
+                                         const size_t lIn,
+                                         const size_t mIn)
+{
+  // Did the user specify a new size?  If so, use it.
+  if (lIn > 0)
+    l = lIn;
+  if (mIn > 0)
+    m = mIn;
+
+  if ((l * m) > numPoints)
+    throw std::invalid_argument("DrusillaSelect::Train(): l and m are too "
+        "large!  Choose smaller values.  l*m must be smaller than the number "
+        "of points in the dataset.");
+
+  candidateSet.set_size(dimensionality, l * m);
+  candidateIndices.set_size(l * m);
+}
+
+template<typename MatType>
+void DrusillaSelect<MatType>::CenterBlock(MatType& block,
+                                          const size_t begin,
+                                          const arma::vec& dataMean,
+                                          arma::vec& norms)
+{
+  // Armadillo's sparse matrices are not safe to access from several threads,
+  // so they are handled serially here and in ScoreBlock().
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(static) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) block.n_cols; ++i)
+#else
+  #pragma omp parallel for schedule(static) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (size_t i = 0; i < block.n_cols; ++i)
+#endif
+  {
+    block.col(i) -= dataMean;
+    norms[begin + i] = arma::norm(block.col(i));
+  }
+}
+
+template<typename MatType>
+void DrusillaSelect<MatType>::ScoreBlock(const MatType& block,
+                                         const size_t begin,
+                                         const arma::vec& norms,
+                                         const arma::vec& line,
+                                         CandidateQueue& pq,
+                                         std::vector<bool>& closeAngle)
+{
+  // The scores are computed in parallel; std::vector<bool> can't be written to
+  // by several threads, so the angles are collected separately.
+  arma::vec sums(block.n_cols);
+  std::vector<char> blockCloseAngle(block.n_cols, 0);
+
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(static) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t j = 0; j < (intmax_t) block.n_cols; ++j)
+#else
+  #pragma omp parallel for schedule(static) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (size_t j = 0; j < block.n_cols; ++j)
+#endif
+  {
+    if (norms[begin + j] > 0.0)
+    {
+      const double offset = arma::dot(block.col(j), line);
+      const double distortion = arma::norm(block.col(j) - offset * line);
+      sums[j] = std::abs(offset) - std::abs(distortion);
+      blockCloseAngle[j] =
+          (std::atan(distortion / std::abs(offset)) < (M_PI / 8.0));
+    }
+    else
+    {
+      sums[j] = norms[begin + j];
+    }
+  }
+
+  // Now insert the candidates in order, so that ties are broken the same way
+  // regardless of the number of threads or the chunk size.
+  for (size_t j = 0; j < sums.n_elem; ++j)
+  {
+    Candidate c = std::make_pair(sums[j], begin + j);
+    if (CandidateCmp()(c, pq.top()))
+    {
+      pq.pop();
+      pq.push(c);
+    }
+
+    if (blockCloseAngle[j])
+      closeAngle[begin + j] = true;
+  }
+}
+
 //! Serialize the model.
 template<typename MatType>
 template<typename Archive>
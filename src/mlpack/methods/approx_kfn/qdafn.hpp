@@ -26,10 +26,23 @@
 
 #include <mlpack/prereqs.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
 
 namespace mlpack {
 namespace neighbor {
 
+/**
+ * The QDAFN class keeps, for each of l random projections, the m reference
+ * points with the largest projections, and searches them in a query-dependent
+ * order.  With OpenMP, the tables are built in parallel, and query points are
+ * searched in parallel.
+ *
+ * A model can also be trained on a dataset on disk that does not fit in
+ * memory, with a data::ChunkReader; the reference set is then read in chunks,
+ * in one pass.
+ *
+ * @tparam MatType Type of matrix to use.
+ */
 template<typename MatType = arma::mat>
 class QDAFN
 {
@@ -68,11 +81,32 @@ class QDAFN
              const size_t l = 0,
              const size_t m = 0);
 
+  /**
+   * Train the QDAFN model on the reference set held by the given reader,
+   * reading it in chunks of the given number of points, so that the reference
+   * set never needs to be held in memory.  The projections of the reference
+   * points are not kept (they are not needed for search).
+   *
+   * @param reader Reader holding the reference set to train on.
+   * @param l Number of projections.
+   * @param m Number of elements to store for each projection.
+   * @param chunkSize Number of points to read at a time.
+   */
+  void Train(data::ChunkReader<typename MatType::elem_type>& reader,
+             const size_t l = 0,
+             const size_t m = 0,
+             const size_t chunkSize = 100000);
+
   /**
    * Search for the k furthest neighbors of the given query set.  (The query set
    * can contain just one point, that is okay.)  The results will be stored in
    * the given neighbors and distances matrices, in the same format as the
    * mlpack NeighborSearch and LSHSearch classes.
+   *
+   * @param querySet Set of query points to search.
+   * @param k Number of furthest neighbors to search for.
+   * @param neighbors Matrix to store resulting neighbors in.
+   * @param distances Matrix to store resulting distances in.
    */
   void Search(const MatType& querySet,
               const size_t k,
@@ -108,6 +142,11 @@ class QDAFN
 
   // Candidate sets; one element in the vector for each table.
   std::vector<MatType> candidateSet;
+
+  //! Draw the random lines for the given dimensionality, and set the sizes of
+  //! the tables.
+  void Initialize(const size_t dimensionality, const size_t lIn,
+                  const size_t mIn);
 };
 
 } // namespace neighbor
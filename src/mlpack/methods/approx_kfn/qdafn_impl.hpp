@@ -53,28 +53,27 @@ void QDAFN<MatType>::Train(const MatType& referenceSet,
                            const size_t lIn,
                            const size_t mIn)
 {
-  if (lIn != 0)
-    l = lIn;
-  if (mIn != 0)
-    m = mIn;
-
-  // Build tables.  This is done by drawing random points from a Gaussian
-  // distribution as the vectors we project onto.  The Gaussian should have zero
-  // mean and unit variance.
-  mlpack::distribution::GaussianDistribution gd(referenceSet.n_rows);
-  lines.set_size(referenceSet.n_rows, l);
-  for (size_t i = 0; i < l; ++i)
-    lines.col(i) = gd.Random();
+  Initialize(referenceSet.n_rows, lIn, mIn);
 
   // Now, project each of the reference points onto each line, and collect the
   // top m elements.
   projections = referenceSet.t() * lines;
 
-  // Loop over each projection and find the top m elements.
-  sIndices.set_size(m, l);
-  sValues.set_size(m, l);
-  candidateSet.resize(l);
+  // Loop over each projection and find the top m elements.  The tables are
+  // independent, so they are built in parallel (except for sparse matrices,
+  // which are not safe to access from several threads).
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) l; ++i)
+#else
+  #pragma omp parallel for schedule(dynamic) \
+      if(!arma::is_SpMat<MatType>::value)
   for (size_t i = 0; i < l; ++i)
+#endif
   {
     candidateSet[i].set_size(referenceSet.n_rows, m);
     arma::uvec sortedIndices = arma::sort_index(projections.col(i), "descend");
@@ -89,6 +88,87 @@ void QDAFN<MatType>::Train(const MatType& referenceSet,
   }
 }
 
+// Train the object on a reference set that is read in chunks.
+template<typename MatType>
+void QDAFN<MatType>::Train(
+    data::ChunkReader<typename MatType::elem_type>& reader,
+    const size_t lIn,
+    const size_t mIn,
+    const size_t chunkSize)
+{
+  if (chunkSize == 0)
+    throw std::invalid_argument("QDAFN::Train(): chunk size must be greater "
+        "than 0!");
+
+  const size_t numPoints = reader.NumPoints();
+  Initialize(reader.Dimensionality(), lIn, mIn);
+  if (m > numPoints)
+    throw std::invalid_argument("QDAFN::Train(): m must not be greater than "
+        "the number of points in the dataset!");
+
+  // The projections of all points are not kept; instead, a min-heap holds the
+  // top m elements of each table.
+  projections.reset();
+  typedef std::pair<double, size_t> Element;
+  typedef std::priority_queue<Element, std::vector<Element>,
+      std::greater<Element>> ElementQueue;
+  std::vector<ElementQueue> queues(l);
+
+  MatType chunk;
+  arma::mat chunkProjections;
+  for (size_t begin = 0; begin < numPoints; begin += chunkSize)
+  {
+    reader.Read(begin, std::min(chunkSize, numPoints - begin), chunk);
+    chunkProjections = chunk.t() * lines;
+
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp parallel for schedule(static)
+    for (intmax_t i = 0; i < (intmax_t) l; ++i)
+#else
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < l; ++i)
+#endif
+    {
+      ElementQueue& queue = queues[i];
+      for (size_t j = 0; j < chunkProjections.n_rows; ++j)
+      {
+        const Element e = std::make_pair(chunkProjections(j, i), begin + j);
+        if (queue.size() < m)
+        {
+          queue.push(e);
+        }
+        else if (queue.top() < e)
+        {
+          queue.pop();
+          queue.push(e);
+        }
+      }
+    }
+  }
+
+  // Empty the heaps into the tables, largest projection first, and then read
+  // the candidate points.
+  for (size_t i = 0; i < l; ++i)
+  {
+    candidateSet[i].set_size(reader.Dimensionality(), m);
+    for (size_t j = m; j > 0; --j)
+    {
+      sIndices(j - 1, i) = queues[i].top().second;
+      sValues(j - 1, i) = queues[i].top().first;
+      queues[i].pop();
+    }
+
+    for (size_t j = 0; j < m; ++j)
+    {
+      reader.Read(sIndices(j, i), 1, chunk);
+      candidateSet[i].col(j) = chunk.col(0);
+    }
+  }
+}
+
 // Search.
 template<typename MatType>
 void QDAFN<MatType>::Search(const MatType& querySet,
@@ -104,71 +184,125 @@ void QDAFN<MatType>::Search(const MatType& querySet,
   neighbors.fill(size_t() - 1);
   distances.zeros(k, querySet.n_cols);
 
-  // Search for each point.
-  for (size_t q = 0; q < querySet.n_cols; ++q)
+  // The query points are projected onto the lines in blocks, so that each
+  // block takes one matrix multiplication.
+  const size_t queryBlockSize = 256;
+  const size_t numBlocks = (querySet.n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+
+  // Armadillo's sparse matrices are not safe to access from several threads.
+  #pragma omp parallel if(!arma::is_SpMat<MatType>::value)
   {
-    // Initialize a priority queue.
-    // The size_t represents the index of the table, and the double represents
-    // the value of l_i * S_i - l_i * query (see line 6 of Algorithm 1).
-    std::priority_queue<std::pair<double, size_t>> queue;
-    for (size_t i = 0; i < l; ++i)
+    arma::mat queryProjections;
+
+    // Parallelization to process more than one block of queries at a time.
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp for schedule(dynamic)
+    for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+    #pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < numBlocks; ++b)
+#endif
     {
-      const double val = sValues(0, i) - arma::dot(querySet.col(q),
-          lines.col(i));
-      queue.push(std::make_pair(val, i));
-    }
+      const size_t begin = (size_t) b * queryBlockSize;
+      const size_t count = std::min(queryBlockSize,
+          (size_t) querySet.n_cols - begin);
+      queryProjections = lines.t() * querySet.cols(begin, begin + count - 1);
+
+      // Search for each point.
+      for (size_t q = begin; q < begin + count; ++q)
+      {
+        // Initialize a priority queue.
+        // The size_t represents the index of the table, and the double
+        // represents the value of l_i * S_i - l_i * query (see line 6 of
+        // Algorithm 1).
+        std::priority_queue<std::pair<double, size_t>> queue;
+        for (size_t i = 0; i < l; ++i)
+        {
+          const double val = sValues(0, i) - queryProjections(i, q - begin);
+          queue.push(std::make_pair(val, i));
+        }
 
-    // To track where we are in each S table, we keep the next index to look at
-    // in each table (they start at 0).
-    arma::Col<size_t> tableLocations = arma::zeros<arma::Col<size_t>>(l);
+        // To track where we are in each S table, we keep the next index to
+        // look at in each table (they start at 0).
+        arma::Col<size_t> tableLocations = arma::zeros<arma::Col<size_t>>(l);
 
-    // Now that the queue is initialized, iterate over m elements.
-    std::vector<std::pair<double, size_t>> v(k, std::make_pair(-1.0,
-        size_t(-1)));
-    std::priority_queue<std::pair<double, size_t>>
-        resultsQueue(std::less<std::pair<double, size_t>>(), std::move(v));
-    for (size_t i = 0; i < m; ++i)
-    {
-      std::pair<size_t, double> p = queue.top();
-      queue.pop();
+        // Now that the queue is initialized, iterate over m elements.
+        std::vector<std::pair<double, size_t>> v(k, std::make_pair(-1.0,
+            size_t(-1)));
+        std::priority_queue<std::pair<double, size_t>>
+            resultsQueue(std::less<std::pair<double, size_t>>(), std::move(v));
+        for (size_t i = 0; i < m; ++i)
+        {
+          std::pair<double, size_t> p = queue.top();
+          queue.pop();
 
-      // Get index of reference point to look at.
-      const size_t tableIndex = tableLocations[p.second];
+          // Get index of reference point to look at.
+          const size_t tableIndex = tableLocations[p.second];
 
-      // Calculate distance from query point.
-      const double dist = mlpack::metric::EuclideanDistance::Evaluate(
-          querySet.col(q), candidateSet[p.second].col(tableIndex));
+          // Calculate distance from query point.
+          const double dist = mlpack::metric::EuclideanDistance::Evaluate(
+              querySet.col(q), candidateSet[p.second].col(tableIndex));
 
-      // Is this neighbor good enough to insert into the results?
-      if (dist > resultsQueue.top().first)
-      {
-        resultsQueue.pop();
-        resultsQueue.push(std::make_pair(dist, sIndices(tableIndex, p.second)));
-      }
+          // Is this neighbor good enough to insert into the results?
+          if (dist > resultsQueue.top().first)
+          {
+            resultsQueue.pop();
+            resultsQueue.push(std::make_pair(dist,
+                sIndices(tableIndex, p.second)));
+          }
 
-      // Now (line 14) get the next element and insert into the queue.  Do this
-      // by adjusting the previous value.  Don't insert anything if we are at
-      // the end of the search, though.
-      if (i < m - 1)
-      {
-        tableLocations[p.second]++;
-        const double val = p.first - sValues(tableIndex, p.second) +
-            sValues(tableIndex + 1, p.second);
+          // Now (line 14) get the next element and insert into the queue.  Do
+          // this by adjusting the previous value.  Don't insert anything if we
+          // are at the end of the search, though.
+          if (i < m - 1)
+          {
+            tableLocations[p.second]++;
+            const double val = p.first - sValues(tableIndex, p.second) +
+                sValues(tableIndex + 1, p.second);
 
-        queue.push(std::make_pair(val, p.second));
-      }
-    }
+            queue.push(std::make_pair(val, p.second));
+          }
+        }
 
-    // Extract the results.
-    for (size_t j = 1; j <= k; ++j)
-    {
-      neighbors(k - j, q) = resultsQueue.top().second;
-      distances(k - j, q) = resultsQueue.top().first;
-      resultsQueue.pop();
+        // Extract the results.
+        for (size_t j = 1; j <= k; ++j)
+        {
+          neighbors(k - j, q) = resultsQueue.top().second;
+          distances(k - j, q) = resultsQueue.top().first;
+          resultsQueue.pop();
+        }
+      }
     }
   }
 }
 
+template<typename MatType>
+void QDAFN<MatType>::Initialize(const size_t dimensionality,
+                                const size_t lIn,
+                                const size_t mIn)
+{
+  if (lIn != 0)
+    l = lIn;
+  if (mIn != 0)
+    m = mIn;
+
+  // Build tables.  This is done by drawing random points from a Gaussian
+  // distribution as the vectors we project onto.  The Gaussian should have zero
+  // mean and unit variance.
+  mlpack::distribution::GaussianDistribution gd(dimensionality);
+  lines.set_size(dimensionality, l);
+  for (size_t i = 0; i < l; ++i)
+    lines.col(i) = gd.Random();
+
+  sIndices.set_size(m, l);
+  sValues.set_size(m, l);
+  candidateSet.resize(l);
+}
+
 template<typename MatType>
 template<typename Archive>
 void QDAFN<MatType>::Serialize(Archive& ar, const unsigned int /* version */)
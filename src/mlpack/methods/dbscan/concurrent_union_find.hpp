@@ -0,0 +1,104 @@
+/**
+ * @file concurrent_union_find.hpp
+ *
+ * A lock-free union-find structure, which can be updated from several threads
+ * at once.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_DBSCAN_CONCURRENT_UNION_FIND_HPP
+#define MLPACK_METHODS_DBSCAN_CONCURRENT_UNION_FIND_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <atomic>
+
+namespace mlpack {
+namespace dbscan {
+
+/**
+ * A union-find structure whose Find() and Union() may be called from several
+ * threads at once without locks.  Like emst::UnionFind, each element starts
+ * in its own component; Union(x, y) unites the components of x and y, and
+ * Find(x) returns the root of the component of x.
+ *
+ * Each parent is an atomic index.  Find() halves the path to the root as it
+ * goes, and Union() links one root under the other with a compare-and-swap,
+ * retrying if another thread changed the root in the meantime.  The larger
+ * root is always linked under the smaller one, so the root of each component
+ * is its smallest element, whatever the order of the unions.
+ */
+class ConcurrentUnionFind
+{
+ public:
+  //! Construct the object with the given size.
+  ConcurrentUnionFind(const size_t size) : parent(size)
+  {
+    for (size_t i = 0; i < size; ++i)
+      parent[i].store(i, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the root of the component containing an element.  This is the
+   * smallest element of the component, once all unions are done.
+   *
+   * @param x Element to find the component of.
+   * @return The root of the component containing x.
+   */
+  size_t Find(size_t x)
+  {
+    while (true)
+    {
+      size_t p = parent[x].load();
+      if (p == x)
+        return x;
+
+      // Point x to its grandparent.  If another thread got there first, its
+      // change is just as good.
+      const size_t grandparent = parent[p].load();
+      if (grandparent != p)
+        parent[x].compare_exchange_weak(p, grandparent);
+
+      x = grandparent;
+    }
+  }
+
+  /**
+   * Union the components containing x and y.
+   *
+   * @param x One element.
+   * @param y The other element.
+   */
+  void Union(size_t x, size_t y)
+  {
+    while (true)
+    {
+      x = Find(x);
+      y = Find(y);
+      if (x == y)
+        return;
+
+      // Link the larger root under the smaller root, if it is still a root.
+      if (x < y)
+        std::swap(x, y);
+
+      size_t expected = x;
+      if (parent[x].compare_exchange_strong(expected, y))
+        return;
+    }
+  }
+
+  //! Get the number of elements.
+  size_t Size() const { return parent.size(); }
+
+ private:
+  //! The parent of each element; roots are their own parents.
+  std::vector<std::atomic<size_t>> parent;
+};
+
+} // namespace dbscan
+} // namespace mlpack
+
+#endif
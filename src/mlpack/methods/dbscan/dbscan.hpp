@@ -11,11 +11,34 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/range_search/range_search.hpp>
 #include "random_point_selection.hpp"
-#include <boost/dynamic_bitset.hpp>
+#include "concurrent_union_find.hpp"
 
 namespace mlpack {
 namespace dbscan {
 
+/**
+ * Whether the given range search type uses the Euclidean distance, in which
+ * case DBSCAN can find the neighbors of points in low dimensions with a grid
+ * instead.  Specialize this for other range search types that use the
+ * Euclidean distance.
+ */
+template<typename RangeSearchType>
+struct UsesEuclideanDistance
+{
+  static const bool value = false;
+};
+
+//! RangeSearch with the Euclidean distance uses the Euclidean distance.
+template<typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+struct UsesEuclideanDistance<range::RangeSearch<metric::EuclideanDistance,
+    MatType, TreeType>>
+{
+  static const bool value = true;
+};
+
 /**
  * DBSCAN (Density-Based Spatial Clustering of Applications with Noise) is a
  * clustering technique described in the following paper:
@@ -32,14 +55,34 @@ namespace dbscan {
  * }
  * @endcode
  *
- * The DBSCAN algorithm iteratively clusters points using range searches with a
- * specified radius parameter.  This implementation allows configuration of the
- * range search technique used and the point selection strategy by means of
- * template parameters.
+ * The DBSCAN algorithm clusters points using range searches with a specified
+ * radius parameter.  This implementation never stores the neighborhoods of the
+ * points.  First, the core points (those with at least minPoints points in
+ * their epsilon-neighborhood, including themselves) are found; then core points
+ * within epsilon of each other are merged into clusters with a
+ * ConcurrentUnionFind, and each other point is assigned to the cluster of its
+ * core neighbor with the smallest index, or marked as noise if it has none.
+ *
+ * If the range search type uses the Euclidean distance, the data is dense and
+ * has at most three dimensions, space is split into a grid of cells of side
+ * epsilon / sqrt(d), so that the points of a cell are all within epsilon of
+ * each other.  Only the points of nearby cells need to be checked, and cells
+ * with at least minPoints points hold only core points.  The core points are
+ * found, and the clusters merged, over the cells in parallel with OpenMP.
+ *
+ * Otherwise, the neighborhoods are passed, one batch of points at a time, to a
+ * sink by the range search (which searches one batch per thread in parallel);
+ * the core points are found in a first pass, and the clusters are merged in a
+ * second one.
+ *
+ * The clusters are numbered in the order of their smallest core point, so the
+ * result depends neither on the number of threads nor on the order in which
+ * the points are visited.
  *
  * @tparam RangeSearchType Class to use for range searching.
  * @tparam PointSelectionPolicy Strategy for selecting next point to cluster
- *      with.
+ *      with.  Since the clusters no longer depend on the order in which points
+ *      are visited, this is unused, and only kept for compatibility.
  */
 template<typename RangeSearchType = range::RangeSearch<>,
          typename PointSelectionPolicy = RandomPointSelection>
@@ -114,33 +157,73 @@ class DBSCAN
   PointSelectionPolicy pointSelector;
 
   /**
-   * This function processes the point at index. It  marks the point as visited,
-   * checks if the given point is core or non-core.  If it is a core point, it
-   * expands the cluster, otherwise it returns.
+   * Find the core points and merge the clusters with a grid of cells, if the
+   * range search uses the Euclidean distance and the data is dense and has at
+   * most three dimensions.  For each point that is not a core point, the index
+   * of its core neighbor with the smallest index (or SIZE_MAX) is stored in
+   * assignments.
    *
-   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
    * @param data Dataset to cluster.
-   * @param unvisited Remembers if a point has been visited.
-   * @param index Index of point to be visited now.
-   * @param assignments Vector to store cluster assignments.
-   * @param currentCluster Index of cluster which will be  assigned to points in
-   *     current cluster.
-   * @param neighbors Matrix containing list of neighbors for each point which
-   *     fall in its epsilon-neighborhood.
-   * @param distances Matrix containing list of distances for each point which
-   *     fall in its epsilon-neighborhood.
-   * @param topLevel If true, then current point is the first point in the
-   *     current cluster, helps in detecting noise.
+   * @param core Whether each point is a core point.
+   * @param components Union-find structure to merge the core points in.
+   * @param assignments Vector to store the core neighbors of other points in.
+   * @return Whether the grid could be used.
    */
   template<typename MatType>
-  size_t ProcessPoint(const MatType& data,
-                      boost::dynamic_bitset<>& unvisited,
-                      const size_t index,
-                      arma::Row<size_t>& assignments,
-                      const size_t currentCluster,
-                      const std::vector<std::vector<size_t>>& neighbors,
-                      const std::vector<std::vector<double>>& distances,
-                      const bool topLevel = true);
+  bool GridCluster(
+      const MatType& data,
+      std::vector<char>& core,
+      ConcurrentUnionFind& components,
+      arma::Row<size_t>& assignments,
+      const typename std::enable_if_t<
+          UsesEuclideanDistance<RangeSearchType>::value &&
+          !arma::is_SpMat<MatType>::value>* = 0);
+
+  //! The grid can't be used for this range search type or matrix type.
+  template<typename MatType>
+  bool GridCluster(
+      const MatType& /* data */,
+      std::vector<char>& /* core */,
+      ConcurrentUnionFind& /* components */,
+      arma::Row<size_t>& /* assignments */,
+      const typename std::enable_if_t<
+          !UsesEuclideanDistance<RangeSearchType>::value ||
+          arma::is_SpMat<MatType>::value>* = 0)
+  {
+    return false;
+  }
+
+  /**
+   * Find the core points and merge the clusters with the range search, by
+   * streaming the neighborhoods of the points twice: once to count the
+   * neighbors of each point, and once to merge the clusters.  For each point
+   * that is not a core point, the index of its core neighbor with the smallest
+   * index (or SIZE_MAX) is stored in assignments.
+   *
+   * @param data Dataset to cluster.
+   * @param core Whether each point is a core point.
+   * @param components Union-find structure to merge the core points in.
+   * @param assignments Vector to store the core neighbors of other points in.
+   */
+  template<typename MatType>
+  void RangeSearchCluster(const MatType& data,
+                          std::vector<char>& core,
+                          ConcurrentUnionFind& components,
+                          arma::Row<size_t>& assignments);
+
+  /**
+   * Number the clusters in the order of their smallest core point, and turn
+   * the core neighbors stored in assignments for the other points into
+   * cluster assignments.  Returns the number of clusters.
+   *
+   * @param core Whether each point is a core point.
+   * @param components Union-find structure holding the merged core points.
+   * @param assignments Core neighbors of the points that are not core points,
+   *     replaced by the cluster assignments of all points.
+   */
+  size_t LabelClusters(const std::vector<char>& core,
+                       ConcurrentUnionFind& components,
+                       arma::Row<size_t>& assignments);
 };
 
 } // namespace dbscan
@@ -9,6 +9,8 @@
 
 #include "dbscan.hpp"
 
+#include <array>
+
 namespace mlpack {
 namespace dbscan {
 
@@ -96,81 +98,361 @@ size_t DBSCAN<RangeSearchType, PointSelectionPolicy>::Cluster(
   assignments.set_size(data.n_cols);
   assignments.fill(SIZE_MAX);
 
-  size_t currentCluster = 0;
-
-  // For each point, find the points in epsilon-nighborhood and their distances.
-  std::vector<std::vector<size_t>> neighbors;
-  std::vector<std::vector<double>> distances;
-  Log::Debug << "Performing range search." << std::endl;
-  rangeSearch.Train(data);
-  rangeSearch.Search(data, math::Range(0.0, epsilon), neighbors, distances);
-  Log::Debug << "Range search complete." << std::endl;
-
-  // Initialize to all true; false means it's been visited.
-  boost::dynamic_bitset<> unvisited(data.n_cols);
-  unvisited.set();
-  while (unvisited.any())
+  std::vector<char> core(data.n_cols, false);
+  ConcurrentUnionFind components(data.n_cols);
+  if (GridCluster(data, core, components, assignments))
+  {
+    Log::Debug << "Clustered with a grid." << std::endl;
+  }
+  else
   {
-    // Select the next unvisited point.
-    const size_t nextIndex = pointSelector.Select(unvisited, data);
-    Log::Debug << "Inspect point " << nextIndex << "; " << unvisited.count()
-        << " unvisited points remain." << std::endl;
-
-    // currentCluster will only be incremented if a cluster was created.
-    currentCluster = ProcessPoint(data, unvisited, nextIndex, assignments,
-        currentCluster, neighbors, distances);
+    Log::Debug << "Performing range search." << std::endl;
+    RangeSearchCluster(data, core, components, assignments);
+    Log::Debug << "Range search complete." << std::endl;
   }
 
-  return currentCluster;
+  return LabelClusters(core, components, assignments);
 }
 
-/**
- * This function processes the point at index. It marks the point as visited,
- * checks if the given point is core or non-core. If it is a core point, it
- * expands the cluster, otherwise it returns.
- */
 template<typename RangeSearchType, typename PointSelectionPolicy>
 template<typename MatType>
-size_t DBSCAN<RangeSearchType, PointSelectionPolicy>::ProcessPoint(
+bool DBSCAN<RangeSearchType, PointSelectionPolicy>::GridCluster(
     const MatType& data,
-    boost::dynamic_bitset<>& unvisited,
-    const size_t index,
+    std::vector<char>& core,
+    ConcurrentUnionFind& components,
     arma::Row<size_t>& assignments,
-    const size_t currentCluster,
-    const std::vector<std::vector<size_t>>& neighbors,
-    const std::vector<std::vector<double>>& distances,
-    const bool topLevel)
+    const typename std::enable_if_t<
+        UsesEuclideanDistance<RangeSearchType>::value &&
+        !arma::is_SpMat<MatType>::value>*)
 {
-  // We've now visited this point.
-  unvisited[index] = false;
+  // The cells are indexed by up to three integer coordinates.
+  typedef std::array<int64_t, 3> Cell;
+  const size_t dims = data.n_rows;
+  if (dims == 0 || dims > 3 || data.n_cols == 0 || !(epsilon > 0.0))
+    return false;
+
+  // Any two points in a cell of side epsilon / sqrt(d) are within epsilon of
+  // each other.
+  const double side = epsilon / std::sqrt((double) dims);
+  const arma::vec minima = arma::conv_to<arma::vec>::from(arma::min(data, 1));
+  const arma::vec maxima = arma::conv_to<arma::vec>::from(arma::max(data, 1));
+  if (!((maxima - minima).max() / side < 1e15))
+    return false; // The coordinates of the cells would overflow.
+
+  auto cellOf = [&](const size_t point)
+  {
+    Cell cell = {{ 0, 0, 0 }};
+    for (size_t d = 0; d < dims; ++d)
+      cell[d] = (int64_t) std::floor((data(d, point) - minima[d]) / side);
+    return cell;
+  };
 
-  if ((neighbors[index].size() < minPoints) && topLevel)
+  // Sort the points by cell (and by index within each cell), so that each cell
+  // is a contiguous range of the order.  The coordinates of the cells are
+  // computed again when needed, instead of being stored for every point.
+  std::vector<size_t> order(data.n_cols);
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b)
   {
-    // Mark the point as noise (leave assignments[index] unset) and return.
-    unvisited[index] = false;
-    return currentCluster;
+    const Cell cellA = cellOf(a);
+    const Cell cellB = cellOf(b);
+    return (cellA < cellB) || (cellA == cellB && a < b);
+  });
+
+  std::vector<Cell> cells;
+  std::vector<size_t> cellStart;
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    const Cell cell = cellOf(order[i]);
+    if (cells.empty() || cell != cells.back())
+    {
+      cells.push_back(cell);
+      cellStart.push_back(i);
+    }
   }
-  else
+  cellStart.push_back(order.size());
+
+  // Find the offsets of the other cells that may hold points within epsilon of
+  // a point in a given cell, that is, those at most epsilon away.
+  std::vector<Cell> offsets;
+  const int64_t reach = (int64_t) std::sqrt((double) dims) + 1;
+  Cell offset = {{ 0, 0, 0 }};
+  for (size_t d = 0; d < dims; ++d)
+    offset[d] = -reach;
+  while (true)
+  {
+    double gap = 0.0;
+    bool self = true;
+    for (size_t d = 0; d < dims; ++d)
+    {
+      gap += std::pow(std::max(std::abs(offset[d]) - 1, (int64_t) 0) * side,
+          2.0);
+      self &= (offset[d] == 0);
+    }
+    if (!self && std::sqrt(gap) <= epsilon)
+      offsets.push_back(offset);
+
+    // Move to the next offset.
+    size_t d = 0;
+    while (d < dims && offset[d] == reach)
+      offset[d++] = -reach;
+    if (d == dims)
+      break;
+    ++offset[d];
+  }
+
+  // Get the indices of the nearby cells that hold points.
+  auto nearbyCells = [&](const size_t c, std::vector<size_t>& nearby)
+  {
+    nearby.clear();
+    for (size_t o = 0; o < offsets.size(); ++o)
+    {
+      Cell cell = cells[c];
+      for (size_t d = 0; d < dims; ++d)
+        cell[d] += offsets[o][d];
+
+      typename std::vector<Cell>::const_iterator it =
+          std::lower_bound(cells.begin(), cells.end(), cell);
+      if (it != cells.end() && *it == cell)
+        nearby.push_back(it - cells.begin());
+    }
+  };
+
+  auto withinRange = [&](const size_t a, const size_t b)
   {
-    assignments[index] = currentCluster;
+    return metric::EuclideanDistance::Evaluate(data.col(a), data.col(b)) <=
+        epsilon;
+  };
 
-    // New cluster.
-    for (size_t j = 0; j < neighbors[index].size(); ++j)
+  // Find the core points.  A cell with at least minPoints points only holds
+  // core points; in other cells, count the neighbors of each point until there
+  // are enough.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (intmax_t c = 0; c < (intmax_t) cells.size(); ++c)
+#else
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t c = 0; c < cells.size(); ++c)
+#endif
+  {
+    const size_t cellSize = cellStart[c + 1] - cellStart[c];
+    if (cellSize >= minPoints)
+    {
+      for (size_t i = cellStart[c]; i < cellStart[c + 1]; ++i)
+        core[order[i]] = true;
+      continue;
+    }
+
+    std::vector<size_t> nearby;
+    nearbyCells(c, nearby);
+    for (size_t i = cellStart[c]; i < cellStart[c + 1]; ++i)
     {
-      // Add each point to the cluster and mark it as visited, but only if it
-      // has not been visited yet.
-      if (!unvisited[neighbors[index][j]])
+      size_t count = cellSize;
+      for (size_t n = 0; n < nearby.size() && count < minPoints; ++n)
+      {
+        for (size_t j = cellStart[nearby[n]]; j < cellStart[nearby[n] + 1] &&
+            count < minPoints; ++j)
+        {
+          if (withinRange(order[i], order[j]))
+            ++count;
+        }
+      }
+
+      core[order[i]] = (count >= minPoints);
+    }
+  }
+
+  // Merge the clusters.  The core points of a cell are all in one cluster, and
+  // two nearby cells are in the same cluster if any of their core points are
+  // within epsilon of each other.  Each pair of cells is only checked from the
+  // cell that comes first.
+#ifdef _WIN32
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (intmax_t c = 0; c < (intmax_t) cells.size(); ++c)
+#else
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t c = 0; c < cells.size(); ++c)
+#endif
+  {
+    size_t first = SIZE_MAX;
+    for (size_t i = cellStart[c]; i < cellStart[c + 1]; ++i)
+    {
+      if (!core[order[i]])
         continue;
 
-      assignments[neighbors[index][j]] = currentCluster;
-      unvisited[neighbors[index][j]] = false;
+      if (first == SIZE_MAX)
+        first = order[i];
+      else
+        components.Union(first, order[i]);
+    }
+
+    if (first == SIZE_MAX)
+      continue;
+
+    std::vector<size_t> nearby;
+    nearbyCells(c, nearby);
+    for (size_t n = 0; n < nearby.size(); ++n)
+    {
+      if (nearby[n] < (size_t) c)
+        continue;
 
-      // Recurse into this point.
-      ProcessPoint(data, unvisited, neighbors[index][j], assignments,
-          currentCluster, neighbors, distances, false);
+      // Skip cells with no core points, or that are already merged.
+      size_t nearbyFirst = SIZE_MAX;
+      for (size_t j = cellStart[nearby[n]]; j < cellStart[nearby[n] + 1]; ++j)
+      {
+        if (core[order[j]])
+        {
+          nearbyFirst = order[j];
+          break;
+        }
+      }
+      if (nearbyFirst == SIZE_MAX ||
+          components.Find(first) == components.Find(nearbyFirst))
+        continue;
+
+      bool connected = false;
+      for (size_t i = cellStart[c]; i < cellStart[c + 1] && !connected; ++i)
+      {
+        if (!core[order[i]])
+          continue;
+
+        for (size_t j = cellStart[nearby[n]]; j < cellStart[nearby[n] + 1] &&
+            !connected; ++j)
+        {
+          if (core[order[j]] && withinRange(order[i], order[j]))
+            connected = true;
+        }
+      }
+
+      if (connected)
+        components.Union(first, nearbyFirst);
     }
-    return currentCluster + 1;
   }
+
+  // Find the core neighbor with the smallest index of every other point.  Every
+  // core point in the same cell is a neighbor.
+#ifdef _WIN32
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (intmax_t c = 0; c < (intmax_t) cells.size(); ++c)
+#else
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t c = 0; c < cells.size(); ++c)
+#endif
+  {
+    size_t cellCore = SIZE_MAX;
+    bool allCore = true;
+    for (size_t i = cellStart[c]; i < cellStart[c + 1]; ++i)
+    {
+      if (core[order[i]])
+        cellCore = std::min(cellCore, order[i]);
+      else
+        allCore = false;
+    }
+
+    if (allCore)
+      continue;
+
+    std::vector<size_t> nearby;
+    nearbyCells(c, nearby);
+    for (size_t i = cellStart[c]; i < cellStart[c + 1]; ++i)
+    {
+      if (core[order[i]])
+        continue;
+
+      size_t best = cellCore;
+      for (size_t n = 0; n < nearby.size(); ++n)
+      {
+        for (size_t j = cellStart[nearby[n]]; j < cellStart[nearby[n] + 1];
+            ++j)
+        {
+          if (core[order[j]] && order[j] < best &&
+              withinRange(order[i], order[j]))
+            best = order[j];
+        }
+      }
+
+      assignments[order[i]] = best;
+    }
+  }
+
+  return true;
+}
+
+template<typename RangeSearchType, typename PointSelectionPolicy>
+template<typename MatType>
+void DBSCAN<RangeSearchType, PointSelectionPolicy>::RangeSearchCluster(
+    const MatType& data,
+    std::vector<char>& core,
+    ConcurrentUnionFind& components,
+    arma::Row<size_t>& assignments)
+{
+  rangeSearch.Train(data);
+
+  // Both passes stream the neighborhoods, so only a few batches of them are
+  // held in memory, and the range search searches the batches in parallel.
+  // A point is not returned in its own range, but it is part of its own
+  // epsilon-neighborhood.
+  rangeSearch.Search(math::Range(0.0, epsilon),
+      [&](const size_t point,
+          const std::vector<size_t>& neighbors,
+          const std::vector<double>& /* distances */)
+  {
+    core[point] = (neighbors.size() + 1 >= minPoints);
+  });
+
+  // The neighbors of each point are sorted by index, so the first core
+  // neighbor is the one with the smallest index.
+  rangeSearch.Search(math::Range(0.0, epsilon),
+      [&](const size_t point,
+          const std::vector<size_t>& neighbors,
+          const std::vector<double>& /* distances */)
+  {
+    for (size_t j = 0; j < neighbors.size(); ++j)
+    {
+      if (!core[neighbors[j]])
+        continue;
+
+      if (!core[point])
+      {
+        assignments[point] = neighbors[j];
+        break;
+      }
+      else if (neighbors[j] > point)
+      {
+        components.Union(point, neighbors[j]);
+      }
+    }
+  });
+}
+
+template<typename RangeSearchType, typename PointSelectionPolicy>
+size_t DBSCAN<RangeSearchType, PointSelectionPolicy>::LabelClusters(
+    const std::vector<char>& core,
+    ConcurrentUnionFind& components,
+    arma::Row<size_t>& assignments)
+{
+  // The root of each cluster is its smallest core point, so it is labeled
+  // before the other points of the cluster.
+  size_t numClusters = 0;
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+  {
+    if (!core[i])
+      continue;
+
+    const size_t root = components.Find(i);
+    assignments[i] = (root == i) ? numClusters++ : assignments[root];
+  }
+
+  // Every other point takes the cluster of its core neighbor, if it has one.
+  for (size_t i = 0; i < assignments.n_elem; ++i)
+    if (!core[i] && assignments[i] != SIZE_MAX)
+      assignments[i] = assignments[assignments[i]];
+
+  return numClusters;
 }
 
 } // namespace dbscan
@@ -37,6 +37,8 @@ PROGRAM_INFO("DBSCAN clustering",
     " 'r-star', 'x', 'hilbert-r', 'r-plus', 'r-plus-plus', 'cover', 'ball'. "
     "The --single_mode option will force single-tree search (as opposed to the "
     "default dual-tree search), and --naive will force brute-force range "
+    "search.  These parameters have no effect on datasets with at most three "
+    "dimensions, which are clustered with a grid of cells instead of a range "
     "search."
     "\n\n"
     "An example usage to run DBSCAN on the dataset in input.csv with a radius "
@@ -284,6 +284,48 @@ class FastMKS
   //! Use a priority queue to represent the list of candidate points.
   typedef std::priority_queue<Candidate, std::vector<Candidate>,
       CandidateCmp> CandidateList;
+
+  /**
+   * Run single-tree search on the reference tree for the first numQueries
+   * points of the query set held by the given rules.  If OpenMP is available,
+   * the query points are split between threads, each with its own rules object
+   * that shares the candidate lists of the given rules.
+   *
+   * @param numQueries Number of query points to search for.
+   * @param rules Rules object that holds the results.
+   * @return Number of nodes pruned during the traversals.
+   */
+  template<typename RuleType>
+  size_t SingleTreeSearch(const size_t numQueries, RuleType& rules);
+
+  /**
+   * Give the statistic of every node in the given tree the given number of
+   * empty slots for the kernel evaluations of parallel single-tree searches
+   * (see FastMKSStat::ThreadKernels()).
+   *
+   * @param node Root of the tree to reset.
+   * @param threads Number of threads that will search the tree.
+   */
+  void ResetThreadKernels(Tree& node, const size_t threads);
+
+  /**
+   * Run brute-force search for each point in the query set.  The kernel values
+   * are computed for a block of query points and a block of reference points
+   * at a time; for kernels that are computed from inner products (see
+   * KernelTraits::UsesInnerProduct), each block is one matrix multiplication.
+   *
+   * @param querySet Set of query points.
+   * @param monochromatic If true, the query set is the reference set, and
+   *     points are not returned as their own candidates.
+   * @param k Number of max-kernel candidates to search for.
+   * @param indices Matrix to store resulting indices of max-kernel search in.
+   * @param kernels Matrix to store resulting max-kernel values in.
+   */
+  void NaiveSearch(const MatType& querySet,
+                   const bool monochromatic,
+                   const size_t k,
+                   arma::Mat<size_t>& indices,
+                   arma::mat& kernels);
 };
 
 } // namespace fastmks
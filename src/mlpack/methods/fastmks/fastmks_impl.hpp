@@ -22,6 +22,48 @@
 namespace mlpack {
 namespace fastmks {
 
+//! Evaluate a block of kernel values with one matrix multiplication.
+template<typename KernelType, typename MatType>
+void EvaluateBlock(
+    KernelType& kernel,
+    const MatType& referenceSet,
+    const size_t referenceBegin,
+    const size_t referenceCount,
+    const MatType& querySet,
+    const size_t queryBegin,
+    const size_t queryCount,
+    arma::mat& block,
+    const typename std::enable_if_t<
+        kernel::KernelTraits<KernelType>::UsesInnerProduct
+    >* = 0)
+{
+  kernel.EvaluateBlock(
+      referenceSet.cols(referenceBegin, referenceBegin + referenceCount - 1),
+      querySet.cols(queryBegin, queryBegin + queryCount - 1), block);
+}
+
+//! Evaluate a block of kernel values one pair of points at a time.
+template<typename KernelType, typename MatType>
+void EvaluateBlock(
+    KernelType& kernel,
+    const MatType& referenceSet,
+    const size_t referenceBegin,
+    const size_t referenceCount,
+    const MatType& querySet,
+    const size_t queryBegin,
+    const size_t queryCount,
+    arma::mat& block,
+    const typename std::enable_if_t<
+        !kernel::KernelTraits<KernelType>::UsesInnerProduct
+    >* = 0)
+{
+  block.set_size(referenceCount, queryCount);
+  for (size_t q = 0; q < queryCount; ++q)
+    for (size_t r = 0; r < referenceCount; ++r)
+      block(r, q) = kernel.Evaluate(querySet.col(queryBegin + q),
+          referenceSet.col(referenceBegin + r));
+}
+
 // No data; create a model on an empty dataset.
 template<typename KernelType,
          typename MatType,
@@ -304,33 +346,7 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
-    {
-      const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
-      std::vector<Candidate> cList(k, def);
-      CandidateList pqueue(CandidateCmp(), std::move(cList));
-
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
-      {
-        const double eval = metric.Kernel().Evaluate(querySet.col(q),
-                                                     referenceSet->col(r));
-
-        if (eval > pqueue.top().first)
-        {
-          Candidate c = std::make_pair(eval, r);
-          pqueue.pop();
-          pqueue.push(c);
-        }
-      }
-
-      for (size_t j = 1; j <= k; j++)
-      {
-        indices(k - j, q) = pqueue.top().second;
-        kernels(k - j, q) = pqueue.top().first;
-        pqueue.pop();
-      }
-    }
+    NaiveSearch(querySet, false, k, indices, kernels);
 
     Timer::Stop("computing_products");
 
@@ -345,10 +361,7 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     typedef FastMKSRules<KernelType, Tree> RuleType;
     RuleType rules(*referenceSet, querySet, k, metric.Kernel());
 
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    SingleTreeSearch(querySet.n_cols, rules);
 
     Log::Info << rules.BaseCases() << " base cases." << std::endl;
     Log::Info << rules.Scores() << " scores." << std::endl;
@@ -433,36 +446,7 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < referenceSet->n_cols; ++q)
-    {
-      const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
-      std::vector<Candidate> cList(k, def);
-      CandidateList pqueue(CandidateCmp(), std::move(cList));
-
-      for (size_t r = 0; r < referenceSet->n_cols; ++r)
-      {
-        if (q == r)
-          continue; // Don't return the point as its own candidate.
-
-        const double eval = metric.Kernel().Evaluate(referenceSet->col(q),
-                                                     referenceSet->col(r));
-
-        if (eval > pqueue.top().first)
-        {
-          Candidate c = std::make_pair(eval, r);
-          pqueue.pop();
-          pqueue.push(c);
-        }
-      }
-
-      for (size_t j = 1; j <= k; j++)
-      {
-        indices(k - j, q) = pqueue.top().second;
-        kernels(k - j, q) = pqueue.top().first;
-        pqueue.pop();
-      }
-    }
+    NaiveSearch(*referenceSet, true, k, indices, kernels);
 
     Timer::Stop("computing_products");
 
@@ -477,13 +461,8 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     typedef FastMKSRules<KernelType, Tree> RuleType;
     RuleType rules(*referenceSet, *referenceSet, k, metric.Kernel());
 
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
     // Save the number of pruned nodes.
-    const size_t numPrunes = traverser.NumPrunes();
+    const size_t numPrunes = SingleTreeSearch(referenceSet->n_cols, rules);
 
     Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
 
@@ -502,6 +481,155 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
   Search(referenceTree, k, indices, kernels);
 }
 
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename RuleType>
+size_t FastMKS<KernelType, MatType, TreeType>::SingleTreeSearch(
+    const size_t numQueries,
+    RuleType& rules)
+{
+  size_t numPrunes = 0;
+
+#ifdef HAS_OPENMP
+  if (omp_get_max_threads() > 1)
+  {
+    size_t parallelScores = 0;
+    size_t parallelBaseCases = 0;
+
+    // Give each thread its own slot for kernel evaluations in every node.
+    ResetThreadKernels(*referenceTree, omp_get_max_threads());
+
+    #pragma omp parallel reduction(+:numPrunes, parallelScores, \
+        parallelBaseCases)
+    {
+      // Each thread gets its own rules and traverser; the results are stored in
+      // the candidate lists of the given rules.
+      RuleType threadRules(rules, omp_get_thread_num());
+      typename Tree::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+#ifdef _WIN32
+      // Visual Studio only implements OpenMP 2.0, which doesn't support
+      // unsigned loop variables.
+      #pragma omp for schedule(dynamic)
+      for (intmax_t i = 0; i < (intmax_t) numQueries; ++i)
+#else
+      #pragma omp for schedule(dynamic)
+      for (size_t i = 0; i < numQueries; ++i)
+#endif
+        traverser.Traverse(i, *referenceTree);
+
+      numPrunes += traverser.NumPrunes();
+      parallelScores += threadRules.Scores();
+      parallelBaseCases += threadRules.BaseCases();
+    }
+
+    rules.Scores() += parallelScores;
+    rules.BaseCases() += parallelBaseCases;
+    return numPrunes;
+  }
+#endif
+
+  typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+  for (size_t i = 0; i < numQueries; ++i)
+    traverser.Traverse(i, *referenceTree);
+
+  numPrunes = traverser.NumPrunes();
+  return numPrunes;
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::ResetThreadKernels(
+    Tree& node,
+    const size_t threads)
+{
+  // No query point has the index size_t() - 1, so no slot holds an evaluation
+  // yet.
+  node.Stat().ThreadKernels().assign(threads,
+      std::make_pair(size_t() - 1, 0.0));
+
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    ResetThreadKernels(node.Child(i), threads);
+}
+
+//! Brute-force search, one block of points at a time.
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::NaiveSearch(
+    const MatType& querySet,
+    const bool monochromatic,
+    const size_t k,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  // The blocks are small enough to stay in cache, but large enough for the
+  // matrix multiplications to be efficient.
+  const size_t queryBlockSize = 256;
+  const size_t referenceBlockSize = 1024;
+
+  const Candidate def = std::make_pair(-DBL_MAX, size_t() - 1);
+  std::vector<CandidateList> pqueues;
+  arma::mat block;
+  for (size_t queryBegin = 0; queryBegin < querySet.n_cols;
+       queryBegin += queryBlockSize)
+  {
+    const size_t queryCount = std::min(queryBlockSize,
+        (size_t) querySet.n_cols - queryBegin);
+    pqueues.assign(queryCount, CandidateList(CandidateCmp(),
+        std::vector<Candidate>(k, def)));
+
+    for (size_t referenceBegin = 0; referenceBegin < referenceSet->n_cols;
+         referenceBegin += referenceBlockSize)
+    {
+      const size_t referenceCount = std::min(referenceBlockSize,
+          (size_t) referenceSet->n_cols - referenceBegin);
+      EvaluateBlock(metric.Kernel(), *referenceSet, referenceBegin,
+          referenceCount, querySet, queryBegin, queryCount, block);
+
+      for (size_t q = 0; q < queryCount; ++q)
+      {
+        CandidateList& pqueue = pqueues[q];
+        for (size_t r = 0; r < referenceCount; ++r)
+        {
+          // Don't return the point as its own candidate.
+          if (monochromatic && (queryBegin + q == referenceBegin + r))
+            continue;
+
+          const double eval = block(r, q);
+          if (eval > pqueue.top().first)
+          {
+            Candidate c = std::make_pair(eval, referenceBegin + r);
+            pqueue.pop();
+            pqueue.push(c);
+          }
+        }
+      }
+    }
+
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+      CandidateList& pqueue = pqueues[q];
+      for (size_t j = 1; j <= k; j++)
+      {
+        indices(k - j, queryBegin + q) = pqueue.top().second;
+        kernels(k - j, queryBegin + q) = pqueue.top().first;
+        pqueue.pop();
+      }
+    }
+  }
+}
+
 //! Serialize the model.
 template<typename KernelType,
          typename MatType,
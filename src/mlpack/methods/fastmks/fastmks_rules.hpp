@@ -48,6 +48,28 @@ class FastMKSRules
                const size_t k,
                KernelType& kernel);
 
+  /**
+   * Construct a FastMKSRules object that shares the candidate lists and the
+   * cached self-kernels of the given FastMKSRules object, but has its own
+   * traversal info and its own base case and score counters.  This is used to
+   * run several single-tree traversals in parallel; each traversal must work on
+   * a disjoint set of query points.  Because the reference tree is shared, a
+   * rules object constructed this way caches the kernel evaluations for the
+   * reference nodes in the slot of the node statistics given by the thread
+   * index (see FastMKSStat::ThreadKernels()), which must be set up before the
+   * traversals start.  The given rules object must outlive this object.
+   *
+   * @param other FastMKSRules object whose candidate lists are used.
+   * @param thread Index of the thread that uses this object.
+   */
+  FastMKSRules(FastMKSRules& other, const size_t thread);
+
+  /**
+   * Destroy the FastMKSRules object, freeing the candidate lists if they are
+   * owned by this object.
+   */
+  ~FastMKSRules();
+
   /**
    * Store the list of candidates for each query point in the given matrices.
    *
@@ -148,8 +170,12 @@ class FastMKSRules
   typedef boost::heap::priority_queue<Candidate,
       boost::heap::compare<CandidateCmp>> CandidateList;
 
-  //! Set of candidates for each point.
-  std::vector<CandidateList> candidates;
+  //! Set of candidates for each point.  These may belong to another
+  //! FastMKSRules object.
+  std::vector<CandidateList>* candidates;
+
+  //! If true, this object owns the candidate lists.
+  bool candidatesOwner;
 
   //! Number of points to search for.
   const size_t k;
@@ -169,6 +195,64 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! Indices of the centroids of the children of a node, held in the class so
+  //! that they aren't continually being reallocated.
+  arma::uvec childIndices;
+  //! Centroids of the children of a node.
+  typename TreeType::Mat childPoints;
+  //! Kernels between a query point and the centroids of the children of a
+  //! node.
+  arma::mat childKernels;
+
+  //! The thread slot of the node statistics that kernel evaluations are cached
+  //! in, if this object shares its candidate lists (see the sharing
+  //! constructor).
+  size_t thread;
+
+  //! Get the last kernel evaluation between the given query point and the
+  //! centroid of the given reference node.  Returns false if there is none, in
+  //! which case kernelEval is not modified and must not be used as a bound.
+  bool NodeKernel(const TreeType& referenceNode,
+                  const size_t queryIndex,
+                  double& kernelEval) const;
+
+  //! Store the last kernel evaluation between the given query point and the
+  //! centroid of the given reference node.
+  void NodeKernel(TreeType& referenceNode,
+                  const size_t queryIndex,
+                  const double kernelEval);
+
+  //! Whether the kernels of the children of a reference node are evaluated all
+  //! at once (see ChildKernels()).
+  static const bool BlockChildKernels =
+      kernel::KernelTraits<KernelType>::UsesInnerProduct &&
+      tree::TreeTraits<TreeType>::FirstPointIsCentroid &&
+      !arma::is_SpMat<typename TreeType::Mat>::value;
+
+  //! Compute the base case between two points, given the kernel value between
+  //! them.
+  double BaseCase(const size_t queryIndex,
+                  const size_t referenceIndex,
+                  const double kernelEval);
+
+  /**
+   * Evaluate the kernels between the given query point and the centroids of
+   * all children of the given reference node with one call to the kernel's
+   * EvaluateBlock(), and store them as the last kernel evaluations of the
+   * children (see NodeKernel()), so that Score() finds the kernel of each
+   * child without evaluating it again.  This is only done if
+   * BlockChildKernels is true.
+   */
+  void ChildKernels(const size_t queryIndex,
+                    TreeType& referenceNode,
+                    std::true_type /* blockKernels */);
+
+  //! Do nothing, since the kernels of the children are evaluated one at a
+  //! time.
+  void ChildKernels(const size_t /* queryIndex */,
+                    TreeType& /* referenceNode */,
+                    std::false_type /* blockKernels */) { }
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
@@ -26,11 +26,14 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     KernelType& kernel) :
     referenceSet(referenceSet),
     querySet(querySet),
+    candidates(new std::vector<CandidateList>()),
+    candidatesOwner(true),
     k(k),
     kernel(kernel),
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
+    thread(0),
     baseCases(0),
     scores(0)
 {
@@ -61,7 +64,39 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
   for (size_t i = 0; i < k; i++)
     pqueue.push(def);
   std::vector<CandidateList> tmp(querySet.n_cols, pqueue);
-  candidates.swap(tmp);
+  candidates->swap(tmp);
+}
+
+template<typename KernelType, typename TreeType>
+FastMKSRules<KernelType, TreeType>::FastMKSRules(FastMKSRules& other,
+                                                 const size_t thread) :
+    referenceSet(other.referenceSet),
+    querySet(other.querySet),
+    candidates(other.candidates),
+    candidatesOwner(false),
+    k(other.k),
+    // Alias the self-kernels of the other object instead of copying them.
+    queryKernels(other.queryKernels.memptr(), other.queryKernels.n_elem, false,
+        true),
+    referenceKernels(other.referenceKernels.memptr(),
+        other.referenceKernels.n_elem, false, true),
+    kernel(other.kernel),
+    lastQueryIndex(-1),
+    lastReferenceIndex(-1),
+    lastKernel(0.0),
+    thread(thread),
+    baseCases(0),
+    scores(0)
+{
+  traversalInfo.LastQueryNode() = (TreeType*) this;
+  traversalInfo.LastReferenceNode() = (TreeType*) this;
+}
+
+template<typename KernelType, typename TreeType>
+FastMKSRules<KernelType, TreeType>::~FastMKSRules()
+{
+  if (candidatesOwner)
+    delete candidates;
 }
 
 template<typename KernelType, typename TreeType>
@@ -74,7 +109,7 @@ void FastMKSRules<KernelType, TreeType>::GetResults(
 
   for (size_t i = 0; i < querySet.n_cols; i++)
   {
-    CandidateList& pqueue = candidates[i];
+    CandidateList& pqueue = (*candidates)[i];
     for (size_t j = 1; j <= k; j++)
     {
       indices(k - j, i) = pqueue.top().second;
@@ -94,6 +129,22 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
   // cover trees, the kernel evaluation between the two centroid points already
   // happened.  So we don't need to do it.  Note that this optimizes out if the
   // first conditional is false (its result is known at compile time).
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid &&
+      (queryIndex == lastQueryIndex) && (referenceIndex == lastReferenceIndex))
+    return lastKernel;
+
+  return BaseCase(queryIndex, referenceIndex,
+      kernel.Evaluate(querySet.col(queryIndex),
+                      referenceSet.col(referenceIndex)));
+}
+
+template<typename KernelType, typename TreeType>
+inline force_inline
+double FastMKSRules<KernelType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex,
+    const double kernelEval)
+{
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
   {
     if ((queryIndex == lastQueryIndex) &&
@@ -103,15 +154,10 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
     // Store new values.
     lastQueryIndex = queryIndex;
     lastReferenceIndex = referenceIndex;
+    lastKernel = kernelEval;
   }
 
   ++baseCases;
-  double kernelEval = kernel.Evaluate(querySet.col(queryIndex),
-                                      referenceSet.col(referenceIndex));
-
-  // Update the last kernel value, if we need to.
-  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
-    lastKernel = kernelEval;
 
   // If the reference and query sets are identical, we still need to compute the
   // base case (so that things can be bounded properly), but we won't add it to
@@ -129,25 +175,26 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
   // Compare with the current best.
-  const double bestKernel = candidates[queryIndex].top().first;
+  const double bestKernel = (*candidates)[queryIndex].top().first;
 
   // See if we can perform a parent-child prune.
   const double furthestDist = referenceNode.FurthestDescendantDistance();
-  if (referenceNode.Parent() != NULL)
+  double parentKernel;
+  if (referenceNode.Parent() != NULL &&
+      NodeKernel(*referenceNode.Parent(), queryIndex, parentKernel))
   {
     double maxKernelBound;
     const double parentDist = referenceNode.ParentDistance();
     const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
     if (kernel::KernelTraits<KernelType>::IsNormalized)
     {
       const double squaredDist = std::pow(combinedDistBound, 2.0);
       const double delta = (1 - 0.5 * squaredDist);
-      if (lastKernel <= delta)
+      if (parentKernel <= delta)
       {
         const double gamma = combinedDistBound * sqrt(1 - 0.25 * squaredDist);
-        maxKernelBound = lastKernel * delta +
-             gamma * sqrt(1 - std::pow(lastKernel, 2.0));
+        maxKernelBound = parentKernel * delta +
+             gamma * sqrt(1 - std::pow(parentKernel, 2.0));
       }
       else
       {
@@ -156,7 +203,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     }
     else
     {
-      maxKernelBound = lastKernel +
+      maxKernelBound = parentKernel +
           combinedDistBound * queryKernels[queryIndex];
     }
 
@@ -171,15 +218,19 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
   {
     // Could it be that this kernel evaluation has already been calculated?
-    if (tree::TreeTraits<TreeType>::HasSelfChildren &&
+    if (!(tree::TreeTraits<TreeType>::HasSelfChildren &&
         referenceNode.Parent() != NULL &&
-        referenceNode.Point(0) == referenceNode.Parent()->Point(0))
+        referenceNode.Point(0) == referenceNode.Parent()->Point(0) &&
+        NodeKernel(*referenceNode.Parent(), queryIndex, kernelEval)))
     {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
-    }
-    else
-    {
-      kernelEval = BaseCase(queryIndex, referenceNode.Point(0));
+      // With kernels that use the inner product, the kernel was evaluated
+      // together with those of the siblings of this node, when the parent was
+      // scored (see ChildKernels()).
+      if (BlockChildKernels && referenceNode.Parent() != NULL &&
+          NodeKernel(referenceNode, queryIndex, kernelEval))
+        kernelEval = BaseCase(queryIndex, referenceNode.Point(0), kernelEval);
+      else
+        kernelEval = BaseCase(queryIndex, referenceNode.Point(0));
     }
   }
   else
@@ -190,7 +241,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     kernelEval = kernel.Evaluate(querySet.col(queryIndex), refCenter);
   }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+  NodeKernel(referenceNode, queryIndex, kernelEval);
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -213,9 +264,17 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     maxKernel = kernelEval + furthestDist * queryKernels[queryIndex];
   }
 
+  if (maxKernel < bestKernel)
+    return DBL_MAX;
+
+  // The children will be scored next, so evaluate their kernels now, all at
+  // once if possible.
+  ChildKernels(queryIndex, referenceNode,
+      std::integral_constant<bool, BlockChildKernels>());
+
   // We return the inverse of the maximum kernel so that larger kernels are
   // recursed into first.
-  return (maxKernel >= bestKernel) ? (1.0 / maxKernel) : DBL_MAX;
+  return 1.0 / maxKernel;
 }
 
 template<typename KernelType, typename TreeType>
@@ -412,7 +471,7 @@ double FastMKSRules<KernelType, TreeType>::Rescore(const size_t queryIndex,
                                                    TreeType& /*referenceNode*/,
                                                    const double oldScore) const
 {
-  const double bestKernel = candidates[queryIndex].top().first;
+  const double bestKernel = (*candidates)[queryIndex].top().first;
 
   return ((1.0 / oldScore) >= bestKernel) ? oldScore : DBL_MAX;
 }
@@ -459,7 +518,7 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
     const size_t point = queryNode.Point(i);
-    const CandidateList& candidatesPoints = candidates[point];
+    const CandidateList& candidatesPoints = (*candidates)[point];
     if (candidatesPoints.top().first < worstPointKernel)
       worstPointKernel = candidatesPoints.top().first;
 
@@ -516,6 +575,70 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   return (interA > interB) ? interA : interB;
 }
 
+template<typename KernelType, typename TreeType>
+void FastMKSRules<KernelType, TreeType>::ChildKernels(
+    const size_t queryIndex,
+    TreeType& referenceNode,
+    std::true_type /* blockKernels */)
+{
+  const size_t numChildren = referenceNode.NumChildren();
+  if (numChildren == 0)
+    return;
+
+  childIndices.set_size(numChildren);
+  for (size_t i = 0; i < numChildren; ++i)
+    childIndices[i] = referenceNode.Child(i).Point(0);
+  childPoints = referenceSet.cols(childIndices);
+
+  kernel.EvaluateBlock(childPoints, querySet.col(queryIndex), childKernels);
+  for (size_t i = 0; i < numChildren; ++i)
+    NodeKernel(referenceNode.Child(i), queryIndex, childKernels[i]);
+}
+
+template<typename KernelType, typename TreeType>
+inline bool FastMKSRules<KernelType, TreeType>::NodeKernel(
+    const TreeType& referenceNode,
+    const size_t queryIndex,
+    double& kernelEval) const
+{
+  // Rules objects that share their candidates with another object are used for
+  // parallel traversals, and other threads may be using the same statistics, so
+  // those objects use their own slot.  The slot may hold an evaluation for an
+  // earlier query point, which is no bound at all for this one.
+  if (candidatesOwner)
+  {
+    kernelEval = referenceNode.Stat().LastKernel();
+    return true;
+  }
+
+  const std::vector<std::pair<size_t, double>>& threadKernels =
+      referenceNode.Stat().ThreadKernels();
+  if (thread >= threadKernels.size() ||
+      threadKernels[thread].first != queryIndex)
+    return false;
+
+  kernelEval = threadKernels[thread].second;
+  return true;
+}
+
+template<typename KernelType, typename TreeType>
+inline void FastMKSRules<KernelType, TreeType>::NodeKernel(
+    TreeType& referenceNode,
+    const size_t queryIndex,
+    const double kernelEval)
+{
+  if (candidatesOwner)
+  {
+    referenceNode.Stat().LastKernel() = kernelEval;
+    return;
+  }
+
+  std::vector<std::pair<size_t, double>>& threadKernels =
+      referenceNode.Stat().ThreadKernels();
+  if (thread < threadKernels.size())
+    threadKernels[thread] = std::make_pair(queryIndex, kernelEval);
+}
+
 /**
  * Helper function to insert a point into the list of candidate points.
  *
@@ -529,7 +652,7 @@ inline void FastMKSRules<KernelType, TreeType>::InsertNeighbor(
     const size_t index,
     const double product)
 {
-  CandidateList& pqueue = candidates[queryIndex];
+  CandidateList& pqueue = (*candidates)[queryIndex];
   if (product > pqueue.top().first)
   {
     Candidate c = std::make_pair(product, index);
@@ -98,6 +98,15 @@ class FastMKSStat
   //! evaluation.
   void*& LastKernelNode() { return lastKernelNode; }
 
+  //! Get the last kernel evaluation of each thread of a parallel single-tree
+  //! search, with the index of the query point it was made for.
+  const std::vector<std::pair<size_t, double>>& ThreadKernels() const
+  { return threadKernels; }
+  //! Modify the last kernel evaluation of each thread of a parallel
+  //! single-tree search.
+  std::vector<std::pair<size_t, double>>& ThreadKernels()
+  { return threadKernels; }
+
   //! Serialize the statistic.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
@@ -110,6 +119,7 @@ class FastMKSStat
     {
       lastKernel = 0.0;
       lastKernelNode = NULL;
+      threadKernels.clear();
     }
   }
 
@@ -126,6 +136,10 @@ class FastMKSStat
   //! The node corresponding to the last kernel evaluation.  This has to be void
   //! otherwise we get recursive template arguments.
   void* lastKernelNode;
+
+  //! The last kernel evaluation of each thread of a parallel single-tree
+  //! search, and the index of the query point it was made for.
+  std::vector<std::pair<size_t, double>> threadKernels;
 };
 
 } // namespace fastmks
@@ -30,6 +30,22 @@ namespace kmeans {
  * dataset.  The conditions under which this will perform best are probably
  * limited to the case where k is close to the number of points in the dataset,
  * and the number of iterations of the k-means algorithm will be few.
+ *
+ * The tree built on the centroids is kept between iterations for as long as
+ * the centroids stay close to the positions it was built on: until some
+ * centroid has moved further than a tenth of the average distance between a
+ * centroid and its nearest other centroid.  In the meantime, the bounds that
+ * the traversal gets from the centroid tree are loosened by the largest
+ * distance a centroid has moved since the tree was built, and the distances
+ * between centroids are bounded from the last exact ones and the movement of
+ * the centroids.  The tree statistics are therefore only allocated when the
+ * tree is rebuilt.
+ *
+ * With OpenMP, the top of the tree built on the dataset is split into
+ * independent subtrees, each of which is traversed against the centroid tree
+ * in parallel.  The assignments are exact whatever the number of threads, but
+ * since the subtrees prune differently from a single traversal, the new
+ * centroids may differ in the last bits.
  */
 template<
     typename MetricType,
@@ -93,6 +109,23 @@ class DualTreeKMeans
   //! Track iteration number.
   size_t iteration;
 
+  //! Convenience typedef for the nearest neighbor search on the centroids.
+  typedef neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType,
+      MatType, NNSTreeType> NNSType;
+
+  //! The nearest neighbor search object, which holds the centroid tree.
+  NNSType* nns;
+  //! The centroids the centroid tree was built on.  (Not every tree type
+  //! copies its dataset, so these must not change until the next build.)
+  arma::mat treeBuildCentroids;
+  //! The current centroids, in the order of the centroid tree.
+  arma::mat treeCentroids;
+  //! Mappings from the order of the centroid tree to the original order.
+  std::vector<size_t> oldFromNewCentroids;
+  //! The average distance between a centroid and its nearest other centroid,
+  //! when the centroid tree was built.
+  double treeBuildSpacing;
+
   //! Upper bounds on nearest centroid.
   arma::vec upperBounds;
   //! Lower bounds on second closest cluster distance for each point.
@@ -102,11 +135,15 @@ class DualTreeKMeans
 
   arma::Row<size_t> assignments;
 
-  std::vector<bool> visited; // Was the point visited this iteration?
+  // Was the point visited this iteration?  (This is not a std::vector<bool>,
+  // since points are visited from several threads.)
+  std::vector<char> visited;
 
   arma::mat lastIterationCentroids; // For sanity checks.
 
-  arma::vec clusterDistances; // The amount the clusters moved last iteration.
+  // The amount the clusters moved since the last iteration, and the maximum
+  // movement.
+  arma::vec clusterDistances;
 
   arma::mat interclusterDistances; // Static storage for intercluster distances.
 
@@ -125,6 +162,15 @@ class DualTreeKMeans
                         arma::Col<size_t>& newCounts,
                         const arma::mat& centroids);
 
+  //! Build the centroid tree on the given centroids, and find the distance
+  //! from each centroid to its nearest other centroid.
+  void BuildCentroidTree(const arma::mat& centroids);
+
+  //! Traverse the dataset tree and the centroid tree with the given rules, in
+  //! parallel if possible.
+  template<typename RuleType>
+  void DualTreeTraverse(RuleType& rules);
+
   void CoalesceTree(Tree& node, const size_t child = 0);
   void DecoalesceTree(Tree& node);
 };
@@ -20,6 +20,8 @@
 
 #include "dual_tree_kmeans_rules.hpp"
 
+#include <queue>
+
 namespace mlpack {
 namespace kmeans {
 
@@ -63,6 +65,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
     metric(metric),
     distanceCalculations(0),
     iteration(0),
+    nns(NULL),
+    treeBuildSpacing(0.0),
     upperBounds(dataset.n_cols),
     lowerBounds(dataset.n_cols),
     prunedPoints(dataset.n_cols, false), // Fill with false.
@@ -88,6 +92,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::~DualTreeKMeans()
 {
   if (tree)
     delete tree;
+  if (nns)
+    delete nns;
 }
 
 // Run a single iteration.
@@ -101,43 +107,58 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     arma::mat& newCentroids,
     arma::Col<size_t>& counts)
 {
-  // Build a tree on the centroids.  This will make a copy if necessary, which
-  // is unfortunate, but I don't see a reasonable way around it.
-  std::vector<size_t> oldFromNewCentroids;
-  Tree* centroidTree = BuildTree<Tree>(centroids, oldFromNewCentroids);
-
-  // Find the nearest neighbors of each of the clusters.  We have to make our
-  // own TreeType, which is a little bit abuse, but we know for sure the
-  // TreeStatType we have will work.
-  neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType, MatType,
-      NNSTreeType> nns(std::move(*centroidTree));
-
-  // Reset information in the tree, if we need to.
+  // Find how far each centroid has moved since the last iteration, and since
+  // the centroid tree was built.  (The movement computed at the end of the last
+  // iteration can't be used, because the empty cluster policy may have moved
+  // some centroids since.)
+  double drift = 0.0;
   if (iteration > 0)
   {
-    Timer::Start("knn");
-
-    // If the tree maps points, we need an intermediate result matrix.
-    arma::mat* interclusterDistancesTemp =
-        (tree::TreeTraits<Tree>::RearrangesDataset) ?
-        new arma::mat(1, centroids.n_elem) : &interclusterDistances;
+    clusterDistances[centroids.n_cols] = 0.0;
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+    {
+      clusterDistances[c] = metric.Evaluate(centroids.col(c),
+          lastIterationCentroids.col(c));
+      if (clusterDistances[c] > clusterDistances[centroids.n_cols])
+        clusterDistances[centroids.n_cols] = clusterDistances[c];
 
-    arma::Mat<size_t> closestClusters; // We don't actually care about these.
-    nns.Search(1, closestClusters, *interclusterDistancesTemp);
-    distanceCalculations += nns.BaseCases() + nns.Scores();
+      drift = std::max(drift, metric.Evaluate(centroids.col(c),
+          treeBuildCentroids.col(c)));
+    }
+    distanceCalculations += 2 * centroids.n_cols;
+  }
 
-    // We need to do the unmapping ourselves, if the tree does mapping.
-    if (tree::TreeTraits<Tree>::RearrangesDataset)
+  // Building a tree on the centroids allocates all its statistics again, so we
+  // keep the old tree until the centroids have moved too far from where it was
+  // built, relative to the distances between them.  Until then, the traversal
+  // loosens its bounds by the drift.
+  if (nns == NULL || drift > 0.1 * treeBuildSpacing)
+  {
+    BuildCentroidTree(centroids);
+    drift = 0.0;
+  }
+  else
+  {
+    // The centroid tree holds the centroids in its own order.
+    for (size_t i = 0; i < treeCentroids.n_cols; ++i)
     {
-      for (size_t i = 0; i < interclusterDistances.n_elem; ++i)
-        interclusterDistances[oldFromNewCentroids[i]] =
-            (*interclusterDistancesTemp)[i];
-
-      delete interclusterDistancesTemp;
+      treeCentroids.col(i) = centroids.col(
+          tree::TreeTraits<Tree>::RearrangesDataset ? oldFromNewCentroids[i] :
+          i);
     }
 
-    Timer::Stop("knn");
+    // Two centroids can't have come closer than their last distance, minus the
+    // movement of both.
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+    {
+      interclusterDistances[c] = std::max(interclusterDistances[c] -
+          clusterDistances[c] - clusterDistances[centroids.n_cols], 0.0);
+    }
+  }
 
+  // Reset information in the tree, if we need to.
+  if (iteration > 0)
+  {
     UpdateTree(*tree, centroids);
 
     for (size_t i = 0; i < dataset.n_cols; ++i)
@@ -147,26 +168,19 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
   {
     // Not initialized yet.
     clusterDistances.set_size(centroids.n_cols + 1);
-    interclusterDistances.set_size(1, centroids.n_cols);
   }
 
   // We won't use the KNN class here because we have our own set of rules.
   lastIterationCentroids = centroids;
   typedef DualTreeKMeansRules<MetricType, Tree> RuleType;
-  RuleType rules(nns.ReferenceTree().Dataset(), dataset, assignments,
-      upperBounds, lowerBounds, metric, prunedPoints, oldFromNewCentroids,
-      visited);
-
-  typename Tree::template BreadthFirstDualTreeTraverser<RuleType>
-      traverser(rules);
+  RuleType rules(treeCentroids, dataset, assignments, upperBounds, lowerBounds,
+      metric, prunedPoints, oldFromNewCentroids, visited, drift);
 
   Timer::Start("tree_mod");
   CoalesceTree(*tree);
   Timer::Stop("tree_mod");
 
-  // Set the number of pruned centroids in the root to 0.
-  tree->Stat().Pruned() = 0;
-  traverser.Traverse(*tree, nns.ReferenceTree());
+  DualTreeTraverse(rules);
   distanceCalculations += rules.BaseCases() + rules.Scores();
 
   Timer::Start("tree_mod");
@@ -180,34 +194,173 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
 
   // Now, calculate how far the clusters moved, after normalizing them.
   double residual = 0.0;
-  clusterDistances[centroids.n_cols] = 0.0;
   for (size_t c = 0; c < centroids.n_cols; ++c)
   {
-    if (counts[c] == 0)
-    {
-      clusterDistances[c] = 0;
-    }
-    else
+    if (counts[c] > 0)
     {
       newCentroids.col(c) /= counts(c);
-      const double movement = metric.Evaluate(centroids.col(c),
-          newCentroids.col(c));
-      clusterDistances[c] = movement;
-      residual += std::pow(movement, 2.0);
-
-      if (movement > clusterDistances[centroids.n_cols])
-        clusterDistances[centroids.n_cols] = movement;
+      residual += std::pow(metric.Evaluate(centroids.col(c),
+          newCentroids.col(c)), 2.0);
+      ++distanceCalculations;
     }
   }
-  distanceCalculations += centroids.n_cols;
-
-  delete centroidTree;
 
   ++iteration;
 
   return std::sqrt(residual);
 }
 
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DualTreeKMeans<MetricType, MatType, TreeType>::BuildCentroidTree(
+    const arma::mat& centroids)
+{
+  // Build a tree on the centroids.  This will make a copy if necessary, which
+  // is unfortunate, but I don't see a reasonable way around it.  The old tree
+  // must be deleted first, since it may reference the old centroids.
+  delete nns;
+  treeBuildCentroids = centroids;
+  oldFromNewCentroids.clear();
+  Tree* centroidTree = BuildTree<Tree>(treeBuildCentroids, oldFromNewCentroids);
+
+  // Find the nearest neighbors of each of the clusters.  We have to make our
+  // own TreeType, which is a little bit abuse, but we know for sure the
+  // TreeStatType we have will work.
+  nns = new NNSType(std::move(*centroidTree));
+  delete centroidTree;
+
+  treeCentroids = nns->ReferenceTree().Dataset();
+  interclusterDistances.set_size(1, centroids.n_cols);
+  if (centroids.n_cols < 2)
+  {
+    // There is no other cluster.
+    interclusterDistances.fill(DBL_MAX);
+    treeBuildSpacing = 0.0;
+    return;
+  }
+
+  Timer::Start("knn");
+
+  // If the tree maps points, we need an intermediate result matrix.
+  arma::mat* interclusterDistancesTemp =
+      (tree::TreeTraits<Tree>::RearrangesDataset) ?
+      new arma::mat(1, centroids.n_cols) : &interclusterDistances;
+
+  arma::Mat<size_t> closestClusters; // We don't actually care about these.
+  nns->Search(1, closestClusters, *interclusterDistancesTemp);
+  distanceCalculations += nns->BaseCases() + nns->Scores();
+
+  // We need to do the unmapping ourselves, if the tree does mapping.
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    for (size_t i = 0; i < interclusterDistances.n_elem; ++i)
+      interclusterDistances[oldFromNewCentroids[i]] =
+          (*interclusterDistancesTemp)[i];
+
+    delete interclusterDistancesTemp;
+  }
+
+  Timer::Stop("knn");
+
+  // Centroids of empty clusters may have been moved to DBL_MAX, so ignore
+  // distances that overflowed.
+  const arma::uvec finite = arma::find_finite(interclusterDistances);
+  treeBuildSpacing = (finite.n_elem == 0) ? 0.0 :
+      arma::accu(interclusterDistances.elem(finite)) / finite.n_elem;
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename RuleType>
+void DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeTraverse(
+    RuleType& rules)
+{
+  typedef typename Tree::template BreadthFirstDualTreeTraverser<RuleType>
+      TraverserType;
+
+#ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+  if (numThreads > 1)
+  {
+    // Split the top of the (coalesced) dataset tree into independent subtrees,
+    // in the same way as NeighborSearch does.  Each subtree holds a disjoint
+    // set of points, and the rules only modify the statistics of query nodes
+    // and the bounds of query points, so the subtrees can be traversed in
+    // parallel.
+    typedef std::pair<size_t, Tree*> Task;
+    std::priority_queue<Task> tasks;
+    std::vector<Tree*> subtrees;
+    tasks.push(Task(tree->NumDescendants(), tree));
+    while (!tasks.empty() && (tasks.size() + subtrees.size()) < 8 * numThreads)
+    {
+      Tree* node = tasks.top().second;
+      tasks.pop();
+
+      if (node->IsLeaf() || (node->NumPoints() > 0 &&
+          !tree::TreeTraits<Tree>::HasSelfChildren))
+      {
+        subtrees.push_back(node);
+        continue;
+      }
+
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        tasks.push(Task(node->Child(i).NumDescendants(), &node->Child(i)));
+    }
+
+    while (!tasks.empty())
+    {
+      subtrees.push_back(tasks.top().second);
+      tasks.pop();
+    }
+
+    // The nodes above the subtrees are never scored, so each subtree starts
+    // like the root: nothing is pruned yet.
+    for (size_t i = 0; i < subtrees.size(); ++i)
+      if (!subtrees[i]->Stat().StaticPruned())
+        subtrees[i]->Stat().Pruned() = 0;
+
+    size_t parallelScores = 0;
+    size_t parallelBaseCases = 0;
+
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio, use
+    // the intmax_t type instead.
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelScores, parallelBaseCases)
+    for (intmax_t i = 0; i < (intmax_t) subtrees.size(); ++i)
+#else
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelScores, parallelBaseCases)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+#endif
+    {
+      RuleType subtreeRules(rules);
+      TraverserType traverser(subtreeRules);
+      traverser.Traverse(*subtrees[i], nns->ReferenceTree());
+
+      parallelScores += subtreeRules.Scores();
+      parallelBaseCases += subtreeRules.BaseCases();
+    }
+
+    rules.Scores() += parallelScores;
+    rules.BaseCases() += parallelBaseCases;
+    return;
+  }
+#endif
+
+  // Set the number of pruned centroids in the root to 0.
+  tree->Stat().Pruned() = 0;
+  TraverserType traverser(rules);
+  traverser.Traverse(*tree, nns->ReferenceTree());
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
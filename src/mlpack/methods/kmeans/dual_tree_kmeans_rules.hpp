@@ -31,7 +31,8 @@ class DualTreeKMeansRules
                       MetricType& metric,
                       const std::vector<bool>& prunedPoints,
                       const std::vector<size_t>& oldFromNewCentroids,
-                      std::vector<bool>& visited);
+                      std::vector<char>& visited,
+                      const double drift = 0.0);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
@@ -67,7 +68,11 @@ class DualTreeKMeansRules
 
   const std::vector<size_t>& oldFromNewCentroids;
 
-  std::vector<bool>& visited;
+  std::vector<char>& visited;
+
+  // The maximum distance between a centroid and its position when the
+  // reference tree was built.
+  double drift;
 
   size_t baseCases;
   size_t scores;
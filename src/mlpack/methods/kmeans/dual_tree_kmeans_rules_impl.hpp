@@ -27,7 +27,8 @@ DualTreeKMeansRules<MetricType, TreeType>::DualTreeKMeansRules(
     MetricType& metric,
     const std::vector<bool>& prunedPoints,
     const std::vector<size_t>& oldFromNewCentroids,
-    std::vector<bool>& visited) :
+    std::vector<char>& visited,
+    const double drift) :
     centroids(centroids),
     dataset(dataset),
     assignments(assignments),
@@ -37,6 +38,7 @@ DualTreeKMeansRules<MetricType, TreeType>::DualTreeKMeansRules(
     prunedPoints(prunedPoints),
     oldFromNewCentroids(oldFromNewCentroids),
     visited(visited),
+    drift(drift),
     baseCases(0),
     scores(0),
     lastQueryIndex(dataset.n_cols),
@@ -209,6 +211,12 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
     adjustedScore = 0.0;
   }
 
+  // The reference tree may have been built on older positions of the
+  // centroids.  Each centroid is within the drift of its old position, so the
+  // distance to a centroid, and the distance between two centroids, may
+  // both be less than the reference tree says, by up to twice the drift.
+  adjustedScore -= 2.0 * drift;
+
   // Now, check if we can prune.
   if (adjustedScore > queryNode.Stat().UpperBound())
   {
@@ -221,7 +229,7 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
       {
         // If this might affect the lower bound, make it more exact.
         queryNode.Stat().LowerBound() = std::min(queryNode.Stat().LowerBound(),
-            queryNode.MinDistance(referenceNode));
+            queryNode.MinDistance(referenceNode) - drift);
         ++scores;
       }
 
@@ -232,8 +240,11 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
 
   if (score != DBL_MAX)
   {
-    // Get minimum and maximum distances.
-    const math::Range distances = queryNode.RangeDistance(referenceNode);
+    // Get minimum and maximum distances, allowing for the centroids to have
+    // moved since the reference tree was built.
+    const math::Range treeDistances = queryNode.RangeDistance(referenceNode);
+    const math::Range distances(std::max(treeDistances.Lo() - drift, 0.0),
+        treeDistances.Hi() + drift);
 
     score = distances.Lo();
     ++scores;
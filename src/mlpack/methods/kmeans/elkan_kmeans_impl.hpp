@@ -15,6 +15,8 @@
 // In case it hasn't been included yet.
 #include "elkan_kmeans.hpp"
 
+#include "update_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -34,10 +36,6 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                  arma::mat& newCentroids,
                                                  arma::Col<size_t>& counts)
 {
-  // Clear new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // At the beginning of the iteration, we must compute the distances between
   // all centers.  This is O(k^2).
   clusterDistances.set_size(centroids.n_cols, centroids.n_cols);
@@ -46,9 +44,6 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // being the closest cluster centroid.
   clusterDistances.diag().fill(DBL_MAX);
 
-  // Initially set r(x) to true.
-  std::vector<bool> mustRecalculate(dataset.n_cols, true);
-
   // If this is the first iteration, we must reset all the bounds.
   if (lowerBounds.n_rows != centroids.n_cols)
   {
@@ -79,94 +74,114 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // that this is equivalent to s(c) for each cluster c.
   minClusterDistances = 0.5 * arma::min(clusterDistances).t();
 
-  // Now loop over all points, and see which ones need to be updated.
+  // Now loop over all points, and see which ones need to be updated.  The
+  // bounds and the assignment of each point are only touched by the thread
+  // that handles the point, so the points can be split between threads.
+  size_t pointDistanceCalculations = 0;
+
+  // Sparse matrices are not accessed in parallel.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic, 256) \
+      reduction(+:pointDistanceCalculations) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) dataset.n_cols; ++i)
+#else
+  #pragma omp parallel for schedule(dynamic, 256) \
+      reduction(+:pointDistanceCalculations) \
+      if(!arma::is_SpMat<MatType>::value)
   for (size_t i = 0; i < dataset.n_cols; ++i)
+#endif
   {
     // Step 2: identify all points such that u(x) <= s(c(x)).
     if (upperBounds(i) <= minClusterDistances(assignments[i]))
     {
       // No change needed.  This point must still belong to that cluster.
-      counts(assignments[i])++;
-      newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
       continue;
     }
-    else
+
+    // Initially set r(x) to true.
+    bool mustRecalculate = true;
+    for (size_t c = 0; c < centroids.n_cols; ++c)
     {
-      for (size_t c = 0; c < centroids.n_cols; ++c)
+      // Step 3: for all remaining points x and centers c such that c != c(x),
+      // u(x) > l(x, c) and u(x) > 0.5 d(c(x), c)...
+      if (assignments[i] == c)
+        continue; // Pruned because this cluster is already the assignment.
+
+      if (upperBounds(i) <= lowerBounds(c, i))
+        continue; // Pruned by triangle inequality on lower bound.
+
+      if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
+        continue; // Pruned by triangle inequality on cluster distances.
+
+      // Step 3a: if r(x) then compute d(x, c(x)) and assign r(x) = false.
+      // Otherwise, d(x, c(x)) = u(x).
+      double dist;
+      if (mustRecalculate)
       {
-        // Step 3: for all remaining points x and centers c such that c != c(x),
-        // u(x) > l(x, c) and u(x) > 0.5 d(c(x), c)...
-        if (assignments[i] == c)
-          continue; // Pruned because this cluster is already the assignment.
+        mustRecalculate = false;
+        dist = metric.Evaluate(dataset.col(i), centroids.col(assignments[i]));
+        lowerBounds(assignments[i], i) = dist;
+        upperBounds(i) = dist;
+        pointDistanceCalculations++;
 
+        // Check if we can prune again.
         if (upperBounds(i) <= lowerBounds(c, i))
           continue; // Pruned by triangle inequality on lower bound.
 
         if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
           continue; // Pruned by triangle inequality on cluster distances.
+      }
+      else
+      {
+        dist = upperBounds(i); // This is equivalent to d(x, c(x)).
+      }
 
-        // Step 3a: if r(x) then compute d(x, c(x)) and assign r(x) = false.
-        // Otherwise, d(x, c(x)) = u(x).
-        double dist;
-        if (mustRecalculate[i])
-        {
-          mustRecalculate[i] = false;
-          dist = metric.Evaluate(dataset.col(i), centroids.col(assignments[i]));
-          lowerBounds(assignments[i], i) = dist;
-          upperBounds(i) = dist;
-          distanceCalculations++;
-
-          // Check if we can prune again.
-          if (upperBounds(i) <= lowerBounds(c, i))
-            continue; // Pruned by triangle inequality on lower bound.
-
-          if (upperBounds(i) <= 0.5 * clusterDistances(assignments[i], c))
-            continue; // Pruned by triangle inequality on cluster distances.
-        }
-        else
-        {
-          dist = upperBounds(i); // This is equivalent to d(x, c(x)).
-        }
-
-        // Step 3b: if d(x, c(x)) > l(x, c) or d(x, c(x)) > 0.5 d(c(x), c)...
-        if (dist > lowerBounds(c, i) ||
-            dist > 0.5 * clusterDistances(assignments[i], c))
+      // Step 3b: if d(x, c(x)) > l(x, c) or d(x, c(x)) > 0.5 d(c(x), c)...
+      if (dist > lowerBounds(c, i) ||
+          dist > 0.5 * clusterDistances(assignments[i], c))
+      {
+        // Compute d(x, c).  If d(x, c) < d(x, c(x)) then assign c(x) = c.
+        const double pointDist = metric.Evaluate(dataset.col(i),
+                                                 centroids.col(c));
+        lowerBounds(c, i) = pointDist;
+        pointDistanceCalculations++;
+        if (pointDist < dist)
         {
-          // Compute d(x, c).  If d(x, c) < d(x, c(x)) then assign c(x) = c.
-          const double pointDist = metric.Evaluate(dataset.col(i),
-                                                   centroids.col(c));
-          lowerBounds(c, i) = pointDist;
-          distanceCalculations++;
-          if (pointDist < dist)
-          {
-            upperBounds(i) = pointDist;
-            assignments[i] = c;
-          }
+          upperBounds(i) = pointDist;
+          assignments[i] = c;
         }
       }
     }
-
-    // At this point, we know the new cluster assignment.
-    // Step 4: for each center c, let m(c) be the mean of the points assigned to
-    // c.
-    newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-    counts[assignments[i]]++;
   }
+  distanceCalculations += pointDistanceCalculations;
+
+  // At this point, we know the new cluster assignments.
+  // Step 4: for each center c, let m(c) be the mean of the points assigned to
+  // c.
+  UpdateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
 
-  // Now, normalize and calculate the distance each cluster has moved.
+  // Now, calculate the distance each cluster has moved.
   arma::vec moveDistances(centroids.n_cols);
   double cNorm = 0.0; // Cluster movement for residual.
   for (size_t c = 0; c < centroids.n_cols; ++c)
   {
-    if (counts[c] > 0)
-      newCentroids.col(c) /= counts[c];
-
     moveDistances(c) = metric.Evaluate(newCentroids.col(c), centroids.col(c));
     cNorm += std::pow(moveDistances(c), 2.0);
     distanceCalculations++;
   }
 
+#ifdef _WIN32
+  #pragma omp parallel for
+  for (intmax_t i = 0; i < (intmax_t) dataset.n_cols; ++i)
+#else
+  #pragma omp parallel for
   for (size_t i = 0; i < dataset.n_cols; ++i)
+#endif
   {
     // Step 5: for each point x and center c, assign
     //   l(x, c) = max { l(x, c) - d(c, m(c)), 0 }.
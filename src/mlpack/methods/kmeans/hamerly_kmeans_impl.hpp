@@ -15,6 +15,8 @@
 // In case it hasn't been included yet.
 #include "hamerly_kmeans.hpp"
 
+#include "update_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -45,10 +47,6 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     minClusterDistances.set_size(centroids.n_cols);
   }
 
-  // Reset new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // Calculate minimum intra-cluster distance for each cluster.
   minClusterDistances.fill(DBL_MAX);
   for (size_t i = 0; i < centroids.n_cols; ++i)
@@ -67,7 +65,25 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
   }
 
+  // The bounds and the assignment of each point are only touched by the thread
+  // that handles the point, so the points can be split between threads.
+  size_t pointDistanceCalculations = 0;
+
+  // Sparse matrices are not accessed in parallel.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic, 256) \
+      reduction(+:hamerlyPruned, pointDistanceCalculations) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) dataset.n_cols; ++i)
+#else
+  #pragma omp parallel for schedule(dynamic, 256) \
+      reduction(+:hamerlyPruned, pointDistanceCalculations) \
+      if(!arma::is_SpMat<MatType>::value)
   for (size_t i = 0; i < dataset.n_cols; ++i)
+#endif
   {
     const double m = std::max(minClusterDistances(assignments[i]),
                               lowerBounds(i));
@@ -76,23 +92,17 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     if (upperBounds(i) <= m)
     {
       ++hamerlyPruned;
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
       continue;
     }
 
     // Tighten upper bound.
     upperBounds(i) = metric.Evaluate(dataset.col(i),
                                      centroids.col(assignments[i]));
-    ++distanceCalculations;
+    ++pointDistanceCalculations;
 
     // Second bound test.
     if (upperBounds(i) <= m)
-    {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
       continue;
-    }
 
     // The bounds failed.  So test against all other clusters.
     // This is Hamerly's Point-All-Ctrs() function from the paper.
@@ -119,15 +129,16 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
         lowerBounds(i) = dist;
       }
     }
-    distanceCalculations += centroids.n_cols - 1;
-
-    // Update new centroids.
-    newCentroids.col(assignments[i]) += dataset.col(i);
-    ++counts(assignments[i]);
+    pointDistanceCalculations += centroids.n_cols - 1;
   }
+  distanceCalculations += pointDistanceCalculations;
+
+  // Calculate the new centroids from the new assignments.
+  UpdateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
 
-  // Normalize centroids and calculate cluster movement (contains parts of
-  // Move-Centers() and Update-Bounds()).
+  // Calculate cluster movement (contains parts of Move-Centers() and
+  // Update-Bounds()).
   double furthestMovement = 0.0;
   double secondFurthestMovement = 0.0;
   size_t furthestMovingCluster = 0;
@@ -135,9 +146,6 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   double centroidMovement = 0.0;
   for (size_t c = 0; c < centroids.n_cols; ++c)
   {
-    if (counts(c) > 0)
-      newCentroids.col(c) /= counts(c);
-
     // Calculate movement.
     const double movement = metric.Evaluate(centroids.col(c),
                                             newCentroids.col(c));
@@ -158,7 +166,13 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Now update bounds (lines 3-8 of Update-Bounds()).
+#ifdef _WIN32
+  #pragma omp parallel for
+  for (intmax_t i = 0; i < (intmax_t) dataset.n_cols; ++i)
+#else
+  #pragma omp parallel for
   for (size_t i = 0; i < dataset.n_cols; ++i)
+#endif
   {
     upperBounds(i) += centroidMovements(assignments[i]);
     if (assignments[i] == furthestMovingCluster)
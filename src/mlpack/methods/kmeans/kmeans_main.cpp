@@ -16,10 +16,12 @@
 #include "allow_empty_clusters.hpp"
 #include "kill_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_parallel_initialization.hpp"
 #include "elkan_kmeans.hpp"
 #include "hamerly_kmeans.hpp"
 #include "pelleg_moore_kmeans.hpp"
 #include "dual_tree_kmeans.hpp"
+#include "mini_batch_kmeans.hpp"
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -41,6 +43,15 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "to be used in each sample, the --percentage parameter is used (it should "
     "be a value between 0.0 and 1.0)."
     "\n\n"
+    "Alternately, the k-means|| approach (Bahmani et al., \"Scalable k-means++"
+    "\", 2012) can be used to select initial points by specifying the "
+    "--kmeans_parallel (-x) option.  This approach samples points in a few "
+    "rounds (specified with --rounds), each of which is expected to sample "
+    "--oversampling times the number of clusters, and then chooses the initial "
+    "points among them with k-means++.  It also works with "
+    "--streaming_input_file, in which case each round is one pass over the "
+    "file."
+    "\n\n"
     "There are several options available for the algorithm used for each Lloyd "
     "iteration, specified with the --algorithm (-a) option.  The standard O(kN)"
     " approach can be used ('naive').  Other options include the Pelleg-Moore "
@@ -60,12 +71,29 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "when neither empty cluster option is specified can be time-consuming to "
     "calculate; therefore, specifying -e or -E will often accelerate runtime."
     "\n\n"
+    "For large datasets, mini-batch k-means (Sculley, \"Web-scale k-means "
+    "clustering\", 2010) can be used instead of full Lloyd iterations by "
+    "specifying a batch size with --mini_batch_size (-b); then each of the "
+    "--max_iterations iterations processes a single batch of points, and "
+    "--algorithm and the empty cluster options are ignored.  A dataset that "
+    "does not fit in memory can be clustered with mini-batch k-means by "
+    "passing it with --streaming_input_file (-f) instead of --input_file; it "
+    "must be an Armadillo binary file holding one point per column, and only "
+    "one batch is held in memory at a time.  In that case only the centroids "
+    "can be saved.  With --checkpoint_interval (-K), progress is logged every "
+    "given number of iterations, and the current centroids are saved to "
+    "--checkpoint_file (-k) if it is given; a run can be resumed by passing "
+    "that file as --initial_centroids."
+    "\n\n"
     "As of October 2014, the --overclustering option has been removed.  If you "
     "want this support back, let us know---file a bug at "
     "https://github.com/mlpack/mlpack/ or get in touch through another means.");
 
 // Required options.
-PARAM_MATRIX_IN_REQ("input", "Input dataset to perform clustering on.", "i");
+PARAM_MATRIX_IN("input", "Input dataset to perform clustering on.", "i");
+PARAM_STRING_IN("streaming_input_file", "Armadillo binary file (with one point "
+    "per column) to perform mini-batch clustering on, without loading it into "
+    "memory.", "f", "");
 PARAM_INT_IN_REQ("clusters", "Number of clusters to find (0 autodetects from "
     "initial centroids).", "c");
 
@@ -97,6 +125,23 @@ PARAM_INT_IN("samplings", "Number of samplings to perform for refined start "
 PARAM_DOUBLE_IN("percentage", "Percentage of dataset to use for each refined "
     "start sampling (use when --refined_start is specified).", "p", 0.02);
 
+// Parameters for k-means|| initialization.
+PARAM_FLAG("kmeans_parallel", "Use the k-means|| strategy by Bahmani et al. to "
+    "choose initial points.", "x");
+PARAM_INT_IN("rounds", "Number of sampling rounds for k-means|| (use when "
+    "--kmeans_parallel is specified).", "R", 5);
+PARAM_DOUBLE_IN("oversampling", "Expected number of points sampled in each "
+    "k-means|| round, as a multiple of the number of clusters (use when "
+    "--kmeans_parallel is specified).", "O", 2.0);
+
+// Parameters for mini-batch k-means.
+PARAM_INT_IN("mini_batch_size", "If greater than 0, use mini-batch k-means "
+    "with batches of this many points.", "b", 0);
+PARAM_INT_IN("checkpoint_interval", "Number of mini-batch iterations between "
+    "checkpoints (0 means no checkpoints).", "K", 0);
+PARAM_STRING_IN("checkpoint_file", "File to save the centroids to at each "
+    "checkpoint.", "k", "");
+
 PARAM_STRING_IN("algorithm", "Algorithm to use for the Lloyd iteration "
     "('naive', 'pelleg-moore', 'elkan', 'hamerly', 'dualtree', or "
     "'dualtree-covertree').", "a", "naive");
@@ -106,6 +151,14 @@ PARAM_STRING_IN("algorithm", "Algorithm to use for the Lloyd iteration "
 template<typename InitialPartitionPolicy>
 void FindEmptyClusterPolicy(const InitialPartitionPolicy& ipp);
 
+// Given the type of initial partition policy, sanitize/load input and run
+// mini-batch k-means.
+template<typename InitialPartitionPolicy>
+void RunMiniBatchKMeans(const InitialPartitionPolicy& ipp);
+
+// Store the assignments and the dataset in the output options.
+void SaveAssignments(arma::mat& dataset, arma::Row<size_t>& assignments);
+
 // Given the initial partitionining policy and empty cluster policy, figure out
 // the Lloyd iteration step type and run k-means.
 template<typename InitialPartitionPolicy, typename EmptyClusterPolicy>
@@ -121,6 +174,25 @@ int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
+  if (CLI::HasParam("input") == CLI::HasParam("streaming_input_file"))
+    Log::Fatal << "Exactly one of --input_file (-i) or --streaming_input_file "
+        << "(-f) must be specified!" << endl;
+
+  if (CLI::GetParam<int>("mini_batch_size") < 0)
+    Log::Fatal << "Invalid mini-batch size ("
+        << CLI::GetParam<int>("mini_batch_size") << ")!  Must be greater than "
+        << "or equal to 0." << endl;
+
+  if (CLI::HasParam("streaming_input_file") &&
+      CLI::GetParam<int>("mini_batch_size") == 0)
+    Log::Fatal << "--mini_batch_size (-b) must be specified with "
+        << "--streaming_input_file (-f)!" << endl;
+
+  if (CLI::GetParam<int>("checkpoint_interval") < 0)
+    Log::Fatal << "Invalid checkpoint interval ("
+        << CLI::GetParam<int>("checkpoint_interval") << ")!  Must be greater "
+        << "than or equal to 0." << endl;
+
   // Initialize random seed.
   if (CLI::GetParam<int>("seed") != 0)
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
@@ -130,6 +202,10 @@ int main(int argc, char** argv)
   // Now, start building the KMeans type that we'll be using.  Start with the
   // initial partition policy.  The call to FindEmptyClusterPolicy<> results in
   // a call to RunKMeans<> and the algorithm is completed.
+  if (CLI::HasParam("refined_start") && CLI::HasParam("kmeans_parallel"))
+    Log::Fatal << "Only one of --refined_start (-r) or --kmeans_parallel (-x) "
+        << "may be specified!" << endl;
+
   if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
@@ -144,6 +220,21 @@ int main(int argc, char** argv)
 
     FindEmptyClusterPolicy<RefinedStart>(RefinedStart(samplings, percentage));
   }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const int rounds = CLI::GetParam<int>("rounds");
+    const double oversampling = CLI::GetParam<double>("oversampling");
+
+    if (rounds < 0)
+      Log::Fatal << "Number of k-means|| rounds (" << rounds << ") must be "
+          << "greater than or equal to 0!" << endl;
+    if (oversampling <= 0.0)
+      Log::Fatal << "k-means|| oversampling factor (" << oversampling << ") "
+          << "must be greater than 0.0!" << endl;
+
+    FindEmptyClusterPolicy<KMeansParallelInitialization>(
+        KMeansParallelInitialization(rounds, oversampling));
+  }
   else
   {
     FindEmptyClusterPolicy<SampleInitialization>(SampleInitialization());
@@ -155,6 +246,17 @@ int main(int argc, char** argv)
 template<typename InitialPartitionPolicy>
 void FindEmptyClusterPolicy(const InitialPartitionPolicy& ipp)
 {
+  // Mini-batch k-means has no empty cluster policy.
+  if (CLI::GetParam<int>("mini_batch_size") > 0)
+  {
+    if (CLI::HasParam("allow_empty_clusters") ||
+        CLI::HasParam("kill_empty_clusters"))
+      Log::Warn << "Empty cluster options are ignored by mini-batch k-means."
+          << endl;
+    RunMiniBatchKMeans(ipp);
+    return;
+  }
+
   if (CLI::HasParam("allow_empty_clusters") &&
       CLI::HasParam("kill_empty_clusters"))
     Log::Fatal << "Only one of --allow_empty_clusters (-e) or "
@@ -237,9 +339,12 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   arma::mat dataset = CLI::GetParam<arma::mat>("input");
   arma::mat centroids;
 
-  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  // The initial centroids are only used if no initialization strategy is
+  // given.
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids") &&
+      !CLI::HasParam("refined_start") && !CLI::HasParam("kmeans_parallel");
   // Load initial centroids if the user asked for it.
-  if (initialCentroidGuess)
+  if (CLI::HasParam("initial_centroids"))
   {
     centroids = std::move(CLI::GetParam<arma::mat>("initial_centroids"));
     if (clusters == 0)
@@ -248,6 +353,9 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     if (CLI::HasParam("refined_start"))
       Log::Warn << "Initial centroids are specified, but will be ignored "
           << "because --refined_start is also specified!" << endl;
+    else if (CLI::HasParam("kmeans_parallel"))
+      Log::Warn << "Initial centroids are specified, but will be ignored "
+          << "because --kmeans_parallel is also specified!" << endl;
     else
       Log::Info << "Using initial centroid guesses." << endl;
   }
@@ -266,63 +374,161 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
         false, initialCentroidGuess);
     Timer::Stop("clustering");
 
-    // Now figure out what to do with our results.
-    if (CLI::HasParam("in_place"))
+    SaveAssignments(dataset, assignments);
+  }
+  else
+  {
+    // Just save the centroids.
+    kmeans.Cluster(dataset, clusters, centroids, initialCentroidGuess);
+    Timer::Stop("clustering");
+  }
+
+  // Should we write the centroids to a file?
+  if (CLI::HasParam("centroid"))
+    CLI::GetParam<arma::mat>("centroid") = std::move(centroids);
+}
+
+// Store the assignments and the dataset in the output options.
+void SaveAssignments(arma::mat& dataset, arma::Row<size_t>& assignments)
+{
+  if (CLI::HasParam("in_place"))
+  {
+    // Add the column of assignments to the dataset; but we have to convert
+    // them to type double first.
+    arma::rowvec converted(assignments.n_elem);
+    for (size_t i = 0; i < assignments.n_elem; i++)
+      converted(i) = (double) assignments(i);
+
+    dataset.insert_rows(dataset.n_rows, converted);
+
+    // Save the dataset.  We have to do a little trickery to get it to save
+    // the input file correctly.
+    CLI::GetUnmappedParam<arma::mat>("output") =
+        CLI::GetUnmappedParam<arma::mat>("input");
+    CLI::GetParam<arma::mat>("output") = std::move(dataset);
+  }
+  else
+  {
+    if (CLI::HasParam("labels_only"))
+    {
+      // Save only the labels.  But the labels are a different type so we need
+      // to do a bit of trickery to get them to save as the right type: we'll
+      // add another option with type Mat<size_t> called 'output_labels', then
+      // set the 'output' option to nothing, and set the 'output_labels'
+      // option to what the user passed for 'output'.
+      CLI::Add<arma::Mat<size_t>>(arma::Mat<size_t>(), "output_labels",
+          "Labels for input dataset.", '\0', false, false, false);
+      CLI::GetUnmappedParam<arma::Mat<size_t>>("output_labels") =
+          CLI::GetUnmappedParam<arma::mat>("output");
+      CLI::GetUnmappedParam<arma::mat>("output") = "";
+
+      CLI::GetParam<arma::Mat<size_t>>("output_labels") =
+          std::move(assignments);
+    }
+    else
     {
-      // Add the column of assignments to the dataset; but we have to convert
-      // them to type double first.
+      // Convert the assignments to doubles.
       arma::rowvec converted(assignments.n_elem);
       for (size_t i = 0; i < assignments.n_elem; i++)
         converted(i) = (double) assignments(i);
 
       dataset.insert_rows(dataset.n_rows, converted);
 
-      // Save the dataset.  We have to do a little trickery to get it to save
-      // the input file correctly.
-      CLI::GetUnmappedParam<arma::mat>("output") =
-          CLI::GetUnmappedParam<arma::mat>("input");
+      // Now save, in the different file.
       CLI::GetParam<arma::mat>("output") = std::move(dataset);
     }
+  }
+}
+
+// Given the type of initial partition policy, sanitize/load input and run
+// mini-batch k-means.
+template<typename InitialPartitionPolicy>
+void RunMiniBatchKMeans(const InitialPartitionPolicy& ipp)
+{
+  int clusters = CLI::GetParam<int>("clusters");
+  if (clusters < 0)
+  {
+    Log::Fatal << "Invalid number of clusters requested (" << clusters << ")! "
+        << "Must be greater than or equal to 0." << endl;
+  }
+  else if (clusters == 0 && !CLI::HasParam("initial_centroids"))
+  {
+    Log::Fatal << "Number of clusters requested is 0, and no initial centroids "
+        << "provided!" << endl;
+  }
+
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+  if (maxIterations < 0)
+  {
+    Log::Fatal << "Invalid value for maximum iterations (" << maxIterations <<
+        ")! Must be greater than or equal to 0." << endl;
+  }
+
+  if (CLI::HasParam("algorithm"))
+    Log::Warn << "--algorithm (-a) is ignored by mini-batch k-means." << endl;
+
+  const bool streaming = CLI::HasParam("streaming_input_file");
+  if (streaming && (CLI::HasParam("output") || CLI::HasParam("in_place")))
+    Log::Fatal << "Only the centroids can be saved when clustering "
+        << "--streaming_input_file (-f); use --centroid_file (-C)." << endl;
+  if (!CLI::HasParam("in_place") && !CLI::HasParam("output") &&
+      !CLI::HasParam("centroid"))
+  {
+    Log::Warn << "--output_file, --in_place, and --centroid_file are not set; "
+        << "no results will be saved." << std::endl;
+  }
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids") &&
+      !CLI::HasParam("refined_start") && !CLI::HasParam("kmeans_parallel");
+  if (CLI::HasParam("initial_centroids"))
+  {
+    centroids = std::move(CLI::GetParam<arma::mat>("initial_centroids"));
+    if (clusters == 0)
+      clusters = centroids.n_cols;
+
+    if (CLI::HasParam("refined_start"))
+      Log::Warn << "Initial centroids are specified, but will be ignored "
+          << "because --refined_start is also specified!" << endl;
+    else if (CLI::HasParam("kmeans_parallel"))
+      Log::Warn << "Initial centroids are specified, but will be ignored "
+          << "because --kmeans_parallel is also specified!" << endl;
     else
-    {
-      if (CLI::HasParam("labels_only"))
-      {
-        // Save only the labels.  But the labels are a different type so we need
-        // to do a bit of trickery to get them to save as the right type: we'll
-        // add another option with type Mat<size_t> called 'output_labels', then
-        // set the 'output' option to nothing, and set the 'output_labels'
-        // option to what the user passed for 'output'.
-        CLI::Add<arma::Mat<size_t>>(arma::Mat<size_t>(), "output_labels",
-            "Labels for input dataset.", '\0', false, false, false);
-        CLI::GetUnmappedParam<arma::Mat<size_t>>("output_labels") =
-            CLI::GetUnmappedParam<arma::mat>("output");
-        CLI::GetUnmappedParam<arma::mat>("output") = "";
-
-        CLI::GetParam<arma::Mat<size_t>>("output_labels") =
-            std::move(assignments);
-      }
-      else
-      {
-        // Convert the assignments to doubles.
-        arma::rowvec converted(assignments.n_elem);
-        for (size_t i = 0; i < assignments.n_elem; i++)
-          converted(i) = (double) assignments(i);
-
-        dataset.insert_rows(dataset.n_rows, converted);
-
-        // Now save, in the different file.
-        CLI::GetParam<arma::mat>("output") = std::move(dataset);
-      }
-    }
+      Log::Info << "Using initial centroid guesses." << endl;
   }
-  else
+
+  MiniBatchKMeans<metric::EuclideanDistance, InitialPartitionPolicy> kmeans(
+      (size_t) CLI::GetParam<int>("mini_batch_size"), (size_t) maxIterations,
+      1e-5, metric::EuclideanDistance(), ipp);
+  kmeans.CheckpointInterval() =
+      (size_t) CLI::GetParam<int>("checkpoint_interval");
+  kmeans.CheckpointFile() = CLI::GetParam<string>("checkpoint_file");
+
+  Timer::Start("clustering");
+  if (streaming)
   {
-    // Just save the centroids.
-    kmeans.Cluster(dataset, clusters, centroids, initialCentroidGuess);
+    data::ChunkReader<> reader(CLI::GetParam<string>("streaming_input_file"));
+    kmeans.Cluster(reader, clusters, centroids, initialCentroidGuess);
     Timer::Stop("clustering");
   }
+  else
+  {
+    arma::mat dataset = CLI::GetParam<arma::mat>("input");
+    if (CLI::HasParam("output") || CLI::HasParam("in_place"))
+    {
+      arma::Row<size_t> assignments;
+      kmeans.Cluster(dataset, clusters, assignments, centroids,
+          initialCentroidGuess);
+      Timer::Stop("clustering");
+      SaveAssignments(dataset, assignments);
+    }
+    else
+    {
+      kmeans.Cluster(dataset, clusters, centroids, initialCentroidGuess);
+      Timer::Stop("clustering");
+    }
+  }
 
-  // Should we write the centroids to a file?
   if (CLI::HasParam("centroid"))
     CLI::GetParam<arma::mat>("centroid") = std::move(centroids);
 }
@@ -0,0 +1,130 @@
+/**
+ * @file kmeans_parallel_initialization.cpp
+ *
+ * Implementation of the non-templated functions of the
+ * KMeansParallelInitialization class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include "kmeans_parallel_initialization.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kmeans;
+
+void KMeansParallelInitialization::Sample(const arma::vec& distances,
+                                          const double potential,
+                                          const size_t clusters,
+                                          const size_t seed,
+                                          const size_t round,
+                                          std::vector<size_t>& sampled) const
+{
+  const double expected = oversampling * clusters;
+
+  // Each block of points is sampled with its own random number generator, so
+  // the samples do not depend on the number of threads.
+  const size_t blockSize = 4096;
+  const size_t numBlocks = (distances.n_elem + blockSize - 1) / blockSize;
+  std::vector<std::vector<size_t>> blockSamples(numBlocks);
+
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for
+  for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+  #pragma omp parallel for
+  for (size_t b = 0; b < numBlocks; ++b)
+#endif
+  {
+    std::seed_seq seedSequence = { (uint32_t) seed, (uint32_t) round,
+        (uint32_t) b };
+    std::mt19937 generator(seedSequence);
+    std::uniform_real_distribution<> uniformDist;
+
+    const size_t end = std::min((b + 1) * blockSize, (size_t) distances.n_elem);
+    for (size_t i = b * blockSize; i < end; ++i)
+    {
+      // The point is sampled with probability
+      // min(1, expected * distances[i] / potential).
+      if (uniformDist(generator) * potential < expected * distances[i])
+        blockSamples[b].push_back(i);
+    }
+  }
+
+  sampled.clear();
+  for (size_t b = 0; b < numBlocks; ++b)
+    sampled.insert(sampled.end(), blockSamples[b].begin(),
+        blockSamples[b].end());
+}
+
+void KMeansParallelInitialization::Reduce(const arma::mat& candidates,
+                                          const arma::Col<size_t>& nearest,
+                                          const size_t clusters,
+                                          arma::mat& centroids)
+{
+  // Weight each candidate by the number of points it is the nearest candidate
+  // of.
+  arma::vec weights(candidates.n_cols, arma::fill::zeros);
+  for (size_t i = 0; i < nearest.n_elem; ++i)
+    weights[nearest[i]]++;
+
+  // Now run k-means++ on the weighted candidates: each centroid is chosen with
+  // probability proportional to the weight of the candidate times its squared
+  // distance to the nearest centroid chosen so far.
+  centroids.set_size(candidates.n_rows, clusters);
+  arma::vec distances(candidates.n_cols);
+  distances.fill(DBL_MAX);
+  arma::vec probabilities(weights);
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    const double total = arma::accu(probabilities);
+    size_t chosen = 0;
+    if (total > 0.0)
+    {
+      const double target = math::Random() * total;
+      double cumulative = 0.0;
+      for (size_t j = 0; j < candidates.n_cols; ++j)
+      {
+        if (probabilities[j] == 0.0)
+          continue;
+
+        chosen = j;
+        cumulative += probabilities[j];
+        if (target < cumulative)
+          break;
+      }
+    }
+    else
+    {
+      // All candidates coincide with chosen centroids.
+      chosen = RandomIndex(candidates.n_cols);
+    }
+
+    centroids.col(c) = candidates.col(chosen);
+
+#ifdef _WIN32
+    #pragma omp parallel for
+    for (intmax_t j = 0; j < (intmax_t) candidates.n_cols; ++j)
+#else
+    #pragma omp parallel for
+    for (size_t j = 0; j < candidates.n_cols; ++j)
+#endif
+    {
+      const double d = metric::SquaredEuclideanDistance::Evaluate(
+          candidates.col(j), candidates.col(chosen));
+      if (d < distances[j])
+        distances[j] = d;
+      probabilities[j] = weights[j] * distances[j];
+    }
+  }
+}
+
+size_t KMeansParallelInitialization::RandomIndex(const size_t n)
+{
+  // math::RandInt() only handles int, which is not enough for large datasets.
+  return std::min((size_t) (math::Random() * n), n - 1);
+}
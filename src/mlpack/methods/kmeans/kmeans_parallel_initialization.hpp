@@ -0,0 +1,201 @@
+/**
+ * @file kmeans_parallel_initialization.hpp
+ *
+ * An implementation of the k-means|| (scalable k-means++) initialization
+ * strategy of Bahmani et al., which chooses initial centroids for k-means in a
+ * few passes over the data.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_HPP
+#define MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means|| initialization strategy, which chooses initial centroids that
+ * are about as good as those of k-means++ but needs only a few passes over the
+ * data.  It is described in the following paper:
+ *
+ * @code
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, B. and Moseley, B. and Vattani, A. and Kumar, R. and
+ *       Vassilvitskii, S.},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ * @endcode
+ *
+ * Starting from a single random point, each round samples every point
+ * independently with probability proportional to its squared distance to the
+ * nearest candidate so far, so that about (oversampling * clusters) points are
+ * added to the candidates in each round.  The candidates are then weighted by
+ * the number of points they are the nearest candidate of, and the centroids
+ * are chosen among them with weighted k-means++.
+ *
+ * The squared distance of each point to its nearest candidate is updated in
+ * parallel with OpenMP, once per round.  The sampling of each block of points
+ * uses its own random number generator, seeded from math::randGen, so the
+ * centroids only depend on the random seed and not on the number of threads.
+ *
+ * The dataset can also be read from disk with a data::ChunkReader, one chunk
+ * of points at a time; only the distance to and index of the nearest candidate
+ * of each point are held in memory, and each round takes a single pass over
+ * the file.
+ *
+ * @code
+ * KMeans<metric::EuclideanDistance, KMeansParallelInitialization> k;
+ * k.Cluster(dataset, 100, centroids);
+ * @endcode
+ */
+class KMeansParallelInitialization
+{
+ public:
+  /**
+   * Create the KMeansParallelInitialization object, optionally specifying the
+   * number of rounds and the oversampling factor.
+   *
+   * @param rounds Number of sampling rounds.
+   * @param oversampling Expected number of points sampled in each round, as a
+   *     multiple of the number of clusters.
+   * @param chunkSize Number of points read at once when the dataset is read
+   *     with a data::ChunkReader.
+   */
+  KMeansParallelInitialization(const size_t rounds = 5,
+                               const double oversampling = 2.0,
+                               const size_t chunkSize = 100000) :
+      rounds(rounds), oversampling(oversampling), chunkSize(chunkSize) { }
+
+  /**
+   * Choose initial centroids for the given dataset.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put initial centroids into.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::mat& centroids);
+
+  /**
+   * Choose initial centroids for the dataset read by the given ChunkReader.
+   *
+   * @param reader ChunkReader to read the dataset from.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put initial centroids into.
+   */
+  template<typename eT>
+  void Cluster(data::ChunkReader<eT>& reader,
+               const size_t clusters,
+               arma::mat& centroids);
+
+  //! Get the number of sampling rounds.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of sampling rounds.
+  size_t& Rounds() { return rounds; }
+
+  //! Get the oversampling factor.
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor.
+  double& Oversampling() { return oversampling; }
+
+  //! Get the number of points read at once from a ChunkReader.
+  size_t ChunkSize() const { return chunkSize; }
+  //! Modify the number of points read at once from a ChunkReader.
+  size_t& ChunkSize() { return chunkSize; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(rounds, "rounds");
+    ar & data::CreateNVP(oversampling, "oversampling");
+    ar & data::CreateNVP(chunkSize, "chunkSize");
+  }
+
+ private:
+  /**
+   * Update the squared distance to the nearest candidate (and its index) of
+   * the given points, with the candidates from firstCandidate onwards, and
+   * return the sum of the squared distances of the points.
+   *
+   * @param points Points to update.
+   * @param offset Index of the first of the points in the dataset.
+   * @param candidates Candidates.
+   * @param firstCandidate Index of the first new candidate.
+   * @param distances Squared distance of each point of the dataset to its
+   *     nearest candidate.
+   * @param nearest Index of the nearest candidate of each point of the
+   *     dataset.
+   */
+  template<typename MatType>
+  static double UpdateDistances(const MatType& points,
+                                const size_t offset,
+                                const arma::mat& candidates,
+                                const size_t firstCandidate,
+                                arma::vec& distances,
+                                arma::Col<size_t>& nearest);
+
+  /**
+   * Sample each point with probability min(1, l * distances[i] / potential),
+   * where l is the expected number of sampled points.
+   *
+   * @param distances Squared distance of each point to its nearest candidate.
+   * @param potential Sum of the squared distances.
+   * @param clusters Number of clusters.
+   * @param seed Seed of the random number generators.
+   * @param round Index of the round.
+   * @param sampled Vector to store the indices of the sampled points in.
+   */
+  void Sample(const arma::vec& distances,
+              const double potential,
+              const size_t clusters,
+              const size_t seed,
+              const size_t round,
+              std::vector<size_t>& sampled) const;
+
+  /**
+   * Choose the centroids among the candidates with weighted k-means++.
+   *
+   * @param candidates Candidates.
+   * @param nearest Index of the nearest candidate of each point.
+   * @param clusters Number of clusters.
+   * @param centroids Matrix to put the centroids into.
+   */
+  static void Reduce(const arma::mat& candidates,
+                     const arma::Col<size_t>& nearest,
+                     const size_t clusters,
+                     arma::mat& centroids);
+
+  //! Get a uniform random index in [0, n).
+  static size_t RandomIndex(const size_t n);
+
+  //! The number of sampling rounds.
+  size_t rounds;
+  //! The expected number of points sampled in each round, divided by the
+  //! number of clusters.
+  double oversampling;
+  //! The number of points read at once from a ChunkReader.
+  size_t chunkSize;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_initialization_impl.hpp"
+
+#endif
@@ -0,0 +1,215 @@
+/**
+ * @file kmeans_parallel_initialization_impl.hpp
+ *
+ * Implementation of the templated functions of the
+ * KMeansParallelInitialization class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_INITIALIZATION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel_initialization.hpp"
+
+#include <mlpack/core/math/random.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MatType>
+void KMeansParallelInitialization::Cluster(const MatType& data,
+                                           const size_t clusters,
+                                           arma::mat& centroids)
+{
+  if (data.n_cols == 0)
+    throw std::invalid_argument("KMeansParallelInitialization::Cluster(): "
+        "dataset is empty");
+
+  arma::vec distances(data.n_cols);
+  distances.fill(DBL_MAX);
+  arma::Col<size_t> nearest(data.n_cols, arma::fill::zeros);
+
+  // Start with a single random point.
+  arma::mat candidates(data.n_rows, 1);
+  candidates.col(0) = arma::vec(data.col(RandomIndex(data.n_cols)));
+  double potential = UpdateDistances(data, 0, candidates, 0, distances,
+      nearest);
+
+  const size_t seed = math::randGen();
+  std::vector<size_t> sampled;
+  for (size_t r = 0; r < rounds && potential > 0.0; ++r)
+  {
+    Sample(distances, potential, clusters, seed, r, sampled);
+
+    const size_t firstCandidate = candidates.n_cols;
+    candidates.resize(data.n_rows, firstCandidate + sampled.size());
+    for (size_t i = 0; i < sampled.size(); ++i)
+      candidates.col(firstCandidate + i) = arma::vec(data.col(sampled[i]));
+
+    potential = UpdateDistances(data, 0, candidates, firstCandidate, distances,
+        nearest);
+  }
+
+  // If there are fewer candidates than clusters (because there were few
+  // rounds, or few distinct points), add random points.
+  if (candidates.n_cols < clusters)
+  {
+    const size_t firstCandidate = candidates.n_cols;
+    candidates.resize(data.n_rows, clusters);
+    for (size_t i = firstCandidate; i < clusters; ++i)
+      candidates.col(i) = arma::vec(data.col(RandomIndex(data.n_cols)));
+
+    UpdateDistances(data, 0, candidates, firstCandidate, distances, nearest);
+  }
+
+  Reduce(candidates, nearest, clusters, centroids);
+}
+
+template<typename eT>
+void KMeansParallelInitialization::Cluster(data::ChunkReader<eT>& reader,
+                                           const size_t clusters,
+                                           arma::mat& centroids)
+{
+  const size_t numPoints = reader.NumPoints();
+  if (numPoints == 0)
+    throw std::invalid_argument("KMeansParallelInitialization::Cluster(): "
+        "dataset is empty");
+  if (chunkSize == 0)
+    throw std::invalid_argument("KMeansParallelInitialization::Cluster(): "
+        "chunk size must be positive");
+
+  arma::vec distances(numPoints);
+  distances.fill(DBL_MAX);
+  arma::Col<size_t> nearest(numPoints, arma::fill::zeros);
+
+  arma::Mat<eT> chunk;
+  arma::mat points;
+  arma::mat candidates;
+
+  // Read the given points into the candidates, after the existing ones.
+  auto addCandidates = [&](const std::vector<size_t>& indices)
+  {
+    const size_t firstCandidate = candidates.n_cols;
+    candidates.resize(reader.Dimensionality(), firstCandidate + indices.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+      reader.Read(indices[i], 1, chunk);
+      candidates.col(firstCandidate + i) = arma::conv_to<arma::vec>::from(
+          chunk);
+    }
+  };
+
+  // Update the distances of all points with the candidates from
+  // firstCandidate onwards, in one pass over the file.
+  auto updateDistances = [&](const size_t firstCandidate)
+  {
+    double potential = 0.0;
+    for (size_t begin = 0; begin < numPoints; begin += chunkSize)
+    {
+      reader.Read(begin, std::min(chunkSize, numPoints - begin), chunk);
+      points = arma::conv_to<arma::mat>::from(chunk);
+      potential += UpdateDistances(points, begin, candidates, firstCandidate,
+          distances, nearest);
+    }
+
+    return potential;
+  };
+
+  // Start with a single random point.
+  addCandidates(std::vector<size_t>(1, RandomIndex(numPoints)));
+  double potential = updateDistances(0);
+
+  const size_t seed = math::randGen();
+  std::vector<size_t> sampled;
+  for (size_t r = 0; r < rounds && potential > 0.0; ++r)
+  {
+    // The sampled points are in increasing order, so they are read from the
+    // file in order.
+    Sample(distances, potential, clusters, seed, r, sampled);
+
+    const size_t firstCandidate = candidates.n_cols;
+    addCandidates(sampled);
+    potential = updateDistances(firstCandidate);
+  }
+
+  // If there are fewer candidates than clusters (because there were few
+  // rounds, or few distinct points), add random points.
+  if (candidates.n_cols < clusters)
+  {
+    const size_t firstCandidate = candidates.n_cols;
+    std::vector<size_t> indices(clusters - firstCandidate);
+    for (size_t i = 0; i < indices.size(); ++i)
+      indices[i] = RandomIndex(numPoints);
+
+    addCandidates(indices);
+    updateDistances(firstCandidate);
+  }
+
+  Reduce(candidates, nearest, clusters, centroids);
+}
+
+template<typename MatType>
+double KMeansParallelInitialization::UpdateDistances(
+    const MatType& points,
+    const size_t offset,
+    const arma::mat& candidates,
+    const size_t firstCandidate,
+    arma::vec& distances,
+    arma::Col<size_t>& nearest)
+{
+  // The points are split into blocks of a fixed size, and the squared distances
+  // are summed block by block, so that the sum does not depend on the number
+  // of threads.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (points.n_cols + blockSize - 1) / blockSize;
+  arma::vec blockPotentials(numBlocks);
+
+  // Sparse matrices are not accessed in parallel.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+  #pragma omp parallel for schedule(dynamic) \
+      if(!arma::is_SpMat<MatType>::value)
+  for (size_t b = 0; b < numBlocks; ++b)
+#endif
+  {
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(begin + blockSize, (size_t) points.n_cols);
+    double blockPotential = 0.0;
+    for (size_t i = begin; i < end; ++i)
+    {
+      double& distance = distances[offset + i];
+      for (size_t c = firstCandidate; c < candidates.n_cols; ++c)
+      {
+        const double d = metric::SquaredEuclideanDistance::Evaluate(
+            points.col(i), candidates.col(c));
+        if (d < distance)
+        {
+          distance = d;
+          nearest[offset + i] = c;
+        }
+      }
+
+      blockPotential += distance;
+    }
+
+    blockPotentials[b] = blockPotential;
+  }
+
+  return arma::accu(blockPotentials);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ *
+ * An implementation of mini-batch k-means (Sculley, 2010), which can cluster
+ * datasets that do not fit in memory.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/data/chunk_reader.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+#include "sample_initialization.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * This gives us a ReadsChunks object that we can use to tell whether or not an
+ * InitialPartitionPolicy can read the dataset from a data::ChunkReader.
+ */
+HAS_MEM_FUNC(Cluster, ReadsChunksCheck);
+
+/**
+ * 'value' is true if the InitialPartitionPolicy class has a member
+ * Cluster(data::ChunkReader<eT>& reader, const size_t clusters,
+ * arma::mat& centroids).
+ */
+template<typename InitialPartitionPolicy, typename eT>
+struct ReadsChunks
+{
+  static const bool value = ReadsChunksCheck<InitialPartitionPolicy,
+      void(InitialPartitionPolicy::*)(data::ChunkReader<eT>&,
+                                      const size_t,
+                                      arma::mat&)>::value;
+};
+
+/**
+ * This class implements mini-batch k-means, as described in the following
+ * paper:
+ *
+ * @code
+ * @inproceedings{sculley2010web,
+ *   title={Web-scale k-means clustering},
+ *   author={Sculley, D.},
+ *   booktitle={Proceedings of the 19th International Conference on World Wide
+ *       Web (WWW '10)},
+ *   pages={1177--1178},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * Instead of full Lloyd iterations over the dataset, each iteration takes a
+ * mini-batch of points, finds the nearest centroid of each point of the batch,
+ * and then moves each of these centroids towards its points, one point at a
+ * time, with a per-centroid learning rate of 1 / (number of points the
+ * centroid has been moved towards so far).  The cost of an iteration therefore
+ * depends only on the batch size, and not on the size of the dataset.
+ *
+ * The dataset can be given in memory, in which case each batch is a uniform
+ * random sample of the points, or it can be read from disk with a
+ * data::ChunkReader, in which case only one batch is held in memory at a time.
+ * When reading from disk, the dataset is split into contiguous blocks of
+ * batchSize points, which are read in a random order (a new one for each pass
+ * over the dataset), so that each batch is a single sequential read.  If the
+ * points are stored in some meaningful order, the file should be shuffled
+ * first.
+ *
+ * The initial centroids are found by running the InitialPartitionPolicy on the
+ * dataset (in memory).  From disk, the InitialPartitionPolicy is given the
+ * ChunkReader if it can read from one (like KMeansParallelInitialization), and
+ * otherwise a uniform random sample of max(batchSize, clusters) points.
+ * Centroids that are never the nearest centroid of any point of a batch keep
+ * their initial position.
+ *
+ * Progress can be saved regularly: every checkpointInterval iterations, the
+ * current centroids are logged and, if a checkpoint file is set, saved to it,
+ * so that a run that is interrupted can be resumed by passing the saved
+ * centroids as the initial guess (the learning rates then start over).
+ *
+ * @code
+ * data::ChunkReader<> reader("dataset.bin");
+ * MiniBatchKMeans<> k(10000, 5000);
+ * arma::mat centroids;
+ * k.Cluster(reader, 100, centroids);
+ * @endcode
+ *
+ * @tparam MetricType The distance metric to use for finding the nearest
+ *     centroids.
+ * @tparam InitialPartitionPolicy Initial partitioning policy; see KMeans.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename InitialPartitionPolicy = SampleInitialization>
+class MiniBatchKMeans
+{
+ public:
+  /**
+   * Create the MiniBatchKMeans object and set the parameters it will be run
+   * with.
+   *
+   * @param batchSize Number of points in each mini-batch.
+   * @param maxIterations Number of mini-batches to process (0 is valid, but
+   *     the algorithm may never terminate).
+   * @param tolerance The algorithm stops once the centroids move less than
+   *     this in an iteration (as the norm of all centroid movements).
+   * @param metric Optional MetricType object; for when the metric has state
+   *     it needs to store.
+   * @param partitioner Optional InitialPartitionPolicy object; for when a
+   *     specially initialized partitioning policy is required.
+   */
+  MiniBatchKMeans(const size_t batchSize = 1000,
+                  const size_t maxIterations = 1000,
+                  const double tolerance = 1e-5,
+                  const MetricType metric = MetricType(),
+                  const InitialPartitionPolicy partitioner =
+                      InitialPartitionPolicy());
+
+  /**
+   * Cluster the given dataset, returning the centroids of each cluster.
+   * Optionally, the initial centroids can be specified by filling the
+   * centroids matrix with them and specifying initialGuess = true.
+   *
+   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial cluster centroids.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  /**
+   * Cluster the given dataset, returning the centroids of each cluster and the
+   * assignment of each point to its nearest centroid.  Optionally, the initial
+   * centroids can be specified by filling the centroids matrix with them and
+   * specifying initialGuess = true.
+   *
+   * @tparam MatType Type of matrix (arma::mat or arma::sp_mat).
+   * @param data Dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param assignments Vector to store cluster assignments in.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial cluster centroids.
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Row<size_t>& assignments,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  /**
+   * Cluster the dataset read by the given ChunkReader, returning the centroids
+   * of each cluster.  Only one batch of points is held in memory at a time.
+   * Optionally, the initial centroids can be specified by filling the
+   * centroids matrix with them and specifying initialGuess = true.
+   *
+   * @param reader ChunkReader to read the dataset from.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *      initial cluster centroids.
+   */
+  template<typename eT>
+  void Cluster(data::ChunkReader<eT>& reader,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  //! Get the number of points in each mini-batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points in each mini-batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for convergence.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for convergence.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the number of iterations between checkpoints (0 means never).
+  size_t CheckpointInterval() const { return checkpointInterval; }
+  //! Modify the number of iterations between checkpoints (0 means never).
+  size_t& CheckpointInterval() { return checkpointInterval; }
+
+  //! Get the file the centroids are saved to at each checkpoint.
+  const std::string& CheckpointFile() const { return checkpointFile; }
+  //! Modify the file the centroids are saved to at each checkpoint (if empty,
+  //! checkpoints are only logged).
+  std::string& CheckpointFile() { return checkpointFile; }
+
+  //! Get the number of points each centroid was moved towards during the last
+  //! clustering.
+  const arma::Col<size_t>& Counts() const { return counts; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+  //! Get the initial partitioning policy.
+  const InitialPartitionPolicy& Partitioner() const { return partitioner; }
+  //! Modify the initial partitioning policy.
+  InitialPartitionPolicy& Partitioner() { return partitioner; }
+
+ private:
+  /**
+   * Find the initial centroids by running the initial partition policy on the
+   * given points.
+   */
+  template<typename MatType>
+  void Initialize(const MatType& data,
+                  const size_t clusters,
+                  arma::mat& centroids);
+
+  /**
+   * Find the initial centroids for the dataset read by the given ChunkReader,
+   * by running the initial partition policy on a uniform random sample of the
+   * points.
+   */
+  template<typename eT, typename Policy = InitialPartitionPolicy>
+  void Initialize(data::ChunkReader<eT>& reader,
+                  const size_t clusters,
+                  arma::mat& centroids,
+                  const typename std::enable_if_t<
+                      !ReadsChunks<Policy, eT>::value>* = 0);
+
+  /**
+   * Find the initial centroids for the dataset read by the given ChunkReader,
+   * by passing the ChunkReader to the initial partition policy.
+   */
+  template<typename eT, typename Policy = InitialPartitionPolicy>
+  void Initialize(data::ChunkReader<eT>& reader,
+                  const size_t clusters,
+                  arma::mat& centroids,
+                  const typename std::enable_if_t<
+                      ReadsChunks<Policy, eT>::value>* = 0);
+
+  /**
+   * Move the centroids towards the points of the given batch, and return the
+   * norm of the movement of all centroids.
+   */
+  double Step(const arma::mat& batch, arma::mat& centroids);
+
+  //! Get a uniform random index in [0, n).
+  static size_t RandomIndex(const size_t n);
+
+  /**
+   * Log progress and save the centroids, if a checkpoint is due after the
+   * given iteration.
+   */
+  void Checkpoint(const size_t iteration,
+                  const double cNorm,
+                  const arma::mat& centroids);
+
+  //! Number of points in each mini-batch.
+  size_t batchSize;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Tolerance for convergence.
+  double tolerance;
+  //! Number of iterations between checkpoints.
+  size_t checkpointInterval;
+  //! File to save the centroids to at each checkpoint.
+  std::string checkpointFile;
+  //! Instantiated distance metric.
+  MetricType metric;
+  //! Instantiated initial partitioning policy.
+  InitialPartitionPolicy partitioner;
+  //! Number of points each centroid was moved towards.
+  arma::Col<size_t> counts;
+  //! Nearest centroid of each point of the current batch.
+  arma::Row<size_t> batchAssignments;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
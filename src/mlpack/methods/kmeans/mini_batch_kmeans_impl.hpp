@@ -0,0 +1,346 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ *
+ * Implementation of the MiniBatchKMeans class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+
+#include "kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename InitialPartitionPolicy>
+MiniBatchKMeans<MetricType, InitialPartitionPolicy>::MiniBatchKMeans(
+    const size_t batchSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const MetricType metric,
+    const InitialPartitionPolicy partitioner) :
+    batchSize(batchSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    checkpointInterval(0),
+    metric(metric),
+    partitioner(partitioner)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename MatType>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Cluster(
+    const MatType& data,
+    const size_t clusters,
+    arma::mat& centroids,
+    const bool initialGuess)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Cluster(): batch size must "
+        "be positive");
+  if (data.n_cols == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Cluster(): dataset is "
+        "empty");
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters || centroids.n_rows != data.n_rows)
+    {
+      std::ostringstream oss;
+      oss << "MiniBatchKMeans::Cluster(): initial centroids have size "
+          << centroids.n_rows << "x" << centroids.n_cols << ", but should be "
+          << data.n_rows << "x" << clusters << "!";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+  else
+  {
+    Initialize(data, clusters, centroids);
+  }
+
+  counts.zeros(clusters);
+
+  // Each batch is a uniform random sample of the dataset.
+  arma::mat batch(data.n_rows, batchSize);
+  size_t iteration = 0;
+  double cNorm;
+  do
+  {
+    for (size_t i = 0; i < batchSize; ++i)
+      batch.col(i) = arma::vec(data.col(RandomIndex(data.n_cols)));
+
+    cNorm = Step(batch, centroids);
+    ++iteration;
+    Checkpoint(iteration, cNorm, centroids);
+  } while (cNorm > tolerance && iteration != maxIterations);
+
+  Log::Info << "MiniBatchKMeans::Cluster(): finished after " << iteration
+      << " iterations." << std::endl;
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename MatType>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Cluster(
+    const MatType& data,
+    const size_t clusters,
+    arma::Row<size_t>& assignments,
+    arma::mat& centroids,
+    const bool initialGuess)
+{
+  Cluster(data, clusters, centroids, initialGuess);
+
+  // Calculate final assignments.
+  assignments.set_size(data.n_cols);
+
+  // Sparse matrices are not accessed in parallel.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) data.n_cols; ++i)
+#else
+  #pragma omp parallel for if(!arma::is_SpMat<MatType>::value)
+  for (size_t i = 0; i < data.n_cols; ++i)
+#endif
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(data.col(i), centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename eT>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Cluster(
+    data::ChunkReader<eT>& reader,
+    const size_t clusters,
+    arma::mat& centroids,
+    const bool initialGuess)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Cluster(): batch size must "
+        "be positive");
+  if (reader.NumPoints() == 0)
+    throw std::invalid_argument("MiniBatchKMeans::Cluster(): dataset is "
+        "empty");
+
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters ||
+        centroids.n_rows != reader.Dimensionality())
+    {
+      std::ostringstream oss;
+      oss << "MiniBatchKMeans::Cluster(): initial centroids have size "
+          << centroids.n_rows << "x" << centroids.n_cols << ", but should be "
+          << reader.Dimensionality() << "x" << clusters << "!";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+  else
+  {
+    Initialize(reader, clusters, centroids);
+  }
+
+  counts.zeros(clusters);
+
+  // The dataset is split into blocks of batchSize points (the last one may be
+  // smaller), and each pass over the dataset visits the blocks in a new random
+  // order.
+  const size_t numBlocks = (reader.NumPoints() + batchSize - 1) / batchSize;
+  std::vector<size_t> blockOrder(numBlocks);
+  for (size_t i = 0; i < numBlocks; ++i)
+    blockOrder[i] = i;
+  size_t position = numBlocks;
+
+  arma::Mat<eT> chunk;
+  arma::mat batch;
+  size_t iteration = 0;
+  double cNorm;
+  do
+  {
+    if (position == numBlocks)
+    {
+      // Shuffle the blocks (Fisher-Yates).
+      for (size_t i = numBlocks - 1; i > 0; --i)
+        std::swap(blockOrder[i], blockOrder[RandomIndex(i + 1)]);
+      position = 0;
+    }
+
+    const size_t begin = blockOrder[position++] * batchSize;
+    reader.Read(begin, std::min(batchSize, reader.NumPoints() - begin), chunk);
+    batch = arma::conv_to<arma::mat>::from(chunk);
+
+    cNorm = Step(batch, centroids);
+    ++iteration;
+    Checkpoint(iteration, cNorm, centroids);
+  } while (cNorm > tolerance && iteration != maxIterations);
+
+  Log::Info << "MiniBatchKMeans::Cluster(): finished after " << iteration
+      << " iterations (" << ((double) iteration / numBlocks) << " passes over "
+      << "the dataset)." << std::endl;
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename MatType>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Initialize(
+    const MatType& data,
+    const size_t clusters,
+    arma::mat& centroids)
+{
+  // The partitioner may give either centroids or assignments; in the latter
+  // case, the initial centroids are the means of the assigned points.
+  arma::Row<size_t> assignments;
+  if (GetInitialAssignmentsOrCentroids(partitioner, data, clusters,
+      assignments, centroids))
+  {
+    arma::Col<size_t> initialCounts(clusters, arma::fill::zeros);
+    centroids.zeros(data.n_rows, clusters);
+    for (size_t i = 0; i < data.n_cols; ++i)
+    {
+      centroids.col(assignments[i]) += arma::vec(data.col(i));
+      initialCounts[assignments[i]]++;
+    }
+
+    for (size_t i = 0; i < clusters; ++i)
+      if (initialCounts[i] != 0)
+        centroids.col(i) /= initialCounts[i];
+  }
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename eT, typename Policy>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Initialize(
+    data::ChunkReader<eT>& reader,
+    const size_t clusters,
+    arma::mat& centroids,
+    const typename std::enable_if_t<!ReadsChunks<Policy, eT>::value>*)
+{
+  // Initialize on a uniform random sample, read one point at a time.
+  const size_t sampleSize = std::max(batchSize, clusters);
+  arma::mat sample(reader.Dimensionality(), sampleSize);
+  arma::Mat<eT> point;
+  for (size_t i = 0; i < sampleSize; ++i)
+  {
+    reader.Read(RandomIndex(reader.NumPoints()), 1, point);
+    sample.col(i) = arma::conv_to<arma::vec>::from(point);
+  }
+
+  Initialize(sample, clusters, centroids);
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+template<typename eT, typename Policy>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Initialize(
+    data::ChunkReader<eT>& reader,
+    const size_t clusters,
+    arma::mat& centroids,
+    const typename std::enable_if_t<ReadsChunks<Policy, eT>::value>*)
+{
+  partitioner.Cluster(reader, clusters, centroids);
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+double MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Step(
+    const arma::mat& batch,
+    arma::mat& centroids)
+{
+  // First find the nearest centroid of each point of the batch, with the
+  // centroids as they are before the batch.  This is the expensive part, and
+  // the points are independent.
+  batchAssignments.set_size(batch.n_cols);
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for
+  for (intmax_t i = 0; i < (intmax_t) batch.n_cols; ++i)
+#else
+  #pragma omp parallel for
+  for (size_t i = 0; i < batch.n_cols; ++i)
+#endif
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = 0;
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(batch.col(i), centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    batchAssignments[i] = closestCluster;
+  }
+
+  // Now move each centroid towards its points, one point at a time, with a
+  // learning rate that decreases with the number of points the centroid has
+  // seen.  This is done in order, so the result does not depend on the number
+  // of threads.
+  const arma::mat oldCentroids(centroids);
+  for (size_t i = 0; i < batch.n_cols; ++i)
+  {
+    const size_t c = batchAssignments[i];
+    counts[c]++;
+    const double eta = 1.0 / counts[c];
+    centroids.col(c) += eta * (batch.col(i) - centroids.col(c));
+  }
+
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+    cNorm += std::pow(metric.Evaluate(oldCentroids.col(i), centroids.col(i)),
+        2.0);
+
+  return std::sqrt(cNorm);
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+size_t MiniBatchKMeans<MetricType, InitialPartitionPolicy>::RandomIndex(
+    const size_t n)
+{
+  // math::RandInt() only handles int, which is not enough for large datasets.
+  return std::min((size_t) (math::Random() * n), n - 1);
+}
+
+template<typename MetricType, typename InitialPartitionPolicy>
+void MiniBatchKMeans<MetricType, InitialPartitionPolicy>::Checkpoint(
+    const size_t iteration,
+    const double cNorm,
+    const arma::mat& centroids)
+{
+  if (checkpointInterval == 0 || iteration % checkpointInterval != 0)
+    return;
+
+  Log::Info << "MiniBatchKMeans::Cluster(): iteration " << iteration
+      << ", centroid movement " << cNorm << "." << std::endl;
+
+  if (!checkpointFile.empty() && !data::Save(checkpointFile, centroids))
+    Log::Warn << "MiniBatchKMeans::Cluster(): could not save checkpoint to '"
+        << checkpointFile << "'!" << std::endl;
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -14,15 +14,38 @@
 #ifndef MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 #define MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
 namespace mlpack {
 namespace kmeans {
 
+/**
+ * 'value' is true if NaiveKMeans finds the nearest centroids with matrix
+ * multiplications, which is the case for the Euclidean distance (or its
+ * square) on dense double-precision data.
+ */
+template<typename MetricType, typename MatType>
+struct UsesGEMMAssignment
+{
+  static const bool value = std::is_same<MatType, arma::mat>::value &&
+      (std::is_same<MetricType, metric::LMetric<2, true>>::value ||
+       std::is_same<MetricType, metric::LMetric<2, false>>::value);
+};
+
 /**
  * This is an implementation of a single iteration of Lloyd's algorithm for
  * k-means.  If your intention is to run the full k-means algorithm, you are
  * looking for the mlpack::kmeans::KMeans class instead of this one.  This class
  * is used by KMeans as the actual implementation of the Lloyd iteration.
  *
+ * With OpenMP, the points are assigned to their nearest centroids in parallel,
+ * and the new centroids are computed in parallel with UpdateCentroids(); the
+ * results do not depend on the number of threads.  For the Euclidean distance
+ * on dense data, the nearest centroids are found for blocks of points at a
+ * time with a matrix multiplication, using ||x - c||^2 = ||x||^2 - 2 x^T c +
+ * ||c||^2.
+ *
  * @param MetricType Type of metric used with this implementation.
  * @param MatType Matrix type (arma::mat or arma::sp_mat).
  */
@@ -60,8 +83,28 @@ class NaiveKMeans
   //! The instantiated metric.
   MetricType& metric;
 
+  //! The nearest centroid of each point.
+  arma::Col<size_t> assignments;
+
   //! Number of distance calculations.
   size_t distanceCalculations;
+
+  /**
+   * Find the nearest centroid of each point by evaluating the metric between
+   * each point and each centroid.
+   */
+  template<typename Metric = MetricType>
+  void AssignPoints(const arma::mat& centroids,
+                    const typename std::enable_if_t<
+                        !UsesGEMMAssignment<Metric, MatType>::value>* = 0);
+
+  /**
+   * Find the nearest centroid of each point with matrix multiplications.
+   */
+  template<typename Metric = MetricType>
+  void AssignPoints(const arma::mat& centroids,
+                    const typename std::enable_if_t<
+                        UsesGEMMAssignment<Metric, MatType>::value>* = 0);
 };
 
 } // namespace kmeans
@@ -17,6 +17,8 @@
 // In case it hasn't been included yet.
 #include "naive_kmeans.hpp"
 
+#include "update_centroids.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -34,11 +36,44 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                  arma::mat& newCentroids,
                                                  arma::Col<size_t>& counts)
 {
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // Find the closest centroid to each point and update the new centroids.
-  for (size_t i = 0; i < dataset.n_cols; i++)
+  assignments.set_size(dataset.n_cols);
+  AssignPoints(centroids);
+  UpdateCentroids(dataset, assignments, centroids.n_cols, newCentroids,
+      counts);
+
+  distanceCalculations += centroids.n_cols * dataset.n_cols;
+
+  // Calculate cluster distortion for this iteration.
+  double cNorm = 0.0;
+  for (size_t i = 0; i < centroids.n_cols; ++i)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  return std::sqrt(cNorm);
+}
+
+template<typename MetricType, typename MatType>
+template<typename Metric>
+void NaiveKMeans<MetricType, MatType>::AssignPoints(
+    const arma::mat& centroids,
+    const typename std::enable_if_t<
+        !UsesGEMMAssignment<Metric, MatType>::value>*)
+{
+  // Sparse matrices are not accessed in parallel.
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for if(!arma::is_SpMat<MatType>::value)
+  for (intmax_t i = 0; i < (intmax_t) dataset.n_cols; ++i)
+#else
+  #pragma omp parallel for if(!arma::is_SpMat<MatType>::value)
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+#endif
   {
     // Find the closest centroid to this point.
     double minDistance = std::numeric_limits<double>::infinity();
@@ -56,29 +91,63 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
 
     Log::Assert(closestCluster != centroids.n_cols);
-
-    // We now have the minimum distance centroid index.  Update that centroid.
-    newCentroids.col(closestCluster) += arma::vec(dataset.col(i));
-    counts(closestCluster)++;
+    assignments[i] = closestCluster;
   }
+}
 
-  // Now normalize the centroid.
-  for (size_t i = 0; i < centroids.n_cols; ++i)
-    if (counts(i) != 0)
-      newCentroids.col(i) /= counts(i);
-
-  distanceCalculations += centroids.n_cols * dataset.n_cols;
+template<typename MetricType, typename MatType>
+template<typename Metric>
+void NaiveKMeans<MetricType, MatType>::AssignPoints(
+    const arma::mat& centroids,
+    const typename std::enable_if_t<
+        UsesGEMMAssignment<Metric, MatType>::value>*)
+{
+  // ||x||^2 is the same for all centroids, so only -2 x^T c + ||c||^2 is
+  // needed to find the closest one.  The block size only depends on the number
+  // of centroids (so that a block of distances takes about 1MB), so the
+  // results do not depend on the number of threads.
+  const arma::rowvec centroidNorms = arma::sum(arma::square(centroids), 0);
+  const size_t blockSize = std::min((size_t) 1024,
+      std::max((size_t) 16, (size_t) 131072 / centroids.n_cols));
+  const size_t numBlocks = (dataset.n_cols + blockSize - 1) / blockSize;
 
-  // Calculate cluster distortion for this iteration.
-  double cNorm = 0.0;
-  for (size_t i = 0; i < centroids.n_cols; ++i)
+  #pragma omp parallel
   {
-    cNorm += std::pow(metric.Evaluate(centroids.col(i), newCentroids.col(i)),
-        2.0);
-  }
-  distanceCalculations += centroids.n_cols;
+    arma::mat products;
 
-  return std::sqrt(cNorm);
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp for schedule(dynamic)
+    for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+    #pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < numBlocks; ++b)
+#endif
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) dataset.n_cols);
+      products = centroids.t() * dataset.cols(begin, end - 1);
+
+      for (size_t i = 0; i < products.n_cols; ++i)
+      {
+        double minDistance = std::numeric_limits<double>::infinity();
+        size_t closestCluster = 0;
+        for (size_t j = 0; j < products.n_rows; ++j)
+        {
+          const double distance = centroidNorms[j] - 2.0 * products(j, i);
+          if (distance < minDistance)
+          {
+            minDistance = distance;
+            closestCluster = j;
+          }
+        }
+
+        assignments[begin + i] = closestCluster;
+      }
+    }
+  }
 }
 
 } // namespace kmeans
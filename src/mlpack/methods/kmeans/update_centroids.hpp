@@ -0,0 +1,119 @@
+/**
+ * @file update_centroids.hpp
+ *
+ * A function that computes the centroids of the clusters of a Lloyd iteration
+ * from the cluster assignments, in parallel if OpenMP is available.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_KMEANS_UPDATE_CENTROIDS_HPP
+#define MLPACK_METHODS_KMEANS_UPDATE_CENTROIDS_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Compute the centroid of each cluster (the mean of the points assigned to
+ * it), and the number of points in each cluster.  The centroid of an empty
+ * cluster is left at zero.
+ *
+ * The points are split into blocks of a fixed size, which are summed in
+ * parallel, each into its own partial sums.  The partial sums are then added
+ * to the centroids in block order.  The blocks depend only on the number of
+ * points and clusters, so the centroids are the same, bit for bit, whatever
+ * the number of threads.
+ *
+ * @param dataset Dataset.
+ * @param assignments Cluster of each point.
+ * @param clusters Number of clusters.
+ * @param newCentroids Matrix to store the centroids in.
+ * @param counts Vector to store the number of points in each cluster in.
+ */
+template<typename MatType>
+void UpdateCentroids(const MatType& dataset,
+                     const arma::Col<size_t>& assignments,
+                     const size_t clusters,
+                     arma::mat& newCentroids,
+                     arma::Col<size_t>& counts)
+{
+  // Blocks must be large enough that adding their partial sums costs little
+  // next to summing them.
+  const size_t blockSize = std::max((size_t) 1024, clusters);
+  const size_t numBlocks = (dataset.n_cols + blockSize - 1) / blockSize;
+
+  // Only a few blocks per thread are summed at once, to bound the memory taken
+  // by the partial sums.  This does not change the order of the additions.
+#ifdef HAS_OPENMP
+  const size_t threads = omp_get_max_threads();
+#else
+  const size_t threads = 1;
+#endif
+  const size_t roundBlocks = std::min(numBlocks, 2 * threads);
+  arma::mat partialSums(dataset.n_rows, clusters * roundBlocks);
+  arma::Mat<size_t> partialCounts(clusters, roundBlocks);
+
+  newCentroids.zeros(dataset.n_rows, clusters);
+  counts.zeros(clusters);
+  for (size_t first = 0; first < numBlocks; first += roundBlocks)
+  {
+    const size_t last = std::min(first + roundBlocks, numBlocks);
+
+    // Sum the points of each block.  Sparse matrices are not accessed in
+    // parallel.
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp parallel for schedule(static) \
+        if(!arma::is_SpMat<MatType>::value)
+    for (intmax_t b = first; b < (intmax_t) last; ++b)
+#else
+    #pragma omp parallel for schedule(static) \
+        if(!arma::is_SpMat<MatType>::value)
+    for (size_t b = first; b < last; ++b)
+#endif
+    {
+      arma::mat sums(partialSums.colptr((b - first) * clusters),
+          dataset.n_rows, clusters, false, true);
+      sums.zeros();
+      partialCounts.col(b - first).zeros();
+
+      const size_t end = std::min((b + 1) * blockSize, (size_t) dataset.n_cols);
+      for (size_t i = b * blockSize; i < end; ++i)
+      {
+        sums.col(assignments[i]) += arma::vec(dataset.col(i));
+        ++partialCounts(assignments[i], b - first);
+      }
+    }
+
+    // Add the partial sums to the centroids in block order.
+#ifdef _WIN32
+    #pragma omp parallel for schedule(static)
+    for (intmax_t c = 0; c < (intmax_t) clusters; ++c)
+#else
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < clusters; ++c)
+#endif
+    {
+      for (size_t b = 0; b < last - first; ++b)
+      {
+        newCentroids.col(c) += partialSums.col(b * clusters + c);
+        counts[c] += partialCounts(c, b);
+      }
+    }
+  }
+
+  for (size_t c = 0; c < clusters; ++c)
+    if (counts[c] > 0)
+      newCentroids.col(c) /= counts[c];
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
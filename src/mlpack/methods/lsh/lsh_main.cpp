@@ -15,6 +15,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include "lsh_search.hpp"
+#include "lsh_tuner.hpp"
 
 using namespace std;
 using namespace mlpack;
@@ -41,7 +42,19 @@ PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with LSH",
     "\n\n"
     "Because this is approximate-nearest-neighbors search, results may be "
     "different from run to run.  Thus, the --seed option can be specified to "
-    "set the random seed.");
+    "set the random seed."
+    "\n\n"
+    "Instead of specifying the LSH parameters by hand, the --tune option can "
+    "be given to search for them.  Then, --tuning_queries points of the "
+    "reference set are held out as sample queries, and every combination of "
+    "the values given with --tune_projections, --tune_tables, "
+    "--tune_hash_widths (as multiples of the default hash width), "
+    "--tune_probes and --tune_bucket_sizes is evaluated by computing the "
+    "recall of the sample queries and measuring the query time and memory "
+    "usage.  The fastest setting (or, with --tune_memory, the smallest one) "
+    "that reaches a recall of --target_recall is then used to build the model "
+    "on the whole reference set.  The Pareto frontier of the evaluated "
+    "settings can be saved with --pareto_frontier_file.");
 
 // Define our input parameters that this program will take.
 PARAM_MATRIX_IN("reference", "Matrix containing the reference dataset.", "r");
@@ -74,6 +87,46 @@ PARAM_INT_IN("bucket_size", "The size of a bucket in the second level hash.",
     "B", 500);
 PARAM_INT_IN("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
+// For tuning the parameters.
+PARAM_FLAG("tune", "If set, search for the LSH parameters that reach "
+    "--target_recall as fast as possible, instead of using --projections, "
+    "--tables, --hash_width, --num_probes and --bucket_size.", "");
+PARAM_DOUBLE_IN("target_recall", "Recall (in [0, 1]) to reach when tuning.",
+    "", 0.9);
+PARAM_INT_IN("tuning_queries", "Number of reference points to hold out as "
+    "sample queries when tuning.", "", 100);
+PARAM_FLAG("tune_memory", "If set, tuning picks the setting with the smallest "
+    "memory usage instead of the fastest one.", "");
+PARAM_VECTOR_IN(int, "tune_projections", "Numbers of projections to try when "
+    "tuning (default 5, 10, 15, 20, 30).", "");
+PARAM_VECTOR_IN(int, "tune_tables", "Numbers of tables to try when tuning "
+    "(default 1, 2, 4, 8, 16, 32).", "");
+PARAM_VECTOR_IN(double, "tune_hash_widths", "Hash widths to try when tuning, "
+    "as multiples of the default hash width (default 0.5, 1, 2, 4).", "");
+PARAM_VECTOR_IN(int, "tune_probes", "Numbers of additional probes to try when "
+    "tuning (default 0, 2, 5, 10, 20).", "");
+PARAM_VECTOR_IN(int, "tune_bucket_sizes", "Bucket sizes to try when tuning "
+    "(default: the value of --bucket_size).", "");
+PARAM_MATRIX_OUT("pareto_frontier", "If tuning, matrix to save the Pareto "
+    "frontier of the evaluated settings into.  Each column is a setting, with "
+    "rows: projections, tables, hash width, probes, bucket size, recall, query "
+    "time (seconds per query) and estimated memory usage (bytes).", "");
+
+// Get the values of the given integer vector parameter for tuning, which may
+// not be negative.
+void GetTuningValues(const string& name, vector<size_t>& values)
+{
+  const vector<int>& params = CLI::GetParam<vector<int>>(name);
+  for (size_t i = 0; i < params.size(); ++i)
+  {
+    if (params[i] < 0)
+      Log::Fatal << "Invalid value for --" << name << ": " << params[i]
+          << "; values must be non-negative!" << endl;
+  }
+
+  values.assign(params.begin(), params.end());
+}
+
 int main(int argc, char *argv[])
 {
   // Give CLI the command line parameters the user passed in.
@@ -126,6 +179,21 @@ int main(int argc, char *argv[])
         << CLI::GetUnmappedParam<LSHSearch<>>("input_model") << "'." << endl;
   }
 
+  if (CLI::HasParam("tune") && !CLI::HasParam("reference"))
+    Log::Fatal << "--reference_file must be specified with --tune!" << endl;
+
+  if (CLI::HasParam("tune") && !CLI::HasParam("k"))
+    Log::Fatal << "--k must be specified with --tune!" << endl;
+
+  const double targetRecall = CLI::GetParam<double>("target_recall");
+  if (CLI::HasParam("tune") && (targetRecall < 0.0 || targetRecall > 1.0))
+    Log::Fatal << "Invalid value for --target_recall: " << targetRecall
+        << "; must be in [0, 1]!" << endl;
+
+  if (!CLI::HasParam("tune") && CLI::HasParam("pareto_frontier"))
+    Log::Warn << "--pareto_frontier_file ignored because --tune is not "
+        << "specified." << endl;
+
   if (!CLI::HasParam("k") && CLI::HasParam("neighbors"))
     Log::Warn << "--neighbors_file ignored because --k is not specified."
         << endl;
@@ -139,14 +207,118 @@ int main(int argc, char *argv[])
   arma::mat queryData;
 
   // Pick up the LSH-specific parameters.
-  const size_t numProj = CLI::GetParam<int>("projections");
-  const size_t numTables = CLI::GetParam<int>("tables");
-  const double hashWidth = CLI::GetParam<double>("hash_width");
-  const size_t numProbes = (size_t) CLI::GetParam<int>("num_probes");
+  size_t numProj = CLI::GetParam<int>("projections");
+  size_t numTables = CLI::GetParam<int>("tables");
+  double hashWidth = CLI::GetParam<double>("hash_width");
+  size_t numProbes = (size_t) CLI::GetParam<int>("num_probes");
 
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
+  if (CLI::HasParam("reference"))
+  {
+    referenceData = std::move(CLI::GetParam<arma::mat>("reference"));
+    Log::Info << "Loaded reference data from '"
+        << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
+        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
+        << endl;
+  }
+
+  if (CLI::HasParam("tune"))
+  {
+    const size_t numQueries = (size_t) CLI::GetParam<int>("tuning_queries");
+    if (numQueries == 0 || numQueries >= referenceData.n_cols)
+    {
+      Log::Fatal << "--tuning_queries must be positive and less than the "
+          << "number of reference points (" << referenceData.n_cols << ")!"
+          << endl;
+    }
+
+    // Hold out a random sample of the reference set as queries.
+    const arma::uvec order = arma::shuffle(arma::linspace<arma::uvec>(0,
+        referenceData.n_cols - 1, referenceData.n_cols));
+    const arma::mat sampleQueries = referenceData.cols(
+        order.head(numQueries));
+    const arma::mat sampleReferences = referenceData.cols(
+        order.tail(referenceData.n_cols - numQueries));
+
+    // Use the given values, or the defaults.
+    std::vector<size_t> numProjValues = { 5, 10, 15, 20, 30 };
+    std::vector<size_t> numTablesValues = { 1, 2, 4, 8, 16, 32 };
+    std::vector<double> hashWidthScales = { 0.5, 1.0, 2.0, 4.0 };
+    std::vector<size_t> TValues = { 0, 2, 5, 10, 20 };
+    std::vector<size_t> bucketSizeValues = { bucketSize };
+    if (CLI::HasParam("tune_projections"))
+      GetTuningValues("tune_projections", numProjValues);
+    if (CLI::HasParam("tune_tables"))
+      GetTuningValues("tune_tables", numTablesValues);
+    if (CLI::HasParam("tune_hash_widths"))
+    {
+      hashWidthScales = CLI::GetParam<vector<double>>("tune_hash_widths");
+      for (size_t i = 0; i < hashWidthScales.size(); ++i)
+      {
+        if (hashWidthScales[i] <= 0.0)
+          Log::Fatal << "Invalid value for --tune_hash_widths: "
+              << hashWidthScales[i] << "; values must be positive!" << endl;
+      }
+    }
+    if (CLI::HasParam("tune_probes"))
+      GetTuningValues("tune_probes", TValues);
+    if (CLI::HasParam("tune_bucket_sizes"))
+      GetTuningValues("tune_bucket_sizes", bucketSizeValues);
+
+    Timer::Start("tuning");
+    LSHTuner<> tuner(sampleReferences, sampleQueries, k);
+    tuner.Tune(numProjValues, numTablesValues, hashWidthScales, TValues,
+        bucketSizeValues, secondHashSize);
+    Timer::Stop("tuning");
+
+    const vector<LSHTuningResult> frontier = tuner.ParetoFrontier();
+    if (frontier.empty())
+      Log::Fatal << "No LSH setting was evaluated while tuning!" << endl;
+
+    if (CLI::HasParam("pareto_frontier"))
+    {
+      arma::mat& output = CLI::GetParam<arma::mat>("pareto_frontier");
+      output.set_size(8, frontier.size());
+      for (size_t i = 0; i < frontier.size(); ++i)
+      {
+        output(0, i) = frontier[i].numProj;
+        output(1, i) = frontier[i].numTables;
+        output(2, i) = frontier[i].hashWidth;
+        output(3, i) = frontier[i].T;
+        output(4, i) = frontier[i].bucketSize;
+        output(5, i) = frontier[i].recall;
+        output(6, i) = frontier[i].queryTime;
+        output(7, i) = frontier[i].memory;
+      }
+    }
+
+    // If no setting reaches the target recall, use the one with the highest
+    // recall (the last of the frontier).
+    LSHTuningResult best = frontier.back();
+    if (best.recall < targetRecall)
+    {
+      Log::Warn << "No evaluated setting reaches a recall of " << targetRecall
+          << "; using the setting with the highest recall (" << best.recall
+          << ")." << endl;
+    }
+    else
+    {
+      best = tuner.Best(targetRecall, CLI::HasParam("tune_memory"));
+    }
+
+    numProj = best.numProj;
+    numTables = best.numTables;
+    hashWidth = best.hashWidth;
+    numProbes = best.T;
+    bucketSize = best.bucketSize;
+    Log::Info << "Tuning chose " << numProj << " projections, " << numTables
+        << " tables, hash width " << hashWidth << ", " << numProbes
+        << " probes and bucket size " << bucketSize << " (recall "
+        << best.recall << " on the sample queries)." << endl;
+  }
+
   if (hashWidth == 0.0)
     Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
         numTables << " tables (L) with default hash width." << endl;
@@ -157,12 +329,6 @@ int main(int argc, char *argv[])
   LSHSearch<> allkann;
   if (CLI::HasParam("reference"))
   {
-    referenceData = std::move(CLI::GetParam<arma::mat>("reference"));
-    Log::Info << "Loaded reference data from '"
-        << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
-        << referenceData.n_rows << " x " << referenceData.n_cols << ")."
-        << endl;
-
     Timer::Start("hash_building");
     allkann.Train(referenceData, numProj, numTables, hashWidth, secondHashSize,
         bucketSize);
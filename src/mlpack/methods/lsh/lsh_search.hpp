@@ -187,6 +187,44 @@ class LSHSearch
              const size_t bucketSize = 500,
              const arma::cube& projection = arma::cube());
 
+  /**
+   * Insert the given points into the model, without rehashing the points that
+   * are already in it.  The points are hashed with the existing projections
+   * and appended to the reference set, so they get the indices n to
+   * n + points.n_cols - 1, where n is the number of points in the reference
+   * set before the insertion.  The model keeps its own copy of the reference
+   * set, with room for more points; when that runs out, its capacity is
+   * doubled, so a series of small insertions does not copy the whole
+   * reference set each time.
+   *
+   * Buckets that run out of space are moved to the end of the bucket storage
+   * with twice their capacity, so the cost of an insertion is amortized
+   * constant per point and table; call Compact() to reclaim the space they
+   * leave behind.  As in Train(), a point is not added to a bucket that
+   * already holds bucketSize points.
+   *
+   * @param points Points to insert.
+   */
+  void Insert(const arma::mat& points);
+
+  /**
+   * Remove the points with the given indices from the hash tables, so that
+   * they will never be returned as neighbors.  The points are not removed from
+   * the reference set (so that the indices of the other points do not
+   * change), and they are still used as queries by the monochromatic Search().
+   * Removing a point twice has no effect.
+   *
+   * @param indices Indices of the points to remove.
+   */
+  void Remove(const arma::Col<size_t>& indices);
+
+  /**
+   * Rebuild the bucket storage so that it holds no unused space: each bucket
+   * gets exactly the capacity it needs, and empty buckets are dropped.  This
+   * is useful after a series of calls to Insert() or Remove().
+   */
+  void Compact();
+
   /**
    * Compute the nearest neighbors of the points in the given query set and
    * store the output in the given matrices.  The matrices will be set to the
@@ -270,6 +308,15 @@ class LSHSearch
   //! Get the number of projections.
   size_t NumProjections() const { return projections.n_slices; }
 
+  //! Get the hash width.
+  double HashWidth() const { return hashWidth; }
+
+  //! Get the number of hash tables.
+  size_t NumTables() const { return numTables; }
+
+  //! Get the size of the second hash.
+  size_t SecondHashSize() const { return secondHashSize; }
+
   //! Get the offsets 'b' for each of the projections.  (One 'b' per column.)
   const arma::mat& Offsets() const { return offsets; }
 
@@ -279,9 +326,22 @@ class LSHSearch
   //! Get the bucket size of the second hash.
   size_t BucketSize() const { return bucketSize; }
 
-  //! Get the second hash table.
-  const std::vector<arma::Col<size_t>>& SecondHashTable() const
-      { return secondHashTable; }
+  //! Get the number of buckets in the second hash table.
+  size_t NumBuckets() const { return bucketContentSize.n_elem; }
+
+  //! Get the storage of the second hash table: the contents of bucket i are
+  //! the BucketContentSize()[i] elements starting at BucketOffsets()[i].
+  const std::vector<size_t>& SecondHashTable() const { return secondHashTable; }
+
+  //! Get the offset of each bucket in the second hash table.
+  const arma::Col<size_t>& BucketOffsets() const { return bucketOffsets; }
+
+  //! Get the capacity of each bucket in the second hash table.
+  const arma::Col<size_t>& BucketCapacities() const { return bucketCapacities; }
+
+  //! Get the number of points in each bucket of the second hash table.
+  const arma::Col<size_t>& BucketContentSize() const
+  { return bucketContentSize; }
 
   //! Get the projection tables.
   const arma::cube& Projections() { return projections; }
@@ -296,69 +356,132 @@ class LSHSearch
 
  private:
   /**
-   * This function takes a query and hashes it into each of the hash tables to
-   * get keys for the query and then the key is hashed to a bucket of the second
-   * hash table and all the points (if any) in those buckets are collected as
-   * the potential neighbor candidates.
+   * Hash each of the given points into each hash table, and then into a bucket
+   * of the second hash table.  The bucket of point j in table i is stored in
+   * element (i, j) of the given matrix.
    *
-   * @param queryPoint The query point currently being processed.
-   * @param referenceIndices The list of neighbor candidates obtained from
-   *    hashing the query into all the hash tables and eventually into
-   *    multiple buckets of the second hash table.
+   * @param points Points to hash.
+   * @param secondHashVectors Matrix to store the buckets of the points in.
+   */
+  void ComputeSecondHashVectors(const arma::mat& points,
+                                arma::Mat<size_t>& secondHashVectors) const;
+
+  /**
+   * Make sure that each bucket of the second hash table can hold the given
+   * number of points, moving the buckets that are too small to the end of the
+   * storage with (at least) twice their previous capacity.
+   *
+   * @param sizes Number of points each bucket must be able to hold.
+   */
+  void ReserveBuckets(const arma::Col<size_t>& sizes);
+
+  /**
+   * Search for the neighbors of each point in the given query set, and store
+   * them in the given matrices (which must already have the right size).  The
+   * queries are processed in blocks, in parallel if OpenMP is available.
+   *
+   * @param querySet Set of query points.
+   * @param monochromatic If true, the query set is the reference set, and a
+   *    point is never returned as its own neighbor.
+   * @param k Number of neighbors to search for.
+   * @param resultingNeighbors Matrix holding output neighbors.
+   * @param distances Matrix holding output distances.
    * @param numTablesToSearch The number of tables to perform the search in. If
    *    0, all tables are searched.
    * @param T The number of additional probing bins for multiprobe LSH. If 0,
    *    single-probe is used.
+   * @return The total number of candidates of all queries.
    */
-  template<typename VecType>
-  void ReturnIndicesFromTable(const VecType& queryPoint,
-                              arma::uvec& referenceIndices,
-                              size_t numTablesToSearch,
-                              const size_t T) const;
+  size_t SearchQueries(const arma::mat& querySet,
+                       const bool monochromatic,
+                       const size_t k,
+                       arma::Mat<size_t>& resultingNeighbors,
+                       arma::mat& distances,
+                       size_t numTablesToSearch,
+                       const size_t T);
 
   /**
-   * This is a helper function that computes the distance of the query to the
-   * neighbor candidates and appropriately stores the best 'k' candidates.  This
-   * is specific to the monochromatic search case, where the query set is the
-   * reference set.
+   * Hash the given block of queries into the first numTablesToSearch hash
+   * tables.  All projections are computed with a single matrix
+   * multiplication.  Column j of each output matrix corresponds to query
+   * begin + j; the rows of queryCodesNotFloored and queryCodes hold the
+   * 'numProj' values of table 0, then those of table 1, and so on.
    *
-   * @param queryIndex The index of the query in question
-   * @param referenceIndices The vector of indices of candidate neighbors for
-   *    the query.
-   * @param k Number of neighbors to search for.
-   * @param neighbors Matrix holding output neighbors.
-   * @param distances Matrix holding output distances.
+   * @param querySet Set of query points.
+   * @param begin Index of the first query of the block.
+   * @param count Number of queries in the block.
+   * @param numTablesToSearch The number of tables to hash the queries into.
+   * @param queryCodesNotFloored Projections of the queries (plus offsets).
+   * @param queryCodes Codes of the queries (the floored projections, divided by
+   *    the hash width).
+   * @param queryHashes Bucket of the second hash table of each query in each
+   *    table (one row per table).
    */
-  void BaseCase(const size_t queryIndex,
-                const arma::uvec& referenceIndices,
-                const size_t k,
-                arma::Mat<size_t>& neighbors,
-                arma::mat& distances) const;
+  void HashQueries(const arma::mat& querySet,
+                   const size_t begin,
+                   const size_t count,
+                   const size_t numTablesToSearch,
+                   arma::mat& queryCodesNotFloored,
+                   arma::mat& queryCodes,
+                   arma::Mat<size_t>& queryHashes) const;
+
+  /**
+   * This function takes the hashes of a query (computed by HashQueries()) and
+   * collects all the points (if any) in the corresponding buckets of the
+   * second hash table as the potential neighbor candidates.  With multiprobe
+   * LSH, additional buckets near the query's buckets are probed too.  Each
+   * candidate is returned once; duplicates are detected by stamping the
+   * candidates in candidateStamps with the given stamp, which must be
+   * different for each query.
+   *
+   * @param queryCodes Codes of the query in each table.
+   * @param queryCodesNotFloored Projections of the query in each table.
+   * @param queryHashes Bucket of the query in each table.
+   * @param T The number of additional probing bins for multiprobe LSH. If 0,
+   *    single-probe is used.
+   * @param stamp Stamp of the query.
+   * @param candidateStamps Last stamp of each reference point.
+   * @param referenceIndices The list of neighbor candidates obtained from
+   *    hashing the query into all the hash tables and eventually into
+   *    multiple buckets of the second hash table.
+   */
+  void ReturnIndicesFromTable(const arma::vec& queryCodes,
+                              const arma::vec& queryCodesNotFloored,
+                              const arma::Col<size_t>& queryHashes,
+                              const size_t T,
+                              const size_t stamp,
+                              std::vector<size_t>& candidateStamps,
+                              std::vector<size_t>& referenceIndices) const;
 
   /**
    * This is a helper function that computes the distance of the query to the
-   * neighbor candidates and appropriately stores the best 'k' candidates.  This
-   * is specific to bichromatic search, where the query set is not the same as
-   * the reference set.
+   * neighbor candidates and appropriately stores the best 'k' candidates.
+   * The candidates are copied into a contiguous block (a few at a time) so
+   * that their distances are computed with vectorized operations.
    *
    * @param queryIndex The index of the query in question
+   * @param querySet Set of query points.
+   * @param monochromatic If true, the query set is the reference set, and the
+   *    query is not considered as its own neighbor.
    * @param referenceIndices The vector of indices of candidate neighbors for
    *    the query.
    * @param k Number of neighbors to search for.
-   * @param querySet Set of query points.
    * @param neighbors Matrix holding output neighbors.
    * @param distances Matrix holding output distances.
+   * @param candidateBlock Scratch matrix to copy the candidates into.
    */
   void BaseCase(const size_t queryIndex,
-                const arma::uvec& referenceIndices,
-                const size_t k,
                 const arma::mat& querySet,
+                const bool monochromatic,
+                const std::vector<size_t>& referenceIndices,
+                const size_t k,
                 arma::Mat<size_t>& neighbors,
-                arma::mat& distances) const;
+                arma::mat& distances,
+                arma::mat& candidateBlock) const;
 
   /**
    * This function implements the core idea behind Multiprobe LSH. It is called
-   * by ReturnIndicesFromTables when T > 0. Given a query's code and its
+   * by ReturnIndicesFromTable() when T > 0. Given a query's code and its
    * projection location, GetAdditionalProbingBins will calculate the T most
    * likely alternative bin codes (other than queryCode) where a query's
    * neighbors might be found in.
@@ -417,6 +540,10 @@ class LSHSearch
   const arma::mat* referenceSet;
   //! If true, we own the reference set.
   bool ownsSet;
+  //! Storage for the reference set after Insert(), with room for more points
+  //! (NULL if Insert() has not been called).  The reference set is then an
+  //! alias of its first columns.
+  arma::mat* referenceStorage;
 
   //! The number of projections.
   size_t numProj;
@@ -441,12 +568,17 @@ class LSHSearch
   //! The bucket size of the second hash.
   size_t bucketSize;
 
-  //! The final hash table; should be (< secondHashSize) vectors each with
-  //! (<= bucketSize) elements.
-  std::vector<arma::Col<size_t>> secondHashTable;
+  //! The final hash table, with the buckets stored one after the other; there
+  //! should be (< secondHashSize) buckets, each with (<= bucketSize) elements.
+  std::vector<size_t> secondHashTable;
 
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
+  //! The offset of each bucket in secondHashTable.
+  arma::Col<size_t> bucketOffsets;
+
+  //! The number of elements each bucket has room for in secondHashTable.
+  arma::Col<size_t> bucketCapacities;
+
+  //! The number of elements present in each hash bucket.
   arma::Col<size_t> bucketContentSize;
 
   //! For a particular hash value, points to the row in secondHashTable
@@ -456,6 +588,13 @@ class LSHSearch
   //! The number of distance evaluations.
   size_t distanceEvaluations;
 
+  //! The last stamp of each reference point, for each thread, used by
+  //! SearchQueries() to find duplicate candidates.  This is kept between
+  //! searches, so it is only allocated once per thread; Train() frees it.
+  std::vector<std::vector<size_t>> candidateStamps;
+  //! The stamp of the first query of the next search.
+  size_t nextStamp;
+
   //! Candidate represents a possible candidate neighbor (distance, index).
   typedef std::pair<double, size_t> Candidate;
 
@@ -478,7 +617,7 @@ class LSHSearch
 
 //! Set the serialization version of the LSHSearch class.
 BOOST_TEMPLATE_CLASS_VERSION(template<typename SortPolicy>,
-    mlpack::neighbor::LSHSearch<SortPolicy>, 1);
+    mlpack::neighbor::LSHSearch<SortPolicy>, 2);
 
 // Include implementation.
 #include "lsh_search_impl.hpp"
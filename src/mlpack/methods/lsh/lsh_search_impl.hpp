@@ -29,12 +29,14 @@ LSHSearch(const arma::mat& referenceSet,
           const size_t bucketSize) :
   referenceSet(NULL), // This will be set in Train().
   ownsSet(false),
+  referenceStorage(NULL),
   numProj(numProj),
   numTables(numTables),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
-  distanceEvaluations(0)
+  distanceEvaluations(0),
+  nextStamp(1)
 {
   // Pass work to training function.
   Train(referenceSet, numProj, numTables, hashWidthIn, secondHashSize,
@@ -51,12 +53,14 @@ LSHSearch(const arma::mat& referenceSet,
           const size_t bucketSize) :
   referenceSet(NULL), // This will be set in Train().
   ownsSet(false),
+  referenceStorage(NULL),
   numProj(projections.n_cols),
   numTables(projections.n_slices),
   hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
-  distanceEvaluations(0)
+  distanceEvaluations(0),
+  nextStamp(1)
 {
   // Pass work to training function
   Train(referenceSet, numProj, numTables, hashWidthIn, secondHashSize,
@@ -68,12 +72,14 @@ template<typename SortPolicy>
 LSHSearch<SortPolicy>::LSHSearch() :
     referenceSet(new arma::mat()), // Use an empty dataset.
     ownsSet(true),
+    referenceStorage(NULL),
     numProj(0),
     numTables(0),
     hashWidth(0),
     secondHashSize(99901),
     bucketSize(500),
-    distanceEvaluations(0)
+    distanceEvaluations(0),
+    nextStamp(1)
 {
 }
 
@@ -82,6 +88,7 @@ template<typename SortPolicy>
 LSHSearch<SortPolicy>::LSHSearch(const LSHSearch& other) :
     referenceSet(new arma::mat(*other.referenceSet)),
     ownsSet(true),
+    referenceStorage(NULL),
     numProj(other.numProj),
     numTables(other.numTables),
     projections(other.projections),
@@ -91,9 +98,12 @@ LSHSearch<SortPolicy>::LSHSearch(const LSHSearch& other) :
     secondHashWeights(other.secondHashWeights),
     bucketSize(other.bucketSize),
     secondHashTable(other.secondHashTable),
+    bucketOffsets(other.bucketOffsets),
+    bucketCapacities(other.bucketCapacities),
     bucketContentSize(other.bucketContentSize),
     bucketRowInHashTable(other.bucketRowInHashTable),
-    distanceEvaluations(other.distanceEvaluations)
+    distanceEvaluations(other.distanceEvaluations),
+    nextStamp(1)
 {
   // Nothing to do.
 }
@@ -103,6 +113,7 @@ template<typename SortPolicy>
 LSHSearch<SortPolicy>::LSHSearch(LSHSearch&& other) :
     referenceSet(other.referenceSet),
     ownsSet(other.ownsSet),
+    referenceStorage(other.referenceStorage),
     numProj(other.numProj),
     numTables(other.numTables),
     projections(std::move(other.projections)),
@@ -112,13 +123,17 @@ LSHSearch<SortPolicy>::LSHSearch(LSHSearch&& other) :
     secondHashWeights(std::move(other.secondHashWeights)),
     bucketSize(other.bucketSize),
     secondHashTable(std::move(other.secondHashTable)),
+    bucketOffsets(std::move(other.bucketOffsets)),
+    bucketCapacities(std::move(other.bucketCapacities)),
     bucketContentSize(std::move(other.bucketContentSize)),
     bucketRowInHashTable(std::move(other.bucketRowInHashTable)),
-    distanceEvaluations(other.distanceEvaluations)
+    distanceEvaluations(other.distanceEvaluations),
+    nextStamp(1)
 {
   // Reset other model to defaults.
   other.referenceSet = new arma::mat();
   other.ownsSet = true;
+  other.referenceStorage = NULL;
   other.numProj = 0;
   other.numTables = 0;
   other.hashWidth = 0;
@@ -131,11 +146,15 @@ LSHSearch<SortPolicy>::LSHSearch(LSHSearch&& other) :
 template<typename SortPolicy>
 LSHSearch<SortPolicy>& LSHSearch<SortPolicy>::operator=(const LSHSearch& other)
 {
+  // Copy the reference set before freeing ours, in case other is this object.
+  const arma::mat* newReferenceSet = new arma::mat(*other.referenceSet);
   if (ownsSet)
     delete referenceSet;
+  delete referenceStorage;
 
-  referenceSet = new arma::mat(*other.referenceSet);
+  referenceSet = newReferenceSet;
   ownsSet = true;
+  referenceStorage = NULL;
   numProj = other.numProj;
   numTables = other.numTables;
   projections = other.projections;
@@ -145,6 +164,8 @@ LSHSearch<SortPolicy>& LSHSearch<SortPolicy>::operator=(const LSHSearch& other)
   secondHashWeights = other.secondHashWeights;
   bucketSize = other.bucketSize;
   secondHashTable = other.secondHashTable;
+  bucketOffsets = other.bucketOffsets;
+  bucketCapacities = other.bucketCapacities;
   bucketContentSize = other.bucketContentSize;
   bucketRowInHashTable = other.bucketRowInHashTable;
   distanceEvaluations = other.distanceEvaluations;
@@ -158,9 +179,11 @@ LSHSearch<SortPolicy>& LSHSearch<SortPolicy>::operator=(LSHSearch&& other)
 {
   if (ownsSet)
     delete referenceSet;
+  delete referenceStorage;
 
   referenceSet = other.referenceSet;
   ownsSet = other.ownsSet;
+  referenceStorage = other.referenceStorage;
   numProj = other.numProj;
   numTables = other.numTables;
   projections = std::move(other.projections);
@@ -170,6 +193,8 @@ LSHSearch<SortPolicy>& LSHSearch<SortPolicy>::operator=(LSHSearch&& other)
   secondHashWeights = std::move(other.secondHashWeights);
   bucketSize = other.bucketSize;
   secondHashTable = std::move(other.secondHashTable);
+  bucketOffsets = std::move(other.bucketOffsets);
+  bucketCapacities = std::move(other.bucketCapacities);
   bucketContentSize = std::move(other.bucketContentSize);
   bucketRowInHashTable = std::move(other.bucketRowInHashTable);
   distanceEvaluations = other.distanceEvaluations;
@@ -177,6 +202,7 @@ LSHSearch<SortPolicy>& LSHSearch<SortPolicy>::operator=(LSHSearch&& other)
   // Reset other model to defaults.
   other.referenceSet = new arma::mat();
   other.ownsSet = true;
+  other.referenceStorage = NULL;
   other.numProj = 0;
   other.numTables = 0;
   other.hashWidth = 0;
@@ -193,6 +219,7 @@ LSHSearch<SortPolicy>::~LSHSearch()
 {
   if (ownsSet)
     delete referenceSet;
+  delete referenceStorage;
 }
 
 // Train on a new reference set.
@@ -205,11 +232,21 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
                                   const size_t bucketSize,
                                   const arma::cube &projection)
 {
-  // Set new reference set.
-  if (this->referenceSet && ownsSet)
-    delete this->referenceSet;
-  this->referenceSet = &referenceSet;
-  this->ownsSet = false;
+  // Set new reference set.  If we are retrained on our own reference set (as
+  // Projections() does), we keep it.
+  if (&referenceSet != this->referenceSet)
+  {
+    if (this->referenceSet && ownsSet)
+      delete this->referenceSet;
+    delete referenceStorage;
+    this->referenceSet = &referenceSet;
+    this->ownsSet = false;
+    referenceStorage = NULL;
+  }
+
+  // The stamps of the searches are sized for the old reference set.
+  candidateStamps.clear();
+  nextStamp = 1;
 
   // Set new parameters.
   this->numProj = numProj;
@@ -281,50 +318,10 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
         "tables provided must be equal to numProj");
   }
 
-  // We will store the second hash vectors in this matrix; the second hash
-  // vector for table i will be held in row i.  We have to use int and not
-  // size_t, otherwise negative numbers are cast to 0.
-  arma::Mat<size_t> secondHashVectors(numTables, referenceSet.n_cols);
-
-  for (size_t i = 0; i < numTables; i++)
-  {
-    // Step IV: create the 'numProj'-dimensional key for each point in each
-    // table.
-
-    // The following code performs the task of hashing each point to a
-    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
-    // 'referenceSet.n_cols') key matrix.
-    //
-    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
-    // and the corresponding offset be 'offset_i'.  Then the key of a single
-    // point is obtained as:
-    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       referenceSet.n_cols);
-    arma::mat hashMat = projections.slice(i).t() * (referenceSet);
-    hashMat += offsetMat;
-    hashMat /= hashWidth;
-
-    // Step V: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.  We must
-    // also normalize the hashes to the range [0, secondHashSize).
-    arma::rowvec unmodVector = secondHashWeights.t() * arma::floor(hashMat);
-    for (size_t j = 0; j < unmodVector.n_elem; ++j)
-    {
-      double shs = (double) secondHashSize; // Convenience cast.
-      if (unmodVector[j] >= 0.0)
-      {
-        const size_t key = size_t(fmod(unmodVector[j], shs));
-        secondHashVectors(i, j) = key;
-      }
-      else
-      {
-        const double mod = fmod(-unmodVector[j], shs);
-        const size_t key = (mod < 1.0) ? 0 : secondHashSize - size_t(mod);
-        secondHashVectors(i, j) = key;
-      }
-    }
-  }
+  // Steps IV and V: hash each point into each table, and then into a bucket of
+  // the second hash table.
+  arma::Mat<size_t> secondHashVectors;
+  ComputeSecondHashVectors(referenceSet, secondHashVectors);
 
   // Now, using the hash vectors for each table, count the number of rows we
   // have in the second hash table.
@@ -339,11 +336,14 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
 
   const size_t numRowsInTable = arma::accu(secondHashBinCounts > 0);
   bucketContentSize.zeros(numRowsInTable);
-  secondHashTable.resize(numRowsInTable);
+  bucketOffsets.set_size(numRowsInTable);
+  bucketCapacities.set_size(numRowsInTable);
+  secondHashTable.assign(arma::accu(secondHashBinCounts), 0);
 
   // Next we must assign each point in each table to the right second hash
   // table.
   size_t currentRow = 0;
+  size_t currentOffset = 0;
   for (size_t i = 0; i < numTables; ++i)
   {
     // Insert the point in the corresponding row to its bucket in the
@@ -360,14 +360,16 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
       if (bucketRowInHashTable[hashInd] == secondHashSize)
       {
         bucketRowInHashTable[hashInd] = currentRow;
-        secondHashTable[currentRow].set_size(maxSize);
+        bucketOffsets[currentRow] = currentOffset;
+        bucketCapacities[currentRow] = maxSize;
+        currentOffset += maxSize;
         currentRow++;
       }
 
-      // If this vector in the hash table is not full, add the point.
+      // If this bucket in the hash table is not full, add the point.
       const size_t index = bucketRowInHashTable[hashInd];
       if (bucketContentSize[index] < maxSize)
-        secondHashTable[index](bucketContentSize[index]++) = j;
+        secondHashTable[bucketOffsets[index] + bucketContentSize[index]++] = j;
 
     } // Loop over all points in the reference set.
   } // Loop over tables.
@@ -378,61 +380,282 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
             << std::endl;
 }
 
-// Base case where the query set is the reference set.  (So, we can't return
-// ourselves as the nearest neighbor.)
+// Insert new points into the model.
 template<typename SortPolicy>
-inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const arma::uvec& referenceIndices,
-                                     const size_t k,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+void LSHSearch<SortPolicy>::Insert(const arma::mat& points)
 {
-  // Let's build the list of candidate neighbors for the given query point.
-  // It will be initialized with k candidates:
-  // (WorstDistance, referenceSet->n_cols)
-  const Candidate def = std::make_pair(SortPolicy::WorstDistance(),
-      referenceSet->n_cols);
-  std::vector<Candidate> vect(k, def);
-  CandidateList pqueue(CandidateCmp(), std::move(vect));
+  if (points.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Insert(): dimensionality of points (" << points.n_rows
+        << ") is not equal to the dimensionality the model was trained on ("
+        << referenceSet->n_rows << ")!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (points.n_cols == 0)
+    return;
+
+  // Hash the new points.
+  arma::Mat<size_t> secondHashVectors;
+  ComputeSecondHashVectors(points, secondHashVectors);
+
+  // Find the bucket of each new point in each table, creating the buckets that
+  // don't exist yet, and count how many points each bucket must be able to
+  // hold.  From here on, secondHashVectors holds rows instead of hash values.
+  const size_t effectiveBucketSize = (bucketSize == 0) ? SIZE_MAX : bucketSize;
+  size_t numRows = bucketContentSize.n_elem;
+  arma::Col<size_t> newSizes(bucketContentSize);
+  for (size_t i = 0; i < secondHashVectors.n_elem; ++i)
+  {
+    const size_t hashInd = secondHashVectors[i];
+    if (bucketRowInHashTable[hashInd] == secondHashSize)
+    {
+      bucketRowInHashTable[hashInd] = numRows++;
+      newSizes.resize(numRows);
+      newSizes[numRows - 1] = 0;
+    }
+
+    const size_t row = bucketRowInHashTable[hashInd];
+    if (newSizes[row] < effectiveBucketSize)
+      ++newSizes[row];
 
-  for (size_t j = 0; j < referenceIndices.n_elem; ++j)
+    secondHashVectors[i] = row;
+  }
+
+  ReserveBuckets(newSizes);
+
+  // Now add the points to their buckets, in the same order as Train() does.
+  // The new points are appended to the reference set, so point j gets the
+  // index firstIndex + j.
+  const size_t firstIndex = referenceSet->n_cols;
+  for (size_t i = 0; i < numTables; ++i)
   {
-    const size_t referenceIndex = referenceIndices[j];
-    // If the points are the same, skip this point.
-    if (queryIndex == referenceIndex)
+    for (size_t j = 0; j < secondHashVectors.n_cols; ++j)
+    {
+      const size_t row = secondHashVectors(i, j);
+      if (bucketContentSize[row] < effectiveBucketSize)
+      {
+        secondHashTable[bucketOffsets[row] + bucketContentSize[row]++] =
+            firstIndex + j;
+      }
+    }
+  }
+
+  // Append the new points to the reference storage.  When it runs out of
+  // space, its capacity is at least doubled, so over a series of insertions
+  // each point is only copied a constant number of times on average.  The
+  // reference set is an alias of the used columns of the storage.
+  const size_t numPoints = firstIndex + points.n_cols;
+  arma::mat* oldStorage = NULL;
+  if (!referenceStorage || numPoints > referenceStorage->n_cols)
+  {
+    oldStorage = referenceStorage;
+    referenceStorage = new arma::mat(referenceSet->n_rows,
+        std::max(numPoints, 2 * firstIndex));
+    if (firstIndex > 0)
+      referenceStorage->cols(0, firstIndex - 1) = *referenceSet;
+  }
+  referenceStorage->cols(firstIndex, numPoints - 1) = points;
+
+  const arma::mat* newReferenceSet = new arma::mat(referenceStorage->memptr(),
+      referenceStorage->n_rows, numPoints, false, true);
+  if (ownsSet)
+    delete referenceSet;
+  delete oldStorage;
+  referenceSet = newReferenceSet;
+  ownsSet = true;
+}
+
+// Remove points from the hash tables.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Remove(const arma::Col<size_t>& indices)
+{
+  for (size_t i = 0; i < indices.n_elem; ++i)
+  {
+    if (indices[i] >= referenceSet->n_cols)
+    {
+      std::ostringstream oss;
+      oss << "LSHSearch::Remove(): index " << indices[i] << " is out of range "
+          << "(reference set has " << referenceSet->n_cols << " points)!"
+          << std::endl;
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  // The points are in the buckets they hash to (unless those buckets were
+  // full), so hash them again to find them.
+  arma::Mat<size_t> secondHashVectors;
+  ComputeSecondHashVectors(referenceSet->cols(indices), secondHashVectors);
+
+  for (size_t i = 0; i < numTables; ++i)
+  {
+    for (size_t j = 0; j < secondHashVectors.n_cols; ++j)
+    {
+      const size_t row = bucketRowInHashTable[secondHashVectors(i, j)];
+      if (row == secondHashSize)
+        continue;
+
+      // Remove one occurrence of the point from the bucket (it holds the point
+      // once for each table that hashes it there) by overwriting it with the
+      // last point of the bucket.
+      size_t* bucket = secondHashTable.data() + bucketOffsets[row];
+      for (size_t k = 0; k < bucketContentSize[row]; ++k)
+      {
+        if (bucket[k] == indices[j])
+        {
+          bucket[k] = bucket[--bucketContentSize[row]];
+          break;
+        }
+      }
+    }
+  }
+}
+
+// Rebuild the bucket storage without unused space.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::Compact()
+{
+  const size_t numRowsInTable = arma::accu(bucketContentSize > 0);
+  std::vector<size_t> newSecondHashTable(arma::accu(bucketContentSize));
+  arma::Col<size_t> newBucketOffsets(numRowsInTable);
+  arma::Col<size_t> newBucketContentSize(numRowsInTable);
+
+  // Copy the buckets in order, and map the old rows to the new rows.  Empty
+  // buckets are dropped.
+  arma::Col<size_t> newRows(bucketContentSize.n_elem);
+  size_t currentRow = 0;
+  size_t currentOffset = 0;
+  for (size_t row = 0; row < bucketContentSize.n_elem; ++row)
+  {
+    if (bucketContentSize[row] == 0)
+    {
+      newRows[row] = secondHashSize;
       continue;
+    }
+
+    std::copy(secondHashTable.begin() + bucketOffsets[row],
+              secondHashTable.begin() + bucketOffsets[row] +
+                  bucketContentSize[row],
+              newSecondHashTable.begin() + currentOffset);
+    newBucketOffsets[currentRow] = currentOffset;
+    newBucketContentSize[currentRow] = bucketContentSize[row];
+    currentOffset += bucketContentSize[row];
+    newRows[row] = currentRow++;
+  }
+
+  for (size_t i = 0; i < bucketRowInHashTable.n_elem; ++i)
+    if (bucketRowInHashTable[i] < secondHashSize)
+      bucketRowInHashTable[i] = newRows[bucketRowInHashTable[i]];
+
+  secondHashTable = std::move(newSecondHashTable);
+  bucketOffsets = std::move(newBucketOffsets);
+  bucketCapacities = newBucketContentSize;
+  bucketContentSize = std::move(newBucketContentSize);
+}
+
+// Hash points into the second hash table.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::ComputeSecondHashVectors(
+    const arma::mat& points,
+    arma::Mat<size_t>& secondHashVectors) const
+{
+  // We will store the second hash vectors in this matrix; the second hash
+  // vector for table i will be held in row i.
+  secondHashVectors.set_size(numTables, points.n_cols);
+
+  for (size_t i = 0; i < numTables; i++)
+  {
+    // Step IV: create the 'numProj'-dimensional key for each point in each
+    // table.
 
-    const double distance = metric::EuclideanDistance::Evaluate(
-        referenceSet->unsafe_col(queryIndex),
-        referenceSet->unsafe_col(referenceIndex));
+    // The following code performs the task of hashing each point to a
+    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
+    // 'points.n_cols') key matrix.
+    //
+    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
+    // and the corresponding offset be 'offset_i'.  Then the key of a single
+    // point is obtained as:
+    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
+    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
+                                       points.n_cols);
+    arma::mat hashMat = projections.slice(i).t() * points;
+    hashMat += offsetMat;
+    hashMat /= hashWidth;
 
-    Candidate c = std::make_pair(distance, referenceIndex);
-    // If this distance is better than the worst candidate, let's insert it.
-    if (CandidateCmp()(c, pqueue.top()))
+    // Step V: Putting the points in the 'secondHashTable' by hashing the key.
+    // Now we hash every key, point ID to its corresponding bucket.  We must
+    // also normalize the hashes to the range [0, secondHashSize).  The hashes
+    // are computed as doubles, otherwise negative numbers are cast to 0.
+    arma::rowvec unmodVector = secondHashWeights.t() * arma::floor(hashMat);
+    for (size_t j = 0; j < unmodVector.n_elem; ++j)
     {
-      pqueue.pop();
-      pqueue.push(c);
+      double shs = (double) secondHashSize; // Convenience cast.
+      if (unmodVector[j] >= 0.0)
+      {
+        const size_t key = size_t(fmod(unmodVector[j], shs));
+        secondHashVectors(i, j) = key;
+      }
+      else
+      {
+        const double mod = fmod(-unmodVector[j], shs);
+        const size_t key = (mod < 1.0) ? 0 : secondHashSize - size_t(mod);
+        secondHashVectors(i, j) = key;
+      }
     }
   }
+}
 
-  for (size_t j = 1; j <= k; j++)
+// Make room in the buckets of the second hash table.
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::ReserveBuckets(const arma::Col<size_t>& sizes)
+{
+  // New buckets start out empty, with no room.
+  const size_t oldNumRows = bucketContentSize.n_elem;
+  bucketOffsets.resize(sizes.n_elem);
+  bucketCapacities.resize(sizes.n_elem);
+  bucketContentSize.resize(sizes.n_elem);
+  for (size_t row = oldNumRows; row < sizes.n_elem; ++row)
   {
-    neighbors(k - j, queryIndex) = pqueue.top().second;
-    distances(k - j, queryIndex) = pqueue.top().first;
-    pqueue.pop();
+    bucketOffsets[row] = secondHashTable.size();
+    bucketCapacities[row] = 0;
+    bucketContentSize[row] = 0;
+  }
+
+  // Buckets that are too small are moved to the end of the storage.  Since
+  // their capacity at least doubles each time, the total amount of copying is
+  // proportional to the number of inserted points.  The space they leave
+  // behind is reclaimed by Compact().
+  for (size_t row = 0; row < sizes.n_elem; ++row)
+  {
+    if (sizes[row] <= bucketCapacities[row])
+      continue;
+
+    const size_t newCapacity = std::max(sizes[row], 2 * bucketCapacities[row]);
+    const size_t newOffset = secondHashTable.size();
+    secondHashTable.resize(newOffset + newCapacity);
+    std::copy(secondHashTable.begin() + bucketOffsets[row],
+              secondHashTable.begin() + bucketOffsets[row] +
+                  bucketContentSize[row],
+              secondHashTable.begin() + newOffset);
+
+    bucketOffsets[row] = newOffset;
+    bucketCapacities[row] = newCapacity;
   }
 }
 
-// Base case for bichromatic search.
+// Compute the distances between a query and its candidate neighbors, and keep
+// the best k.
 template<typename SortPolicy>
-inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const arma::uvec& referenceIndices,
-                                     const size_t k,
-                                     const arma::mat& querySet,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+void LSHSearch<SortPolicy>::BaseCase(
+    const size_t queryIndex,
+    const arma::mat& querySet,
+    const bool monochromatic,
+    const std::vector<size_t>& referenceIndices,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances,
+    arma::mat& candidateBlock) const
 {
   // Let's build the list of candidate neighbors for the given query point.
   // It will be initialized with k candidates:
@@ -442,19 +665,50 @@ void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
-  for (size_t j = 0; j < referenceIndices.n_elem; ++j)
+  // The candidates are copied into candidateBlock, a block at a time, so that
+  // the distances to a whole block are computed with vectorized operations on
+  // contiguous memory.
+  const size_t distanceBlockSize = 64;
+  size_t blockIndices[distanceBlockSize];
+  candidateBlock.set_size(referenceSet->n_rows, distanceBlockSize);
+  const arma::vec query(const_cast<double*>(querySet.colptr(queryIndex)),
+      querySet.n_rows, false, true);
+
+  size_t next = 0;
+  while (next < referenceIndices.size())
   {
-    const size_t referenceIndex = referenceIndices[j];
-    const double distance = metric::EuclideanDistance::Evaluate(
-        querySet.unsafe_col(queryIndex),
-        referenceSet->unsafe_col(referenceIndex));
-
-    Candidate c = std::make_pair(distance, referenceIndex);
-    // If this distance is better than the worst candidate, let's insert it.
-    if (CandidateCmp()(c, pqueue.top()))
+    size_t count = 0;
+    for ( ; next < referenceIndices.size() && count < distanceBlockSize; ++next)
     {
-      pqueue.pop();
-      pqueue.push(c);
+      const size_t referenceIndex = referenceIndices[next];
+      // In monochromatic search, we can't return ourselves as the nearest
+      // neighbor, so skip this point.
+      if (monochromatic && queryIndex == referenceIndex)
+        continue;
+
+      blockIndices[count] = referenceIndex;
+      std::copy(referenceSet->colptr(referenceIndex),
+                referenceSet->colptr(referenceIndex) + referenceSet->n_rows,
+                candidateBlock.colptr(count++));
+    }
+
+    // Compute the squared differences in place.
+    arma::mat block(candidateBlock.memptr(), candidateBlock.n_rows, count,
+        false, true);
+    block.each_col() -= query;
+    block %= block;
+
+    for (size_t c = 0; c < count; ++c)
+    {
+      const double distance = std::sqrt(arma::accu(block.unsafe_col(c)));
+
+      Candidate candidate = std::make_pair(distance, blockIndices[c]);
+      // If this distance is better than the worst candidate, let's insert it.
+      if (CandidateCmp()(candidate, pqueue.top()))
+      {
+        pqueue.pop();
+        pqueue.push(candidate);
+      }
     }
   }
 
@@ -729,152 +983,202 @@ void LSHSearch<SortPolicy>::GetAdditionalProbingBins(
   }
 }
 
+// Hash a block of queries.
 template<typename SortPolicy>
-template<typename VecType>
-void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
-    const VecType& queryPoint,
-    arma::uvec& referenceIndices,
-    size_t numTablesToSearch,
-    const size_t T) const
+void LSHSearch<SortPolicy>::HashQueries(const arma::mat& querySet,
+                                        const size_t begin,
+                                        const size_t count,
+                                        const size_t numTablesToSearch,
+                                        arma::mat& queryCodesNotFloored,
+                                        arma::mat& queryCodes,
+                                        arma::Mat<size_t>& queryHashes) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
-
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
-
-  // Hash the query in each of the 'numTablesToSearch' hash tables using the
-  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
-  // keys for the query where each key is a 'numProj' dimensional integer
-  // vector.
-
-  // Compute the projection of the query in each table.
-  arma::mat allProjInTables(numProj, numTablesToSearch);
-  arma::mat queryCodesNotFloored(numProj, numTablesToSearch);
-  for (size_t i = 0; i < numTablesToSearch; i++)
-    queryCodesNotFloored.unsafe_col(i) = projections.slice(i).t() * queryPoint;
-  queryCodesNotFloored += offsets.cols(0, numTablesToSearch - 1);
-  allProjInTables = arma::floor(queryCodesNotFloored / hashWidth);
-
-  // Use hashMat to store the primary probing codes and any additional codes
-  // from multiprobe LSH.
-  arma::Mat<size_t> hashMat;
-  hashMat.set_size(T + 1, numTablesToSearch);
-
-  // Compute the primary hash value of each key of the query into a bucket of
+  // The slices of the projection cube are stored one after the other, so the
+  // projections of the first 'numTablesToSearch' tables are the first columns
+  // of a (dimensionality x (numProj * numTables)) matrix, and all of the
+  // queries can be projected into all of the tables with one matrix
+  // multiplication.  The offsets are laid out the same way.
+  const arma::mat allProjections(const_cast<double*>(projections.memptr()),
+      projections.n_rows, numProj * numTablesToSearch, false, true);
+  const arma::vec allOffsets(const_cast<double*>(offsets.memptr()),
+      numProj * numTablesToSearch, false, true);
+
+  queryCodesNotFloored = allProjections.t() *
+      querySet.cols(begin, begin + count - 1);
+  queryCodesNotFloored.each_col() += allOffsets;
+  queryCodes = arma::floor(queryCodesNotFloored / hashWidth);
+
+  // Compute the primary hash value of each key of each query into a bucket of
   // the secondHashTable using the secondHashWeights.
-  hashMat.row(0) = arma::conv_to<arma::Row<size_t>> // Floor by typecasting
-      ::from(secondHashWeights.t() * allProjInTables);
+  queryHashes.set_size(numTablesToSearch, count);
+  for (size_t i = 0; i < numTablesToSearch; ++i)
+  {
+    queryHashes.row(i) = arma::conv_to<arma::Row<size_t>> // Floor by casting.
+        ::from(secondHashWeights.t() *
+        queryCodes.rows(i * numProj, (i + 1) * numProj - 1));
+  }
   // Mod to compute 2nd-level codes.
-  for (size_t i = 0; i < numTablesToSearch; i++)
-    hashMat(0, i) = (hashMat(0, i) % secondHashSize);
+  for (size_t i = 0; i < queryHashes.n_elem; ++i)
+    queryHashes[i] = (queryHashes[i] % secondHashSize);
+}
 
-  // Compute hash codes of additional probing bins.
-  if (T > 0)
+template<typename SortPolicy>
+void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
+    const arma::vec& queryCodes,
+    const arma::vec& queryCodesNotFloored,
+    const arma::Col<size_t>& queryHashes,
+    const size_t T,
+    const size_t stamp,
+    std::vector<size_t>& candidateStamps,
+    std::vector<size_t>& referenceIndices) const
+{
+  // Collect the points of the given bucket that have not been collected yet
+  // for this query.  Instead of clearing a mark for each reference point
+  // before each query, each query marks the points with its own stamp.
+  referenceIndices.clear();
+  auto collectBucket = [&](const size_t hashInd)
   {
-    for (size_t i = 0; i < numTablesToSearch; ++i)
+    const size_t tableRow = bucketRowInHashTable[hashInd];
+    if (tableRow >= secondHashSize)
+      return;
+
+    const size_t* bucket = secondHashTable.data() + bucketOffsets[tableRow];
+    for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
+    {
+      if (candidateStamps[bucket[j]] != stamp)
+      {
+        candidateStamps[bucket[j]] = stamp;
+        referenceIndices.push_back(bucket[j]);
+      }
+    }
+  };
+
+  for (size_t i = 0; i < queryHashes.n_elem; ++i)
+  {
+    // The query's bucket in this table.
+    collectBucket(queryHashes[i]);
+
+    // Compute hash codes of additional probing bins.
+    if (T > 0)
     {
       // Construct this table's probing sequence of length T.
+      const arma::vec tableCodes(const_cast<double*>(queryCodes.memptr() +
+          i * numProj), numProj, false, true);
+      const arma::vec tableCodesNotFloored(const_cast<double*>(
+          queryCodesNotFloored.memptr() + i * numProj), numProj, false, true);
       arma::mat additionalProbingBins;
-      GetAdditionalProbingBins(allProjInTables.unsafe_col(i),
-                                queryCodesNotFloored.unsafe_col(i),
-                                T,
-                                additionalProbingBins);
+      GetAdditionalProbingBins(tableCodes, tableCodesNotFloored, T,
+          additionalProbingBins);
 
       // Map each probing bin to a bin in secondHashTable (just like we did for
       // the primary hash table).
-      hashMat(arma::span(1, T), i) = // Compute code of rows 1:end of column i
-        arma::conv_to< arma::Col<size_t> >:: // floor by typecasting to size_t
-        from( secondHashWeights.t() * additionalProbingBins );
-      for (size_t p = 1; p < T + 1; ++p)
-        hashMat(p, i) = (hashMat(p, i) % secondHashSize);
+      const arma::Row<size_t> probingHashes = // Floor by typecasting.
+          arma::conv_to<arma::Row<size_t>>::from(secondHashWeights.t() *
+          additionalProbingBins);
+      for (size_t p = 0; p < T; ++p)
+        collectBucket(probingHashes[p] % secondHashSize);
     }
   }
+}
 
+// Search for the neighbors of all points in a query set.
+template<typename SortPolicy>
+size_t LSHSearch<SortPolicy>::SearchQueries(
+    const arma::mat& querySet,
+    const bool monochromatic,
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    size_t numTablesToSearch,
+    const size_t T)
+{
+  // Decide on the number of tables to look into.
+  if (numTablesToSearch == 0) // If no user input is given, search all.
+    numTablesToSearch = numTables;
 
-  // Count number of points hashed in the same bucket as the query.
-  size_t maxNumPoints = 0;
-  for (size_t i = 0; i < numTablesToSearch; ++i)
-  {
-    for (size_t p = 0; p < T + 1; ++p)
-    {
-      const size_t hashInd = hashMat(p, i); // find query's bucket
-      const size_t tableRow = bucketRowInHashTable[hashInd];
-      if (tableRow < secondHashSize)
-        maxNumPoints += bucketContentSize[tableRow]; // count bucket contents
-    }
-  }
+  // Sanity check to make sure that the existing number of tables is not
+  // exceeded.
+  if (numTablesToSearch > numTables)
+    numTablesToSearch = numTables;
 
-  // There are two ways to proceed here:
-  // Either allocate a maxNumPoints-size vector, place all candidates, and run
-  // unique on the vector to discard duplicates.
-  // Or allocate a referenceSet->n_cols size vector (i.e. number of reference
-  // points) of zeros, and mark found indices as 1.
-  // Option 1 runs faster for small maxNumPoints but worse for larger values, so
-  // we choose based on a heuristic.
-  const float cutoff = 0.1;
-  const float selectivity = static_cast<float>(maxNumPoints) /
-      static_cast<float>(referenceSet->n_cols);
-
-  if (selectivity > cutoff)
-  {
-    // Heuristic: larger maxNumPoints means we should use find() because it
-    // should be faster.
-    // Reference points hashed in the same bucket as the query are set to >0.
-    arma::Col<size_t> refPointsConsidered;
-    refPointsConsidered.zeros(referenceSet->n_cols);
+  // The queries are hashed in blocks, to make the projections one matrix
+  // multiplication per block.
+  const size_t queryBlockSize = 256;
+  const size_t numBlocks = (querySet.n_cols + queryBlockSize - 1) /
+      queryBlockSize;
+
+  // Each thread has its own candidate stamps, which are kept between searches.
+  // Query i of this search stamps its candidates with firstStamp + i, which no
+  // earlier search used, so the stamps never need to be reset.
+#ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+  if (candidateStamps.size() < numThreads)
+    candidateStamps.resize(numThreads);
+  const size_t firstStamp = nextStamp;
+  nextStamp += querySet.n_cols;
 
-    for (size_t i = 0; i < numTablesToSearch; ++i) // for all tables
-    {
-      for (size_t p = 0; p < T + 1; ++p) // For entire probing sequence.
-      {
-        // get the sequence code
-        size_t hashInd = hashMat(p, i);
-        size_t tableRow = bucketRowInHashTable[hashInd];
-
-        if (tableRow < secondHashSize && bucketContentSize[tableRow] > 0)
-          // Pick the indices in the bucket corresponding to hashInd.
-          for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
-            refPointsConsidered[ secondHashTable[tableRow](j) ]++;
-      }
-    }
+  size_t numCandidates = 0;
 
-    // Only keep reference points found in at least one bucket.
-    referenceIndices = arma::find(refPointsConsidered > 0);
-    return;
-  }
-  else
+  #pragma omp parallel \
+      shared(resultingNeighbors, distances) \
+      reduction(+:numCandidates)
   {
-    // Heuristic: smaller maxNumPoints means we should use unique() because it
-    // should be faster.
-    // Allocate space for the query's potential neighbors.
-    arma::uvec refPointsConsideredSmall;
-    refPointsConsideredSmall.zeros(maxNumPoints);
+#ifdef HAS_OPENMP
+    std::vector<size_t>& threadStamps = candidateStamps[omp_get_thread_num()];
+#else
+    std::vector<size_t>& threadStamps = candidateStamps[0];
+#endif
+    // Points may have been inserted since the last search.
+    if (threadStamps.size() < referenceSet->n_cols)
+      threadStamps.resize(referenceSet->n_cols, 0);
 
-    // Retrieve candidates.
-    size_t start = 0;
+    // Scratch space, which is reused for all the queries of a thread.
+    std::vector<size_t> referenceIndices;
+    arma::mat queryCodesNotFloored, queryCodes, candidateBlock;
+    arma::Mat<size_t> queryHashes;
 
-    for (size_t i = 0; i < numTablesToSearch; ++i) // For all tables
+    // Parallelization to process more than one block of queries at a time.
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp for schedule(dynamic)
+    for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+    #pragma omp for schedule(dynamic)
+    for (size_t b = 0; b < numBlocks; ++b)
+#endif
     {
-      for (size_t p = 0; p < T + 1; ++p)
-      {
-        const size_t hashInd =  hashMat(p, i); // Find the query's bucket.
-        const size_t tableRow = bucketRowInHashTable[hashInd];
+      const size_t begin = (size_t) b * queryBlockSize;
+      const size_t count = std::min(queryBlockSize,
+          (size_t) querySet.n_cols - begin);
+      HashQueries(querySet, begin, count, numTablesToSearch,
+          queryCodesNotFloored, queryCodes, queryHashes);
 
-        if (tableRow < secondHashSize)
-         // Store all secondHashTable points in the candidates set.
-         for (size_t j = 0; j < bucketContentSize[tableRow]; ++j)
-           refPointsConsideredSmall(start++) = secondHashTable[tableRow](j);
+      for (size_t q = 0; q < count; ++q)
+      {
+        // Hash every query into every hash table and eventually into the
+        // 'secondHashTable' to obtain the neighbor candidates.
+        ReturnIndicesFromTable(queryCodes.unsafe_col(q),
+            queryCodesNotFloored.unsafe_col(q), queryHashes.unsafe_col(q), T,
+            firstStamp + begin + q, threadStamps, referenceIndices);
+
+        // An informative book-keeping for the number of neighbor candidates
+        // returned on average.
+        numCandidates += referenceIndices.size();
+
+        // Sequentially go through all the candidates and save the best 'k'
+        // candidates.
+        BaseCase(begin + q, querySet, monochromatic, referenceIndices, k,
+            resultingNeighbors, distances, candidateBlock);
       }
     }
-
-    // Keep only one copy of each candidate.
-    referenceIndices = arma::unique(refPointsConsideredSmall);
-    return;
   }
+
+  return numCandidates;
 }
 
 // Search for nearest neighbors in a given query set.
@@ -929,45 +1233,13 @@ void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
     Log::Info << "Running multiprobe LSH with " << Teffective
         <<" additional probing bins per table per query." << std::endl;
 
-  size_t avgIndicesReturned = 0;
-
   Timer::Start("computing_neighbors");
 
-  // Parallelization to process more than one query at a time.
-#ifdef _WIN32
-  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
-  // support unsigned loop variables. If we're building for Visual Studio, use
-  // the intmax_t type instead.
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
-      reduction(+:avgIndicesReturned)
-  for (intmax_t i = 0; i < (intmax_t) querySet.n_cols; ++i)
-#else
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
-      reduction(+:avgIndicesReturned)
-  for (size_t i = 0; i < querySet.n_cols; ++i)
-#endif
-  {
-    // Go through every query point.
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(querySet.col(i), refIndices, numTablesToSearch,
-        Teffective);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    // Make atomic to avoid race conditions when multiple threads are running
-    // #pragma omp atomic
-    avgIndicesReturned = avgIndicesReturned + refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    BaseCase(i, refIndices, k, querySet, resultingNeighbors, distances);
-  }
+  // Hash every query into every hash table and eventually into the
+  // 'secondHashTable' to obtain the neighbor candidates, and save the best 'k'
+  // candidates of each query.
+  size_t avgIndicesReturned = SearchQueries(querySet, false, k,
+      resultingNeighbors, distances, numTablesToSearch, Teffective);
 
   Timer::Stop("computing_neighbors");
 
@@ -1006,45 +1278,13 @@ Search(const size_t k,
     Log::Info << "Running multiprobe LSH with " << Teffective <<
       " additional probing bins per table per query."<< std::endl;
 
-  size_t avgIndicesReturned = 0;
-
   Timer::Start("computing_neighbors");
 
-  // Parallelization to process more than one query at a time.
-#ifdef _WIN32
-  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
-  // support unsigned loop variables. If we're building for Visual Studio, use
-  // the intmax_t type instead.
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
-      reduction(+:avgIndicesReturned)
-  for (intmax_t i = 0; i < (intmax_t) referenceSet->n_cols; ++i)
-#else
-  #pragma omp parallel for \
-      shared(resultingNeighbors, distances) \
-      schedule(dynamic)\
-      reduction(+:avgIndicesReturned)
-  for (size_t i = 0; i < referenceSet->n_cols; ++i)
-#endif
-  {
-    // Go through every query point.
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(referenceSet->col(i), refIndices, numTablesToSearch,
-        Teffective);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    // Make atomic to avoid race conditions when multiple threads are running.
-    // #pragma omp atomic
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    BaseCase(i, refIndices, k, resultingNeighbors, distances);
-  }
+  // Hash every point into every hash table and eventually into the
+  // 'secondHashTable' to obtain the neighbor candidates, and save the best 'k'
+  // candidates of each point.
+  size_t avgIndicesReturned = SearchQueries(*referenceSet, true, k,
+      resultingNeighbors, distances, numTablesToSearch, Teffective);
 
   Timer::Stop("computing_neighbors");
 
@@ -1093,7 +1333,9 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
   {
     if (ownsSet)
       delete referenceSet;
+    delete referenceStorage;
     ownsSet = true;
+    referenceStorage = NULL;
   }
   ar & CreateNVP(referenceSet, "referenceSet");
 
@@ -1128,8 +1370,9 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
   // needs specific handling for new version
 
   // Backward compatibility: in older versions of LSHSearch, the secondHashTable
-  // was stored as an arma::Mat<size_t>.  So we need to properly load that, then
-  // prune it down to size.
+  // was stored as an arma::Mat<size_t> (version 0) or as one arma::Col<size_t>
+  // per bucket (version 1).  So we need to properly load that, then flatten it.
+  std::vector<arma::Col<size_t>> oldSecondHashTable;
   if (version == 0)
   {
     arma::Mat<size_t> tmpSecondHashTable;
@@ -1139,7 +1382,7 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
     // it.
     tmpSecondHashTable = tmpSecondHashTable.t();
 
-    secondHashTable.resize(tmpSecondHashTable.n_cols);
+    oldSecondHashTable.resize(tmpSecondHashTable.n_cols);
     for (size_t i = 0; i < tmpSecondHashTable.n_cols; ++i)
     {
       // Find length of each column.  We know we are at the end of the list when
@@ -1151,32 +1394,30 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
           break;
 
       // Set the size of the new column correctly.
-      secondHashTable[i].set_size(len);
+      oldSecondHashTable[i].set_size(len);
       for (size_t j = 0; j < len; ++j)
-        secondHashTable[i](j) = tmpSecondHashTable(j, i);
+        oldSecondHashTable[i](j) = tmpSecondHashTable(j, i);
     }
   }
-  else
+  else if (version == 1)
   {
     size_t tables;
-    if (Archive::is_saving::value)
-      tables = secondHashTable.size();
     ar & CreateNVP(tables, "numSecondHashTables");
 
-    // Set size of second hash table if needed.
-    if (Archive::is_loading::value)
-    {
-      secondHashTable.clear();
-      secondHashTable.resize(tables);
-    }
-
-    for (size_t i = 0; i < secondHashTable.size(); ++i)
+    oldSecondHashTable.resize(tables);
+    for (size_t i = 0; i < oldSecondHashTable.size(); ++i)
     {
       std::ostringstream oss;
       oss << "secondHashTable" << i;
-      ar & CreateNVP(secondHashTable[i], oss.str());
+      ar & CreateNVP(oldSecondHashTable[i], oss.str());
     }
   }
+  else
+  {
+    ar & CreateNVP(secondHashTable, "secondHashTable");
+    ar & CreateNVP(bucketOffsets, "bucketOffsets");
+    ar & CreateNVP(bucketCapacities, "bucketCapacities");
+  }
 
   // Backward compatibility: old versions of LSHSearch held bucketContentSize
   // for all possible buckets (of size secondHashSize), but now we hold a
@@ -1191,7 +1432,7 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
     ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
 
     // Compress into a smaller vector by just dropping all of the zeros.
-    bucketContentSize.set_size(secondHashTable.size());
+    bucketContentSize.set_size(oldSecondHashTable.size());
     for (size_t i = 0; i < tmpBucketContentSize.n_elem; ++i)
       if (tmpBucketContentSize[i] > 0)
         bucketContentSize[bucketRowInHashTable[i]] = tmpBucketContentSize[i];
@@ -1202,6 +1443,21 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
     ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
   }
 
+  // Store the buckets of old versions one after the other.
+  if (version < 2)
+  {
+    secondHashTable.clear();
+    bucketOffsets.set_size(oldSecondHashTable.size());
+    bucketCapacities.set_size(oldSecondHashTable.size());
+    for (size_t i = 0; i < oldSecondHashTable.size(); ++i)
+    {
+      bucketOffsets[i] = secondHashTable.size();
+      bucketCapacities[i] = oldSecondHashTable[i].n_elem;
+      secondHashTable.insert(secondHashTable.end(),
+          oldSecondHashTable[i].begin(), oldSecondHashTable[i].end());
+    }
+  }
+
   ar & CreateNVP(distanceEvaluations, "distanceEvaluations");
 }
 
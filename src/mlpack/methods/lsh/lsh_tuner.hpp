@@ -0,0 +1,160 @@
+/**
+ * @file lsh_tuner.hpp
+ *
+ * Defines the LSHTuner class, which searches for LSHSearch parameters that
+ * give a good tradeoff between recall, query time and memory usage on a given
+ * dataset.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_LSH_LSH_TUNER_HPP
+#define MLPACK_METHODS_LSH_LSH_TUNER_HPP
+
+#include <mlpack/prereqs.hpp>
+#include "lsh_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * A setting of the LSHSearch parameters, with the recall, query time and
+ * memory usage that were measured with it.
+ */
+struct LSHTuningResult
+{
+  //! The number of projections in each hash table.
+  size_t numProj;
+  //! The number of hash tables.
+  size_t numTables;
+  //! The hash width.
+  double hashWidth;
+  //! The number of additional probing bins (multiprobe LSH).
+  size_t T;
+  //! The maximum number of points in a bucket (0 means no limit).
+  size_t bucketSize;
+
+  //! The recall of the search, in [0, 1].
+  double recall;
+  //! The average time taken by a query, in seconds.
+  double queryTime;
+  //! An estimate of the memory used by the hash tables, in bytes.
+  double memory;
+};
+
+/**
+ * The LSHTuner class measures the recall, query time and memory usage of
+ * LSHSearch for a grid of parameter settings, so that a setting that reaches a
+ * target recall as cheaply as possible can be picked without manual tuning.
+ * The recall is computed with LSHSearch::ComputeRecall() against the exact
+ * neighbors of a set of sample queries, which are computed once with
+ * NeighborSearch.
+ *
+ * A model is only trained for each combination of the number of projections,
+ * the hash width and the bucket size, with the largest number of tables;
+ * smaller numbers of tables and the number of probes are evaluated by
+ * searching only some of the tables of that model.  The memory usage of a
+ * setting with fewer tables is estimated accordingly.
+ *
+ * For the results to be representative, the sample queries should come from
+ * the same distribution as the real queries, but should not be part of the
+ * reference set; for instance, hold out a random sample of the reference set.
+ *
+ * @code
+ * LSHTuner<> tuner(referenceSet, sampleQueries, 10);
+ * tuner.Tune({ 5, 10, 20 }, { 5, 10, 20 }, { 0.5, 1.0, 2.0 }, { 0, 5 },
+ *     { 500 });
+ * std::vector<LSHTuningResult> frontier = tuner.ParetoFrontier();
+ * const LSHTuningResult& best = tuner.Best(0.9);
+ * @endcode
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy = NearestNeighborSort>
+class LSHTuner
+{
+ public:
+  /**
+   * Create the LSHTuner object, and compute the exact neighbors of the sample
+   * queries.  The matrices are not copied, so they must stay valid for as long
+   * as the LSHTuner object is used.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of sample query points.
+   * @param k Number of neighbors to search for.
+   */
+  LSHTuner(const arma::mat& referenceSet,
+           const arma::mat& querySet,
+           const size_t k);
+
+  /**
+   * Evaluate every combination of the given parameter values, and store the
+   * results (which can then be accessed with Results(), ParetoFrontier() and
+   * Best()).  Any previous results are discarded.
+   *
+   * The hash widths are given as multiples of the hash width that LSHSearch
+   * chooses by default for the reference set.  Numbers of probes larger than
+   * the maximum for a number of projections (2^numProj - 1) are skipped.
+   *
+   * @param numProjValues Numbers of projections in each hash table.
+   * @param numTablesValues Numbers of hash tables.
+   * @param hashWidthScales Hash widths, relative to the default hash width.
+   * @param TValues Numbers of additional probing bins.
+   * @param bucketSizeValues Bucket sizes of the second hash table.
+   * @param secondHashSize The size of the second hash table.
+   */
+  void Tune(const std::vector<size_t>& numProjValues,
+            const std::vector<size_t>& numTablesValues,
+            const std::vector<double>& hashWidthScales,
+            const std::vector<size_t>& TValues,
+            const std::vector<size_t>& bucketSizeValues,
+            const size_t secondHashSize = 99901);
+
+  /**
+   * Return the results that are on the Pareto frontier: those for which no
+   * other result has at least the same recall, at most the same query time
+   * and at most the same memory usage (and is better in at least one).  The
+   * results are sorted by increasing recall.
+   */
+  std::vector<LSHTuningResult> ParetoFrontier() const;
+
+  /**
+   * Return the result with the smallest query time (or, if minimizeMemory is
+   * true, the smallest memory usage) among those that reach the given recall.
+   * An std::runtime_error is thrown if no result reaches it.
+   *
+   * @param targetRecall Minimum recall, in [0, 1].
+   * @param minimizeMemory If true, minimize memory usage instead of query
+   *     time.
+   */
+  const LSHTuningResult& Best(const double targetRecall,
+                              const bool minimizeMemory = false) const;
+
+  //! Get the results of all evaluated settings.
+  const std::vector<LSHTuningResult>& Results() const { return results; }
+
+  //! Get the exact neighbors of the sample queries.
+  const arma::Mat<size_t>& TrueNeighbors() const { return trueNeighbors; }
+
+ private:
+  //! The reference set.
+  const arma::mat& referenceSet;
+  //! The sample queries.
+  const arma::mat& querySet;
+  //! The number of neighbors to search for.
+  size_t k;
+  //! The exact neighbors of the sample queries.
+  arma::Mat<size_t> trueNeighbors;
+  //! The results of all evaluated settings.
+  std::vector<LSHTuningResult> results;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "lsh_tuner_impl.hpp"
+
+#endif
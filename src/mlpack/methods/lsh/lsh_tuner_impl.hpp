@@ -0,0 +1,196 @@
+/**
+ * @file lsh_tuner_impl.hpp
+ *
+ * Implementation of the LSHTuner class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_LSH_LSH_TUNER_IMPL_HPP
+#define MLPACK_METHODS_LSH_LSH_TUNER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lsh_tuner.hpp"
+
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <chrono>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy>
+LSHTuner<SortPolicy>::LSHTuner(const arma::mat& referenceSet,
+                               const arma::mat& querySet,
+                               const size_t k) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    k(k)
+{
+  if (querySet.n_rows != referenceSet.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHTuner::LSHTuner(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality of the "
+        << "reference set (" << referenceSet.n_rows << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Compute the exact neighbors of the sample queries.
+  Timer::Start("computing_true_neighbors");
+  arma::mat distances;
+  NeighborSearch<SortPolicy> exactSearch(referenceSet);
+  exactSearch.Search(querySet, k, trueNeighbors, distances);
+  Timer::Stop("computing_true_neighbors");
+}
+
+template<typename SortPolicy>
+void LSHTuner<SortPolicy>::Tune(const std::vector<size_t>& numProjValues,
+                                const std::vector<size_t>& numTablesValues,
+                                const std::vector<double>& hashWidthScales,
+                                const std::vector<size_t>& TValues,
+                                const std::vector<size_t>& bucketSizeValues,
+                                const size_t secondHashSize)
+{
+  results.clear();
+  if (numTablesValues.empty())
+    return;
+
+  const size_t maxTables = *std::max_element(numTablesValues.begin(),
+      numTablesValues.end());
+
+  // Find the default hash width (this only needs one table).
+  LSHSearch<SortPolicy> defaultModel;
+  defaultModel.Train(referenceSet, 1, 1, 0.0, secondHashSize);
+  const double defaultHashWidth = defaultModel.HashWidth();
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  for (size_t p = 0; p < numProjValues.size(); ++p)
+  {
+    const size_t numProj = numProjValues[p];
+    for (size_t w = 0; w < hashWidthScales.size(); ++w)
+    {
+      const double hashWidth = hashWidthScales[w] * defaultHashWidth;
+      for (size_t b = 0; b < bucketSizeValues.size(); ++b)
+      {
+        const size_t bucketSize = bucketSizeValues[b];
+        LSHSearch<SortPolicy> lsh(referenceSet, numProj, maxTables, hashWidth,
+            secondHashSize, bucketSize);
+
+        // The projections, offsets and buckets grow with the number of
+        // tables; the second hash weights and the map from hash values to
+        // buckets do not.
+        const double tableMemory = (referenceSet.n_rows + 1) * numProj *
+            sizeof(double) + (lsh.SecondHashTable().size() + 3 *
+            lsh.NumBuckets()) * sizeof(size_t) / (double) maxTables;
+        const double fixedMemory = numProj * sizeof(double) +
+            secondHashSize * sizeof(size_t);
+
+        for (size_t t = 0; t < numTablesValues.size(); ++t)
+        {
+          const size_t numTables = numTablesValues[t];
+          if (numTables == 0)
+            continue;
+
+          for (size_t i = 0; i < TValues.size(); ++i)
+          {
+            const size_t T = TValues[i];
+            if (numProj < 8 * sizeof(size_t) &&
+                T > (((size_t) 1) << numProj) - 1)
+              continue;
+
+            const std::chrono::high_resolution_clock::time_point start =
+                std::chrono::high_resolution_clock::now();
+            lsh.Search(querySet, k, neighbors, distances, numTables, T);
+            const double elapsed = std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - start).count();
+
+            LSHTuningResult result;
+            result.numProj = numProj;
+            result.numTables = numTables;
+            result.hashWidth = hashWidth;
+            result.T = T;
+            result.bucketSize = bucketSize;
+            result.recall = LSHSearch<SortPolicy>::ComputeRecall(neighbors,
+                trueNeighbors);
+            result.queryTime = elapsed / std::max((size_t) querySet.n_cols,
+                (size_t) 1);
+            result.memory = fixedMemory + numTables * tableMemory;
+            results.push_back(result);
+
+            Log::Info << "LSH with " << numProj << " projections, "
+                << numTables << " tables, hash width " << hashWidth << ", "
+                << T << " probes and bucket size " << bucketSize << ": recall "
+                << result.recall << ", " << result.queryTime << "s per query, "
+                << result.memory << " bytes." << std::endl;
+          }
+        }
+      }
+    }
+  }
+}
+
+template<typename SortPolicy>
+std::vector<LSHTuningResult> LSHTuner<SortPolicy>::ParetoFrontier() const
+{
+  std::vector<LSHTuningResult> frontier;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const LSHTuningResult& a = results[i];
+    bool dominated = false;
+    for (size_t j = 0; j < results.size() && !dominated; ++j)
+    {
+      const LSHTuningResult& b = results[j];
+      dominated = (b.recall >= a.recall && b.queryTime <= a.queryTime &&
+          b.memory <= a.memory) && (b.recall > a.recall ||
+          b.queryTime < a.queryTime || b.memory < a.memory);
+    }
+
+    if (!dominated)
+      frontier.push_back(a);
+  }
+
+  std::sort(frontier.begin(), frontier.end(),
+      [](const LSHTuningResult& a, const LSHTuningResult& b)
+      {
+        return a.recall < b.recall;
+      });
+
+  return frontier;
+}
+
+template<typename SortPolicy>
+const LSHTuningResult& LSHTuner<SortPolicy>::Best(
+    const double targetRecall,
+    const bool minimizeMemory) const
+{
+  const LSHTuningResult* best = NULL;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const LSHTuningResult& result = results[i];
+    if (result.recall < targetRecall)
+      continue;
+
+    if (best == NULL || (minimizeMemory ? (result.memory < best->memory) :
+        (result.queryTime < best->queryTime)))
+      best = &result;
+  }
+
+  if (best == NULL)
+  {
+    std::ostringstream oss;
+    oss << "LSHTuner::Best(): no evaluated setting reaches a recall of "
+        << targetRecall << "!";
+    throw std::runtime_error(oss.str());
+  }
+
+  return *best;
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file dynamic_neighbor_search.hpp
+ *
+ * Definition of the DynamicNeighborSearch class, which performs neighbor search
+ * on a reference set that points can be inserted into and removed from without
+ * rebuilding the whole tree.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/prereqs.hpp>
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The DynamicNeighborSearch class performs the same searches as NeighborSearch,
+ * but allows points to be inserted into and removed from the reference set.
+ * Trees such as the kd-tree and the ball tree are static, so this class uses
+ * the logarithmic method (Bentley and Saxe, 1980): the reference set is split
+ * into a list of components of decreasing size, each of which is an ordinary
+ * NeighborSearch object with its own tree.
+ *
+ * Inserted points form a new component, which is merged with the smallest
+ * existing components for as long as they are no larger than it.  Every point
+ * is therefore part of O(log n) tree builds over its lifetime, and inserting a
+ * small batch of points only rebuilds small trees.  Removed points are marked
+ * and skipped during search; once more than half of the points of a component
+ * are removed, that component is rebuilt without them.  A search searches each
+ * component and merges the results, so the results are exact (for epsilon = 0)
+ * and identical to a NeighborSearch built on the live points.
+ *
+ * Each point is identified by the index it was given when it was inserted:
+ * the points of the initial reference set have indices 0 to n - 1, and every
+ * batch of inserted points gets the next indices.  Indices of removed points
+ * are never reused.
+ *
+ * This class is not (yet) available through NSModel or the command-line
+ * programs, since it cannot be serialized.
+ *
+ * @code
+ * DynamicNeighborSearch<> knn(referenceSet);
+ * const size_t first = knn.Insert(newPoints); // Indices first, first + 1, ...
+ * knn.Remove(3);
+ * knn.Search(querySet, 5, neighbors, distances);
+ * @endcode
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam MetricType The metric to use for computation.
+ * @tparam MatType The type of data matrix.
+ * @tparam TreeType The tree type to use; must adhere to the TreeType API.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         typename MetricType = mlpack::metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class DynamicNeighborSearch
+{
+ public:
+  //! The type of NeighborSearch object used for each component.
+  typedef NeighborSearch<SortPolicy, MetricType, MatType, TreeType> NSType;
+  //! Convenience typedef.
+  typedef typename NSType::Tree Tree;
+
+  /**
+   * Create the DynamicNeighborSearch object with an empty reference set.  Use
+   * Insert() to add points.
+   *
+   * @param mode Neighbor search mode.
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  DynamicNeighborSearch(const NeighborSearchMode mode = DUAL_TREE_MODE,
+                        const double epsilon = 0,
+                        const MetricType metric = MetricType());
+
+  /**
+   * Create the DynamicNeighborSearch object with the given reference set.  The
+   * points get the indices 0 to referenceSet.n_cols - 1.
+   *
+   * @param referenceSet Set of reference points.
+   * @param mode Neighbor search mode.
+   * @param epsilon Relative approximate error (non-negative).
+   * @param metric An optional instance of the MetricType class.
+   */
+  DynamicNeighborSearch(const MatType& referenceSet,
+                        const NeighborSearchMode mode = DUAL_TREE_MODE,
+                        const double epsilon = 0,
+                        const MetricType metric = MetricType());
+
+  //! Copying is not supported.
+  DynamicNeighborSearch(const DynamicNeighborSearch& other) = delete;
+  //! Copying is not supported.
+  DynamicNeighborSearch& operator=(const DynamicNeighborSearch& other) = delete;
+
+  /**
+   * Delete the DynamicNeighborSearch object, and all of its components.
+   */
+  ~DynamicNeighborSearch();
+
+  /**
+   * Insert the given points into the reference set.  The points get
+   * consecutive indices, starting with the returned index.
+   *
+   * @param points Points to insert.
+   * @return Index of the first inserted point.
+   */
+  size_t Insert(const MatType& points);
+
+  /**
+   * Remove the point with the given index from the reference set.  An
+   * std::invalid_argument is thrown if there is no such point, or if it has
+   * already been removed.
+   *
+   * @param index Index of the point to remove.
+   */
+  void Remove(const size_t index);
+
+  /**
+   * For each point in the query set, compute the k best neighbors among the
+   * points currently in the reference set, and store the results in the given
+   * matrices (in the same format as NeighborSearch::Search()).  The indices
+   * are the indices given to the points when they were inserted.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const MatType& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  //! Get the number of indices given out so far (including removed points).
+  size_t NumIndices() const { return locations.size(); }
+  //! Get the number of points currently in the reference set.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the number of components (trees) the reference set is split into.
+  size_t NumComponents() const { return components.size(); }
+
+  //! Get the search mode.
+  NeighborSearchMode SearchMode() const { return searchMode; }
+  //! Get the approximation parameter epsilon.
+  double Epsilon() const { return epsilon; }
+
+ private:
+  //! A part of the reference set, with its own NeighborSearch object.
+  struct Component
+  {
+    //! The NeighborSearch object for the points of this component.
+    NSType* search;
+    //! The index of each point of search->ReferenceSet().
+    std::vector<size_t> indices;
+    //! Whether each point of search->ReferenceSet() has been removed.
+    std::vector<bool> removed;
+    //! The number of removed points.
+    size_t numRemoved;
+  };
+
+  /**
+   * Build a component from the given points, which have the given indices, and
+   * store it as the component at the given position.
+   */
+  void BuildComponent(MatType&& points,
+                      const std::vector<size_t>& pointIndices,
+                      const size_t position);
+
+  /**
+   * Append the points of the given component that have not been removed (and
+   * their indices) to the given matrix and vector.
+   */
+  void AppendLivePoints(const Component& component,
+                        MatType& points,
+                        std::vector<size_t>& pointIndices) const;
+
+  //! Update the location of the points of the component at the given
+  //! position.
+  void UpdateLocations(const size_t position);
+
+  //! The components of the reference set, in order of decreasing size (as long
+  //! as there are no removals).
+  std::vector<Component> components;
+  //! The component and position of each point, indexed by point index.  The
+  //! component of a removed point is size_t() - 1.
+  std::vector<std::pair<size_t, size_t>> locations;
+  //! The number of points currently in the reference set.
+  size_t numPoints;
+
+  //! The search mode of each component.
+  NeighborSearchMode searchMode;
+  //! The approximation parameter of each component.
+  double epsilon;
+  //! The instantiated metric.
+  MetricType metric;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "dynamic_neighbor_search_impl.hpp"
+
+#endif
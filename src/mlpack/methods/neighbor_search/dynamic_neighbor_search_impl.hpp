@@ -0,0 +1,337 @@
+/**
+ * @file dynamic_neighbor_search_impl.hpp
+ *
+ * Implementation of the DynamicNeighborSearch class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_IMPL_HPP
+#define MLPACK_METHODS_NEIGHBOR_SEARCH_DYNAMIC_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dynamic_neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+DynamicNeighborSearch(const NeighborSearchMode mode,
+                      const double epsilon,
+                      const MetricType metric) :
+    numPoints(0),
+    searchMode(mode),
+    epsilon(epsilon),
+    metric(metric)
+{
+  if (epsilon < 0)
+    throw std::invalid_argument("epsilon must be non-negative");
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+DynamicNeighborSearch(const MatType& referenceSet,
+                      const NeighborSearchMode mode,
+                      const double epsilon,
+                      const MetricType metric) :
+    numPoints(0),
+    searchMode(mode),
+    epsilon(epsilon),
+    metric(metric)
+{
+  if (epsilon < 0)
+    throw std::invalid_argument("epsilon must be non-negative");
+
+  Insert(referenceSet);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+~DynamicNeighborSearch()
+{
+  for (size_t i = 0; i < components.size(); ++i)
+    delete components[i].search;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+size_t DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Insert(const MatType& points)
+{
+  const size_t firstIndex = locations.size();
+  if (points.n_cols == 0)
+    return firstIndex;
+
+  MatType newPoints(points);
+  std::vector<size_t> newIndices(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    newIndices[i] = firstIndex + i;
+
+  locations.resize(firstIndex + points.n_cols);
+  numPoints += points.n_cols;
+
+  // Merge the new points with the smallest components, for as long as those
+  // are no larger than the new component.
+  while (!components.empty())
+  {
+    const Component& last = components.back();
+    if (last.indices.size() - last.numRemoved > newPoints.n_cols)
+      break;
+
+    AppendLivePoints(last, newPoints, newIndices);
+    delete last.search;
+    components.pop_back();
+  }
+
+  BuildComponent(std::move(newPoints), newIndices, components.size());
+
+  return firstIndex;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Remove(const size_t index)
+{
+  if (index >= locations.size() || locations[index].first == size_t() - 1)
+  {
+    std::stringstream ss;
+    ss << "DynamicNeighborSearch::Remove(): there is no point with index "
+        << index;
+    throw std::invalid_argument(ss.str());
+  }
+
+  const size_t position = locations[index].first;
+  Component& component = components[position];
+  component.removed[locations[index].second] = true;
+  ++component.numRemoved;
+  --numPoints;
+  locations[index].first = size_t() - 1;
+
+  // If more than half of the component is gone, rebuild it without the
+  // removed points.
+  if (2 * component.numRemoved > component.indices.size())
+  {
+    MatType points(component.search->ReferenceSet().n_rows, 0);
+    std::vector<size_t> pointIndices;
+    AppendLivePoints(component, points, pointIndices);
+    delete component.search;
+
+    if (pointIndices.empty())
+    {
+      components.erase(components.begin() + position);
+      for (size_t i = position; i < components.size(); ++i)
+        UpdateLocations(i);
+    }
+    else
+    {
+      BuildComponent(std::move(points), pointIndices, position);
+    }
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+Search(const MatType& querySet,
+       const size_t k,
+       arma::Mat<size_t>& neighbors,
+       arma::mat& distances)
+{
+  if (k > numPoints)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << numPoints << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  // Collect the results of every component.  Each component is searched for
+  // k + (number of removed points) neighbors, so that at least k of the
+  // results (or all of the points of the component) have not been removed.
+  typedef std::pair<double, size_t> Candidate;
+  std::vector<std::vector<Candidate>> candidates(querySet.n_cols);
+  arma::Mat<size_t> componentNeighbors;
+  arma::mat componentDistances;
+  for (size_t c = 0; c < components.size(); ++c)
+  {
+    const Component& component = components[c];
+    const size_t componentK = std::min(k + component.numRemoved,
+        component.indices.size());
+    component.search->Search(querySet, componentK, componentNeighbors,
+        componentDistances);
+
+    for (size_t q = 0; q < querySet.n_cols; ++q)
+    {
+      for (size_t j = 0; j < componentK; ++j)
+      {
+        const size_t neighbor = componentNeighbors(j, q);
+        if (neighbor >= component.indices.size() || component.removed[neighbor])
+          continue;
+
+        candidates[q].push_back(std::make_pair(componentDistances(j, q),
+            component.indices[neighbor]));
+      }
+    }
+  }
+
+  // Keep the best k results for each query point.
+  neighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+  for (size_t q = 0; q < querySet.n_cols; ++q)
+  {
+    std::vector<Candidate>& list = candidates[q];
+    const size_t numResults = std::min(k, list.size());
+    std::partial_sort(list.begin(), list.begin() + numResults, list.end(),
+        [](const Candidate& a, const Candidate& b)
+        {
+          return (a.first != b.first) ? SortPolicy::IsBetter(a.first, b.first) :
+              (a.second < b.second);
+        });
+
+    for (size_t j = 0; j < k; ++j)
+    {
+      if (j < numResults)
+      {
+        neighbors(j, q) = list[j].second;
+        distances(j, q) = list[j].first;
+      }
+      else
+      {
+        neighbors(j, q) = size_t() - 1;
+        distances(j, q) = SortPolicy::WorstDistance();
+      }
+    }
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+BuildComponent(MatType&& points,
+               const std::vector<size_t>& pointIndices,
+               const size_t position)
+{
+  Component component;
+  component.search = new NSType(searchMode, epsilon, metric);
+  component.removed.assign(pointIndices.size(), false);
+  component.numRemoved = 0;
+
+  if (searchMode == NAIVE_MODE)
+  {
+    // The naive search keeps the points in order.
+    component.search->Train(std::move(points));
+    component.indices = pointIndices;
+  }
+  else
+  {
+    // Build the tree here, so that we know how it reorders the points.
+    Timer::Start("tree_building");
+    std::vector<size_t> oldFromNew;
+    Tree* tree = BuildTree<MatType, Tree>(std::move(points), oldFromNew);
+    Timer::Stop("tree_building");
+
+    component.search->Train(std::move(*tree));
+    delete tree;
+
+    if (oldFromNew.empty())
+    {
+      component.indices = pointIndices;
+    }
+    else
+    {
+      component.indices.resize(pointIndices.size());
+      for (size_t i = 0; i < oldFromNew.size(); ++i)
+        component.indices[i] = pointIndices[oldFromNew[i]];
+    }
+  }
+
+  if (position == components.size())
+    components.push_back(component);
+  else
+    components[position] = component;
+
+  UpdateLocations(position);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+AppendLivePoints(const Component& component,
+                 MatType& points,
+                 std::vector<size_t>& pointIndices) const
+{
+  const MatType& referenceSet = component.search->ReferenceSet();
+  const size_t oldCols = points.n_cols;
+  points.resize(referenceSet.n_rows,
+      oldCols + component.indices.size() - component.numRemoved);
+
+  size_t col = oldCols;
+  for (size_t i = 0; i < component.indices.size(); ++i)
+  {
+    if (component.removed[i])
+      continue;
+
+    points.col(col++) = referenceSet.col(i);
+    pointIndices.push_back(component.indices[i]);
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DynamicNeighborSearch<SortPolicy, MetricType, MatType, TreeType>::
+UpdateLocations(const size_t position)
+{
+  // Removed points must stay unlocated, or they could be removed again.
+  const Component& component = components[position];
+  for (size_t i = 0; i < component.indices.size(); ++i)
+    if (!component.removed[i])
+      locations[component.indices[i]] = std::make_pair(position, i);
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -89,6 +89,15 @@ PARAM_DOUBLE_IN("rho", "Balance threshold (only valid for spill trees).", "b",
 
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference data in single precision, "
+    "which halves the memory it takes (only valid for kd-trees and ball "
+    "trees).", "P");
+PARAM_STRING_IN("input_tree_file", "File containing a reference tree saved "
+    "with --output_tree_file.  The file is memory-mapped instead of building "
+    "the tree (only valid for kd-trees and ball trees).", "", "");
+PARAM_STRING_IN("output_tree_file", "If specified, the reference tree is saved "
+    "to this file in a flat format that can be memory-mapped with "
+    "--input_tree_file (only valid for kd-trees and ball trees).", "", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
@@ -118,10 +127,24 @@ int main(int argc, char *argv[])
     Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
         << " may be specified!" << endl;
 
+  // A tree file replaces both of them.
+  if (CLI::HasParam("input_tree_file") && (CLI::HasParam("reference") ||
+      CLI::HasParam("input_model")))
+    Log::Fatal << "--input_tree_file may not be specified with "
+        << "--reference_file (-r) or --input_model_file (-m)!" << endl;
+
   // A user must specify one of them...
-  if (!CLI::HasParam("reference") && !CLI::HasParam("input_model"))
-    Log::Fatal << "No model specified (--input_model_file) and no reference "
-        << "data specified (--reference_file)!  One must be provided." << endl;
+  if (!CLI::HasParam("reference") && !CLI::HasParam("input_model") &&
+      !CLI::HasParam("input_tree_file"))
+    Log::Fatal << "No model specified (--input_model_file or "
+        << "--input_tree_file) and no reference data specified "
+        << "(--reference_file)!  One must be provided." << endl;
+
+  // The random basis is not stored in tree files.
+  if (CLI::HasParam("random_basis") && (CLI::HasParam("input_tree_file") ||
+      CLI::HasParam("output_tree_file")))
+    Log::Fatal << "--random_basis (-R) may not be specified with "
+        << "--input_tree_file or --output_tree_file!" << endl;
 
   if (CLI::HasParam("input_model"))
   {
@@ -132,6 +155,9 @@ int main(int argc, char *argv[])
     if (CLI::HasParam("random_basis"))
       Log::Warn << "--random_basis (-R) will be ignored because "
           << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("single_precision"))
+      Log::Warn << "--single_precision (-P) will be ignored because "
+          << "--input_model_file is specified." << endl;
     if (CLI::HasParam("tau"))
       Log::Warn << "--tau (-u) will be ignored because --input_model_file is "
           "specified." << endl;
@@ -245,7 +271,7 @@ int main(int argc, char *argv[])
       Log::Warn << "--single_mode ignored because --naive is present." << endl;
   }
 
-  if (CLI::HasParam("reference"))
+  if (CLI::HasParam("reference") || CLI::HasParam("input_tree_file"))
   {
     // Get all the parameters.
     const string treeType = CLI::GetParam<string>("tree_type");
@@ -294,14 +320,41 @@ int main(int argc, char *argv[])
     knn.Tau() = tau;
     knn.Rho() = rho;
 
-    arma::mat referenceSet = std::move(CLI::GetParam<arma::mat>("reference"));
+    // Only kd-trees and ball trees can hold single-precision data.
+    const bool singlePrecision = CLI::HasParam("single_precision");
+    if (singlePrecision && tree != KNNModel::KD_TREE &&
+        tree != KNNModel::BALL_TREE)
+      Log::Fatal << "--single_precision (-P) is only valid for kd-trees and "
+          << "ball trees." << endl;
+    knn.SinglePrecision() = singlePrecision;
+
+    // Only kd-trees and ball trees can be stored in tree files.
+    if (CLI::HasParam("input_tree_file") && tree != KNNModel::KD_TREE &&
+        tree != KNNModel::BALL_TREE)
+      Log::Fatal << "--input_tree_file is only valid for kd-trees and ball "
+          << "trees." << endl;
+
+    if (CLI::HasParam("input_tree_file"))
+    {
+      const string treeFile = CLI::GetParam<string>("input_tree_file");
+      knn.LoadTree(treeFile, searchMode, epsilon);
 
-    Log::Info << "Loaded reference data from '"
-        << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
-        << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
-        << endl;
+      Log::Info << "Loaded reference tree from '" << treeFile << "' ("
+          << knn.Dimensionality() << "x" << knn.NumPoints() << ")." << endl;
+    }
+    else
+    {
+      arma::mat referenceSet =
+          std::move(CLI::GetParam<arma::mat>("reference"));
+
+      Log::Info << "Loaded reference data from '"
+          << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
+          << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
+          << endl;
 
-    knn.BuildModel(std::move(referenceSet), size_t(lsInt), searchMode, epsilon);
+      knn.BuildModel(std::move(referenceSet), size_t(lsInt), searchMode,
+          epsilon);
+    }
   }
   else
   {
@@ -320,10 +373,29 @@ int main(int argc, char *argv[])
 
     Log::Info << "Loaded kNN model from '"
         << CLI::GetUnmappedParam<KNNModel>("input_model") << "' (trained on "
-        << knn.Dataset().n_rows << "x" << knn.Dataset().n_cols << " dataset)."
+        << knn.Dimensionality() << "x" << knn.NumPoints() << " dataset)."
         << endl;
   }
 
+  // Save the reference tree, if desired.
+  if (CLI::HasParam("output_tree_file"))
+  {
+    if (knn.TreeType() != KNNModel::KD_TREE &&
+        knn.TreeType() != KNNModel::BALL_TREE)
+      Log::Fatal << "--output_tree_file is only valid for kd-trees and ball "
+          << "trees." << endl;
+    if (knn.RandomBasis())
+      Log::Fatal << "--output_tree_file is not valid for models with a random "
+          << "basis." << endl;
+    if (knn.SearchMode() == NAIVE_MODE)
+      Log::Fatal << "--output_tree_file is not valid with naive search, which "
+          << "builds no tree." << endl;
+
+    const string treeFile = CLI::GetParam<string>("output_tree_file");
+    knn.SaveTree(treeFile);
+    Log::Info << "Saved reference tree to '" << treeFile << "'." << endl;
+  }
+
   // Perform search, if desired.
   if (CLI::HasParam("k"))
   {
@@ -341,11 +413,11 @@ int main(int argc, char *argv[])
     // Sanity check on k value: must be greater than 0, must be less than the
     // number of reference points.  Since it is unsigned, we only test the upper
     // bound.
-    if (k > knn.Dataset().n_cols)
+    if (k > knn.NumPoints())
     {
       Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less ";
       Log::Fatal << "than or equal to the number of reference points (";
-      Log::Fatal << knn.Dataset().n_cols << ")." << endl;
+      Log::Fatal << knn.NumPoints() << ")." << endl;
     }
 
     // Now run the search.
@@ -59,7 +59,9 @@ enum NeighborSearchMode
  *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
- * @tparam MatType The type of data matrix.
+ * @tparam MatType The type of data matrix.  Single-precision data (arma::fmat)
+ *     may be used with trees that have double-precision bounds, such as the
+ *     kd-tree; distances are still returned as doubles.
  * @tparam TreeType The tree type to use; must adhere to the TreeType API.
  * @tparam DualTreeTraversalType The type of dual tree traversal to use
  *     (defaults to the tree's default traverser).
@@ -299,6 +301,43 @@ class NeighborSearch
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
 
+  /**
+   * For each point in the query set, compute the nearest neighbors and hand
+   * them to the given sink, instead of storing the results of all query points
+   * in one matrix.  The query set is searched in batches of batchSize points
+   * (in the current search mode), and the results of each query point are
+   * passed to the sink as soon as its batch is finished, so only the results
+   * of one batch are held in memory at any time.  This allows very large query
+   * sets or values of k, where the k x n result matrices would not fit in
+   * memory; the sink could, for instance, write the results to disk.
+   *
+   * The sink is called once for each query point, in order, as
+   *
+   * @code
+   * sink(queryIndex, neighbors, distances);
+   * @endcode
+   *
+   * where queryIndex is the index of the query point in querySet, neighbors is
+   * an arma::Col<size_t> holding the indices of its k neighbors, and distances
+   * is an arma::vec holding the distances to them (in the same order as a
+   * column of the results of the other Search() overloads).  The vectors are
+   * only valid during the call.  Any callable object (such as a lambda) can be
+   * used as the sink.
+   *
+   * The results are identical to those of the other Search() overloads, but
+   * BaseCases() and Scores() give the totals over all batches.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param sink Callable object that receives the results of each query point.
+   * @param batchSize Number of query points searched at once.
+   */
+  template<typename SinkType>
+  void Search(const MatType& querySet,
+              const size_t k,
+              SinkType&& sink,
+              const size_t batchSize = 10000);
+
   /**
    * Given a pre-built query tree, search for the nearest neighbors of each
    * point in the query tree, storing the output in the given matrices.  The
@@ -400,6 +439,15 @@ class NeighborSearch
   //! Modify the reference tree.
   Tree& ReferenceTree() { return *referenceTree; }
 
+  //! Access the mapping from the indices of the points in the reference tree
+  //! to their original indices (empty if the tree does not reorder points).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+  //! Modify the mapping from the indices of the points in the reference tree
+  //! to their original indices.  Set this when a tree built elsewhere is
+  //! given to the constructor or to Train().
+  std::vector<size_t>& OldFromNewReferences() { return oldFromNewReferences; }
+
   //! Serialize the NeighborSearch model.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
@@ -434,6 +482,44 @@ class NeighborSearch
   //! Search() without a query set.
   bool treeNeedsReset;
 
+  //! The squared norms of the reference points, for the Euclidean distance
+  //! (see NeighborSearchRules::BaseCaseBlock()).  These are shared by every
+  //! rules object of a search.
+  arma::Col<typename MatType::elem_type> referenceNorms;
+
+  //! Compute the squared norms of the reference points, if they are used by
+  //! the metric.  This is called whenever the reference set changes.
+  void ComputeReferenceNorms();
+
+  /**
+   * Run single-tree search on the reference tree for the first numQueries
+   * points of the query set held by the given rules.  If OpenMP is available
+   * and the tree type allows it, the query points are split between threads,
+   * each with its own rules object that shares the candidate lists of the given
+   * rules.
+   *
+   * @param numQueries Number of query points to search for.
+   * @param rules Rules object to use for the traversal.
+   */
+  void SingleTreeTraverse(
+      const size_t numQueries,
+      NeighborSearchRules<SortPolicy, MetricType, Tree>& rules);
+
+  /**
+   * Traverse the given query tree and the reference tree with the given rules.
+   * If OpenMP is available, the top levels of the query tree are split into
+   * independent subtrees, and each of these is traversed against the reference
+   * tree in parallel.  Each parallel traversal
+   * has its own rules object, but all of them write to the candidate lists of
+   * the given rules, so the results are identical to a serial traversal.
+   *
+   * @param queryTree Tree built on the query points.
+   * @param rules Rules object to use for the traversal.
+   */
+  void DualTreeTraverse(
+      Tree& queryTree,
+      NeighborSearchRules<SortPolicy, MetricType, Tree>& rules);
+
   //! The NSModel class should have access to internal members.
   template<typename SortPol>
   friend class TrainVisitor;
@@ -15,6 +15,7 @@
 
 #include <mlpack/prereqs.hpp>
 #include <mlpack/core/tree/greedy_single_tree_traverser.hpp>
+#include <mlpack/core/tree/tree_profile.hpp>
 #include "neighbor_search_rules.hpp"
 #include <mlpack/core/tree/spill_tree/is_spill_tree.hpp>
 
@@ -98,6 +99,13 @@ SingleTreeTraversalType>::NeighborSearch(const MatType& referenceSetIn,
 {
   if (epsilon < 0)
     throw std::invalid_argument("epsilon must be non-negative");
+
+  // Describe the reference tree in the profiling counters, if they are
+  // enabled.
+  if (referenceTree)
+    tree::ProfileTree(*referenceTree, "reference_tree");
+
+  ComputeReferenceNorms();
 }
 
 // Construct the object.
@@ -130,6 +138,13 @@ SingleTreeTraversalType>::NeighborSearch(MatType&& referenceSetIn,
 {
   if (epsilon < 0)
     throw std::invalid_argument("epsilon must be non-negative");
+
+  // Describe the reference tree in the profiling counters, if they are
+  // enabled.
+  if (referenceTree)
+    tree::ProfileTree(*referenceTree, "reference_tree");
+
+  ComputeReferenceNorms();
 }
 
 // Construct the object.
@@ -159,6 +174,12 @@ SingleTreeTraversalType>::NeighborSearch(const Tree& referenceTree,
 {
   if (epsilon < 0)
     throw std::invalid_argument("epsilon must be non-negative");
+
+  // Describe the reference tree in the profiling counters, if they are
+  // enabled.
+  tree::ProfileTree(*this->referenceTree, "reference_tree");
+
+  ComputeReferenceNorms();
 }
 
 // Construct the object.
@@ -188,6 +209,12 @@ SingleTreeTraversalType>::NeighborSearch(Tree&& referenceTree,
 {
   if (epsilon < 0)
     throw std::invalid_argument("epsilon must be non-negative");
+
+  // Describe the reference tree in the profiling counters, if they are
+  // enabled.
+  tree::ProfileTree(*this->referenceTree, "reference_tree");
+
+  ComputeReferenceNorms();
 }
 
 // Construct the object without a reference dataset.
@@ -248,7 +275,8 @@ SingleTreeTraversalType>::NeighborSearch(const NeighborSearch& other) :
     metric(other.metric),
     baseCases(other.baseCases),
     scores(other.scores),
-    treeNeedsReset(false)
+    treeNeedsReset(false),
+    referenceNorms(other.referenceNorms)
 {
   // Nothing else to do.
 }
@@ -274,7 +302,8 @@ SingleTreeTraversalType>::NeighborSearch(NeighborSearch&& other) :
     metric(std::move(other.metric)),
     baseCases(other.baseCases),
     scores(other.scores),
-    treeNeedsReset(other.treeNeedsReset)
+    treeNeedsReset(other.treeNeedsReset),
+    referenceNorms(std::move(other.referenceNorms))
 {
   // Clear the other model.
   other.referenceSet = new MatType();
@@ -329,6 +358,7 @@ NeighborSearch<SortPolicy,
   baseCases = other.baseCases;
   scores = other.scores;
   treeNeedsReset = false;
+  referenceNorms = other.referenceNorms;
 }
 
 // Move operator.
@@ -370,6 +400,7 @@ NeighborSearch<SortPolicy,
   baseCases = other.baseCases;
   scores = other.scores;
   treeNeedsReset = other.treeNeedsReset;
+  referenceNorms = std::move(other.referenceNorms);
 
   // Reset the other object.
   other.referenceSet = new MatType();
@@ -427,6 +458,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(
     referenceTree = BuildTree<MatType, Tree>(referenceSet,
         oldFromNewReferences);
     treeOwner = true;
+    tree::ProfileTree(*referenceTree, "reference_tree");
   }
   else
   {
@@ -442,6 +474,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(
   else
     this->referenceSet = &referenceSet;
   setOwner = false; // We don't own the set in either case.
+
+  ComputeReferenceNorms();
 }
 
 template<typename SortPolicy,
@@ -468,6 +502,7 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(MatType&& referenceSetIn)
     referenceTree = BuildTree<MatType, Tree>(std::move(referenceSetIn),
         oldFromNewReferences);
     treeOwner = true;
+    tree::ProfileTree(*referenceTree, "reference_tree");
   }
   else
   {
@@ -488,6 +523,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(MatType&& referenceSetIn)
     referenceSet = new MatType(std::move(referenceSetIn));
     setOwner = true;
   }
+
+  ComputeReferenceNorms();
 }
 
 template<typename SortPolicy,
@@ -519,6 +556,9 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(
   this->referenceSet = &this->referenceTree->Dataset();
   treeOwner = true;
   setOwner = false;
+
+  tree::ProfileTree(*this->referenceTree, "reference_tree");
+  ComputeReferenceNorms();
 }
 
 template<typename SortPolicy,
@@ -549,6 +589,9 @@ DualTreeTraversalType, SingleTreeTraversalType>::Train(Tree&& referenceTree)
   this->referenceSet = &this->referenceTree->Dataset();
   treeOwner = true;
   setOwner = false;
+
+  tree::ProfileTree(*this->referenceTree, "reference_tree");
+  ComputeReferenceNorms();
 }
 
 /**
@@ -633,12 +676,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       // Create the helper object for the tree traversal.
       RuleType rules(*referenceSet, querySet, k, metric, epsilon);
 
-      // Create the traverser.
-      SingleTreeTraversalType<RuleType> traverser(rules);
-
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < querySet.n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
+      // Now traverse for each point.
+      SingleTreeTraverse(querySet.n_cols, rules);
 
       scores += rules.Scores();
       baseCases += rules.BaseCases();
@@ -658,15 +697,14 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
       Timer::Start("tree_building");
       Tree* queryTree = BuildTree<MatType, Tree>(querySet, oldFromNewQueries);
       Timer::Stop("tree_building");
+      tree::ProfileTree(*queryTree, "query_tree");
       Timer::Start("computing_neighbors");
 
       // Create the helper object for the tree traversal.
-      RuleType rules(*referenceSet, queryTree->Dataset(), k, metric, epsilon);
-
-      // Create the traverser.
-      DualTreeTraversalType<RuleType> traverser(rules);
+      RuleType rules(*referenceSet, queryTree->Dataset(), k, metric, epsilon,
+          false, &referenceNorms);
 
-      traverser.Traverse(*queryTree, *referenceTree);
+      DualTreeTraverse(*queryTree, rules);
 
       scores += rules.Scores();
       baseCases += rules.BaseCases();
@@ -768,6 +806,54 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   }
 } // Search()
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+template<typename SinkType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::Search(
+    const MatType& querySet,
+    const size_t k,
+    SinkType&& sink,
+    const size_t batchSize)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("NeighborSearch::Search(): batchSize must be "
+        "positive");
+
+  // Search the query points one batch at a time, and hand the results of each
+  // batch to the sink before moving on to the next batch.
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  for (size_t begin = 0; begin < querySet.n_cols; begin += batchSize)
+  {
+    const size_t end = std::min(begin + batchSize, (size_t) querySet.n_cols);
+    const MatType batch(querySet.cols(begin, end - 1));
+    Search(batch, k, neighbors, distances);
+
+    totalBaseCases += baseCases;
+    totalScores += scores;
+
+    for (size_t i = 0; i < batch.n_cols; ++i)
+    {
+      const arma::Col<size_t> queryNeighbors(neighbors.colptr(i), k, false,
+          true);
+      const arma::vec queryDistances(distances.colptr(i), k, false, true);
+      sink(begin + i, queryNeighbors, queryDistances);
+    }
+  }
+
+  baseCases = totalBaseCases;
+  scores = totalScores;
+}
+
 template<typename SortPolicy,
          typename MetricType,
          typename MatType,
@@ -805,6 +891,9 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   // Get a reference to the query set.
   const MatType& querySet = queryTree.Dataset();
 
+  // Describe the query tree in the profiling counters, if they are enabled.
+  tree::ProfileTree(queryTree, "query_tree");
+
   // We won't need to map query indices, but will we need to map distances?
   arma::Mat<size_t>* neighborPtr = &neighbors;
 
@@ -817,11 +906,10 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
 
   // Create the helper object for the traversal.
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, querySet, k, metric, epsilon, sameSet);
+  RuleType rules(*referenceSet, querySet, k, metric, epsilon, sameSet,
+      &referenceNorms);
 
-  // Create the traverser.
-  DualTreeTraversalType<RuleType> traverser(rules);
-  traverser.Traverse(queryTree, *referenceTree);
+  DualTreeTraverse(queryTree, rules);
 
   scores += rules.Scores();
   baseCases += rules.BaseCases();
@@ -898,7 +986,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   // Create the helper object for the traversal.
   typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, *referenceSet, k, metric, epsilon,
-      true /* don't return the same point as nearest neighbor */);
+      true /* don't return the same point as nearest neighbor */,
+      &referenceNorms);
 
   switch (searchMode)
   {
@@ -914,12 +1003,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
     }
     case SINGLE_TREE_MODE:
     {
-      // Create the traverser.
-      SingleTreeTraversalType<RuleType> traverser(rules);
-
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < referenceSet->n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
+      // Now traverse for each point.
+      SingleTreeTraverse(referenceSet->n_cols, rules);
 
       scores += rules.Scores();
       baseCases += rules.BaseCases();
@@ -952,19 +1037,17 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
         }
       }
 
-      // Create the traverser.
-      DualTreeTraversalType<RuleType> traverser(rules);
-
       if (tree::IsSpillTree<Tree>::value)
       {
         // For Dual Tree Search on SpillTree, the queryTree must be built with
         // non overlapping (tau = 0).
         Tree queryTree(*referenceSet);
-        traverser.Traverse(queryTree, *referenceTree);
+        tree::ProfileTree(queryTree, "query_tree");
+        DualTreeTraverse(queryTree, rules);
       }
       else
       {
-        traverser.Traverse(*referenceTree, *referenceTree);
+        DualTreeTraverse(*referenceTree, rules);
         // Next time we perform this search, we'll need to reset the tree.
         treeNeedsReset = true;
       }
@@ -1029,6 +1112,163 @@ DualTreeTraversalType, SingleTreeTraversalType>::Search(
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::SingleTreeTraverse(
+    const size_t numQueries,
+    NeighborSearchRules<SortPolicy, MetricType, Tree>& rules)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+
+#ifdef HAS_OPENMP
+  // Trees with self-children (i.e. cover trees) have their distance evaluations
+  // cached in the reference nodes by the rules, so they cannot be searched in
+  // parallel.
+  if (omp_get_max_threads() > 1 && !tree::TreeTraits<Tree>::HasSelfChildren)
+  {
+    size_t parallelScores = 0;
+    size_t parallelBaseCases = 0;
+
+    #pragma omp parallel reduction(+:parallelScores, parallelBaseCases)
+    {
+      // Each thread gets its own rules and traverser; the results are stored in
+      // the candidate lists of the given rules.
+      RuleType threadRules(rules);
+      SingleTreeTraversalType<RuleType> traverser(threadRules);
+
+#ifdef _WIN32
+      // Visual Studio only implements OpenMP 2.0, which doesn't support
+      // unsigned loop variables.
+      #pragma omp for schedule(dynamic)
+      for (intmax_t i = 0; i < (intmax_t) numQueries; ++i)
+#else
+      #pragma omp for schedule(dynamic)
+      for (size_t i = 0; i < numQueries; ++i)
+#endif
+        traverser.Traverse(i, *referenceTree);
+
+      parallelScores += threadRules.Scores();
+      parallelBaseCases += threadRules.BaseCases();
+    }
+
+    rules.Scores() += parallelScores;
+    rules.BaseCases() += parallelBaseCases;
+    return;
+  }
+#endif
+
+  SingleTreeTraversalType<RuleType> traverser(rules);
+
+  for (size_t i = 0; i < numQueries; ++i)
+    traverser.Traverse(i, *referenceTree);
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::DualTreeTraverse(
+    Tree& queryTree,
+    NeighborSearchRules<SortPolicy, MetricType, Tree>& rules)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+
+#ifdef HAS_OPENMP
+  // Dual-tree traversals only modify the statistics of query nodes (unlike
+  // single-tree traversals of cover trees), so every type of tree can be
+  // traversed in parallel.
+  const size_t numThreads = omp_get_max_threads();
+  if (numThreads > 1)
+  {
+    // Split the top of the query tree into independent subtrees, always
+    // splitting the largest subtree first.  We want a few subtrees per thread
+    // so that the dynamic schedule can balance the load.  Nodes that hold
+    // points themselves are not split, since then the points would be lost;
+    // but the point of a node with a self-child (i.e. in a cover tree) is
+    // held by its self-child too, so those nodes can be split.
+    typedef std::pair<size_t, Tree*> Task;
+    std::priority_queue<Task> tasks;
+    std::vector<Tree*> subtrees;
+    tasks.push(Task(queryTree.NumDescendants(), &queryTree));
+    while (!tasks.empty() && (tasks.size() + subtrees.size()) < 8 * numThreads)
+    {
+      Tree* node = tasks.top().second;
+      tasks.pop();
+
+      if (node->IsLeaf() || (node->NumPoints() > 0 &&
+          !tree::TreeTraits<Tree>::HasSelfChildren))
+      {
+        subtrees.push_back(node);
+        continue;
+      }
+
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        tasks.push(Task(node->Child(i).NumDescendants(), &node->Child(i)));
+    }
+
+    while (!tasks.empty())
+    {
+      subtrees.push_back(tasks.top().second);
+      tasks.pop();
+    }
+
+    size_t parallelScores = 0;
+    size_t parallelBaseCases = 0;
+
+#ifdef _WIN32
+    // Visual Studio only implements OpenMP 2.0, which doesn't support unsigned
+    // loop variables.
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelScores, parallelBaseCases)
+    for (intmax_t i = 0; i < (intmax_t) subtrees.size(); ++i)
+#else
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelScores, parallelBaseCases)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+#endif
+    {
+      // Each subtree holds a disjoint set of query points, so the traversals
+      // can share the candidate lists.
+      RuleType subtreeRules(rules);
+      DualTreeTraversalType<RuleType> traverser(subtreeRules);
+
+      // Start the traversal at the depth of the subtree, so that the profile
+      // counts node combinations at the same depths as a serial traversal
+      // from the root does.
+      size_t depth = 0;
+      for (const Tree* node = subtrees[i]; node->Parent() != NULL;
+           node = node->Parent())
+        ++depth;
+      tree::SetTraversalDepth(traverser, depth);
+
+      traverser.Traverse(*subtrees[i], *referenceTree);
+
+      parallelScores += subtreeRules.Scores();
+      parallelBaseCases += subtreeRules.BaseCases();
+    }
+
+    rules.Scores() += parallelScores;
+    rules.BaseCases() += parallelBaseCases;
+    return;
+  }
+#endif
+
+  DualTreeTraversalType<RuleType> traverser(rules);
+  traverser.Traverse(queryTree, *referenceTree);
+}
+
 //! Calculate the average relative error.
 template<typename SortPolicy,
          typename MetricType,
@@ -1171,6 +1411,8 @@ DualTreeTraversalType, SingleTreeTraversalType>::Serialize(
       referenceSet = &referenceTree->Dataset();
       metric = referenceTree->Metric(); // Get the metric from the tree.
       setOwner = false;
+
+      tree::ProfileTree(*referenceTree, "reference_tree");
     }
   }
 
@@ -1179,9 +1421,29 @@ DualTreeTraversalType, SingleTreeTraversalType>::Serialize(
   {
     baseCases = 0;
     scores = 0;
+    ComputeReferenceNorms();
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class DualTreeTraversalType,
+         template<typename> class SingleTreeTraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+DualTreeTraversalType, SingleTreeTraversalType>::ComputeReferenceNorms()
+{
+  // Only NeighborSearchRules::BaseCaseBlock() uses the norms, and only for the
+  // Euclidean distance.
+  if (std::is_same<MetricType, metric::EuclideanDistance>::value)
+    referenceNorms = arma::trans(arma::sum(arma::square(*referenceSet), 0));
+  else
+    referenceNorms.reset();
+}
+
 } // namespace neighbor
 } // namespace mlpack
 
@@ -44,13 +44,37 @@ class NeighborSearchRules
    * @param epsilon Relative approximate error.
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
+   * @param referenceNorms Squared norms of the reference points, used by
+   *      BaseCaseBlock().  If NULL, BaseCaseBlock() computes the norms of each
+   *      block of reference points itself.  The norms must outlive this object.
    */
-  NeighborSearchRules(const typename TreeType::Mat& referenceSet,
-                      const typename TreeType::Mat& querySet,
-                      const size_t k,
-                      MetricType& metric,
-                      const double epsilon = 0,
-                      const bool sameSet = false);
+  NeighborSearchRules(
+      const typename TreeType::Mat& referenceSet,
+      const typename TreeType::Mat& querySet,
+      const size_t k,
+      MetricType& metric,
+      const double epsilon = 0,
+      const bool sameSet = false,
+      const arma::Col<typename TreeType::Mat::elem_type>* referenceNorms =
+          NULL);
+
+  /**
+   * Construct a NeighborSearchRules object that shares the candidate lists and
+   * the reference norms of the given NeighborSearchRules object, but has its
+   * own traversal info and its own base case and score counters.  This is
+   * used to run several traversals in parallel; each of the traversals must
+   * work on a disjoint set of query points.  The given rules object must
+   * outlive this object.
+   *
+   * @param other NeighborSearchRules object whose candidate lists are used.
+   */
+  NeighborSearchRules(NeighborSearchRules& other);
+
+  /**
+   * Destroy the NeighborSearchRules object, freeing the candidate lists if
+   * they are owned by this object.
+   */
+  ~NeighborSearchRules();
 
   /**
    * Store the list of candidates for each query point in the given matrices.
@@ -71,6 +95,24 @@ class NeighborSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Compute the base cases between each of the given query points and each of
+   * the referenceCount reference points starting at referenceBegin.  This has
+   * the same effect as calling BaseCase() for every pair.  For the Euclidean
+   * distance, the distances of the whole block are estimated at once with
+   * ||q||^2 + ||r||^2 - 2 q^T r (so the inner products are one matrix
+   * multiplication), and only the pairs whose estimate could improve the
+   * candidate list of the query point are evaluated exactly; only those are
+   * counted as base cases.
+   *
+   * @param queryIndices Indices of query points.
+   * @param referenceBegin Index of the first reference point.
+   * @param referenceCount Number of reference points.
+   */
+  void BaseCaseBlock(const std::vector<size_t>& queryIndices,
+                     const size_t referenceBegin,
+                     const size_t referenceCount);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -177,8 +219,12 @@ class NeighborSearchRules
   typedef std::priority_queue<Candidate, std::vector<Candidate>, CandidateCmp>
       CandidateList;
 
-  //! Set of candidate neighbors for each point.
-  std::vector<CandidateList> candidates;
+  //! Set of candidate neighbors for each point.  These may belong to another
+  //! NeighborSearchRules object.
+  std::vector<CandidateList>* candidates;
+
+  //! If true, this object owns the candidate lists.
+  bool candidatesOwner;
 
   //! Number of neighbors to search for.
   const size_t k;
@@ -204,6 +250,21 @@ class NeighborSearchRules
   //! The number of scores that have been performed.
   size_t scores;
 
+  //! Scratch space for BaseCaseBlock(): the gathered query points.
+  typename TreeType::Mat blockQuerySet;
+  //! Scratch space for BaseCaseBlock(): the squared norms of the query points.
+  arma::Col<typename TreeType::Mat::elem_type> blockQueryNorms;
+  //! Scratch space for BaseCaseBlock(): the inner products of the block.
+  typename TreeType::Mat blockProducts;
+
+  //! Scratch space for BaseCaseBlock(): the squared norms of the reference
+  //! points, if referenceNorms is NULL.
+  arma::Col<typename TreeType::Mat::elem_type> blockReferenceNorms;
+
+  //! The squared norms of all reference points, or NULL if they are not
+  //! known.  These are shared with the object that owns them.
+  const arma::Col<typename TreeType::Mat::elem_type>* referenceNorms;
+
   //! Traversal info for the parent combination; this is updated by the
   //! traversal before each call to Score().
   TraversalInfoType traversalInfo;
@@ -26,9 +26,12 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     const size_t k,
     MetricType& metric,
     const double epsilon,
-    const bool sameSet) :
+    const bool sameSet,
+    const arma::Col<typename TreeType::Mat::elem_type>* referenceNorms) :
     referenceSet(referenceSet),
     querySet(querySet),
+    candidates(new std::vector<CandidateList>()),
+    candidatesOwner(true),
     k(k),
     metric(metric),
     sameSet(sameSet),
@@ -36,7 +39,8 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
     baseCases(0),
-    scores(0)
+    scores(0),
+    referenceNorms(referenceNorms)
 {
   // We must set the traversal info last query and reference node pointers to
   // something that is both invalid (i.e. not a tree node) and not NULL.  We'll
@@ -54,9 +58,39 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
-  candidates.reserve(querySet.n_cols);
+  candidates->reserve(querySet.n_cols);
   for (size_t i = 0; i < querySet.n_cols; i++)
-    candidates.push_back(pqueue);
+    candidates->push_back(pqueue);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
+    NeighborSearchRules& other) :
+    referenceSet(other.referenceSet),
+    querySet(other.querySet),
+    candidates(other.candidates),
+    candidatesOwner(false),
+    k(other.k),
+    metric(other.metric),
+    sameSet(other.sameSet),
+    epsilon(other.epsilon),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0),
+    referenceNorms(other.referenceNorms)
+{
+  // As in the other constructor, the traversal info must point to something
+  // invalid but non-NULL.
+  traversalInfo.LastQueryNode() = (TreeType*) this;
+  traversalInfo.LastReferenceNode() = (TreeType*) this;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+NeighborSearchRules<SortPolicy, MetricType, TreeType>::~NeighborSearchRules()
+{
+  if (candidatesOwner)
+    delete candidates;
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -69,7 +103,7 @@ void NeighborSearchRules<SortPolicy, MetricType, TreeType>::GetResults(
 
   for (size_t i = 0; i < querySet.n_cols; i++)
   {
-    CandidateList& pqueue = candidates[i];
+    CandidateList& pqueue = (*candidates)[i];
     for (size_t j = 1; j <= k; j++)
     {
       neighbors(k - j, i) = pqueue.top().second;
@@ -107,6 +141,81 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::BaseCaseBlock(
+    const std::vector<size_t>& queryIndices,
+    const size_t referenceBegin,
+    const size_t referenceCount)
+{
+  typedef typename TreeType::Mat MatType;
+  typedef typename MatType::elem_type ElemType;
+
+  // The estimate only applies to the Euclidean distance.
+  if (!std::is_same<MetricType, metric::EuclideanDistance>::value)
+  {
+    for (size_t i = 0; i < queryIndices.size(); ++i)
+      for (size_t j = 0; j < referenceCount; ++j)
+        BaseCase(queryIndices[i], referenceBegin + j);
+    return;
+  }
+
+  if (queryIndices.empty() || referenceCount == 0)
+    return;
+
+  // Gather the query points into the scratch matrix; the reference points are
+  // already contiguous.
+  const size_t numQueries = queryIndices.size();
+  blockQuerySet.set_size(querySet.n_rows, numQueries);
+  for (size_t i = 0; i < numQueries; ++i)
+    blockQuerySet.col(i) = querySet.col(queryIndices[i]);
+  const MatType references(
+      const_cast<ElemType*>(referenceSet.colptr(referenceBegin)),
+      referenceSet.n_rows, referenceCount, false, true);
+
+  // The squared norms of the reference points are usually computed once by the
+  // owner of the reference set.
+  const ElemType* blockNorms;
+  if (referenceNorms)
+  {
+    blockNorms = referenceNorms->memptr() + referenceBegin;
+  }
+  else
+  {
+    blockReferenceNorms = arma::trans(arma::sum(arma::square(references), 0));
+    blockNorms = blockReferenceNorms.memptr();
+  }
+
+  blockQueryNorms = arma::trans(arma::sum(arma::square(blockQuerySet), 0));
+  blockProducts = arma::trans(blockQuerySet) * references;
+
+  // The rounding error of the estimate of each squared distance is at most a
+  // small multiple of the machine epsilon times the sum of the squared norms,
+  // so we know an interval that the true distance lies in.
+  const double slackFactor = 2.0 * (querySet.n_rows + 2) *
+      std::numeric_limits<ElemType>::epsilon();
+
+  for (size_t i = 0; i < numQueries; ++i)
+  {
+    const size_t queryIndex = queryIndices[i];
+    const CandidateList& pqueue = (*candidates)[queryIndex];
+    for (size_t j = 0; j < referenceCount; ++j)
+    {
+      const double norms = blockQueryNorms[i] + blockNorms[j];
+      const double estimate = norms - 2.0 * blockProducts(i, j);
+      const double slack = slackFactor * norms;
+      const double lo = std::sqrt(std::max(estimate - slack, 0.0));
+      const double hi = std::sqrt(std::max(estimate + slack, 0.0));
+
+      // Only evaluate the distance exactly if the best distance in the
+      // interval could make it into the candidate list; BaseCase() counts the
+      // pairs that are evaluated.
+      const double bestDistance = SortPolicy::IsBetter(lo, hi) ? lo : hi;
+      if (SortPolicy::IsBetter(bestDistance, pqueue.top().first))
+        BaseCase(queryIndex, referenceBegin + j);
+    }
+  }
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -143,7 +252,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
   }
 
   // Compare against the best k'th distance for this query point so far.
-  double bestDistance = candidates[queryIndex].top().first;
+  double bestDistance = (*candidates)[queryIndex].top().first;
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ?
@@ -179,7 +288,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   const double distance = SortPolicy::ConvertToDistance(oldScore);
 
   // Just check the score again against the distances.
-  double bestDistance = candidates[queryIndex].top().first;
+  double bestDistance = (*candidates)[queryIndex].top().first;
   bestDistance = SortPolicy::Relax(bestDistance, epsilon);
 
   return (SortPolicy::IsBetter(distance, bestDistance)) ? oldScore : DBL_MAX;
@@ -404,7 +513,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // Loop over points held in the node.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = candidates[queryNode.Point(i)].top().first;
+    const double distance = (*candidates)[queryNode.Point(i)].top().first;
     if (SortPolicy::IsBetter(worstDistance, distance))
       worstDistance = distance;
     if (SortPolicy::IsBetter(distance, bestPointDistance))
@@ -499,7 +608,7 @@ InsertNeighbor(
     const size_t neighbor,
     const double distance)
 {
-  CandidateList& pqueue = candidates[queryIndex];
+  CandidateList& pqueue = (*candidates)[queryIndex];
   Candidate c = std::make_pair(distance, neighbor);
 
   if (CandidateCmp()(c, pqueue.top()))
@@ -16,30 +16,34 @@
 #define MLPACK_METHODS_NEIGHBOR_SEARCH_NS_MODEL_HPP
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/binary_space_tree/flat_tree_file.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
 #include <mlpack/core/tree/spill_tree.hpp>
 #include <mlpack/core/tree/octree.hpp>
 #include <boost/variant.hpp>
+#include <memory>
 #include "neighbor_search.hpp"
 
 namespace mlpack {
 namespace neighbor {
 
 /**
- * Alias template for euclidean neighbor search.
+ * Alias template for euclidean neighbor search.  The data is held in double
+ * precision unless another MatType is given.
  */
 template<typename SortPolicy,
          template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
 using NSType = NeighborSearch<SortPolicy,
                               metric::EuclideanDistance,
-                              arma::mat,
+                              MatType,
                               TreeType,
                               TreeType<metric::EuclideanDistance,
                                   NeighborSearchStat<SortPolicy>,
-                                  arma::mat>::template DualTreeTraverser>;
+                                  MatType>::template DualTreeTraverser>;
 
 template<typename SortPolicy>
 struct NSModelName
@@ -114,8 +118,8 @@ class BiSearchVisitor : public boost::static_visitor<void>
   const double rho;
 
   //! Bichromatic neighbor search on the given NSType considering the leafSize.
-  template<typename NSType>
-  void SearchLeaf(NSType* ns) const;
+  template<typename NSType, typename MatType>
+  void SearchLeaf(NSType* ns, const MatType& queries) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -142,6 +146,12 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic neighbor search specialized for octrees.
   void operator()(NSTypeT<tree::Octree>* ns) const;
 
+  //! Bichromatic neighbor search with single-precision KDTrees.
+  void operator()(NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const;
+
+  //! Bichromatic neighbor search with single-precision BallTrees.
+  void operator()(NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const;
+
   //! Construct the BiSearchVisitor.
   BiSearchVisitor(const arma::mat& querySet,
                   const size_t k,
@@ -172,8 +182,8 @@ class TrainVisitor : public boost::static_visitor<void>
   const double rho;
 
   //! Train on the given NSType considering the leafSize.
-  template<typename NSType>
-  void TrainLeaf(NSType* ns) const;
+  template<typename NSType, typename MatType>
+  void TrainLeaf(NSType* ns, MatType&& references) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -200,6 +210,12 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train specialized for octrees.
   void operator()(NSTypeT<tree::Octree>* ns) const;
 
+  //! Train single-precision KDTrees.
+  void operator()(NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const;
+
+  //! Train single-precision BallTrees.
+  void operator()(NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const;
+
   //! Construct the TrainVisitor object with the given reference set, leafSize
   //! for BinarySpaceTrees, and tau and rho for spill trees.
   TrainVisitor(arma::mat&& referenceSet,
@@ -208,6 +224,43 @@ class TrainVisitor : public boost::static_visitor<void>
                const double rho);
 };
 
+/**
+ * SaveTreeVisitor saves the reference tree of the given NSType to a flat tree
+ * file (see tree::FlatTreeFile).  Only kd-trees and ball trees can be saved
+ * this way; for other types of trees an exception is thrown.
+ */
+template<typename SortPolicy>
+class SaveTreeVisitor : public boost::static_visitor<void>
+{
+ private:
+  //! The name of the file to save to.
+  const std::string& filename;
+
+  //! Save the reference tree of the given NSType.
+  template<typename NSType>
+  void SaveLeaf(const NSType* ns) const;
+
+ public:
+  //! Throw, since the tree type can't be saved to a flat tree file.
+  template<typename NSType>
+  void operator()(NSType* ns) const;
+
+  //! Save the reference tree of a kd-tree NSType.
+  void operator()(NSType<SortPolicy, tree::KDTree>* ns) const;
+
+  //! Save the reference tree of a ball tree NSType.
+  void operator()(NSType<SortPolicy, tree::BallTree>* ns) const;
+
+  //! Save the reference tree of a single-precision kd-tree NSType.
+  void operator()(NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const;
+
+  //! Save the reference tree of a single-precision ball tree NSType.
+  void operator()(NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const;
+
+  //! Construct the SaveTreeVisitor object with the given filename.
+  SaveTreeVisitor(const std::string& filename);
+};
+
 /**
  * SearchModeVisitor exposes the SearchMode() method of the given NSType.
  */
@@ -231,7 +284,9 @@ class EpsilonVisitor : public boost::static_visitor<double&>
 };
 
 /**
- * ReferenceSetVisitor exposes the referenceSet of the given NSType.
+ * ReferenceSetVisitor exposes the referenceSet of the given NSType.  Models
+ * that hold single-precision data have no double-precision reference set, so
+ * for them an exception is thrown.
  */
 class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
 {
@@ -239,6 +294,38 @@ class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
   //! Return the reference set.
   template<typename NSType>
   const arma::mat& operator()(NSType *ns) const;
+
+  //! Throw, since the reference set is not held in double precision.
+  template<typename SortPolicy,
+           template<typename TreeMetricType,
+                    typename TreeStatType,
+                    typename TreeMatType> class TreeType>
+  const arma::mat& operator()(NSType<SortPolicy, TreeType, arma::fmat>* ns)
+      const;
+};
+
+/**
+ * DimensionalityVisitor returns the dimensionality of the reference set of the
+ * given NSType.
+ */
+class DimensionalityVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  //! Return the dimensionality of the reference set.
+  template<typename NSType>
+  size_t operator()(NSType* ns) const;
+};
+
+/**
+ * NumPointsVisitor returns the number of points in the reference set of the
+ * given NSType.
+ */
+class NumPointsVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  //! Return the number of points in the reference set.
+  template<typename NSType>
+  size_t operator()(NSType* ns) const;
 };
 
 /**
@@ -303,6 +390,10 @@ class NSModel
   //! This is the random projection matrix; only used if randomBasis is true.
   arma::mat q;
 
+  //! If true, the reference set is held in single precision (only for
+  //! kd-trees and ball trees).
+  bool singlePrecision;
+
   /**
    * nSearch holds an instance of the NeigborSearch class for the current
    * treeType. It is initialized every time BuildModel is executed.
@@ -322,7 +413,20 @@ class NSModel
                  NSType<SortPolicy, tree::MaxRPTree>*,
                  SpillKNN*,
                  NSType<SortPolicy, tree::UBTree>*,
-                 NSType<SortPolicy, tree::Octree>*> nSearch;
+                 NSType<SortPolicy, tree::Octree>*,
+                 NSType<SortPolicy, tree::KDTree, arma::fmat>*,
+                 NSType<SortPolicy, tree::BallTree, arma::fmat>*> nSearch;
+
+  //! The flat tree file that the reference tree was loaded from, if any.  The
+  //! dataset of the tree is stored in this file, so it must outlive nSearch.
+  std::shared_ptr<void> treeFile;
+
+  //! Load the reference tree of the given NSType from the given flat tree
+  //! file.
+  template<typename NSImplType>
+  void LoadFlatTree(const std::string& filename,
+                    const NeighborSearchMode searchMode,
+                    const double epsilon);
 
  public:
   /**
@@ -370,9 +474,15 @@ class NSModel
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
 
-  //! Expose the dataset.
+  //! Expose the dataset.  This throws std::invalid_argument if the model
+  //! holds single-precision data.
   const arma::mat& Dataset() const;
 
+  //! Get the dimensionality of the reference set.
+  size_t Dimensionality() const;
+  //! Get the number of points in the reference set.
+  size_t NumPoints() const;
+
   //! Expose SearchMode.
   NeighborSearchMode SearchMode() const;
   NeighborSearchMode& SearchMode();
@@ -401,12 +511,39 @@ class NSModel
   bool RandomBasis() const { return randomBasis; }
   bool& RandomBasis() { return randomBasis; }
 
+  //! Expose singlePrecision (don't modify it after the model has been built).
+  bool SinglePrecision() const { return singlePrecision; }
+  bool& SinglePrecision() { return singlePrecision; }
+
   //! Build the reference tree.
   void BuildModel(arma::mat&& referenceSet,
                   const size_t leafSize,
                   const NeighborSearchMode searchMode,
                   const double epsilon = 0);
 
+  /**
+   * Save the reference tree and the reference set to a flat tree file (see
+   * tree::FlatTreeFile), which can be loaded much faster than the model can be
+   * rebuilt or deserialized.  Only kd-trees and ball trees without a random
+   * basis can be saved this way.
+   *
+   * @param filename Name of the file to write.
+   */
+  void SaveTree(const std::string& filename) const;
+
+  /**
+   * Build the model from a reference tree saved with SaveTree().  The file is
+   * memory-mapped, and the reference set is not copied out of it.  The tree
+   * type and the precision of the model must match the saved tree.
+   *
+   * @param filename Name of the file to load.
+   * @param searchMode Neighbor search mode.
+   * @param epsilon Relative approximate error (non-negative).
+   */
+  void LoadTree(const std::string& filename,
+                const NeighborSearchMode searchMode,
+                const double epsilon = 0);
+
   //! Perform neighbor search.  The query set will be reordered.
   void Search(arma::mat&& querySet,
               const size_t k,
@@ -427,7 +564,7 @@ class NSModel
 
 //! Set the serialization version of the NSModel class.
 BOOST_TEMPLATE_CLASS_VERSION(template<typename SortPolicy>,
-    mlpack::neighbor::NSModel<SortPolicy>, 1);
+    mlpack::neighbor::NSModel<SortPolicy>, 2);
 
 // Include implementation.
 #include "ns_model_impl.hpp"
@@ -67,7 +67,7 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -76,7 +76,7 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -106,19 +106,40 @@ template<typename SortPolicy>
 void BiSearchVisitor<SortPolicy>::operator()(NSTypeT<tree::Octree>* ns) const
 {
   if (ns)
-    return SearchLeaf(ns);
+    return SearchLeaf(ns, querySet);
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search with single-precision KDTrees.
+template<typename SortPolicy>
+void BiSearchVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const
+{
+  if (ns)
+    return SearchLeaf(ns, arma::conv_to<arma::fmat>::from(querySet));
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Bichromatic neighbor search with single-precision BallTrees.
+template<typename SortPolicy>
+void BiSearchVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const
+{
+  if (ns)
+    return SearchLeaf(ns, arma::conv_to<arma::fmat>::from(querySet));
   throw std::runtime_error("no neighbor search model initialized");
 }
 
 //! Bichromatic neighbor search on the given NSType considering the leafSize.
 template<typename SortPolicy>
-template<typename NSType>
-void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns) const
+template<typename NSType, typename MatType>
+void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns,
+                                             const MatType& queries) const
 {
   if (ns->SearchMode() == DUAL_TREE_MODE)
   {
     std::vector<size_t> oldFromNewQueries;
-    typename NSType::Tree queryTree(std::move(querySet), oldFromNewQueries,
+    typename NSType::Tree queryTree(std::move(queries), oldFromNewQueries,
         leafSize);
 
     arma::Mat<size_t> neighborsOut;
@@ -135,7 +156,7 @@ void BiSearchVisitor<SortPolicy>::SearchLeaf(NSType* ns) const
     }
   }
   else
-    ns->Search(querySet, k, neighbors, distances);
+    ns->Search(queries, k, neighbors, distances);
 }
 
 //! Save parameters for Train.
@@ -167,7 +188,7 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::KDTree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -176,7 +197,7 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::BallTree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
   throw std::runtime_error("no neighbor search model initialized");
 }
 
@@ -203,21 +224,50 @@ template<typename SortPolicy>
 void TrainVisitor<SortPolicy>::operator()(NSTypeT<tree::Octree>* ns) const
 {
   if (ns)
-    return TrainLeaf(ns);
+    return TrainLeaf(ns, std::move(referenceSet));
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train single-precision KDTrees.
+template<typename SortPolicy>
+void TrainVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const
+{
+  if (ns)
+  {
+    arma::fmat references = arma::conv_to<arma::fmat>::from(referenceSet);
+    referenceSet.reset();
+    return TrainLeaf(ns, std::move(references));
+  }
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Train single-precision BallTrees.
+template<typename SortPolicy>
+void TrainVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const
+{
+  if (ns)
+  {
+    arma::fmat references = arma::conv_to<arma::fmat>::from(referenceSet);
+    referenceSet.reset();
+    return TrainLeaf(ns, std::move(references));
+  }
   throw std::runtime_error("no neighbor search model initialized");
 }
 
 //! Train on the given NSType considering the leafSize.
 template<typename SortPolicy>
-template<typename NSType>
-void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns) const
+template<typename NSType, typename MatType>
+void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns, MatType&& references)
+    const
 {
   if (ns->SearchMode() == NAIVE_MODE)
-    ns->Train(std::move(referenceSet));
+    ns->Train(std::move(references));
   else
   {
     std::vector<size_t> oldFromNewReferences;
-    typename NSType::Tree referenceTree(std::move(referenceSet),
+    typename NSType::Tree referenceTree(std::move(references),
         oldFromNewReferences, leafSize);
     ns->Train(std::move(referenceTree));
     // Set the mappings.
@@ -225,6 +275,68 @@ void TrainVisitor<SortPolicy>::TrainLeaf(NSType* ns) const
   }
 }
 
+//! Save parameters for SaveTree.
+template<typename SortPolicy>
+SaveTreeVisitor<SortPolicy>::SaveTreeVisitor(const std::string& filename) :
+    filename(filename)
+{}
+
+//! Throw for NSTypes that can't be saved to a flat tree file.
+template<typename SortPolicy>
+template<typename NSType>
+void SaveTreeVisitor<SortPolicy>::operator()(NSType* /* ns */) const
+{
+  throw std::invalid_argument("NSModel::SaveTree(): only kd-trees and ball "
+      "trees can be saved to a flat tree file");
+}
+
+//! Save the reference tree of a kd-tree NSType.
+template<typename SortPolicy>
+void SaveTreeVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree>* ns) const
+{
+  SaveLeaf(ns);
+}
+
+//! Save the reference tree of a ball tree NSType.
+template<typename SortPolicy>
+void SaveTreeVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::BallTree>* ns) const
+{
+  SaveLeaf(ns);
+}
+
+//! Save the reference tree of a single-precision kd-tree NSType.
+template<typename SortPolicy>
+void SaveTreeVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::KDTree, arma::fmat>* ns) const
+{
+  SaveLeaf(ns);
+}
+
+//! Save the reference tree of a single-precision ball tree NSType.
+template<typename SortPolicy>
+void SaveTreeVisitor<SortPolicy>::operator()(
+    NSType<SortPolicy, tree::BallTree, arma::fmat>* ns) const
+{
+  SaveLeaf(ns);
+}
+
+//! Save the reference tree of the given NSType.
+template<typename SortPolicy>
+template<typename NSType>
+void SaveTreeVisitor<SortPolicy>::SaveLeaf(const NSType* ns) const
+{
+  if (!ns)
+    throw std::runtime_error("no neighbor search model initialized");
+  if (ns->SearchMode() == NAIVE_MODE)
+    throw std::invalid_argument("NSModel::SaveTree(): a model that uses "
+        "naive search has no tree to save");
+
+  tree::FlatTreeFile<typename NSType::Tree>::Save(filename,
+      ns->ReferenceTree(), ns->OldFromNewReferences());
+}
+
 //! Return the search mode.
 template<typename NSType>
 NeighborSearchMode& SearchModeVisitor::operator()(NSType* ns) const
@@ -252,6 +364,36 @@ const arma::mat& ReferenceSetVisitor::operator()(NSType* ns) const
   throw std::runtime_error("no neighbor search model initialized");
 }
 
+//! Single-precision models have no double-precision reference set.
+template<typename SortPolicy,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+const arma::mat& ReferenceSetVisitor::operator()(
+    NSType<SortPolicy, TreeType, arma::fmat>* /* ns */) const
+{
+  throw std::invalid_argument("NSModel::Dataset(): the model holds "
+      "single-precision data; use Dimensionality() and NumPoints() instead");
+}
+
+//! Return the dimensionality of the reference set.
+template<typename NSType>
+size_t DimensionalityVisitor::operator()(NSType* ns) const
+{
+  if (ns)
+    return ns->ReferenceSet().n_rows;
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Return the number of points in the reference set.
+template<typename NSType>
+size_t NumPointsVisitor::operator()(NSType* ns) const
+{
+  if (ns)
+    return ns->ReferenceSet().n_cols;
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
 //! Clean memory, if necessary.
 template<typename NSType>
 void DeleteVisitor::operator()(NSType* ns) const
@@ -270,7 +412,8 @@ NSModel<SortPolicy>::NSModel(TreeTypes treeType, bool randomBasis) :
     leafSize(20),
     tau(0),
     rho(0.7),
-    randomBasis(randomBasis)
+    randomBasis(randomBasis),
+    singlePrecision(false)
 {
   // Nothing to do.
 }
@@ -283,7 +426,9 @@ NSModel<SortPolicy>::NSModel(const NSModel& other) :
     rho(other.rho),
     randomBasis(other.randomBasis),
     q(other.q),
-    nSearch(other.nSearch)
+    singlePrecision(other.singlePrecision),
+    nSearch(other.nSearch),
+    treeFile(other.treeFile)
 {
   // Nothing to do.
 }
@@ -296,7 +441,9 @@ NSModel<SortPolicy>::NSModel(NSModel&& other) :
     rho(other.rho),
     randomBasis(other.randomBasis),
     q(std::move(other.q)),
-    nSearch(other.nSearch)
+    singlePrecision(other.singlePrecision),
+    nSearch(other.nSearch),
+    treeFile(std::move(other.treeFile))
 {
   // Reset parameters of the other model.
   other.treeType = TreeTypes::KD_TREE;
@@ -304,6 +451,7 @@ NSModel<SortPolicy>::NSModel(NSModel&& other) :
   other.tau = 0;
   other.rho = 0.7;
   other.randomBasis = false;
+  other.singlePrecision = false;
   other.nSearch = decltype(other.nSearch)();
 }
 
@@ -318,7 +466,9 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(const NSModel& other)
   rho = other.rho;
   randomBasis = other.randomBasis;
   q = other.q;
+  singlePrecision = other.singlePrecision;
   nSearch = other.nSearch;
+  treeFile = other.treeFile;
 
   return *this;
 }
@@ -334,8 +484,10 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(NSModel&& other)
   rho = other.rho;
   randomBasis = other.randomBasis;
   q = std::move(other.q);
+  singlePrecision = other.singlePrecision;
   // Copy the pointer and type.
   nSearch = other.nSearch;
+  treeFile = std::move(other.treeFile);
 
   // Reset parameters of the other model.
   other.treeType = TreeTypes::KD_TREE;
@@ -343,6 +495,7 @@ NSModel<SortPolicy>& NSModel<SortPolicy>::operator=(NSModel&& other)
   other.tau = 0;
   other.rho = 0.7;
   other.randomBasis = false;
+  other.singlePrecision = false;
   other.nSearch = decltype(other.nSearch)();
 
   return *this;
@@ -362,6 +515,7 @@ NSModel<SortPolicy>::~NSModel()
  */
 template<typename Archive,
          typename SortPolicy,
+         typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType,
@@ -371,7 +525,7 @@ void serialize(
     Archive& ar,
     NeighborSearch<SortPolicy,
                    metric::EuclideanDistance,
-                   arma::mat,
+                   MatType,
                    TreeType,
                    TraversalType,
                    SingleTreeTraversalType>& ns,
@@ -396,10 +550,18 @@ void NSModel<SortPolicy>::Serialize(Archive& ar, const unsigned int version)
   }
   ar & data::CreateNVP(randomBasis, "randomBasis");
   ar & data::CreateNVP(q, "q");
+  // Older versions of NSModel only held double-precision data.
+  if (version > 1)
+    ar & data::CreateNVP(singlePrecision, "singlePrecision");
+  else if (Archive::is_loading::value)
+    singlePrecision = false;
 
   // This should never happen, but just in case, be clean with memory.
   if (Archive::is_loading::value)
+  {
     boost::apply_visitor(DeleteVisitor(), nSearch);
+    treeFile.reset();
+  }
 
   const std::string& name = NSModelName<SortPolicy>::Name();
   ar & data::CreateNVP(nSearch, name);
@@ -412,6 +574,20 @@ const arma::mat& NSModel<SortPolicy>::Dataset() const
   return boost::apply_visitor(ReferenceSetVisitor(), nSearch);
 }
 
+//! Get the dimensionality of the reference set.
+template<typename SortPolicy>
+size_t NSModel<SortPolicy>::Dimensionality() const
+{
+  return boost::apply_visitor(DimensionalityVisitor(), nSearch);
+}
+
+//! Get the number of points in the reference set.
+template<typename SortPolicy>
+size_t NSModel<SortPolicy>::NumPoints() const
+{
+  return boost::apply_visitor(NumPointsVisitor(), nSearch);
+}
+
 //! Access the search mode.
 template<typename SortPolicy>
 NeighborSearchMode NSModel<SortPolicy>::SearchMode() const
@@ -445,6 +621,11 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
                                      const NeighborSearchMode searchMode,
                                      const double epsilon)
 {
+  // Only the kd-tree and the ball tree hold single-precision data.
+  if (singlePrecision && treeType != KD_TREE && treeType != BALL_TREE)
+    throw std::invalid_argument("NSModel::BuildModel(): single-precision "
+        "data is only supported with kd-trees and ball trees");
+
   this->leafSize = leafSize;
   // Initialize random basis if necessary.
   if (randomBasis)
@@ -480,6 +661,7 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
 
   // Clean memory, if necessary.
   boost::apply_visitor(DeleteVisitor(), nSearch);
+  treeFile.reset();
 
   // Do we need to modify the reference set?
   if (randomBasis)
@@ -494,7 +676,11 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   switch (treeType)
   {
     case KD_TREE:
-      nSearch = new NSType<SortPolicy, tree::KDTree>(searchMode, epsilon);
+      if (singlePrecision)
+        nSearch = new NSType<SortPolicy, tree::KDTree, arma::fmat>(searchMode,
+            epsilon);
+      else
+        nSearch = new NSType<SortPolicy, tree::KDTree>(searchMode, epsilon);
       break;
     case COVER_TREE:
       nSearch = new NSType<SortPolicy, tree::StandardCoverTree>(searchMode,
@@ -507,7 +693,11 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
       nSearch = new NSType<SortPolicy, tree::RStarTree>(searchMode, epsilon);
       break;
     case BALL_TREE:
-      nSearch = new NSType<SortPolicy, tree::BallTree>(searchMode, epsilon);
+      if (singlePrecision)
+        nSearch = new NSType<SortPolicy, tree::BallTree, arma::fmat>(
+            searchMode, epsilon);
+      else
+        nSearch = new NSType<SortPolicy, tree::BallTree>(searchMode, epsilon);
       break;
     case X_TREE:
       nSearch = new NSType<SortPolicy, tree::XTree>(searchMode, epsilon);
@@ -552,6 +742,76 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   }
 }
 
+//! Save the reference tree to a flat tree file.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::SaveTree(const std::string& filename) const
+{
+  // The random basis is not stored in the file.
+  if (randomBasis)
+    throw std::invalid_argument("NSModel::SaveTree(): models with a random "
+        "basis can't be saved to a flat tree file");
+
+  boost::apply_visitor(SaveTreeVisitor<SortPolicy>(filename), nSearch);
+}
+
+//! Build the model from a flat tree file.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::LoadTree(const std::string& filename,
+                                   const NeighborSearchMode searchMode,
+                                   const double epsilon)
+{
+  if (randomBasis)
+    throw std::invalid_argument("NSModel::LoadTree(): models with a random "
+        "basis can't be loaded from a flat tree file");
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      if (singlePrecision)
+        LoadFlatTree<NSType<SortPolicy, tree::KDTree, arma::fmat>>(filename,
+            searchMode, epsilon);
+      else
+        LoadFlatTree<NSType<SortPolicy, tree::KDTree>>(filename, searchMode,
+            epsilon);
+      break;
+    case BALL_TREE:
+      if (singlePrecision)
+        LoadFlatTree<NSType<SortPolicy, tree::BallTree, arma::fmat>>(filename,
+            searchMode, epsilon);
+      else
+        LoadFlatTree<NSType<SortPolicy, tree::BallTree>>(filename, searchMode,
+            epsilon);
+      break;
+    default:
+      throw std::invalid_argument("NSModel::LoadTree(): only kd-trees and "
+          "ball trees can be loaded from a flat tree file");
+  }
+}
+
+//! Load the reference tree of the given NSType from a flat tree file.
+template<typename SortPolicy>
+template<typename NSImplType>
+void NSModel<SortPolicy>::LoadFlatTree(const std::string& filename,
+                                       const NeighborSearchMode searchMode,
+                                       const double epsilon)
+{
+  typedef tree::FlatTreeFile<typename NSImplType::Tree> FileType;
+
+  Timer::Start("loading_tree");
+  std::shared_ptr<FileType> file(new FileType(filename));
+  Timer::Stop("loading_tree");
+
+  // Clean memory, if necessary.  The old tree may use the old file.
+  boost::apply_visitor(DeleteVisitor(), nSearch);
+  treeFile.reset();
+
+  NSImplType* ns = new NSImplType(std::move(file->Tree()), searchMode,
+      epsilon);
+  ns->OldFromNewReferences() = file->OldFromNew();
+  nSearch = ns;
+  treeFile = file;
+}
+
 //! Perform neighbor search.  The query set will be reordered.
 template<typename SortPolicy>
 void NSModel<SortPolicy>::Search(arma::mat&& querySet,
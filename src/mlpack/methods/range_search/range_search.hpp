@@ -17,12 +17,14 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include "range_search_stat.hpp"
+#include "range_search_results.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
 
-//! Forward declaration.
+//! Forward declarations.
 class TrainVisitor;
+class RSModel;
 
 /**
  * The RangeSearch class is a template class for performing range searches.  It
@@ -31,7 +33,9 @@ class TrainVisitor;
  * class.
  *
  * @tparam MetricType Metric to use for range search calculations.
- * @tparam MatType Type of data to use.
+ * @tparam MatType Type of data to use.  Single-precision data (arma::fmat) may
+ *     be used with trees that have double-precision bounds, such as the
+ *     kd-tree; distances are still returned as doubles.
  * @tparam TreeType Type of tree to use; must satisfy the TreeType policy API.
  */
 template<typename MetricType = metric::EuclideanDistance,
@@ -299,6 +303,110 @@ class RangeSearch
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Count the reference points in the given range for each point in the query
+   * set, without storing the reference points themselves.  Reference nodes
+   * that fall entirely into the range are counted without evaluating any
+   * distances, so this is faster than a full search too.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of reference points in the
+   *      given range of each query point.
+   */
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              arma::Col<size_t>& counts);
+
+  /**
+   * Count the points in the given range for each point in the reference set,
+   * without storing the points themselves.  A point is not counted in its own
+   * range.
+   *
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of points in the given
+   *      range of each point of the reference set.
+   */
+  void Search(const math::Range& range, arma::Col<size_t>& counts);
+
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, and pass the results of each query point to the given sink as
+   * soon as they are available.  The query points are searched in batches of
+   * batchSize points, so only the results of a few batches are held in memory
+   * at any time.  The sink is called once for each query point, in order, as
+   *
+   * @code
+   * sink(queryIndex, neighbors, distances);
+   * @endcode
+   *
+   * where neighbors and distances are the std::vector<size_t> and
+   * std::vector<double> of the results of that query point, sorted by
+   * neighbor index.  They are only valid during the call.  After the search,
+   * BaseCases() and Scores() hold the totals of all batches.
+   *
+   * If OpenMP is available, one batch per thread is searched at the same time,
+   * so the results of up to that many batches are held in memory; the sink is
+   * still only called from the calling thread, in order.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param sink Callable object which receives the results of each query point.
+   * @param batchSize Number of query points to search at once.
+   */
+  template<typename SinkType>
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              SinkType&& sink,
+              const size_t batchSize = 10000);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, and pass the results of each point to the given sink as soon as they
+   * are available, in the same way as the overload above.  A point is not
+   * returned in its own results.
+   *
+   * @param range Range of distances in which to search.
+   * @param sink Callable object which receives the results of each point.
+   * @param batchSize Number of points to search at once.
+   */
+  template<typename SinkType>
+  void Search(const math::Range& range,
+              SinkType&& sink,
+              const size_t batchSize = 10000);
+
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, storing the results in the given compressed container, sorted
+   * by neighbor index.  The query points are searched in batches of batchSize
+   * points, so apart from the container itself only the results of a few
+   * batches are held in memory at any time.  Any previous results in the
+   * container are removed.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param results Container which will hold the results.
+   * @param batchSize Number of query points to search at once.
+   */
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              RangeSearchResults& results,
+              const size_t batchSize = 10000);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, storing the results in the given compressed container, sorted by
+   * neighbor index.  A point is not returned in its own results.  Any previous
+   * results in the container are removed.
+   *
+   * @param range Range of distances in which to search.
+   * @param results Container which will hold the results.
+   * @param batchSize Number of points to search at once.
+   */
+  void Search(const math::Range& range,
+              RangeSearchResults& results,
+              const size_t batchSize = 10000);
+
   //! Get whether single-tree search is being used.
   bool SingleMode() const { return singleMode; }
   //! Modify whether single-tree search is being used.
@@ -324,6 +432,11 @@ class RangeSearch
   //! Return the reference tree (or NULL if in naive mode).
   Tree* ReferenceTree() { return referenceTree; }
 
+  //! Access the mapping from the indices of the points in the reference tree
+  //! to their original indices (empty if this object did not build the tree).
+  const std::vector<size_t>& OldFromNewReferences() const
+  { return oldFromNewReferences; }
+
  private:
   //! Mappings to old reference indices (used when this object builds trees).
   std::vector<size_t> oldFromNewReferences;
@@ -351,8 +464,118 @@ class RangeSearch
   //! The total number of scores during the last search.
   size_t scores;
 
+  /**
+   * Run single-tree range search on the reference tree for each query point of
+   * the given rules object.  The rules are copied for the traversal, and the
+   * copies store their results in the same place as the given rules (which
+   * must already have room for each query point).  If OpenMP is available and
+   * the tree type allows it, the query points are split between threads, each
+   * with its own copy of the rules.  The number of base cases and scores is
+   * added to the counts held by this object.
+   *
+   * @param numQueries Number of query points.
+   * @param prototypeRules Rules object to copy for the traversal.
+   */
+  template<typename RuleType>
+  void SingleTreeSearch(const size_t numQueries,
+                        const RuleType& prototypeRules);
+
+  /**
+   * The results of one batch of query points in compressed sparse row form,
+   * and the buffers used to find them.  The buffers are reused for every batch
+   * searched with the same object.
+   */
+  struct BatchResults
+  {
+    //! The offset of the first result of each query point of the batch, and
+    //! the total number of results at the end.
+    std::vector<size_t> offsets;
+    //! The neighbors of each query point, sorted by index.
+    std::vector<size_t> neighbors;
+    //! The distances to each neighbor.
+    std::vector<double> distances;
+
+    //! The query index of each result, in the order the rules found them.
+    std::vector<size_t> foundQueries;
+    //! The reference index of each result, in the order the rules found them.
+    std::vector<size_t> foundNeighbors;
+    //! The distance of each result, in the order the rules found them.
+    std::vector<double> foundDistances;
+    //! Scratch space for sorting the results of one query point.
+    std::vector<std::pair<size_t, double>> sortScratch;
+
+    //! The number of base cases of the batch.
+    size_t baseCases;
+    //! The number of scores of the batch.
+    size_t scores;
+  };
+
+  /**
+   * Search the given query set in batches of batchSize points, and pass the
+   * results of each batch to the given function, in order, as
+   *
+   * @code
+   * handleBatch(begin, results);
+   * @endcode
+   *
+   * where begin is the index of the first point of the batch and results is
+   * the BatchResults object of the batch.  If OpenMP is available, the batches
+   * are searched in rounds of one batch per thread.  If sameSet is true, the
+   * query set must be the reference set; each point is then removed from its
+   * own results.
+   *
+   * @param querySet Set of query points to search with.
+   * @param sameSet Whether the query set is the reference set.
+   * @param range Range of distances in which to search.
+   * @param batchSize Number of query points in each batch.
+   * @param handleBatch Callable object which receives the results of each
+   *     batch.
+   */
+  template<typename BatchFunctionType>
+  void SearchInBatches(const MatType& querySet,
+                       const bool sameSet,
+                       const math::Range& range,
+                       const size_t batchSize,
+                       BatchFunctionType&& handleBatch);
+
+  /**
+   * Search for all reference points in the given range for each point of one
+   * batch of query points.  The rules append the results to flat buffers,
+   * which are then grouped into compressed sparse row form by query point
+   * with a counting sort; the neighbors have their original reference indices
+   * and are sorted by index.  This does not modify the object (or the timers),
+   * so several batches may be searched at the same time.
+   *
+   * @param batch Batch of query points.
+   * @param firstIndex Index of the first point of the batch in the query set.
+   * @param sameSet Whether the query set is the reference set; if so, each
+   *     point is skipped in its own results.
+   * @param range Range of distances in which to search.
+   * @param results Object to store the results of the batch in.
+   */
+  void SearchBatch(const MatType& batch,
+                   const size_t firstIndex,
+                   const bool sameSet,
+                   const math::Range& range,
+                   BatchResults& results) const;
+
+  /**
+   * Sort the results of one query point by neighbor index.
+   *
+   * @param neighbors Neighbors of the query point.
+   * @param distances Distances to each neighbor.
+   * @param numResults Number of neighbors.
+   * @param scratch Scratch space for the sort.
+   */
+  static void SortByNeighbor(size_t* neighbors,
+                             double* distances,
+                             const size_t numResults,
+                             std::vector<std::pair<size_t, double>>& scratch);
+
   //! For access to mappings when building models.
   friend class TrainVisitor;
+  //! For access to mappings when loading trees from flat tree files.
+  friend class RSModel;
 };
 
 } // namespace range
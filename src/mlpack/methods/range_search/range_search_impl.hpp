@@ -480,17 +480,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
   else if (singleMode)
   {
-    // Create the traverser.
+    // Traverse for each point.
     RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
         metric);
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases += rules.BaseCases();
-    scores += rules.Scores();
+    SingleTreeSearch(querySet.n_cols, rules);
   }
   else // Dual-tree recursion.
   {
@@ -706,15 +699,10 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases = rules.BaseCases();
-    scores = rules.Scores();
+    // Traverse for each point.
+    baseCases = 0;
+    scores = 0;
+    SingleTreeSearch(referenceSet->n_cols, rules);
   }
   else // Dual-tree recursion.
   {
@@ -757,6 +745,585 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  counts.zeros(querySet.n_cols);
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+
+  // Reset counts.
+  baseCases = 0;
+  scores = 0;
+
+  // Only query indices may need to be mapped; the reference points are never
+  // stored.
+  if (naive)
+  {
+    RuleType rules(*referenceSet, querySet, range, counts, metric);
+
+    // The naive brute-force solution.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    baseCases += (querySet.n_cols * referenceSet->n_cols);
+  }
+  else if (singleMode)
+  {
+    RuleType rules(*referenceSet, querySet, range, counts, metric);
+    SingleTreeSearch(querySet.n_cols, rules);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    std::vector<size_t> oldFromNewQueries;
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    arma::Col<size_t> treeCounts(querySet.n_cols, arma::fill::zeros);
+    RuleType rules(*referenceSet, queryTree->Dataset(), range, treeCounts,
+        metric);
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+
+    if (tree::TreeTraits<Tree>::RearrangesDataset)
+    {
+      for (size_t i = 0; i < treeCounts.n_elem; ++i)
+        counts[oldFromNewQueries[i]] = treeCounts[i];
+    }
+    else
+    {
+      counts = treeCounts;
+    }
+
+    delete queryTree;
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  counts.zeros(referenceSet->n_cols);
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+    return;
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // If we built the tree, the counts are in the order of the tree's dataset and
+  // have to be mapped back.
+  const bool mapCounts = treeOwner && tree::TreeTraits<Tree>::RearrangesDataset;
+  arma::Col<size_t> treeCounts;
+  if (mapCounts)
+    treeCounts.zeros(referenceSet->n_cols);
+
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  RuleType rules(*referenceSet, *referenceSet, range,
+      (mapCounts ? treeCounts : counts), metric,
+      true /* don't count the query in the results */);
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    baseCases = (referenceSet->n_cols * referenceSet->n_cols);
+    scores = 0;
+  }
+  else if (singleMode)
+  {
+    baseCases = 0;
+    scores = 0;
+    SingleTreeSearch(referenceSet->n_cols, rules);
+  }
+  else // Dual-tree recursion.
+  {
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*referenceTree, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  if (mapCounts)
+  {
+    for (size_t i = 0; i < treeCounts.n_elem; ++i)
+      counts[oldFromNewReferences[i]] = treeCounts[i];
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename SinkType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    SinkType&& sink,
+    const size_t batchSize)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The results of each point are copied out of the batch into these vectors,
+  // which are reused for every point.
+  std::vector<size_t> neighbors;
+  std::vector<double> distances;
+  SearchInBatches(querySet, false, range, batchSize,
+      [&](const size_t begin, const BatchResults& results)
+      {
+        for (size_t i = 0; i + 1 < results.offsets.size(); ++i)
+        {
+          neighbors.assign(results.neighbors.begin() + results.offsets[i],
+              results.neighbors.begin() + results.offsets[i + 1]);
+          distances.assign(results.distances.begin() + results.offsets[i],
+              results.distances.begin() + results.offsets[i + 1]);
+          sink(begin + i, neighbors, distances);
+        }
+      });
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename SinkType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    SinkType&& sink,
+    const size_t batchSize)
+{
+  std::vector<size_t> neighbors;
+  std::vector<double> distances;
+  SearchInBatches(*referenceSet, true, range, batchSize,
+      [&](const size_t begin, const BatchResults& results)
+      {
+        for (size_t i = 0; i + 1 < results.offsets.size(); ++i)
+        {
+          neighbors.assign(results.neighbors.begin() + results.offsets[i],
+              results.neighbors.begin() + results.offsets[i + 1]);
+          distances.assign(results.distances.begin() + results.offsets[i],
+              results.distances.begin() + results.offsets[i + 1]);
+          sink(begin + i, neighbors, distances);
+        }
+      });
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    RangeSearchResults& results,
+    const size_t batchSize)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The batches are already in compressed form, so the results of each point
+  // are appended straight from them.
+  results.Clear();
+  SearchInBatches(querySet, false, range, batchSize,
+      [&results](const size_t /* begin */, const BatchResults& batchResults)
+      {
+        for (size_t i = 0; i + 1 < batchResults.offsets.size(); ++i)
+        {
+          const size_t offset = batchResults.offsets[i];
+          results.Append(batchResults.neighbors.data() + offset,
+              batchResults.distances.data() + offset,
+              batchResults.offsets[i + 1] - offset);
+        }
+      });
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    RangeSearchResults& results,
+    const size_t batchSize)
+{
+  results.Clear();
+  SearchInBatches(*referenceSet, true, range, batchSize,
+      [&results](const size_t /* begin */, const BatchResults& batchResults)
+      {
+        for (size_t i = 0; i + 1 < batchResults.offsets.size(); ++i)
+        {
+          const size_t offset = batchResults.offsets[i];
+          results.Append(batchResults.neighbors.data() + offset,
+              batchResults.distances.data() + offset,
+              batchResults.offsets[i + 1] - offset);
+        }
+      });
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename BatchFunctionType>
+void RangeSearch<MetricType, MatType, TreeType>::SearchInBatches(
+    const MatType& querySet,
+    const bool sameSet,
+    const math::Range& range,
+    const size_t batchSize,
+    BatchFunctionType&& handleBatch)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("RangeSearch::Search(): batchSize must be "
+        "positive");
+
+  // If the query set is the reference set and we built the tree, the reference
+  // set has been rearranged, so the batches are gathered in the original order
+  // of the points, which is the order the results are returned in.
+  const bool mapped = sameSet && treeOwner &&
+      tree::TreeTraits<Tree>::RearrangesDataset;
+  std::vector<size_t> newFromOld;
+  if (mapped)
+  {
+    newFromOld.resize(oldFromNewReferences.size());
+    for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+      newFromOld[oldFromNewReferences[i]] = i;
+  }
+
+  // The batches are searched in rounds of one batch per thread.  Trees with
+  // self-children (i.e. cover trees) have their distance evaluations cached in
+  // the reference nodes by the rules, so for those only one batch is searched
+  // at a time.  The buffers of each batch are reused in every round.
+  size_t roundBatches = 1;
+#ifdef HAS_OPENMP
+  if (!tree::TreeTraits<Tree>::HasSelfChildren)
+    roundBatches = omp_get_max_threads();
+#endif
+  std::vector<BatchResults> results(roundBatches);
+
+  Timer::Start("range_search/computing_neighbors");
+
+  baseCases = 0;
+  scores = 0;
+  const size_t numPoints = querySet.n_cols;
+  for (size_t roundBegin = 0; roundBegin < numPoints;
+      roundBegin += roundBatches * batchSize)
+  {
+    const size_t numBatches = std::min(roundBatches,
+        (numPoints - roundBegin + batchSize - 1) / batchSize);
+
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (intmax_t b = 0; b < (intmax_t) numBatches; ++b)
+#else
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBatches; ++b)
+#endif
+    {
+      const size_t begin = roundBegin + b * batchSize;
+      const size_t end = std::min(begin + batchSize, numPoints);
+      MatType batch(querySet.n_rows, end - begin);
+      for (size_t i = 0; i < batch.n_cols; ++i)
+        batch.col(i) = querySet.col(mapped ? newFromOld[begin + i] :
+            begin + i);
+
+      SearchBatch(batch, begin, sameSet, range, results[b]);
+    }
+
+    // Now hand the results of the round on, in order.
+    for (size_t b = 0; b < numBatches; ++b)
+    {
+      baseCases += results[b].baseCases;
+      scores += results[b].scores;
+      handleBatch(roundBegin + b * batchSize, results[b]);
+    }
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::SearchBatch(
+    const MatType& batch,
+    const size_t firstIndex,
+    const bool sameSet,
+    const math::Range& range,
+    BatchResults& results) const
+{
+  results.foundQueries.clear();
+  results.foundNeighbors.clear();
+  results.foundDistances.clear();
+  results.baseCases = 0;
+  results.scores = 0;
+
+  // The rules take a non-const metric, so each batch gets its own copy.  They
+  // append the results to the flat vectors in the order they are found.
+  MetricType batchMetric(metric);
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+
+  // If there are no points, there is no search to be done.
+  if (referenceSet->n_cols == 0)
+  {
+    results.offsets.assign(batch.n_cols + 1, 0);
+    results.neighbors.clear();
+    results.distances.clear();
+    return;
+  }
+
+  // The batch index of each query index used by the rules, if the query tree
+  // rearranges the batch.
+  std::vector<size_t> oldFromNewQueries;
+
+  if (naive)
+  {
+    RuleType rules(*referenceSet, batch, range, results.foundQueries,
+        results.foundNeighbors, results.foundDistances, batchMetric);
+
+    // The naive brute-force solution.
+    for (size_t i = 0; i < batch.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    results.baseCases = batch.n_cols * referenceSet->n_cols;
+  }
+  else if (singleMode)
+  {
+    RuleType rules(*referenceSet, batch, range, results.foundQueries,
+        results.foundNeighbors, results.foundDistances, batchMetric);
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+    for (size_t i = 0; i < batch.n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    results.baseCases = rules.BaseCases();
+    results.scores = rules.Scores();
+  }
+  else // Dual-tree recursion.
+  {
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(batch),
+        oldFromNewQueries);
+
+    RuleType rules(*referenceSet, queryTree->Dataset(), range,
+        results.foundQueries, results.foundNeighbors, results.foundDistances,
+        batchMetric);
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    results.baseCases = rules.BaseCases();
+    results.scores = rules.Scores();
+
+    delete queryTree;
+  }
+
+  // Now group the results by query point with a counting sort, mapping the
+  // query and reference indices back to the batch and to the original
+  // reference set as we go.  If the batch is part of the reference set, each
+  // point is skipped in its own results.
+  const bool mapQueries = !oldFromNewQueries.empty();
+  const bool mapReferences = treeOwner &&
+      tree::TreeTraits<Tree>::RearrangesDataset;
+  const size_t numFound = results.foundQueries.size();
+  for (size_t r = 0; r < numFound; ++r)
+  {
+    if (mapQueries)
+      results.foundQueries[r] = oldFromNewQueries[results.foundQueries[r]];
+    if (mapReferences)
+      results.foundNeighbors[r] = oldFromNewReferences[
+          results.foundNeighbors[r]];
+    if (sameSet && results.foundNeighbors[r] ==
+        firstIndex + results.foundQueries[r])
+      results.foundQueries[r] = batch.n_cols; // Mark the result as skipped.
+  }
+
+  results.offsets.assign(batch.n_cols + 1, 0);
+  for (size_t r = 0; r < numFound; ++r)
+    if (results.foundQueries[r] < batch.n_cols)
+      ++results.offsets[results.foundQueries[r] + 1];
+  for (size_t i = 0; i < batch.n_cols; ++i)
+    results.offsets[i + 1] += results.offsets[i];
+
+  results.neighbors.resize(results.offsets[batch.n_cols]);
+  results.distances.resize(results.offsets[batch.n_cols]);
+  for (size_t r = 0; r < numFound; ++r)
+  {
+    // The offset of each query point is moved past each of its results, and
+    // moved back afterwards.
+    const size_t query = results.foundQueries[r];
+    if (query < batch.n_cols)
+    {
+      const size_t position = results.offsets[query]++;
+      results.neighbors[position] = results.foundNeighbors[r];
+      results.distances[position] = results.foundDistances[r];
+    }
+  }
+  for (size_t i = batch.n_cols; i > 0; --i)
+    results.offsets[i] = results.offsets[i - 1];
+  results.offsets[0] = 0;
+
+  // Finally, sort the results of each query point by neighbor index.
+  for (size_t i = 0; i < batch.n_cols; ++i)
+  {
+    SortByNeighbor(results.neighbors.data() + results.offsets[i],
+        results.distances.data() + results.offsets[i],
+        results.offsets[i + 1] - results.offsets[i], results.sortScratch);
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename RuleType>
+void RangeSearch<MetricType, MatType, TreeType>::SingleTreeSearch(
+    const size_t numQueries,
+    const RuleType& prototypeRules)
+{
+#ifdef HAS_OPENMP
+  // Trees with self-children (i.e. cover trees) have their distance evaluations
+  // cached in the reference nodes by the rules, so they cannot be searched in
+  // parallel.
+  if (omp_get_max_threads() > 1 && !tree::TreeTraits<Tree>::HasSelfChildren)
+  {
+    size_t parallelScores = 0;
+    size_t parallelBaseCases = 0;
+
+    #pragma omp parallel reduction(+:parallelScores, parallelBaseCases)
+    {
+      // Each thread only touches the results of its own query points, so all
+      // of the rules can write into the same results.
+      RuleType rules(prototypeRules);
+      typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+#ifdef _WIN32
+      // Visual Studio only implements OpenMP 2.0, which doesn't support
+      // unsigned loop variables.
+      #pragma omp for schedule(dynamic)
+      for (intmax_t i = 0; i < (intmax_t) numQueries; ++i)
+#else
+      #pragma omp for schedule(dynamic)
+      for (size_t i = 0; i < numQueries; ++i)
+#endif
+        traverser.Traverse(i, *referenceTree);
+
+      parallelScores += rules.Scores();
+      parallelBaseCases += rules.BaseCases();
+    }
+
+    scores += parallelScores;
+    baseCases += parallelBaseCases;
+    return;
+  }
+#endif
+
+  RuleType rules(prototypeRules);
+  typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+  // Now have it traverse for each point.
+  for (size_t i = 0; i < numQueries; ++i)
+    traverser.Traverse(i, *referenceTree);
+
+  baseCases += rules.BaseCases();
+  scores += rules.Scores();
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::SortByNeighbor(
+    size_t* neighbors,
+    double* distances,
+    const size_t numResults,
+    std::vector<std::pair<size_t, double>>& scratch)
+{
+  if (std::is_sorted(neighbors, neighbors + numResults))
+    return;
+
+  scratch.resize(numResults);
+  for (size_t i = 0; i < numResults; ++i)
+    scratch[i] = std::make_pair(neighbors[i], distances[i]);
+  std::sort(scratch.begin(), scratch.end());
+
+  for (size_t i = 0; i < numResults; ++i)
+  {
+    neighbors[i] = scratch[i].first;
+    distances[i] = scratch[i].second;
+  }
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
@@ -82,6 +82,15 @@ PARAM_INT_IN("leaf_size", "Leaf size for tree building (used for kd-trees, "
     "Hilbert R trees, R+ trees, R++ trees, and octrees).", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
+PARAM_FLAG("single_precision", "Hold the reference data in single precision, "
+    "which halves the memory it takes (only valid for kd-trees and ball "
+    "trees).", "P");
+PARAM_STRING_IN("input_tree_file", "File containing a reference tree saved "
+    "with --output_tree_file.  The file is memory-mapped instead of building "
+    "the tree (only valid for kd-trees and ball trees).", "", "");
+PARAM_STRING_IN("output_tree_file", "If specified, the reference tree is saved "
+    "to this file in a flat format that can be memory-mapped with "
+    "--input_tree_file (only valid for kd-trees and ball trees).", "", "");
 PARAM_INT_IN("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 
 // Search settings.
@@ -104,10 +113,24 @@ int main(int argc, char *argv[])
     Log::Fatal << "Only one of --reference_file (-r) or --input_model_file (-m)"
         << " may be specified!" << endl;
 
+  // A tree file replaces both of them.
+  if (CLI::HasParam("input_tree_file") && (CLI::HasParam("reference") ||
+      CLI::HasParam("input_model")))
+    Log::Fatal << "--input_tree_file may not be specified with "
+        << "--reference_file (-r) or --input_model_file (-m)!" << endl;
+
   // A user must specify one of them...
-  if (!CLI::HasParam("reference") && !CLI::HasParam("input_model"))
-    Log::Fatal << "No model specified (--input_model_file) and no reference "
-        << "data specified (--reference_file)!  One must be provided." << endl;
+  if (!CLI::HasParam("reference") && !CLI::HasParam("input_model") &&
+      !CLI::HasParam("input_tree_file"))
+    Log::Fatal << "No model specified (--input_model_file or "
+        << "--input_tree_file) and no reference data specified "
+        << "(--reference_file)!  One must be provided." << endl;
+
+  // The random basis is not stored in tree files.
+  if (CLI::HasParam("random_basis") && (CLI::HasParam("input_tree_file") ||
+      CLI::HasParam("output_tree_file")))
+    Log::Fatal << "--random_basis (-R) may not be specified with "
+        << "--input_tree_file or --output_tree_file!" << endl;
 
   if (CLI::HasParam("input_model"))
   {
@@ -121,6 +144,9 @@ int main(int argc, char *argv[])
     if (CLI::HasParam("random_basis"))
       Log::Warn << "--random_basis (-R) will be ignored because "
           << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("single_precision"))
+      Log::Warn << "--single_precision (-P) will be ignored because "
+          << "--input_model_file is specified." << endl;
     if (CLI::HasParam("naive"))
       Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
           << "specified." << endl;
@@ -156,7 +182,7 @@ int main(int argc, char *argv[])
   RSModel rs;
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
-  if (CLI::HasParam("reference"))
+  if (CLI::HasParam("reference") || CLI::HasParam("input_tree_file"))
   {
     // Get all the parameters.
     const string treeType = CLI::GetParam<string>("tree_type");
@@ -199,15 +225,42 @@ int main(int argc, char *argv[])
     rs.TreeType() = tree;
     rs.RandomBasis() = randomBasis;
 
-    arma::mat referenceSet = std::move(CLI::GetParam<arma::mat>("reference"));
+    // Only kd-trees and ball trees can hold single-precision data.
+    const bool singlePrecision = CLI::HasParam("single_precision");
+    if (singlePrecision && tree != RSModel::KD_TREE &&
+        tree != RSModel::BALL_TREE)
+      Log::Fatal << "--single_precision (-P) is only valid for kd-trees and "
+          << "ball trees." << endl;
+    rs.SinglePrecision() = singlePrecision;
+
+    // Only kd-trees and ball trees can be stored in tree files.
+    if (CLI::HasParam("input_tree_file") && tree != RSModel::KD_TREE &&
+        tree != RSModel::BALL_TREE)
+      Log::Fatal << "--input_tree_file is only valid for kd-trees and ball "
+          << "trees." << endl;
+
+    if (CLI::HasParam("input_tree_file"))
+    {
+      const string treeFile = CLI::GetParam<string>("input_tree_file");
+      rs.LoadTree(treeFile, naive, singleMode);
 
-    Log::Info << "Loaded reference data from '"
-        << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
-        << referenceSet.n_rows << "x" << referenceSet.n_cols << ")." << endl;
+      Log::Info << "Loaded reference tree from '" << treeFile << "' ("
+          << rs.Dimensionality() << "x" << rs.NumPoints() << ")." << endl;
+    }
+    else
+    {
+      arma::mat referenceSet =
+          std::move(CLI::GetParam<arma::mat>("reference"));
 
-    const size_t leafSize = size_t(lsInt);
+      Log::Info << "Loaded reference data from '"
+          << CLI::GetUnmappedParam<arma::mat>("reference") << "' ("
+          << referenceSet.n_rows << "x" << referenceSet.n_cols << ")."
+          << endl;
 
-    rs.BuildModel(std::move(referenceSet), leafSize, naive, singleMode);
+      const size_t leafSize = size_t(lsInt);
+
+      rs.BuildModel(std::move(referenceSet), leafSize, naive, singleMode);
+    }
   }
   else
   {
@@ -216,7 +269,7 @@ int main(int argc, char *argv[])
 
     Log::Info << "Loaded range search model from '"
         << CLI::GetUnmappedParam<RSModel>("input_model") << "' ("
-        << "trained on " << rs.Dataset().n_rows << "x" << rs.Dataset().n_cols
+        << "trained on " << rs.Dimensionality() << "x" << rs.NumPoints()
         << " dataset)." << endl;
 
     // Adjust singleMode and naive if necessary.
@@ -225,6 +278,25 @@ int main(int argc, char *argv[])
     rs.LeafSize() = size_t(lsInt);
   }
 
+  // Save the reference tree, if desired.
+  if (CLI::HasParam("output_tree_file"))
+  {
+    if (rs.TreeType() != RSModel::KD_TREE &&
+        rs.TreeType() != RSModel::BALL_TREE)
+      Log::Fatal << "--output_tree_file is only valid for kd-trees and ball "
+          << "trees." << endl;
+    if (rs.RandomBasis())
+      Log::Fatal << "--output_tree_file is not valid for models with a random "
+          << "basis." << endl;
+    if (rs.Naive())
+      Log::Fatal << "--output_tree_file is not valid with naive search, which "
+          << "builds no tree." << endl;
+
+    const string treeFile = CLI::GetParam<string>("output_tree_file");
+    rs.SaveTree(treeFile);
+    Log::Info << "Saved reference tree to '" << treeFile << "'." << endl;
+  }
+
   // Perform search, if desired.
   if (CLI::HasParam("min") || CLI::HasParam("max"))
   {
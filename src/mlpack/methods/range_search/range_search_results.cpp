@@ -0,0 +1,124 @@
+/**
+ * @file range_search_results.cpp
+ *
+ * Implementation of the RangeSearchResults class.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#include "range_search_results.hpp"
+
+using namespace mlpack;
+using namespace mlpack::range;
+
+RangeSearchResults::RangeSearchResults(const bool deltaEncoded) :
+    deltaEncoded(deltaEncoded)
+{
+  Clear();
+}
+
+void RangeSearchResults::Clear()
+{
+  offsets.assign(1, 0);
+  indices.clear();
+  encodedOffsets.assign(1, 0);
+  encodedIndices.clear();
+  distances.clear();
+}
+
+void RangeSearchResults::Append(const std::vector<size_t>& neighbors,
+                                const std::vector<double>& distances)
+{
+  if (neighbors.size() != distances.size())
+    throw std::invalid_argument("RangeSearchResults::Append(): number of "
+        "neighbors and distances do not match");
+
+  Append(neighbors.data(), distances.data(), neighbors.size());
+}
+
+void RangeSearchResults::Append(const size_t* neighbors,
+                                const double* distances,
+                                const size_t numResults)
+{
+  for (size_t i = 1; i < numResults; ++i)
+  {
+    if (neighbors[i] < neighbors[i - 1])
+      throw std::invalid_argument("RangeSearchResults::Append(): neighbors "
+          "are not sorted");
+  }
+
+  if (deltaEncoded)
+  {
+    // Encode the difference to the previous neighbor (the first neighbor is
+    // encoded as is), seven bits at a time, lowest bits first.  The high bit
+    // of each byte is set if more bytes follow.
+    size_t last = 0;
+    for (size_t i = 0; i < numResults; ++i)
+    {
+      size_t delta = neighbors[i] - last;
+      last = neighbors[i];
+      while (delta >= 0x80)
+      {
+        encodedIndices.push_back((unsigned char) ((delta & 0x7F) | 0x80));
+        delta >>= 7;
+      }
+      encodedIndices.push_back((unsigned char) delta);
+    }
+    encodedOffsets.push_back(encodedIndices.size());
+  }
+  else
+  {
+    indices.insert(indices.end(), neighbors, neighbors + numResults);
+  }
+
+  for (size_t i = 0; i < numResults; ++i)
+    this->distances.push_back((float) distances[i]);
+  offsets.push_back(this->distances.size());
+}
+
+void RangeSearchResults::Neighbors(const size_t query,
+                                   std::vector<size_t>& neighbors) const
+{
+  if (query >= NumQueries())
+  {
+    std::ostringstream oss;
+    oss << "RangeSearchResults::Neighbors(): query index " << query
+        << " is out of range (" << NumQueries() << " query points)";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (!deltaEncoded)
+  {
+    neighbors.assign(indices.begin() + offsets[query],
+        indices.begin() + offsets[query + 1]);
+    return;
+  }
+
+  neighbors.resize(NumResults(query));
+  size_t position = encodedOffsets[query];
+  size_t last = 0;
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    size_t delta = 0;
+    size_t shift = 0;
+    unsigned char byte;
+    do
+    {
+      byte = encodedIndices[position++];
+      delta |= ((size_t) (byte & 0x7F)) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    last += delta;
+    neighbors[i] = last;
+  }
+}
+
+size_t RangeSearchResults::MemoryUsage() const
+{
+  return offsets.size() * sizeof(size_t) + indices.size() * sizeof(size_t) +
+      encodedOffsets.size() * sizeof(size_t) + encodedIndices.size() +
+      distances.size() * sizeof(float);
+}
@@ -0,0 +1,138 @@
+/**
+ * @file range_search_results.hpp
+ *
+ * Defines the RangeSearchResults class, a compact container for the results of
+ * a range search.
+ *
+ * mlpack is free software; you may redistribute it and/or modify it under the
+ * terms of the 3-clause BSD license.  You should have received a copy of the
+ * 3-clause BSD license along with mlpack.  If not, see
+ * http://www.opensource.org/licenses/BSD-3-Clause for more information.
+ */
+#ifndef MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RESULTS_HPP
+#define MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RESULTS_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The RangeSearchResults class holds the results of a range search in
+ * compressed sparse row (CSR) form: the results of all query points are stored
+ * one after the other in a single array of neighbor indices and a single array
+ * of distances, and an array of offsets gives the first result of each query
+ * point.  Distances are stored in single precision.  Compared to a vector of
+ * vectors for each query point, this avoids one allocation per query point and
+ * takes roughly a third of the memory.
+ *
+ * The results of each query point are sorted by neighbor index.  If delta
+ * encoding is enabled, the neighbor indices of each query point are stored as
+ * the differences between consecutive indices, each as a variable-length
+ * integer of 7 bits per byte; when the neighbors of a query point are close in
+ * index (as is typical after the dataset has been sorted, or for large
+ * ranges), most differences fit in a single byte.
+ *
+ * Results are added one query point at a time with Append(); usually this is
+ * done by RangeSearch::Search().
+ *
+ * @code
+ * RangeSearch<> rs(dataset);
+ * RangeSearchResults results(true);
+ * rs.Search(querySet, Range(0.0, 1.0), results);
+ *
+ * std::vector<size_t> neighbors;
+ * results.Neighbors(3, neighbors);
+ * const float* distances = results.Distances(3);
+ * @endcode
+ */
+class RangeSearchResults
+{
+ public:
+  /**
+   * Create an empty container.
+   *
+   * @param deltaEncoded If true, neighbor indices are delta-encoded.
+   */
+  RangeSearchResults(const bool deltaEncoded = false);
+
+  //! Remove all results, keeping the encoding.
+  void Clear();
+
+  /**
+   * Append the results of the next query point.  The neighbors must be sorted
+   * in increasing order; std::invalid_argument is thrown otherwise.
+   *
+   * @param neighbors Sorted indices of the neighbors of the query point.
+   * @param distances Distances to each neighbor.
+   */
+  void Append(const std::vector<size_t>& neighbors,
+              const std::vector<double>& distances);
+
+  /**
+   * Append the results of the next query point, given as arrays.  The
+   * neighbors must be sorted in increasing order; std::invalid_argument is
+   * thrown otherwise.
+   *
+   * @param neighbors Sorted indices of the neighbors of the query point.
+   * @param distances Distances to each neighbor.
+   * @param numResults Number of neighbors (and distances).
+   */
+  void Append(const size_t* neighbors,
+              const double* distances,
+              const size_t numResults);
+
+  //! Get the number of query points.
+  size_t NumQueries() const { return offsets.size() - 1; }
+  //! Get the total number of results of all query points.
+  size_t NumResults() const { return offsets.back(); }
+  //! Get the number of results of the given query point.
+  size_t NumResults(const size_t query) const
+  { return offsets[query + 1] - offsets[query]; }
+
+  /**
+   * Get the neighbors of the given query point, decoding them if necessary.
+   *
+   * @param query Index of the query point.
+   * @param neighbors Vector to store the sorted neighbor indices in.
+   */
+  void Neighbors(const size_t query, std::vector<size_t>& neighbors) const;
+
+  //! Get the distances of the given query point (NumResults(query) of them).
+  const float* Distances(const size_t query) const
+  { return distances.data() + offsets[query]; }
+
+  //! Get whether neighbor indices are delta-encoded.
+  bool DeltaEncoded() const { return deltaEncoded; }
+
+  //! Get the offset of the first result of each query point (and the total
+  //! number of results at the end).
+  const std::vector<size_t>& Offsets() const { return offsets; }
+  //! Get the neighbor indices of all query points (empty if delta-encoded).
+  const std::vector<size_t>& Indices() const { return indices; }
+  //! Get the distances of all query points.
+  const std::vector<float>& Distances() const { return distances; }
+
+  //! Get the number of bytes used by the stored results.
+  size_t MemoryUsage() const;
+
+ private:
+  //! If true, neighbor indices are delta-encoded.
+  bool deltaEncoded;
+  //! The offset of the first result of each query point.
+  std::vector<size_t> offsets;
+  //! The neighbor indices, if they are not delta-encoded.
+  std::vector<size_t> indices;
+  //! The offset of the first encoded byte of each query point, if neighbor
+  //! indices are delta-encoded.
+  std::vector<size_t> encodedOffsets;
+  //! The delta-encoded neighbor indices.
+  std::vector<unsigned char> encodedIndices;
+  //! The distances.
+  std::vector<float> distances;
+};
+
+} // namespace range
+} // namespace mlpack
+
+#endif
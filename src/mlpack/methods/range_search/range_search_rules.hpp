@@ -41,14 +41,63 @@ class RangeSearchRules
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
    */
-  RangeSearchRules(const arma::mat& referenceSet,
-                   const arma::mat& querySet,
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
                    const math::Range& range,
                    std::vector<std::vector<size_t> >& neighbors,
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric,
                    const bool sameSet = false);
 
+  /**
+   * Construct the RangeSearchRules object so that it only counts the results
+   * for each query point, without storing them.  The counts are added to the
+   * given vector, which must already have one element for each query point.
+   * Reference nodes that fall entirely in the range are counted without any
+   * distance evaluation.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param counts Vector to add the number of results of each query point to.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not count itself in the results.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   arma::Col<size_t>& counts,
+                   MetricType& metric,
+                   const bool sameSet = false);
+
+  /**
+   * Construct the RangeSearchRules object so that it appends each result, in
+   * the order the results are found, to three flat vectors (the query index,
+   * the reference index and the distance), instead of to one vector for each
+   * query point.  This avoids an allocation for each query point; the results
+   * can be grouped by query point afterwards with a counting sort.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param resultQueries Vector to append the query index of each result to.
+   * @param resultNeighbors Vector to append the reference index of each result
+   *      to.
+   * @param resultDistances Vector to append the distance of each result to.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not return itself in the results.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   std::vector<size_t>& resultQueries,
+                   std::vector<size_t>& resultNeighbors,
+                   std::vector<double>& resultDistances,
+                   MetricType& metric,
+                   const bool sameSet = false);
+
   /**
    * Compute the base case between the given query point and reference point.
    *
@@ -119,19 +168,31 @@ class RangeSearchRules
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
+  //! The vector the resultant neighbor indices should be stored in (NULL if
+  //! only counts are computed).
+  std::vector<std::vector<size_t> >* neighbors;
+
+  //! The vector the resultant neighbor distances should be stored in (NULL if
+  //! only counts are computed).
+  std::vector<std::vector<double> >* distances;
+
+  //! The vector the number of results should be added to (NULL if the results
+  //! are stored).
+  arma::Col<size_t>* counts;
 
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The flat vectors the query index, reference index and distance of each
+  //! result are appended to (NULL unless the results are stored flat).
+  std::vector<size_t>* resultQueries;
+  std::vector<size_t>* resultNeighbors;
+  std::vector<double>* resultDistances;
 
   //! The instantiated metric.
   MetricType& metric;
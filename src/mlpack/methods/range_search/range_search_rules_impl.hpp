@@ -20,8 +20,8 @@ namespace range {
 
 template<typename MetricType, typename TreeType>
 RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t> >& neighbors,
     std::vector<std::vector<double> >& distances,
@@ -30,8 +30,68 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    neighbors(&neighbors),
+    distances(&distances),
+    counts(NULL),
+    resultQueries(NULL),
+    resultNeighbors(NULL),
+    resultDistances(NULL),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts,
+    MetricType& metric,
+    const bool sameSet) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    counts(&counts),
+    resultQueries(NULL),
+    resultNeighbors(NULL),
+    resultDistances(NULL),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType>
+RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    std::vector<size_t>& resultQueries,
+    std::vector<size_t>& resultNeighbors,
+    std::vector<double>& resultDistances,
+    MetricType& metric,
+    const bool sameSet) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    counts(NULL),
+    resultQueries(&resultQueries),
+    resultNeighbors(&resultNeighbors),
+    resultDistances(&resultDistances),
     metric(metric),
     sameSet(sameSet),
     lastQueryIndex(querySet.n_cols),
@@ -68,8 +128,21 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
 
   if (range.Contains(distance))
   {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
+    if (counts)
+    {
+      ++(*counts)[queryIndex];
+    }
+    else if (resultQueries)
+    {
+      resultQueries->push_back(queryIndex);
+      resultNeighbors->push_back(referenceIndex);
+      resultDistances->push_back(distance);
+    }
+    else
+    {
+      (*neighbors)[queryIndex].push_back(referenceIndex);
+      (*distances)[queryIndex].push_back(distance);
+    }
   }
 
   return distance;
@@ -236,13 +309,53 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     baseCaseMod = 1;
   }
 
+  // If we are only counting, no distances need to be evaluated; we only have
+  // to skip the query point itself.
+  if (counts)
+  {
+    size_t count = referenceNode.NumDescendants() - baseCaseMod;
+    if (&referenceSet == &querySet)
+    {
+      for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
+      {
+        if (queryIndex == referenceNode.Descendant(i))
+        {
+          --count;
+          break;
+        }
+      }
+    }
+
+    (*counts)[queryIndex] += count;
+    return;
+  }
+
+  // Flat results are appended to the end of the flat vectors.
+  if (resultQueries)
+  {
+    for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
+    {
+      if ((&referenceSet == &querySet) &&
+          (queryIndex == referenceNode.Descendant(i)))
+        continue;
+
+      const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+          referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
+
+      resultQueries->push_back(queryIndex);
+      resultNeighbors->push_back(referenceNode.Descendant(i));
+      resultDistances->push_back(distance);
+    }
+    return;
+  }
+
   // Resize distances and neighbors vectors appropriately.  We have to use
   // reserve() and not resize(), because we don't know if we will encounter the
   // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+  const size_t oldSize = (*neighbors)[queryIndex].size();
+  (*neighbors)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
       baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+  (*distances)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
       baseCaseMod);
 
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
@@ -254,8 +367,8 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
         referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    (*neighbors)[queryIndex].push_back(referenceNode.Descendant(i));
+    (*distances)[queryIndex].push_back(distance);
   }
 }
 
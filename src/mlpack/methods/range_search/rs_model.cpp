@@ -23,7 +23,8 @@ using namespace mlpack::range;
 RSModel::RSModel(TreeTypes treeType, bool randomBasis) :
     treeType(treeType),
     leafSize(0),
-    randomBasis(randomBasis)
+    randomBasis(randomBasis),
+    singlePrecision(false)
 {
   // Nothing to do.
 }
@@ -33,7 +34,9 @@ RSModel::RSModel(const RSModel& other) :
     treeType(other.treeType),
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
-    rSearch(other.rSearch)
+    singlePrecision(other.singlePrecision),
+    rSearch(other.rSearch),
+    treeFile(other.treeFile)
 {
 
 }
@@ -43,12 +46,15 @@ RSModel::RSModel(RSModel&& other) :
     treeType(other.treeType),
     leafSize(other.leafSize),
     randomBasis(other.randomBasis),
-    rSearch(other.rSearch)
+    singlePrecision(other.singlePrecision),
+    rSearch(other.rSearch),
+    treeFile(std::move(other.treeFile))
 {
   // Reset other model.
   other.treeType = TreeTypes::KD_TREE;
   other.leafSize = 0;
   other.randomBasis = false;
+  other.singlePrecision = false;
   other.rSearch = decltype(other.rSearch)();
 }
 
@@ -60,7 +66,9 @@ RSModel& RSModel::operator=(const RSModel& other)
   treeType = other.treeType;
   leafSize = other.leafSize;
   randomBasis = other.randomBasis;
+  singlePrecision = other.singlePrecision;
   rSearch = other.rSearch;
+  treeFile = other.treeFile;
 
   return *this;
 }
@@ -73,12 +81,15 @@ RSModel& RSModel::operator=(RSModel&& other)
   treeType = other.treeType;
   leafSize = other.leafSize;
   randomBasis = other.randomBasis;
+  singlePrecision = other.singlePrecision;
   rSearch = other.rSearch;
+  treeFile = std::move(other.treeFile);
 
   // Reset other model.
   other.treeType = TreeTypes::KD_TREE;
   other.leafSize = 0;
   other.randomBasis = false;
+  other.singlePrecision = false;
   other.rSearch = decltype(other.rSearch)();
 
   return *this;
@@ -95,6 +106,11 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
                          const bool naive,
                          const bool singleMode)
 {
+  // Only the kd-tree and the ball tree hold single-precision data.
+  if (singlePrecision && treeType != KD_TREE && treeType != BALL_TREE)
+    throw std::invalid_argument("RSModel::BuildModel(): single-precision data "
+        "is only supported with kd-trees and ball trees");
+
   // Initialize random basis if necessary.
   if (randomBasis)
   {
@@ -106,6 +122,7 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
 
   // Clean memory, if necessary.
   boost::apply_visitor(DeleteVisitor(), rSearch);
+  treeFile.reset();
 
   // Do we need to modify the reference set?
   if (randomBasis)
@@ -120,7 +137,10 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
   switch (treeType)
   {
     case KD_TREE:
-      rSearch = new RSType<tree::KDTree> (naive, singleMode);
+      if (singlePrecision)
+        rSearch = new RSType<tree::KDTree, arma::fmat>(naive, singleMode);
+      else
+        rSearch = new RSType<tree::KDTree> (naive, singleMode);
       break;
 
     case COVER_TREE:
@@ -136,7 +156,10 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
       break;
 
     case BALL_TREE:
-      rSearch = new RSType<tree::BallTree>(naive, singleMode);  
+      if (singlePrecision)
+        rSearch = new RSType<tree::BallTree, arma::fmat>(naive, singleMode);
+      else
+        rSearch = new RSType<tree::BallTree>(naive, singleMode);
       break;
 
     case X_TREE:
@@ -186,6 +209,127 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
   }
 }
 
+//! Save parameters for SaveTree.
+SaveTreeVisitor::SaveTreeVisitor(const std::string& filename) :
+    filename(filename)
+{}
+
+//! Throw for RSTypes that can't be saved to a flat tree file.
+template<typename RSType>
+void SaveTreeVisitor::operator()(RSType* /* rs */) const
+{
+  throw std::invalid_argument("RSModel::SaveTree(): only kd-trees and ball "
+      "trees can be saved to a flat tree file");
+}
+
+//! Save the reference tree of a kd-tree RSType.
+void SaveTreeVisitor::operator()(RSType<tree::KDTree>* rs) const
+{
+  SaveLeaf(rs);
+}
+
+//! Save the reference tree of a ball tree RSType.
+void SaveTreeVisitor::operator()(RSType<tree::BallTree>* rs) const
+{
+  SaveLeaf(rs);
+}
+
+//! Save the reference tree of a single-precision kd-tree RSType.
+void SaveTreeVisitor::operator()(RSType<tree::KDTree, arma::fmat>* rs) const
+{
+  SaveLeaf(rs);
+}
+
+//! Save the reference tree of a single-precision ball tree RSType.
+void SaveTreeVisitor::operator()(RSType<tree::BallTree, arma::fmat>* rs) const
+{
+  SaveLeaf(rs);
+}
+
+//! Save the reference tree of the given RSType.
+template<typename RSType>
+void SaveTreeVisitor::SaveLeaf(RSType* rs) const
+{
+  if (!rs)
+    throw std::runtime_error("no range search model initialized");
+  if (!rs->ReferenceTree())
+    throw std::invalid_argument("RSModel::SaveTree(): a model that uses naive "
+        "search has no tree to save");
+
+  tree::FlatTreeFile<typename RSType::Tree>::Save(filename,
+      *rs->ReferenceTree(), rs->OldFromNewReferences());
+}
+
+// Save the reference tree to a flat tree file.
+void RSModel::SaveTree(const std::string& filename) const
+{
+  // The random basis is not stored in the file.
+  if (randomBasis)
+    throw std::invalid_argument("RSModel::SaveTree(): models with a random "
+        "basis can't be saved to a flat tree file");
+
+  boost::apply_visitor(SaveTreeVisitor(filename), rSearch);
+}
+
+// Build the model from a flat tree file.
+void RSModel::LoadTree(const std::string& filename,
+                       const bool naive,
+                       const bool singleMode)
+{
+  if (randomBasis)
+    throw std::invalid_argument("RSModel::LoadTree(): models with a random "
+        "basis can't be loaded from a flat tree file");
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      if (singlePrecision)
+        LoadFlatTree<RSType<tree::KDTree, arma::fmat>>(filename, naive,
+            singleMode);
+      else
+        LoadFlatTree<RSType<tree::KDTree>>(filename, naive, singleMode);
+      break;
+    case BALL_TREE:
+      if (singlePrecision)
+        LoadFlatTree<RSType<tree::BallTree, arma::fmat>>(filename, naive,
+            singleMode);
+      else
+        LoadFlatTree<RSType<tree::BallTree>>(filename, naive, singleMode);
+      break;
+    default:
+      throw std::invalid_argument("RSModel::LoadTree(): only kd-trees and "
+          "ball trees can be loaded from a flat tree file");
+  }
+}
+
+// Load the reference tree of the given RSType from a flat tree file.
+template<typename RSImplType>
+void RSModel::LoadFlatTree(const std::string& filename,
+                           const bool naive,
+                           const bool singleMode)
+{
+  typedef typename RSImplType::Tree Tree;
+  typedef tree::FlatTreeFile<Tree> FileType;
+
+  Timer::Start("loading_tree");
+  std::shared_ptr<FileType> file(new FileType(filename));
+  Timer::Stop("loading_tree");
+
+  // Clean memory, if necessary.  The old tree may use the old file.
+  boost::apply_visitor(DeleteVisitor(), rSearch);
+  treeFile.reset();
+
+  RSImplType* rs = new RSImplType(new Tree(std::move(file->Tree())),
+      singleMode);
+  rs->Naive() = naive;
+
+  // Give the model ownership of the tree and the mappings.
+  rs->treeOwner = true;
+  rs->oldFromNewReferences = file->OldFromNew();
+  rSearch = rs;
+  treeFile = file;
+}
+
 // Perform range search.
 void RSModel::Search(arma::mat&& querySet,
                      const math::Range& range,
@@ -16,22 +16,26 @@
 #define MLPACK_METHODS_RANGE_SEARCH_RS_MODEL_HPP
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/binary_space_tree/flat_tree_file.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
 #include <mlpack/core/tree/octree.hpp>
 #include <boost/variant.hpp>
+#include <memory>
 #include "range_search.hpp"
 
 namespace mlpack {
 namespace range {
 
 /**
- * Alias template for Range Search.
+ * Alias template for Range Search.  The data is held in double precision
+ * unless another MatType is given.
  */
 template<template<typename TreeMetricType,
                   typename TreeStatType,
-                  typename TreeMatType> class TreeType>
-using RSType = RangeSearch<metric::EuclideanDistance, arma::mat, TreeType>;
+                  typename TreeMatType> class TreeType,
+         typename MatType = arma::mat>
+using RSType = RangeSearch<metric::EuclideanDistance, MatType, TreeType>;
 
 struct RSModelName
 {
@@ -88,8 +92,8 @@ class BiSearchVisitor : public boost::static_visitor<void>
   const size_t leafSize;
 
   //! Bichromatic range search on the given RSType considering the leafSize.
-  template<typename RSType>
-  void SearchLeaf(RSType* rs) const;
+  template<typename RSType, typename MatType>
+  void SearchLeaf(RSType* rs, const MatType& queries) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -113,6 +117,12 @@ class BiSearchVisitor : public boost::static_visitor<void>
   //! Bichromatic range search specialized for octrees.
   void operator()(RSTypeT<tree::Octree>* rs) const;
 
+  //! Bichromatic range search with single-precision KDTrees.
+  void operator()(RSType<tree::KDTree, arma::fmat>* rs) const;
+
+  //! Bichromatic range search with single-precision BallTrees.
+  void operator()(RSType<tree::BallTree, arma::fmat>* rs) const;
+
   //! Construct the BiSearchVisitor.
   BiSearchVisitor(const arma::mat& querySet,
                   const math::Range& range,
@@ -135,8 +145,8 @@ class TrainVisitor : public boost::static_visitor<void>
   //! The leaf size, used only by BinarySpaceTree.
   size_t leafSize;
   //! Train on the given RsType considering the leafSize.
-  template<typename RSType>
-  void TrainLeaf(RSType* rs) const;
+  template<typename RSType, typename MatType>
+  void TrainLeaf(RSType* rs, MatType&& references) const;
 
  public:
   //! Alias template necessary for visual c++ compiler.
@@ -160,13 +170,57 @@ class TrainVisitor : public boost::static_visitor<void>
   //! Train specialized for octrees.
   void operator()(RSTypeT<tree::Octree>* rs) const;
 
+  //! Train single-precision KDTrees.
+  void operator()(RSType<tree::KDTree, arma::fmat>* rs) const;
+
+  //! Train single-precision BallTrees.
+  void operator()(RSType<tree::BallTree, arma::fmat>* rs) const;
+
   //! Construct the TrainVisitor object with the given reference set, leafSize
   TrainVisitor(arma::mat&& referenceSet,
                const size_t leafSize);
 };
 
 /**
- * ReferenceSetVisitor exposes the referenceSet of the given RSType.
+ * SaveTreeVisitor saves the reference tree of the given RSType to a flat tree
+ * file (see tree::FlatTreeFile).  Only kd-trees and ball trees can be saved
+ * this way; for other types of trees an exception is thrown.
+ */
+class SaveTreeVisitor : public boost::static_visitor<void>
+{
+ private:
+  //! The name of the file to save to.
+  const std::string& filename;
+
+  //! Save the reference tree of the given RSType.
+  template<typename RSType>
+  void SaveLeaf(RSType* rs) const;
+
+ public:
+  //! Throw, since the tree type can't be saved to a flat tree file.
+  template<typename RSType>
+  void operator()(RSType* rs) const;
+
+  //! Save the reference tree of a kd-tree RSType.
+  void operator()(RSType<tree::KDTree>* rs) const;
+
+  //! Save the reference tree of a ball tree RSType.
+  void operator()(RSType<tree::BallTree>* rs) const;
+
+  //! Save the reference tree of a single-precision kd-tree RSType.
+  void operator()(RSType<tree::KDTree, arma::fmat>* rs) const;
+
+  //! Save the reference tree of a single-precision ball tree RSType.
+  void operator()(RSType<tree::BallTree, arma::fmat>* rs) const;
+
+  //! Construct the SaveTreeVisitor object with the given filename.
+  SaveTreeVisitor(const std::string& filename);
+};
+
+/**
+ * ReferenceSetVisitor exposes the referenceSet of the given RSType.  Models
+ * that hold single-precision data have no double-precision reference set, so
+ * for them an exception is thrown.
  */
 class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
 {
@@ -174,6 +228,36 @@ class ReferenceSetVisitor : public boost::static_visitor<const arma::mat&>
   //! Return the reference set.
   template<typename RSType>
   const arma::mat& operator()(RSType* rs) const;
+
+  //! Throw, since the reference set is not held in double precision.
+  template<template<typename TreeMetricType,
+                    typename TreeStatType,
+                    typename TreeMatType> class TreeType>
+  const arma::mat& operator()(RSType<TreeType, arma::fmat>* rs) const;
+};
+
+/**
+ * DimensionalityVisitor returns the dimensionality of the reference set of the
+ * given RSType.
+ */
+class DimensionalityVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  //! Return the dimensionality of the reference set.
+  template<typename RSType>
+  size_t operator()(RSType* rs) const;
+};
+
+/**
+ * NumPointsVisitor returns the number of points in the reference set of the
+ * given RSType.
+ */
+class NumPointsVisitor : public boost::static_visitor<size_t>
+{
+ public:
+  //! Return the number of points in the reference set.
+  template<typename RSType>
+  size_t operator()(RSType* rs) const;
 };
 
 /**
@@ -265,6 +349,10 @@ class RSModel
   //! Random projection matrix.
   arma::mat q;
 
+  //! If true, the reference set is held in single precision (only for
+  //! kd-trees and ball trees).
+  bool singlePrecision;
+
   /**
    * rSearch holds an instance of the RangeSearch class for the current
    * treeType. It is initialized every time BuildModel is executed.
@@ -283,7 +371,20 @@ class RSModel
                  RSType<tree::RPTree>*,
                  RSType<tree::MaxRPTree>*,
                  RSType<tree::UBTree>*,
-                 RSType<tree::Octree>*> rSearch;
+                 RSType<tree::Octree>*,
+                 RSType<tree::KDTree, arma::fmat>*,
+                 RSType<tree::BallTree, arma::fmat>*> rSearch;
+
+  //! The flat tree file that the reference tree was loaded from, if any.  The
+  //! dataset of the tree is stored in this file, so it must outlive rSearch.
+  std::shared_ptr<void> treeFile;
+
+  //! Load the reference tree of the given RSType from the given flat tree
+  //! file.
+  template<typename RSImplType>
+  void LoadFlatTree(const std::string& filename,
+                    const bool naive,
+                    const bool singleMode);
 
  public:
   /**
@@ -333,9 +434,15 @@ class RSModel
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
 
-  //! Expose the dataset.
+  //! Expose the dataset.  This throws std::invalid_argument if the model
+  //! holds single-precision data.
   const arma::mat& Dataset() const;
 
+  //! Get the dimensionality of the reference set.
+  size_t Dimensionality() const;
+  //! Get the number of points in the reference set.
+  size_t NumPoints() const;
+
   //! Get whether the model is in single-tree search mode.
   bool SingleMode() const;
   //! Modify whether the model is in single-tree search mode.
@@ -362,6 +469,13 @@ class RSModel
   //! been built).
   bool& RandomBasis() { return randomBasis; }
 
+  //! Get whether the reference set is held in single precision.
+  bool SinglePrecision() const { return singlePrecision; }
+  //! Modify whether the reference set is held in single precision (don't do
+  //! this after the model has been built).  Only kd-trees and ball trees
+  //! support single-precision data.
+  bool& SinglePrecision() { return singlePrecision; }
+
   /**
    * Build the reference tree on the given dataset with the given parameters.
    * This takes possession of the reference set to avoid a copy.
@@ -370,12 +484,37 @@ class RSModel
    * @param leafSize Leaf size of tree (ignored for the cover tree).
    * @param naive Whether naive search should be used.
    * @param singleMode Whether single-tree search should be used.
+   * @throws std::invalid_argument if SinglePrecision() is set and the tree is
+   *     neither a kd-tree nor a ball tree.
    */
   void BuildModel(arma::mat&& referenceSet,
                   const size_t leafSize,
                   const bool naive,
                   const bool singleMode);
 
+  /**
+   * Save the reference tree and the reference set to a flat tree file (see
+   * tree::FlatTreeFile), which can be loaded much faster than the model can be
+   * rebuilt or deserialized.  Only kd-trees and ball trees without a random
+   * basis can be saved this way.
+   *
+   * @param filename Name of the file to write.
+   */
+  void SaveTree(const std::string& filename) const;
+
+  /**
+   * Build the model from a reference tree saved with SaveTree().  The file is
+   * memory-mapped, and the reference set is not copied out of it.  The tree
+   * type and the precision of the model must match the saved tree.
+   *
+   * @param filename Name of the file to load.
+   * @param naive Whether naive search should be used.
+   * @param singleMode Whether single-tree search should be used.
+   */
+  void LoadTree(const std::string& filename,
+                const bool naive,
+                const bool singleMode);
+
   /**
    * Perform range search.  This takes possession of the query set, so the query
    * set will not be usable after the search.  For more information on the
@@ -420,6 +559,9 @@ class RSModel
 } // namespace range
 } // namespace mlpack
 
+//! Set the serialization version of the RSModel class.
+BOOST_TEMPLATE_CLASS_VERSION(template<>, mlpack::range::RSModel, 1);
+
 // Include implementation (of Serialize() and inline functions).
 #include "rs_model_impl.hpp"
 
@@ -15,6 +15,8 @@
 // In case it hasn't been included yet.
 #include "rs_model.hpp"
 
+#include <boost/serialization/variant.hpp>
+
 namespace mlpack {
 namespace range {
 
@@ -55,7 +57,7 @@ void BiSearchVisitor::operator()(RSTypeT<TreeType>* rs) const
 void BiSearchVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet);
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -63,7 +65,7 @@ void BiSearchVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 void BiSearchVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet);
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -71,13 +73,29 @@ void BiSearchVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 void BiSearchVisitor::operator()(RSTypeT<tree::Octree>* rs) const
 {
   if (rs)
-    return SearchLeaf(rs);
+    return SearchLeaf(rs, querySet);
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Bichromatic range search with single-precision KDTrees.
+void BiSearchVisitor::operator()(RSType<tree::KDTree, arma::fmat>* rs) const
+{
+  if (rs)
+    return SearchLeaf(rs, arma::conv_to<arma::fmat>::from(querySet));
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Bichromatic range search with single-precision BallTrees.
+void BiSearchVisitor::operator()(RSType<tree::BallTree, arma::fmat>* rs) const
+{
+  if (rs)
+    return SearchLeaf(rs, arma::conv_to<arma::fmat>::from(querySet));
   throw std::runtime_error("no range search model initialized");
 }
 
 //! Bichromatic range search on the given RSType considering the leafSize.
-template<typename RSType>
-void BiSearchVisitor::SearchLeaf(RSType* rs) const
+template<typename RSType, typename MatType>
+void BiSearchVisitor::SearchLeaf(RSType* rs, const MatType& queries) const
 {
   if (!rs->Naive() && !rs->SingleMode())
   {
@@ -85,7 +103,7 @@ void BiSearchVisitor::SearchLeaf(RSType* rs) const
     Timer::Start("tree_building");
     Log::Info << "Building query tree..." << std::endl;
     std::vector<size_t> oldFromNewQueries;
-    typename RSType::Tree queryTree(std::move(querySet), oldFromNewQueries,
+    typename RSType::Tree queryTree(std::move(queries), oldFromNewQueries,
         leafSize);
     Log::Info << "Tree built." << std::endl;
     Timer::Stop("tree_building");
@@ -104,7 +122,7 @@ void BiSearchVisitor::SearchLeaf(RSType* rs) const
     }
   }
   else
-    rs->Search(querySet, range, neighbors, distances);
+    rs->Search(queries, range, neighbors, distances);
 }
 
 //! Save parameters for Train.
@@ -129,7 +147,7 @@ void TrainVisitor::operator()(RSTypeT<TreeType>* rs) const
 void TrainVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -137,7 +155,7 @@ void TrainVisitor::operator()(RSTypeT<tree::KDTree>* rs) const
 void TrainVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
   throw std::runtime_error("no range search model initialized");
 }
 
@@ -145,21 +163,45 @@ void TrainVisitor::operator()(RSTypeT<tree::BallTree>* rs) const
 void TrainVisitor::operator()(RSTypeT<tree::Octree>* rs) const
 {
   if (rs)
-    return TrainLeaf(rs);
+    return TrainLeaf(rs, std::move(referenceSet));
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Train single-precision KDTrees.
+void TrainVisitor::operator()(RSType<tree::KDTree, arma::fmat>* rs) const
+{
+  if (rs)
+  {
+    arma::fmat references = arma::conv_to<arma::fmat>::from(referenceSet);
+    referenceSet.reset();
+    return TrainLeaf(rs, std::move(references));
+  }
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Train single-precision BallTrees.
+void TrainVisitor::operator()(RSType<tree::BallTree, arma::fmat>* rs) const
+{
+  if (rs)
+  {
+    arma::fmat references = arma::conv_to<arma::fmat>::from(referenceSet);
+    referenceSet.reset();
+    return TrainLeaf(rs, std::move(references));
+  }
   throw std::runtime_error("no range search model initialized");
 }
 
 //! Train on the given RSType considering the leafSize.
-template<typename RSType>
-void TrainVisitor::TrainLeaf(RSType* rs) const
+template<typename RSType, typename MatType>
+void TrainVisitor::TrainLeaf(RSType* rs, MatType&& references) const
 {
   if (rs->Naive())
-    rs->Train(std::move(referenceSet));
+    rs->Train(std::move(references));
   else
   {
     std::vector<size_t> oldFromNewReferences;
     typename RSType::Tree* tree =
-        new typename RSType::Tree(std::move(referenceSet), oldFromNewReferences,
+        new typename RSType::Tree(std::move(references), oldFromNewReferences,
         leafSize);
     rs->Train(tree);
 
@@ -178,6 +220,35 @@ const arma::mat& ReferenceSetVisitor::operator()(RSType* rs) const
   throw std::runtime_error("no range search model initialized");
 }
 
+//! Single-precision models have no double-precision reference set.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+const arma::mat& ReferenceSetVisitor::operator()(
+    RSType<TreeType, arma::fmat>* /* rs */) const
+{
+  throw std::invalid_argument("RSModel::Dataset(): the model holds "
+      "single-precision data; use Dimensionality() and NumPoints() instead");
+}
+
+//! Return the dimensionality of the reference set.
+template<typename RSType>
+size_t DimensionalityVisitor::operator()(RSType* rs) const
+{
+  if (rs)
+    return rs->ReferenceSet().n_rows;
+  throw std::runtime_error("no range search model initialized");
+}
+
+//! Return the number of points in the reference set.
+template<typename RSType>
+size_t NumPointsVisitor::operator()(RSType* rs) const
+{
+  if (rs)
+    return rs->ReferenceSet().n_cols;
+  throw std::runtime_error("no range search model initialized");
+}
+
 //! For cleaning memory
 template<typename RSType>
 void DeleteVisitor::operator()(RSType* rs) const
@@ -220,9 +291,26 @@ bool& NaiveVisitor::operator()(RSType* rs) const
  throw std::runtime_error("no range search model initialized");
 }
 
+/**
+ * Non-intrusive serialization for RangeSearch.  This is needed to serialize
+ * the boost variant, which looks for a serialize function for its member
+ * types.
+ */
+template<typename Archive,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void serialize(Archive& ar,
+               RangeSearch<metric::EuclideanDistance, MatType, TreeType>& rs,
+               const unsigned int version)
+{
+  rs.Serialize(ar, version);
+}
+
 // Serialize the model.
 template<typename Archive>
-void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
+void RSModel::Serialize(Archive& ar, const unsigned int version)
 {
   using data::CreateNVP;
 
@@ -234,10 +322,22 @@ void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
   if (Archive::is_loading::value)
     boost::apply_visitor(DeleteVisitor(), rSearch);
 
-  // We'll only need to serialize one of the model objects, based on the type.
   const std::string& name = RSModelName::Name();
-  SerializeVisitor<Archive> s(ar, name);
-  boost::apply_visitor(s, rSearch);
+  if (version == 0)
+  {
+    // Older versions serialized only the object the variant pointed to, and
+    // held only double-precision data.
+    singlePrecision = false;
+    SerializeVisitor<Archive> s(ar, name);
+    boost::apply_visitor(s, rSearch);
+  }
+  else
+  {
+    // The variant remembers which type it holds, so the model can be loaded
+    // into an empty RSModel.
+    ar & CreateNVP(singlePrecision, "singlePrecision");
+    ar & CreateNVP(rSearch, name);
+  }
 }
 
 inline const arma::mat& RSModel::Dataset() const
@@ -245,6 +345,16 @@ inline const arma::mat& RSModel::Dataset() const
   return boost::apply_visitor(ReferenceSetVisitor(), rSearch);
 }
 
+inline size_t RSModel::Dimensionality() const
+{
+  return boost::apply_visitor(DimensionalityVisitor(), rSearch);
+}
+
+inline size_t RSModel::NumPoints() const
+{
+  return boost::apply_visitor(NumPointsVisitor(), rSearch);
+}
+
 inline bool RSModel::SingleMode() const
 {
   return boost::apply_visitor(SingleModeVisitor(), rSearch);
@@ -31,6 +31,7 @@
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
 
 #include "ra_query_stat.hpp"
+#include "ra_search_rules.hpp"
 #include "ra_util.hpp"
 
 namespace mlpack {
@@ -58,6 +59,14 @@ class RAModel;
  *
  * RASearch is currently known to not work with ball trees (#356).
  *
+ * With OpenMP, single-tree search is parallelized over blocks of query points,
+ * and dual-tree search over the top-level subtrees of the query tree.  Each
+ * block or subtree draws its samples from its own stream of a random number
+ * generator that is seeded from mlpack::math::randGen, so for a given seed
+ * (see mlpack::math::RandomSeed()) the results of single-tree search do not
+ * depend on the number of threads, and the results of dual-tree search only
+ * depend on the number of threads.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
  * @tparam MetricType The metric to use for computation.
  * @tparam TreeType The tree type to use.
@@ -419,6 +428,31 @@ class RASearch
   void Serialize(Archive& ar, const unsigned int /* version */);
 
  private:
+  //! Convenience typedef for the rules used by the traversals.
+  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+
+  /**
+   * Traverse the reference tree for each of the first numQueries query points
+   * with the given rules.  The query points are split into blocks, each of
+   * which is sampled with its own random number stream; with OpenMP, the
+   * blocks are searched in parallel.
+   *
+   * @param numQueries Number of query points.
+   * @param rules Rules object to use for the traversal.
+   */
+  void SingleTreeTraverse(const size_t numQueries, RuleType& rules);
+
+  /**
+   * Traverse the given query tree and the reference tree with the given rules.
+   * With OpenMP, the top levels of the query tree are split into independent
+   * subtrees, each of which is traversed against the reference tree in
+   * parallel with its own random number stream.
+   *
+   * @param queryTree Tree built on the query points.
+   * @param rules Rules object to use for the traversal.
+   */
+  void DualTreeTraverse(Tree& queryTree, RuleType& rules);
+
   //! Permutations of reference points during tree building.
   std::vector<size_t> oldFromNewReferences;
   //! Pointer to the root of the reference tree.
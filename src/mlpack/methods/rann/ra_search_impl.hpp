@@ -360,8 +360,6 @@ Search(const MatType& querySet,
   neighborPtr->set_size(k, querySet.n_cols);
   distancePtr->set_size(k, querySet.n_cols);
 
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
-
   if (naive)
   {
     RuleType rules(*referenceSet, querySet, k, metric, tau, alpha, naive,
@@ -394,12 +392,7 @@ Search(const MatType& querySet,
     {
       Log::Info << "Performing single-tree traversal..." << std::endl;
 
-      // Create the traverser.
-      typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-      // Now have it traverse for each point.
-      for (size_t i = 0; i < querySet.n_cols; ++i)
-        traverser.Traverse(i, *referenceTree);
+      SingleTreeTraverse(querySet.n_cols, rules);
 
       Log::Info << "Single-tree traversal complete." << std::endl;
       Log::Info << "Average number of distance calculations per query point: "
@@ -423,12 +416,11 @@ Search(const MatType& querySet,
 
     RuleType rules(*referenceSet, queryTree->Dataset(), k, metric, tau, alpha,
         naive, sampleAtLeaves, firstLeafExact, singleSampleLimit, false);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
 
     Log::Info << "Query statistic pre-search: "
         << queryTree->Stat().NumSamplesMade() << std::endl;
 
-    traverser.Traverse(*queryTree, *referenceTree);
+    DualTreeTraverse(*queryTree, rules);
 
     Log::Info << "Dual-tree traversal complete." << std::endl;
     Log::Info << "Average number of distance calculations per query point: "
@@ -533,13 +525,10 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distances.set_size(k, querySet.n_cols);
 
   // Create the helper object for the tree traversal.
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, queryTree->Dataset(), k, metric, tau, alpha,
       naive, sampleAtLeaves, firstLeafExact, singleSampleLimit, false);
 
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+  DualTreeTraverse(*queryTree, rules);
 
   rules.GetResults(*neighborPtr, distances);
 
@@ -589,7 +578,6 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distancePtr->set_size(k, referenceSet->n_cols);
 
   // Create the helper object for the tree traversal.
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
   RuleType rules(*referenceSet, *referenceSet, k, metric, tau, alpha, naive,
       sampleAtLeaves, firstLeafExact, singleSampleLimit, true /* same sets */);
 
@@ -610,19 +598,11 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    SingleTreeTraverse(referenceSet->n_cols, rules);
   }
   else
   {
-    // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*referenceTree, *referenceTree);
+    DualTreeTraverse(*referenceTree, rules);
   }
 
   rules.GetResults(*neighborPtr, *distancePtr);
@@ -652,6 +632,153 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::SingleTreeTraverse(
+    const size_t numQueries,
+    RuleType& rules)
+{
+  // Each block of query points is sampled with its own stream, so the results
+  // do not depend on which thread searches which block.
+  const size_t seed = math::randGen();
+  const size_t blockSize = 64;
+  const size_t numBlocks = (numQueries + blockSize - 1) / blockSize;
+
+#ifdef HAS_OPENMP
+  if (omp_get_max_threads() > 1)
+  {
+    size_t parallelDistComputations = 0;
+
+    #pragma omp parallel reduction(+:parallelDistComputations)
+    {
+      // Each thread gets its own rules and traverser; the results are stored
+      // in the candidate lists of the given rules.
+      RuleType threadRules(rules);
+      typename Tree::template SingleTreeTraverser<RuleType>
+          traverser(threadRules);
+
+#ifdef _WIN32
+      // Tiny workaround: Visual Studio only implements OpenMP 2.0, which
+      // doesn't support unsigned loop variables. If we're building for Visual
+      // Studio, use the intmax_t type instead.
+      #pragma omp for schedule(dynamic)
+      for (intmax_t b = 0; b < (intmax_t) numBlocks; ++b)
+#else
+      #pragma omp for schedule(dynamic)
+      for (size_t b = 0; b < numBlocks; ++b)
+#endif
+      {
+        threadRules.Seed(seed, b);
+        const size_t end = std::min(((size_t) b + 1) * blockSize, numQueries);
+        for (size_t i = (size_t) b * blockSize; i < end; ++i)
+          traverser.Traverse(i, *referenceTree);
+      }
+
+      parallelDistComputations += threadRules.NumDistComputations();
+    }
+
+    rules.NumDistComputations() += parallelDistComputations;
+    return;
+  }
+#endif
+
+  typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+    rules.Seed(seed, b);
+    const size_t end = std::min((b + 1) * blockSize, numQueries);
+    for (size_t i = b * blockSize; i < end; ++i)
+      traverser.Traverse(i, *referenceTree);
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::DualTreeTraverse(
+    Tree& queryTree,
+    RuleType& rules)
+{
+  const size_t seed = math::randGen();
+
+#ifdef HAS_OPENMP
+  const size_t numThreads = omp_get_max_threads();
+  if (numThreads > 1)
+  {
+    // Split the top of the query tree into independent subtrees, always
+    // splitting the largest subtree first, as in NeighborSearch.  Nodes that
+    // hold points themselves are not split, since then the points would be
+    // lost.  The split only depends on the tree and the number of threads, so
+    // the subtrees (and their random number streams) are the same every time.
+    typedef std::pair<size_t, Tree*> Task;
+    std::priority_queue<Task> tasks;
+    std::vector<Tree*> subtrees;
+    tasks.push(Task(queryTree.NumDescendants(), &queryTree));
+    while (!tasks.empty() && (tasks.size() + subtrees.size()) < 8 * numThreads)
+    {
+      Tree* node = tasks.top().second;
+      tasks.pop();
+
+      if (node->IsLeaf() || (node->NumPoints() > 0 &&
+          !tree::TreeTraits<Tree>::HasSelfChildren))
+      {
+        subtrees.push_back(node);
+        continue;
+      }
+
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        tasks.push(Task(node->Child(i).NumDescendants(), &node->Child(i)));
+    }
+
+    while (!tasks.empty())
+    {
+      subtrees.push_back(tasks.top().second);
+      tasks.pop();
+    }
+
+    size_t parallelDistComputations = 0;
+
+#ifdef _WIN32
+    // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+    // support unsigned loop variables. If we're building for Visual Studio,
+    // use the intmax_t type instead.
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelDistComputations)
+    for (intmax_t i = 0; i < (intmax_t) subtrees.size(); ++i)
+#else
+    #pragma omp parallel for schedule(dynamic) \
+        reduction(+:parallelDistComputations)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+#endif
+    {
+      // Each subtree holds a disjoint set of query points, so the traversals
+      // can share the candidate lists and the sample counts.
+      RuleType subtreeRules(rules);
+      subtreeRules.Seed(seed, i);
+      typename Tree::template DualTreeTraverser<RuleType>
+          traverser(subtreeRules);
+      traverser.Traverse(*subtrees[i], *referenceTree);
+
+      parallelDistComputations += subtreeRules.NumDistComputations();
+    }
+
+    rules.NumDistComputations() += parallelDistComputations;
+    return;
+  }
+#endif
+
+  rules.Seed(seed, 0);
+  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+  traverser.Traverse(queryTree, *referenceTree);
+}
+
 template<typename SortPolicy,
          typename MetricType,
          typename MatType,
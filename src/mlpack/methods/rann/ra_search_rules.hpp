@@ -16,6 +16,8 @@
 
 #include <mlpack/core/tree/traversal_info.hpp>
 
+#include <random>
+
 namespace mlpack {
 namespace neighbor {
 
@@ -64,6 +66,41 @@ class RASearchRules
                 const size_t singleSampleLimit = 20,
                 const bool sameSet = false);
 
+  /**
+   * Construct a RASearchRules object that shares the candidate lists and the
+   * sample counts of the given RASearchRules object, but has its own random
+   * number generator, traversal info and distance computation counter.  This
+   * is used to run several traversals in parallel; each of the traversals
+   * must work on a disjoint set of query points.  The given rules object must
+   * outlive this object.
+   *
+   * @param other RASearchRules object whose candidate lists are used.
+   */
+  RASearchRules(RASearchRules& other);
+
+  /**
+   * Assignment is not supported, since an object made with the constructor
+   * above only holds a pointer to the candidate lists of another object.
+   */
+  RASearchRules& operator=(const RASearchRules& other) = delete;
+
+  /**
+   * Destroy the RASearchRules object, freeing the candidate lists if they are
+   * owned by this object.
+   */
+  ~RASearchRules();
+
+  /**
+   * Restart the random number generator used for sampling, as the given stream
+   * of the given seed.  Different streams of the same seed are independent, so
+   * traversals that run in parallel can each use their own stream, and the
+   * results only depend on the seed and on the way the work is split up.
+   *
+   * @param seed Seed of the random number generator.
+   * @param stream Index of the stream.
+   */
+  void Seed(const size_t seed, const size_t stream);
+
   /**
    * Store the list of candidates for each query point in the given matrices.
    *
@@ -225,7 +262,10 @@ class RASearchRules
                  const double oldScore);
 
 
-  size_t NumDistComputations() { return numDistComputations; }
+  //! Get the number of distance computations.
+  size_t NumDistComputations() const { return numDistComputations; }
+  //! Modify the number of distance computations.
+  size_t& NumDistComputations() { return numDistComputations; }
   size_t NumEffectiveSamples()
   {
     if (numSamplesMade.n_elem == 0)
@@ -261,8 +301,12 @@ class RASearchRules
   typedef std::priority_queue<Candidate, std::vector<Candidate>, CandidateCmp>
       CandidateList;
 
-  //! Set of candidate neighbors for each point.
-  std::vector<CandidateList> candidates;
+  //! Set of candidate neighbors for each point.  This may be shared with
+  //! other RASearchRules objects.
+  std::vector<CandidateList>* candidates;
+
+  //! If true, this object owns the candidate lists.
+  bool candidatesOwner;
 
   //! Number of neighbors to search for.
   const size_t k;
@@ -282,9 +326,13 @@ class RASearchRules
   //! The minimum number of samples required per query
   size_t numSamplesReqd;
 
-  //! The number of samples made for every query
+  //! The number of samples made for every query (this may be an alias of the
+  //! sample counts of another RASearchRules object).
   arma::Col<size_t> numSamplesMade;
 
+  //! The random number generator used for sampling.
+  std::mt19937 generator;
+
   //! The sampling ratio
   double samplingRatio;
 
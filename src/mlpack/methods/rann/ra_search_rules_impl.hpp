@@ -33,11 +33,14 @@ RASearchRules(const arma::mat& referenceSet,
               const bool sameSet) :
     referenceSet(referenceSet),
     querySet(querySet),
+    candidates(new std::vector<CandidateList>()),
+    candidatesOwner(true),
     k(k),
     metric(metric),
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
+    generator(math::randGen()),
     sameSet(sameSet)
 {
   // Validate tau to make sure that the rank approximation is greater than the
@@ -80,9 +83,9 @@ RASearchRules(const arma::mat& referenceSet,
   std::vector<Candidate> vect(k, def);
   CandidateList pqueue(CandidateCmp(), std::move(vect));
 
-  candidates.reserve(querySet.n_cols);
+  candidates->reserve(querySet.n_cols);
   for (size_t i = 0; i < querySet.n_cols; i++)
-    candidates.push_back(pqueue);
+    candidates->push_back(pqueue);
 
   if (naive)// No tree traversal; just do naive sampling here.
   {
@@ -90,13 +93,53 @@ RASearchRules(const arma::mat& referenceSet,
     arma::uvec distinctSamples;
     for (size_t i = 0; i < querySet.n_cols; ++i)
     {
-      math::ObtainDistinctSamples(0, n, numSamplesReqd, distinctSamples);
+      math::ObtainDistinctSamples(0, n, numSamplesReqd, distinctSamples,
+          generator);
       for (size_t j = 0; j < distinctSamples.n_elem; j++)
         BaseCase(i, (size_t) distinctSamples[j]);
     }
   }
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+RASearchRules<SortPolicy, MetricType, TreeType>::RASearchRules(
+    RASearchRules& other) :
+    referenceSet(other.referenceSet),
+    querySet(other.querySet),
+    candidates(other.candidates),
+    candidatesOwner(false),
+    k(other.k),
+    metric(other.metric),
+    sampleAtLeaves(other.sampleAtLeaves),
+    firstLeafExact(other.firstLeafExact),
+    singleSampleLimit(other.singleSampleLimit),
+    numSamplesReqd(other.numSamplesReqd),
+    numSamplesMade(other.numSamplesMade.memptr(), other.numSamplesMade.n_elem,
+        false, true),
+    generator(other.generator),
+    samplingRatio(other.samplingRatio),
+    numDistComputations(0),
+    sameSet(other.sameSet)
+{
+  // Nothing else to do.  The traversal info is not shared, because each
+  // traversal has its own.
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+RASearchRules<SortPolicy, MetricType, TreeType>::~RASearchRules()
+{
+  if (candidatesOwner)
+    delete candidates;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void RASearchRules<SortPolicy, MetricType, TreeType>::Seed(const size_t seed,
+                                                            const size_t stream)
+{
+  std::seed_seq seedSequence = { (uint32_t) seed, (uint32_t) stream };
+  generator.seed(seedSequence);
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 void RASearchRules<SortPolicy, MetricType, TreeType>::GetResults(
     arma::Mat<size_t>& neighbors,
@@ -107,7 +150,7 @@ void RASearchRules<SortPolicy, MetricType, TreeType>::GetResults(
 
   for (size_t i = 0; i < querySet.n_cols; i++)
   {
-    CandidateList& pqueue = candidates[i];
+    CandidateList& pqueue = (*candidates)[i];
     for (size_t j = 1; j <= k; j++)
     {
       neighbors(k - j, i) = pqueue.top().second;
@@ -149,7 +192,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode);
-  const double bestDistance = candidates[queryIndex].top().first;
+  const double bestDistance = (*candidates)[queryIndex].top().first;
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -163,7 +206,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode, baseCaseResult);
-  const double bestDistance = candidates[queryIndex].top().first;
+  const double bestDistance = (*candidates)[queryIndex].top().first;
 
   return Score(queryIndex, referenceNode, distance, bestDistance);
 }
@@ -206,7 +249,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           // Hence, approximate the node by sampling enough number of points.
           arma::uvec distinctSamples;
           math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-              samplesReqd, distinctSamples);
+              samplesReqd, distinctSamples, generator);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -222,7 +265,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             // Approximate node by sampling enough number of points.
             arma::uvec distinctSamples;
             math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-                samplesReqd, distinctSamples);
+                samplesReqd, distinctSamples, generator);
             for (size_t i = 0; i < distinctSamples.n_elem; i++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -275,7 +318,7 @@ Rescore(const size_t queryIndex,
     return oldScore;
 
   // Just check the score again against the distances.
-  const double bestDistance = candidates[queryIndex].top().first;
+  const double bestDistance = (*candidates)[queryIndex].top().first;
 
   // If this is better than the best distance we've seen so far,
   // maybe there will be something down this node.
@@ -310,7 +353,7 @@ Rescore(const size_t queryIndex,
         // by sampling enough number of points.
         arma::uvec distinctSamples;
         math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-            samplesReqd, distinctSamples);
+            samplesReqd, distinctSamples, generator);
         for (size_t i = 0; i < distinctSamples.n_elem; i++)
           // The counting of the samples are done in the 'BaseCase' function so
           // no book-keeping is required here.
@@ -326,7 +369,7 @@ Rescore(const size_t queryIndex,
           // Approximate node by sampling enough points.
           arma::uvec distinctSamples;
           math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-              samplesReqd, distinctSamples);
+              samplesReqd, distinctSamples, generator);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -375,7 +418,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = candidates[queryNode.Point(i)].top().first
+    const double bound = (*candidates)[queryNode.Point(i)].top().first
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -414,7 +457,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = candidates[queryNode.Point(i)].top().first
+    const double bound = (*candidates)[queryNode.Point(i)].top().first
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -513,7 +556,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           {
             const size_t queryIndex = queryNode.Descendant(i);
             math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-                samplesReqd, distinctSamples);
+                samplesReqd, distinctSamples, generator);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -543,7 +586,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             {
               const size_t queryIndex = queryNode.Descendant(i);
               math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-                  samplesReqd, distinctSamples);
+                  samplesReqd, distinctSamples, generator);
               for (size_t j = 0; j < distinctSamples.n_elem; j++)
                 // The counting of the samples are done in the 'BaseCase'
                 // function so no book-keeping is required here.
@@ -628,7 +671,7 @@ Rescore(TreeType& queryNode,
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = candidates[queryNode.Point(i)].top().first
+    const double bound = (*candidates)[queryNode.Point(i)].top().first
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -718,7 +761,7 @@ Rescore(TreeType& queryNode,
         {
           const size_t queryIndex = queryNode.Descendant(i);
           math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-              samplesReqd, distinctSamples);
+              samplesReqd, distinctSamples, generator);
           for (size_t j = 0; j < distinctSamples.n_elem; j++)
             // The counting of the samples are done in the 'BaseCase'
             // function so no book-keeping is required here.
@@ -747,7 +790,7 @@ Rescore(TreeType& queryNode,
           {
             const size_t queryIndex = queryNode.Descendant(i);
             math::ObtainDistinctSamples(0, referenceNode.NumDescendants(),
-                samplesReqd, distinctSamples);
+                samplesReqd, distinctSamples, generator);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in BaseCase() so no
               // book-keeping is required here.
@@ -813,7 +856,7 @@ InsertNeighbor(
     const size_t neighbor,
     const double distance)
 {
-  CandidateList& pqueue = candidates[queryIndex];
+  CandidateList& pqueue = (*candidates)[queryIndex];
   Candidate c = std::make_pair(distance, neighbor);
 
   if (CandidateCmp()(c, pqueue.top()))
@@ -98,6 +98,11 @@ using enable_if_t = typename enable_if<B, T>::type;
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/timers.hpp>
 
+// Use OpenMP if compiled with -DHAS_OPENMP.
+#ifdef HAS_OPENMP
+  #include <omp.h>
+#endif
+
 // On Visual Studio, disable C4519 (default arguments for function templates)
 // since it's by default an error, which doesn't even make any sense because
 // it's part of the C++11 standard.
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/dbscan/dbscan.hpp>
+#include <mlpack/methods/emst/union_find.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
@@ -141,4 +142,225 @@ BOOST_AUTO_TEST_CASE(GaussiansTest)
   }
 }
 
+/**
+ * Cluster the given points with a brute-force DBSCAN, numbering the clusters
+ * in the order of their smallest core point and assigning each other point to
+ * the cluster of its core neighbor with the smallest index.
+ */
+size_t BruteForceDBSCAN(const arma::mat& points,
+                        const double epsilon,
+                        const size_t minPoints,
+                        arma::Row<size_t>& assignments)
+{
+  arma::mat distances(points.n_cols, points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    for (size_t j = 0; j < points.n_cols; ++j)
+      distances(i, j) = metric::EuclideanDistance::Evaluate(points.col(i),
+          points.col(j));
+
+  std::vector<bool> core(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    core[i] = (arma::accu(distances.col(i) <= epsilon) >= minPoints);
+
+  assignments.set_size(points.n_cols);
+  assignments.fill(SIZE_MAX);
+  size_t clusters = 0;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    if (!core[i] || assignments[i] != SIZE_MAX)
+      continue;
+
+    // Find every core point reachable from this one.
+    std::vector<size_t> stack(1, i);
+    assignments[i] = clusters;
+    while (!stack.empty())
+    {
+      const size_t point = stack.back();
+      stack.pop_back();
+      for (size_t j = 0; j < points.n_cols; ++j)
+      {
+        if (core[j] && assignments[j] == SIZE_MAX &&
+            distances(point, j) <= epsilon)
+        {
+          assignments[j] = clusters;
+          stack.push_back(j);
+        }
+      }
+    }
+    ++clusters;
+  }
+
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    if (core[i])
+      continue;
+
+    for (size_t j = 0; j < points.n_cols; ++j)
+    {
+      if (core[j] && distances(i, j) <= epsilon)
+      {
+        assignments[i] = assignments[j];
+        break;
+      }
+    }
+  }
+
+  return clusters;
+}
+
+/**
+ * Generate a few Gaussian blobs with some uniform noise.
+ */
+arma::mat GenerateBlobs(const size_t dims)
+{
+  arma::mat points(dims, 1000);
+  points.randn();
+  for (size_t i = 0; i < 800; ++i)
+    points.col(i) = 0.5 * points.col(i) + 2.0 * (i % 4);
+  points.cols(800, 999).randu();
+  points.cols(800, 999) *= 8.0;
+
+  return points;
+}
+
+/**
+ * Make sure that the grid, used in low dimensions, gives exactly the clusters
+ * of a brute-force DBSCAN.
+ */
+BOOST_AUTO_TEST_CASE(GridBruteForceTest)
+{
+  for (size_t dims = 1; dims <= 3; ++dims)
+  {
+    const arma::mat points = GenerateBlobs(dims);
+    const double epsilon = 0.1 * dims;
+
+    arma::Row<size_t> bruteAssignments;
+    const size_t bruteClusters = BruteForceDBSCAN(points, epsilon, 4,
+        bruteAssignments);
+
+    DBSCAN<> d(epsilon, 4);
+    arma::Row<size_t> assignments;
+    const size_t clusters = d.Cluster(points, assignments);
+
+    BOOST_REQUIRE_EQUAL(clusters, bruteClusters);
+    for (size_t i = 0; i < points.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], bruteAssignments[i]);
+  }
+}
+
+/**
+ * Make sure that the range search, used in higher dimensions or with other
+ * distances, gives exactly the clusters of a brute-force DBSCAN.
+ */
+BOOST_AUTO_TEST_CASE(RangeSearchBruteForceTest)
+{
+  const arma::mat points = GenerateBlobs(5);
+
+  arma::Row<size_t> bruteAssignments;
+  const size_t bruteClusters = BruteForceDBSCAN(points, 0.6, 5,
+      bruteAssignments);
+
+  DBSCAN<> d(0.6, 5);
+  arma::Row<size_t> assignments;
+  const size_t clusters = d.Cluster(points, assignments);
+
+  BOOST_REQUIRE_EQUAL(clusters, bruteClusters);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], bruteAssignments[i]);
+
+  // Single-tree search streams the neighborhoods in the same order.
+  range::RangeSearch<> rs(false, true);
+  DBSCAN<> singleD(0.6, 5, rs);
+  arma::Row<size_t> singleAssignments;
+  BOOST_REQUIRE_EQUAL(singleD.Cluster(points, singleAssignments),
+      bruteClusters);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(singleAssignments[i], bruteAssignments[i]);
+}
+
+/**
+ * Make sure that the root of each component of a ConcurrentUnionFind is its
+ * smallest element.
+ */
+BOOST_AUTO_TEST_CASE(ConcurrentUnionFindTest)
+{
+  ConcurrentUnionFind components(10);
+  components.Union(7, 3);
+  components.Union(9, 7);
+  components.Union(5, 8);
+  components.Union(8, 9);
+
+  for (size_t i = 0; i < 10; ++i)
+  {
+    if (i == 3 || i == 5 || i == 7 || i == 8 || i == 9)
+      BOOST_REQUIRE_EQUAL(components.Find(i), 3);
+    else
+      BOOST_REQUIRE_EQUAL(components.Find(i), i);
+  }
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Union the elements of a ConcurrentUnionFind from several threads at once, and
+ * make sure that the components are the same as those of a serial
+ * emst::UnionFind, and that the root of each component is its smallest element.
+ */
+BOOST_AUTO_TEST_CASE(ParallelConcurrentUnionFindTest)
+{
+  const size_t size = 20000;
+  const size_t numPairs = 15000;
+
+  // Random pairs, plus chains that link every seventh element, so that some
+  // components are long and many threads work on the same component.
+  arma::Mat<size_t> pairs(2, numPairs + size - 7);
+  for (size_t i = 0; i < numPairs; ++i)
+  {
+    pairs(0, i) = math::RandInt(size);
+    pairs(1, i) = math::RandInt(size);
+  }
+  for (size_t i = 0; i < size - 7; ++i)
+  {
+    pairs(0, numPairs + i) = size - 1 - i;
+    pairs(1, numPairs + i) = size - 8 - i;
+  }
+  pairs = pairs.cols(arma::shuffle(arma::linspace<arma::uvec>(0,
+      pairs.n_cols - 1, pairs.n_cols)));
+
+  emst::UnionFind serialComponents(size);
+  for (size_t i = 0; i < pairs.n_cols; ++i)
+    serialComponents.Union(pairs(0, i), pairs(1, i));
+
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(4);
+
+  ConcurrentUnionFind components(size);
+#ifdef _WIN32
+  // Tiny workaround: Visual Studio only implements OpenMP 2.0, which doesn't
+  // support unsigned loop variables. If we're building for Visual Studio, use
+  // the intmax_t type instead.
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (intmax_t i = 0; i < (intmax_t) pairs.n_cols; ++i)
+#else
+  #pragma omp parallel for schedule(dynamic, 16)
+  for (size_t i = 0; i < pairs.n_cols; ++i)
+#endif
+    components.Union(pairs(0, i), pairs(1, i));
+
+  omp_set_num_threads(prevNumThreads);
+
+  // The smallest element of each serial component.
+  std::vector<size_t> smallest(size, size);
+  for (size_t i = 0; i < size; ++i)
+  {
+    const size_t root = serialComponents.Find(i);
+    smallest[root] = std::min(smallest[root], i);
+  }
+
+  for (size_t i = 0; i < size; ++i)
+    BOOST_REQUIRE_EQUAL(components.Find(i),
+        smallest[serialComponents.Find(i)]);
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
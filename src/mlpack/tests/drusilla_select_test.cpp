@@ -167,4 +167,39 @@ BOOST_AUTO_TEST_CASE(SparseTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+// Make sure that training on a dataset that is read in chunks gives the same
+// candidate set as training on the dataset in memory.
+BOOST_AUTO_TEST_CASE(StreamingTrainTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 1000);
+  dataset.save("drusilla_select_stream.bin", arma::arma_binary);
+
+  DrusillaSelect<> ds(dataset, 5, 4);
+
+  data::ChunkReader<> reader("drusilla_select_stream.bin");
+  BOOST_REQUIRE_EQUAL(reader.NumPoints(), 1000);
+  BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 4);
+
+  // Use a chunk size that doesn't divide the number of points.
+  DrusillaSelect<> streamingDs(5, 4);
+  streamingDs.Train(reader, 0, 0, 128);
+
+  remove("drusilla_select_stream.bin");
+
+  BOOST_REQUIRE_EQUAL(ds.CandidateIndices().n_elem,
+      streamingDs.CandidateIndices().n_elem);
+  for (size_t i = 0; i < ds.CandidateIndices().n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(ds.CandidateIndices()[i],
+        streamingDs.CandidateIndices()[i]);
+  CheckMatrices(ds.CandidateSet(), streamingDs.CandidateSet());
+
+  arma::Mat<size_t> neighbors, streamingNeighbors;
+  arma::mat distances, streamingDistances;
+  ds.Search(dataset, 3, neighbors, distances);
+  streamingDs.Search(dataset, 3, streamingNeighbors, streamingDistances);
+
+  CheckMatrices(neighbors, streamingNeighbors);
+  CheckMatrices(distances, streamingDistances);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -1075,4 +1075,83 @@ BOOST_AUTO_TEST_CASE(CopyAssignmentTest)
   }
 }
 
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that parallel single-tree FastMKS gives the same results as serial
+ * single-tree FastMKS, for both the bichromatic and monochromatic cases.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeTest)
+{
+  arma::mat referenceData = arma::randn<arma::mat>(5, 1000);
+  arma::mat queryData = arma::randn<arma::mat>(5, 500);
+  PolynomialKernel pk(2.0);
+
+  FastMKS<PolynomialKernel> f(referenceData, pk, true);
+
+  arma::Mat<size_t> parallelIndices, parallelMonoIndices;
+  arma::mat parallelProducts, parallelMonoProducts;
+  f.Search(queryData, 10, parallelIndices, parallelProducts);
+  f.Search(10, parallelMonoIndices, parallelMonoProducts);
+
+  // Now perform the same searches with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  arma::Mat<size_t> serialIndices, serialMonoIndices;
+  arma::mat serialProducts, serialMonoProducts;
+  f.Search(queryData, 10, serialIndices, serialProducts);
+  f.Search(10, serialMonoIndices, serialMonoProducts);
+
+  omp_set_num_threads(prevNumThreads);
+
+  CheckMatrices(parallelIndices, serialIndices);
+  CheckMatrices(parallelProducts, serialProducts);
+  CheckMatrices(parallelMonoIndices, serialMonoIndices);
+  CheckMatrices(parallelMonoProducts, serialMonoProducts);
+}
+#endif
+
+/**
+ * Make sure that naive search, which evaluates the kernel in blocks, gives the
+ * same results as single-tree search when the sets span several blocks.
+ */
+BOOST_AUTO_TEST_CASE(BlockedNaiveVsSingleTree)
+{
+  arma::mat referenceData = arma::randn<arma::mat>(5, 2500);
+  arma::mat queryData = arma::randn<arma::mat>(5, 600);
+  PolynomialKernel pk(2.0, 1.0);
+
+  FastMKS<PolynomialKernel> naive(referenceData, pk, false, true);
+  FastMKS<PolynomialKernel> single(referenceData, pk, true, false);
+
+  arma::Mat<size_t> naiveIndices, singleIndices;
+  arma::mat naiveProducts, singleProducts;
+  naive.Search(queryData, 5, naiveIndices, naiveProducts);
+  single.Search(queryData, 5, singleIndices, singleProducts);
+
+  for (size_t q = 0; q < naiveIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < naiveIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(naiveIndices(r, q), singleIndices(r, q));
+      BOOST_REQUIRE_CLOSE(naiveProducts(r, q), singleProducts(r, q), 1e-5);
+    }
+  }
+
+  // Now the monochromatic search, where no point may be its own candidate.
+  naive.Search(5, naiveIndices, naiveProducts);
+  single.Search(5, singleIndices, singleProducts);
+
+  for (size_t q = 0; q < naiveIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < naiveIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_NE(naiveIndices(r, q), q);
+      BOOST_REQUIRE_EQUAL(naiveIndices(r, q), singleIndices(r, q));
+      BOOST_REQUIRE_CLOSE(naiveProducts(r, q), singleProducts(r, q), 1e-5);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
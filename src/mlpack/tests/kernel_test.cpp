@@ -609,4 +609,56 @@ BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
   BOOST_REQUIRE_CLOSE(p.Evaluate(b, a), 11.0, 1e-5);
 }
 
+/**
+ * Make sure that EvaluateBlock() gives the same results as Evaluate() for the
+ * given kernel.
+ */
+template<typename KernelType>
+void CheckEvaluateBlock(KernelType& kernel)
+{
+  arma::mat a = arma::randn<arma::mat>(4, 20);
+  arma::mat b = arma::randn<arma::mat>(4, 30);
+  a.col(3).zeros();
+  b.col(5).zeros();
+
+  arma::mat kernels;
+  kernel.EvaluateBlock(a, b, kernels);
+
+  BOOST_REQUIRE_EQUAL(kernels.n_rows, a.n_cols);
+  BOOST_REQUIRE_EQUAL(kernels.n_cols, b.n_cols);
+  for (size_t j = 0; j < b.n_cols; ++j)
+  {
+    for (size_t i = 0; i < a.n_cols; ++i)
+    {
+      const double eval = kernel.Evaluate(a.col(i), b.col(j));
+      if (std::abs(eval) < 1e-10)
+        BOOST_REQUIRE_SMALL(kernels(i, j), 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(kernels(i, j), eval, 1e-5);
+    }
+  }
+}
+
+/**
+ * Test the block evaluation of the kernels that are computed from inner
+ * products.
+ */
+BOOST_AUTO_TEST_CASE(EvaluateBlockTest)
+{
+  BOOST_REQUIRE(KernelTraits<LinearKernel>::UsesInnerProduct);
+  BOOST_REQUIRE(KernelTraits<PolynomialKernel>::UsesInnerProduct);
+  BOOST_REQUIRE(KernelTraits<CosineDistance>::UsesInnerProduct);
+  BOOST_REQUIRE(KernelTraits<HyperbolicTangentKernel>::UsesInnerProduct);
+  BOOST_REQUIRE(!KernelTraits<GaussianKernel>::UsesInnerProduct);
+
+  LinearKernel lk;
+  CheckEvaluateBlock(lk);
+  PolynomialKernel pk(3.0, 1.5);
+  CheckEvaluateBlock(pk);
+  CosineDistance cd;
+  CheckEvaluateBlock(cd);
+  HyperbolicTangentKernel hk(0.5, 0.2);
+  CheckEvaluateBlock(hk);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -18,6 +18,8 @@
 #include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
 #include <mlpack/methods/kmeans/sample_initialization.hpp>
 #include <mlpack/methods/kmeans/random_partition.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel_initialization.hpp>
 
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
@@ -670,6 +672,53 @@ BOOST_AUTO_TEST_CASE(DTNNCoverTreeTest)
   }
 }
 
+/**
+ * Make sure that the dual-tree Lloyd step is still exact when it reuses the
+ * tree built on the centroids of an earlier iteration, by moving the centroids
+ * only a little between iterations.
+ */
+BOOST_AUTO_TEST_CASE(DTNNCentroidTreeReuseTest)
+{
+  arma::mat dataset(5, 2000);
+  dataset.randu();
+  arma::mat centroids(5, 30);
+  centroids.randu();
+
+  metric::EuclideanDistance metric;
+  DefaultDualTreeKMeans<metric::EuclideanDistance, arma::mat> dtnn(dataset,
+      metric);
+  CoverTreeDualTreeKMeans<metric::EuclideanDistance, arma::mat> ctnn(dataset,
+      metric);
+  NaiveKMeans<metric::EuclideanDistance, arma::mat> naive(dataset, metric);
+
+  for (size_t it = 0; it < 8; ++it)
+  {
+    arma::mat naiveCentroids, dtnnCentroids, ctnnCentroids;
+    arma::Col<size_t> naiveCounts, dtnnCounts, ctnnCounts;
+    naive.Iterate(centroids, naiveCentroids, naiveCounts);
+    dtnn.Iterate(centroids, dtnnCentroids, dtnnCounts);
+    ctnn.Iterate(centroids, ctnnCentroids, ctnnCounts);
+
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+    {
+      BOOST_REQUIRE_EQUAL(dtnnCounts[c], naiveCounts[c]);
+      BOOST_REQUIRE_EQUAL(ctnnCounts[c], naiveCounts[c]);
+      if (naiveCounts[c] == 0)
+        continue;
+
+      for (size_t d = 0; d < centroids.n_rows; ++d)
+      {
+        BOOST_REQUIRE_CLOSE(dtnnCentroids(d, c), naiveCentroids(d, c), 1e-5);
+        BOOST_REQUIRE_CLOSE(ctnnCentroids(d, c), naiveCentroids(d, c), 1e-5);
+      }
+    }
+
+    // Move every centroid a little bit.
+    centroids += 1e-4 * arma::randn<arma::mat>(centroids.n_rows,
+        centroids.n_cols);
+  }
+}
+
 /**
  * Make sure that the sample initialization strategy successfully samples points
  * from the dataset.
@@ -704,4 +753,387 @@ BOOST_AUTO_TEST_CASE(SampleInitializationTest)
   }
 }
 
+/**
+ * Generate a dataset of three well-separated Gaussian clusters, with the points
+ * of the clusters interleaved.
+ */
+void GenerateMiniBatchData(arma::mat& data, arma::mat& centers)
+{
+  centers = arma::mat("0.0 10.0 -10.0; 0.0 10.0 10.0");
+  data.randn(2, 3000);
+  data *= 0.5;
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) += centers.col(i % 3);
+}
+
+/**
+ * Make sure that each of the given centers has a centroid close to it.
+ */
+void CheckMiniBatchCentroids(const arma::mat& centroids,
+                             const arma::mat& centers)
+{
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, centers.n_rows);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, centers.n_cols);
+  for (size_t i = 0; i < centers.n_cols; ++i)
+  {
+    double minDistance = DBL_MAX;
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+      minDistance = std::min(minDistance, EuclideanDistance::Evaluate(
+          centers.col(i), centroids.col(j)));
+    BOOST_REQUIRE_LT(minDistance, 0.3);
+  }
+}
+
+/**
+ * Make sure that mini-batch k-means finds well-separated clusters in memory,
+ * and that the assignments match the centroids.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchKMeansTest)
+{
+  arma::mat data, centers;
+  GenerateMiniBatchData(data, centers);
+
+  MiniBatchKMeans<> kmeans(100, 300, 0.0);
+  arma::mat centroids = centers + 1.0;
+  arma::Row<size_t> assignments;
+  kmeans.Cluster(data, 3, assignments, centroids, true);
+
+  CheckMiniBatchCentroids(centroids, centers);
+  BOOST_REQUIRE_EQUAL(arma::accu(kmeans.Counts()), 300 * 100);
+
+  // Point i was generated around center i % 3, and the clusters are
+  // well-separated, so it must be assigned like the first point of its cluster.
+  BOOST_REQUIRE_EQUAL(assignments.n_elem, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[i % 3]);
+
+  // Without an initial guess, we should still get a centroid per cluster.
+  kmeans.Cluster(data, 3, assignments, centroids);
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 3);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_LT(assignments[i], 3);
+}
+
+/**
+ * Make sure that mini-batch k-means finds well-separated clusters when reading
+ * the dataset from disk, and that checkpoints are saved.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchKMeansStreamingTest)
+{
+  arma::mat data, centers;
+  GenerateMiniBatchData(data, centers);
+  data.save("mini_batch_kmeans_data.bin", arma::arma_binary);
+
+  data::ChunkReader<> reader("mini_batch_kmeans_data.bin");
+  MiniBatchKMeans<> kmeans(128, 200, 0.0);
+  kmeans.CheckpointInterval() = 50;
+  kmeans.CheckpointFile() = "mini_batch_kmeans_checkpoint.bin";
+
+  arma::mat centroids = centers + 1.0;
+  kmeans.Cluster(reader, 3, centroids, true);
+  CheckMiniBatchCentroids(centroids, centers);
+
+  // The last checkpoint was saved after the last iteration.
+  arma::mat checkpoint;
+  BOOST_REQUIRE(data::Load("mini_batch_kmeans_checkpoint.bin", checkpoint));
+  CheckMatrices(checkpoint, centroids);
+
+  remove("mini_batch_kmeans_data.bin");
+  remove("mini_batch_kmeans_checkpoint.bin");
+}
+
+/**
+ * Make sure that a naive Lloyd iteration with the Euclidean distance, which
+ * finds the nearest centroids with matrix multiplications, gives the same
+ * centroids as a brute-force search.
+ */
+BOOST_AUTO_TEST_CASE(NaiveKMeansGEMMTest)
+{
+  arma::mat dataset(5, 3000);
+  dataset.randu();
+  arma::mat centroids(5, 40);
+  centroids.randu();
+
+  metric::EuclideanDistance metric;
+  NaiveKMeans<metric::EuclideanDistance, arma::mat> naive(dataset, metric);
+  arma::mat newCentroids;
+  arma::Col<size_t> counts;
+  naive.Iterate(centroids, newCentroids, counts);
+
+  arma::mat bruteCentroids(5, 40, arma::fill::zeros);
+  arma::Col<size_t> bruteCounts(40, arma::fill::zeros);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    const arma::rowvec distances = arma::sum(arma::square(
+        centroids.each_col() - dataset.col(i)));
+    arma::uword closest;
+    distances.min(closest);
+    bruteCentroids.col(closest) += dataset.col(i);
+    bruteCounts[closest]++;
+  }
+
+  BOOST_REQUIRE_EQUAL(naive.DistanceCalculations(), (size_t) (3000 * 40 + 40));
+  for (size_t c = 0; c < 40; ++c)
+  {
+    BOOST_REQUIRE_EQUAL(counts[c], bruteCounts[c]);
+    if (bruteCounts[c] > 0)
+      bruteCentroids.col(c) /= bruteCounts[c];
+  }
+
+  for (size_t i = 0; i < bruteCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(newCentroids[i], bruteCentroids[i], 1e-5);
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+
+/**
+ * Run k-means with the given Lloyd step type, first on one thread and then on
+ * all threads, and make sure that the results are exactly the same.
+ */
+template<template<class, class> class LloydStepType>
+void CheckParallelLloydStep(const arma::mat& dataset,
+                            const arma::mat& initialCentroids)
+{
+  KMeans<metric::EuclideanDistance, SampleInitialization, MaxVarianceNewCluster,
+      LloydStepType> kmeans;
+
+  const int prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  arma::Row<size_t> serialAssignments;
+  arma::mat serialCentroids(initialCentroids);
+  kmeans.Cluster(dataset, initialCentroids.n_cols, serialAssignments,
+      serialCentroids, false, true);
+
+  omp_set_num_threads(prevNumThreads);
+  arma::Row<size_t> assignments;
+  arma::mat centroids(initialCentroids);
+  kmeans.Cluster(dataset, initialCentroids.n_cols, assignments, centroids,
+      false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], serialAssignments[i]);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(centroids[i], serialCentroids[i]);
+}
+
+/**
+ * Make sure that the naive, Elkan and Hamerly Lloyd steps give the same results
+ * whatever the number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelLloydStepTest)
+{
+  arma::mat dataset(8, 5000);
+  dataset.randu();
+  arma::mat centroids(8, 25);
+  centroids.randu();
+
+  CheckParallelLloydStep<NaiveKMeans>(dataset, centroids);
+  CheckParallelLloydStep<ElkanKMeans>(dataset, centroids);
+  CheckParallelLloydStep<HamerlyKMeans>(dataset, centroids);
+}
+
+/**
+ * Make sure that the dual-tree Lloyd steps, which traverse subtrees of the
+ * dataset tree in parallel, still give exact results on all threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeKMeansTest)
+{
+  arma::mat dataset(6, 5000);
+  dataset.randu();
+  arma::mat centroids(6, 40);
+  centroids.randu();
+
+  arma::Row<size_t> assignments;
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  km.Cluster(dataset, centroids.n_cols, assignments, naiveCentroids, false,
+      true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      DefaultDualTreeKMeans> dtnn;
+  arma::Row<size_t> dtnnAssignments;
+  arma::mat dtnnCentroids(centroids);
+  dtnn.Cluster(dataset, centroids.n_cols, dtnnAssignments, dtnnCentroids,
+      false, true);
+
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      CoverTreeDualTreeKMeans> ctnn;
+  arma::Row<size_t> ctnnAssignments;
+  arma::mat ctnnCentroids(centroids);
+  ctnn.Cluster(dataset, centroids.n_cols, ctnnAssignments, ctnnCentroids,
+      false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(dtnnAssignments[i], assignments[i]);
+    BOOST_REQUIRE_EQUAL(ctnnAssignments[i], assignments[i]);
+  }
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dtnnCentroids[i], naiveCentroids[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(ctnnCentroids[i], naiveCentroids[i], 1e-5);
+  }
+}
+
+#endif
+
+/**
+ * Generate a dataset of 20 small, well-separated clusters in three dimensions.
+ * Point i belongs to cluster i % 20.
+ */
+void GenerateSeparatedData(arma::mat& data, arma::mat& centers)
+{
+  centers.zeros(3, 20);
+  for (size_t i = 0; i < 20; ++i)
+  {
+    centers(0, i) = 10.0 * (i % 5);
+    centers(1, i) = 10.0 * (i / 5);
+    centers(2, i) = (i % 2 == 0) ? 0.0 : 10.0;
+  }
+
+  data.randn(3, 4000);
+  data *= 0.1;
+  for (size_t i = 0; i < data.n_cols; ++i)
+    data.col(i) += centers.col(i % 20);
+}
+
+/**
+ * Make sure that k-means|| chooses one initial centroid in each of a set of
+ * well-separated clusters, and that it works as the initial partition policy
+ * of KMeans.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelInitializationTest)
+{
+  arma::mat data, centers;
+  GenerateSeparatedData(data, centers);
+
+  KMeansParallelInitialization init;
+  arma::mat centroids;
+  init.Cluster(data, 20, centroids);
+
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 20);
+  for (size_t i = 0; i < centers.n_cols; ++i)
+  {
+    size_t closeCentroids = 0;
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+      if (EuclideanDistance::Evaluate(centers.col(i), centroids.col(j)) < 1.0)
+        ++closeCentroids;
+    BOOST_REQUIRE_EQUAL(closeCentroids, 1);
+  }
+
+  // With such initial centroids, k-means finds the clusters.
+  KMeans<EuclideanDistance, KMeansParallelInitialization> kmeans;
+  arma::Row<size_t> assignments;
+  kmeans.Cluster(data, 20, assignments);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], assignments[i % 20]);
+
+  // With fewer points than clusters, there should still be enough centroids.
+  arma::mat smallData = data.cols(0, 4);
+  init.Cluster(smallData, 10, centroids);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 10);
+}
+
+/**
+ * A KMeansParallelInitialization that counts the calls to each of its Cluster()
+ * overloads, so we can check which one was used.
+ */
+class CountingParallelInitialization : public KMeansParallelInitialization
+{
+ public:
+  CountingParallelInitialization() : matrixCalls(0), readerCalls(0) { }
+
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::mat& centroids)
+  {
+    ++matrixCalls;
+    KMeansParallelInitialization::Cluster(data, clusters, centroids);
+  }
+
+  template<typename eT>
+  void Cluster(data::ChunkReader<eT>& reader,
+               const size_t clusters,
+               arma::mat& centroids)
+  {
+    ++readerCalls;
+    KMeansParallelInitialization::Cluster(reader, clusters, centroids);
+  }
+
+  //! The number of calls with a matrix.
+  size_t matrixCalls;
+  //! The number of calls with a ChunkReader.
+  size_t readerCalls;
+};
+
+/**
+ * Make sure that k-means|| gives the same centroids when reading the dataset
+ * from disk as in memory, and that mini-batch k-means uses it when reading
+ * from disk.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelInitializationStreamingTest)
+{
+  arma::mat data, centers;
+  GenerateSeparatedData(data, centers);
+  data.save("kmeans_parallel_data.bin", arma::arma_binary);
+
+  KMeansParallelInitialization init(3, 2.0, 2048);
+  arma::mat centroids;
+  math::RandomSeed(42);
+  init.Cluster(data, 20, centroids);
+
+  data::ChunkReader<> reader("kmeans_parallel_data.bin");
+  arma::mat streamingCentroids;
+  math::RandomSeed(42);
+  init.Cluster(reader, 20, streamingCentroids);
+  CheckMatrices(centroids, streamingCentroids);
+
+  // MiniBatchKMeans must hand the reader itself to k-means||, instead of
+  // sampling points from it.
+  BOOST_REQUIRE((ReadsChunks<KMeansParallelInitialization, double>::value));
+  MiniBatchKMeans<EuclideanDistance, CountingParallelInitialization> kmeans(
+      200, 300, 0.0);
+  kmeans.Cluster(reader, 20, centroids);
+  BOOST_REQUIRE_EQUAL(kmeans.Partitioner().readerCalls, (size_t) 1);
+  BOOST_REQUIRE_EQUAL(kmeans.Partitioner().matrixCalls, (size_t) 0);
+  CheckMiniBatchCentroids(centroids, centers);
+
+  remove("kmeans_parallel_data.bin");
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+
+/**
+ * Make sure that k-means|| gives the same centroids whatever the number of
+ * threads.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelInitializationThreadsTest)
+{
+  arma::mat data, centers;
+  GenerateSeparatedData(data, centers);
+
+  KMeansParallelInitialization init;
+  const int prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  arma::mat serialCentroids;
+  math::RandomSeed(7);
+  init.Cluster(data, 20, serialCentroids);
+
+  omp_set_num_threads(prevNumThreads);
+  arma::mat centroids;
+  math::RandomSeed(7);
+  init.Cluster(data, 20, centroids);
+
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(centroids[i], serialCentroids[i]);
+}
+
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -10,12 +10,14 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/dynamic_neighbor_search.hpp>
 #include <mlpack/methods/neighbor_search/unmap.hpp>
 #include <mlpack/methods/neighbor_search/ns_model.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/example_tree.hpp>
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
+#include "serialization.hpp"
 
 using namespace mlpack;
 using namespace mlpack::neighbor;
@@ -1436,4 +1438,623 @@ BOOST_AUTO_TEST_CASE(MoveOperatorNaiveTest)
   CheckMatrices(distances, distances2);
 }
 
+/**
+ * The dual-tree traversal computes leaf-leaf base cases in blocks, estimating
+ * the distances with ||q||^2 + ||r||^2 - 2 q^T r.  Make sure that the results
+ * are still exact for both nearest and furthest neighbor search when the points
+ * are far from the origin, where that estimate is the least accurate.
+ */
+BOOST_AUTO_TEST_CASE(BaseCaseBlockTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 2000) + 1000.0;
+
+  KNN knn(dataset, DUAL_TREE_MODE);
+  KNN naiveKNN(dataset, NAIVE_MODE);
+  KFN kfn(dataset, DUAL_TREE_MODE);
+  KFN naiveKFN(dataset, NAIVE_MODE);
+
+  arma::Mat<size_t> neighbors, naiveNeighbors;
+  arma::mat distances, naiveDistances;
+
+  knn.Search(10, neighbors, distances);
+  naiveKNN.Search(10, naiveNeighbors, naiveDistances);
+  CheckMatrices(neighbors, naiveNeighbors);
+  CheckMatrices(distances, naiveDistances);
+
+  kfn.Search(10, neighbors, distances);
+  naiveKFN.Search(10, naiveNeighbors, naiveDistances);
+  CheckMatrices(neighbors, naiveNeighbors);
+  CheckMatrices(distances, naiveDistances);
+}
+
+/**
+ * A wrapper around NeighborSearchRules without BaseCaseBlock(), so that the
+ * dual-tree traverser calls BaseCase() for each pair of points in two leaves.
+ */
+template<typename RuleType, typename TreeType>
+class PerPairRules
+{
+ public:
+  typedef typename RuleType::TraversalInfoType TraversalInfoType;
+
+  PerPairRules(RuleType& rules) : rules(rules) { }
+
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex)
+  {
+    return rules.BaseCase(queryIndex, referenceIndex);
+  }
+
+  double Score(const size_t queryIndex, TreeType& referenceNode)
+  {
+    return rules.Score(queryIndex, referenceNode);
+  }
+
+  double Score(TreeType& queryNode, TreeType& referenceNode)
+  {
+    return rules.Score(queryNode, referenceNode);
+  }
+
+  TraversalInfoType& TraversalInfo() { return rules.TraversalInfo(); }
+
+ private:
+  RuleType& rules;
+};
+
+/**
+ * Time the dual-tree traversal with BaseCaseBlock() against the same traversal
+ * with one BaseCase() call per pair of points, and make sure that both give the
+ * same results, and that the blocked traversal does not count more base cases.
+ * The timings are printed with Log::Info.
+ */
+BOOST_AUTO_TEST_CASE(BaseCaseBlockTimingTest)
+{
+  typedef KNN::Tree TreeType;
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+
+  arma::mat dataset = arma::randu<arma::mat>(10, 5000);
+  std::vector<size_t> oldFromNew;
+  TreeType blockTree(dataset, oldFromNew, 20);
+  TreeType perPairTree(blockTree);
+  EuclideanDistance metric;
+
+  arma::Mat<size_t> blockNeighbors, perPairNeighbors;
+  arma::mat blockDistances, perPairDistances;
+
+  Timer::Start("knn_base_case_block");
+  RuleType blockRules(blockTree.Dataset(), blockTree.Dataset(), 10, metric, 0,
+      true);
+  TreeType::DualTreeTraverser<RuleType> blockTraverser(blockRules);
+  blockTraverser.Traverse(blockTree, blockTree);
+  Timer::Stop("knn_base_case_block");
+  blockRules.GetResults(blockNeighbors, blockDistances);
+
+  Timer::Start("knn_base_case_per_pair");
+  RuleType rules(perPairTree.Dataset(), perPairTree.Dataset(), 10, metric, 0,
+      true);
+  PerPairRules<RuleType, TreeType> perPairRules(rules);
+  TreeType::DualTreeTraverser<PerPairRules<RuleType, TreeType>>
+      perPairTraverser(perPairRules);
+  perPairTraverser.Traverse(perPairTree, perPairTree);
+  Timer::Stop("knn_base_case_per_pair");
+  rules.GetResults(perPairNeighbors, perPairDistances);
+
+  Log::Info << "Dual-tree kNN with BaseCaseBlock(): "
+      << Timer::Get("knn_base_case_block").count() << "us; with per-pair "
+      << "BaseCase(): " << Timer::Get("knn_base_case_per_pair").count()
+      << "us." << std::endl;
+
+  CheckMatrices(blockNeighbors, perPairNeighbors);
+  CheckMatrices(blockDistances, perPairDistances);
+
+  // Pairs that BaseCaseBlock() skips are not base cases.
+  BOOST_REQUIRE_GT(blockRules.BaseCases(), (size_t) 0);
+  BOOST_REQUIRE_LE(blockRules.BaseCases(), rules.BaseCases());
+
+  // KNN gives the rules the reference norms it computed when it was trained,
+  // and that must not change the results either.
+  KNN knn(dataset);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(10, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    const size_t queryIndex = oldFromNew[i];
+    for (size_t j = 0; j < neighbors.n_rows; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors(j, queryIndex),
+          oldFromNew[blockNeighbors(j, i)]);
+      BOOST_REQUIRE_CLOSE(distances(j, queryIndex), blockDistances(j, i),
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Insert points into and remove points from a DynamicNeighborSearch object, and
+ * make sure that the results are the same as the results of a naive search on
+ * the points that are left.
+ */
+BOOST_AUTO_TEST_CASE(DynamicNeighborSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 1500);
+  arma::mat querySet = arma::randu<arma::mat>(3, 100);
+
+  DynamicNeighborSearch<> knn(dataset.cols(0, 499));
+  BOOST_REQUIRE_EQUAL(knn.NumPoints(), (size_t) 500);
+
+  // Insert the rest of the points in small batches, and remove some of the
+  // points as we go.
+  std::vector<bool> removed(dataset.n_cols, false);
+  for (size_t i = 500; i < dataset.n_cols; i += 50)
+  {
+    BOOST_REQUIRE_EQUAL(knn.Insert(dataset.cols(i, i + 49)), i);
+
+    for (size_t j = 0; j < 20; ++j)
+    {
+      const size_t index = math::RandInt(i + 50);
+      if (!removed[index])
+      {
+        knn.Remove(index);
+        removed[index] = true;
+      }
+    }
+  }
+
+  // Removing a point twice is an error.
+  size_t removedIndex = 0;
+  while (!removed[removedIndex])
+    ++removedIndex;
+  BOOST_REQUIRE_THROW(knn.Remove(removedIndex), std::invalid_argument);
+  BOOST_REQUIRE_THROW(knn.Remove(dataset.n_cols), std::invalid_argument);
+
+  // The number of components should stay logarithmic.
+  BOOST_REQUIRE_LE(knn.NumComponents(), (size_t) 12);
+
+  // Build the naive model on the points that are left.
+  std::vector<size_t> liveIndices;
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    if (!removed[i])
+      liveIndices.push_back(i);
+  BOOST_REQUIRE_EQUAL(knn.NumPoints(), liveIndices.size());
+
+  arma::mat liveSet(3, liveIndices.size());
+  for (size_t i = 0; i < liveIndices.size(); ++i)
+    liveSet.col(i) = dataset.col(liveIndices[i]);
+  KNN naive(liveSet, NAIVE_MODE);
+
+  arma::Mat<size_t> neighbors, naiveNeighbors;
+  arma::mat distances, naiveDistances;
+  knn.Search(querySet, 10, neighbors, distances);
+  naive.Search(querySet, 10, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], liveIndices[naiveNeighbors[i]]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Remove every point of a component of a DynamicNeighborSearch object, and make
+ * sure that the points already removed from the later components stay removed.
+ */
+BOOST_AUTO_TEST_CASE(DynamicNeighborSearchEmptyComponentTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 28);
+
+  // Build components of 16, 8 and 4 points.
+  DynamicNeighborSearch<> knn(dataset.cols(0, 15));
+  knn.Insert(dataset.cols(16, 23));
+  knn.Insert(dataset.cols(24, 27));
+  BOOST_REQUIRE_EQUAL(knn.NumComponents(), (size_t) 3);
+
+  // Remove a point from the last component, then all of the middle component.
+  knn.Remove(24);
+  for (size_t i = 16; i < 24; ++i)
+    knn.Remove(i);
+
+  BOOST_REQUIRE_EQUAL(knn.NumComponents(), (size_t) 2);
+  BOOST_REQUIRE_EQUAL(knn.NumPoints(), (size_t) 19);
+
+  // The point removed first must not have come back.
+  BOOST_REQUIRE_THROW(knn.Remove(24), std::invalid_argument);
+  BOOST_REQUIRE_THROW(knn.Remove(20), std::invalid_argument);
+  BOOST_REQUIRE_EQUAL(knn.NumPoints(), (size_t) 19);
+
+  // The other points of the last component can still be removed.
+  knn.Remove(25);
+  BOOST_REQUIRE_EQUAL(knn.NumPoints(), (size_t) 18);
+}
+
+/**
+ * Make sure that the streaming search hands every query point to the sink
+ * exactly once, in order, with the same results as the regular search, in
+ * every search mode.
+ */
+BOOST_AUTO_TEST_CASE(StreamingSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 350);
+
+  const NeighborSearchMode modes[] = { NAIVE_MODE, SINGLE_TREE_MODE,
+      DUAL_TREE_MODE, GREEDY_SINGLE_TREE_MODE };
+  for (size_t m = 0; m < 4; ++m)
+  {
+    KNN knn(referenceData, modes[m]);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, 5, neighbors, distances);
+
+    // Use a batch size that does not divide the number of query points.
+    size_t nextQuery = 0;
+    knn.Search(queryData, 5, [&](const size_t queryIndex,
+                                 const arma::Col<size_t>& queryNeighbors,
+                                 const arma::vec& queryDistances)
+        {
+          BOOST_REQUIRE_EQUAL(queryIndex, nextQuery++);
+          BOOST_REQUIRE_EQUAL(queryNeighbors.n_elem, (size_t) 5);
+          BOOST_REQUIRE_EQUAL(queryDistances.n_elem, (size_t) 5);
+          for (size_t j = 0; j < 5; ++j)
+          {
+            BOOST_REQUIRE_EQUAL(queryNeighbors[j], neighbors(j, queryIndex));
+            BOOST_REQUIRE_CLOSE(queryDistances[j], distances(j, queryIndex),
+                1e-5);
+          }
+        }, 100);
+
+    BOOST_REQUIRE_EQUAL(nextQuery, (size_t) queryData.n_cols);
+  }
+}
+
+/**
+ * Make sure that neighbor search works on single-precision data: tree-based
+ * search must give the same results as naive search on the same data, and the
+ * distances must be close to those computed in double precision.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(5, 200);
+  arma::fmat fReferenceData = arma::conv_to<arma::fmat>::from(referenceData);
+  arma::fmat fQueryData = arma::conv_to<arma::fmat>::from(queryData);
+
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::fmat,
+      KDTree> FloatKNN;
+  FloatKNN naive(fReferenceData, NAIVE_MODE);
+  FloatKNN singleTree(fReferenceData, SINGLE_TREE_MODE);
+  FloatKNN dualTree(fReferenceData, DUAL_TREE_MODE);
+  KNN doubleNaive(referenceData, NAIVE_MODE);
+
+  arma::Mat<size_t> naiveNeighbors, singleNeighbors, dualNeighbors,
+      doubleNeighbors;
+  arma::mat naiveDistances, singleDistances, dualDistances, doubleDistances;
+  naive.Search(fQueryData, 10, naiveNeighbors, naiveDistances);
+  singleTree.Search(fQueryData, 10, singleNeighbors, singleDistances);
+  dualTree.Search(fQueryData, 10, dualNeighbors, dualDistances);
+  doubleNaive.Search(queryData, 10, doubleNeighbors, doubleDistances);
+
+  for (size_t i = 0; i < naiveNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(singleNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_EQUAL(dualNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(singleDistances[i], naiveDistances[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(dualDistances[i], naiveDistances[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(naiveDistances[i], doubleDistances[i], 1e-3);
+  }
+}
+
+/**
+ * Make sure that an NSModel holding single-precision data gives the same
+ * results as naive search on single-precision data, for kd-trees and ball trees
+ * and for every search mode, and that it survives serialization.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionModelTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500);
+  arma::mat queryData = arma::randu<arma::mat>(5, 100);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::fmat, KDTree>
+      naive(arma::conv_to<arma::fmat>::from(referenceData), NAIVE_MODE);
+  arma::Mat<size_t> trueNeighbors, trueMonoNeighbors;
+  arma::mat trueDistances, trueMonoDistances;
+  naive.Search(arma::conv_to<arma::fmat>::from(queryData), 5, trueNeighbors,
+      trueDistances);
+  naive.Search(5, trueMonoNeighbors, trueMonoDistances);
+
+  const KNNModel::TreeTypes treeTypes[] = { KNNModel::KD_TREE,
+                                            KNNModel::BALL_TREE };
+  const NeighborSearchMode searchModes[] = { NAIVE_MODE, SINGLE_TREE_MODE,
+                                             DUAL_TREE_MODE };
+  for (size_t t = 0; t < 2; ++t)
+  {
+    for (size_t m = 0; m < 3; ++m)
+    {
+      KNNModel model(treeTypes[t]);
+      model.SinglePrecision() = true;
+      model.BuildModel(arma::mat(referenceData), 10, searchModes[m]);
+
+      BOOST_REQUIRE_EQUAL(model.Dimensionality(), (size_t) 5);
+      BOOST_REQUIRE_EQUAL(model.NumPoints(), (size_t) 500);
+      BOOST_REQUIRE_THROW(model.Dataset(), std::invalid_argument);
+
+      KNNModel xmlModel, textModel, binaryModel;
+      SerializeObjectAll(model, xmlModel, textModel, binaryModel);
+
+      KNNModel* models[] = { &model, &xmlModel, &textModel, &binaryModel };
+      for (size_t i = 0; i < 4; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(models[i]->SinglePrecision(), true);
+
+        arma::Mat<size_t> neighbors, monoNeighbors;
+        arma::mat distances, monoDistances;
+        models[i]->Search(arma::mat(queryData), 5, neighbors, distances);
+        models[i]->Search(5, monoNeighbors, monoDistances);
+
+        for (size_t j = 0; j < trueNeighbors.n_elem; ++j)
+        {
+          BOOST_REQUIRE_EQUAL(neighbors[j], trueNeighbors[j]);
+          BOOST_REQUIRE_CLOSE(distances[j], trueDistances[j], 1e-5);
+        }
+        for (size_t j = 0; j < trueMonoNeighbors.n_elem; ++j)
+        {
+          BOOST_REQUIRE_EQUAL(monoNeighbors[j], trueMonoNeighbors[j]);
+          BOOST_REQUIRE_CLOSE(monoDistances[j], trueMonoDistances[j], 1e-5);
+        }
+      }
+    }
+  }
+
+  // Other tree types can't hold single-precision data.
+  KNNModel coverModel(KNNModel::COVER_TREE);
+  coverModel.SinglePrecision() = true;
+  BOOST_REQUIRE_THROW(coverModel.BuildModel(arma::mat(referenceData), 10,
+      DUAL_TREE_MODE), std::invalid_argument);
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that the parallel dual-tree search returns exactly the same results
+ * as the serial dual-tree search, for both the bichromatic and monochromatic
+ * cases, and for cover trees too.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 1500);
+
+  KNN knn(referenceData);
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, RStarTree>
+      rknn(referenceData);
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      StandardCoverTree> cknn(referenceData);
+
+  arma::Mat<size_t> parallelNeighbors, parallelMonoNeighbors,
+      rParallelNeighbors, cParallelNeighbors, cParallelMonoNeighbors;
+  arma::mat parallelDistances, parallelMonoDistances, rParallelDistances,
+      cParallelDistances, cParallelMonoDistances;
+  knn.Search(queryData, 10, parallelNeighbors, parallelDistances);
+  knn.Search(10, parallelMonoNeighbors, parallelMonoDistances);
+  rknn.Search(queryData, 10, rParallelNeighbors, rParallelDistances);
+  cknn.Search(queryData, 10, cParallelNeighbors, cParallelDistances);
+  cknn.Search(10, cParallelMonoNeighbors, cParallelMonoDistances);
+
+  // Now perform the same searches with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  arma::Mat<size_t> serialNeighbors, serialMonoNeighbors, rSerialNeighbors,
+      cSerialNeighbors, cSerialMonoNeighbors;
+  arma::mat serialDistances, serialMonoDistances, rSerialDistances,
+      cSerialDistances, cSerialMonoDistances;
+  knn.Search(queryData, 10, serialNeighbors, serialDistances);
+  knn.Search(10, serialMonoNeighbors, serialMonoDistances);
+  rknn.Search(queryData, 10, rSerialNeighbors, rSerialDistances);
+  cknn.Search(queryData, 10, cSerialNeighbors, cSerialDistances);
+  cknn.Search(10, cSerialMonoNeighbors, cSerialMonoDistances);
+
+  omp_set_num_threads(prevNumThreads);
+
+  CheckMatrices(parallelNeighbors, serialNeighbors);
+  CheckMatrices(parallelDistances, serialDistances);
+  CheckMatrices(parallelMonoNeighbors, serialMonoNeighbors);
+  CheckMatrices(parallelMonoDistances, serialMonoDistances);
+  CheckMatrices(rParallelNeighbors, rSerialNeighbors);
+  CheckMatrices(rParallelDistances, rSerialDistances);
+  CheckMatrices(cParallelNeighbors, cSerialNeighbors);
+  CheckMatrices(cParallelDistances, cSerialDistances);
+  CheckMatrices(cParallelMonoNeighbors, cSerialMonoNeighbors);
+  CheckMatrices(cParallelMonoDistances, cSerialMonoDistances);
+}
+#endif
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that the parallel dual-tree search records node combinations at the
+ * same depths as the serial search.  The reference set fits in one leaf and
+ * every reference point is a neighbor, so nothing is pruned and both searches
+ * visit each query node once; the parallel search only skips the nodes above
+ * the subtrees it splits the query tree into.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeProfileTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 15);
+  arma::mat queryData = arma::randu<arma::mat>(3, 2000);
+
+  KNN knn(referenceData);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  const size_t prevNumThreads = omp_get_max_threads();
+  Counter::Reset();
+  Counter::Enable();
+  omp_set_num_threads(1);
+  knn.Search(queryData, 15, neighbors, distances);
+  const std::vector<double> serialVisits = Counter::Get("dual_tree_visits");
+  const std::vector<double> serialPrunes = Counter::Get("dual_tree_prunes");
+
+  Counter::Reset();
+  omp_set_num_threads(4);
+  knn.Search(queryData, 15, neighbors, distances);
+  const std::vector<double> parallelVisits = Counter::Get("dual_tree_visits");
+  const std::vector<double> parallelPrunes = Counter::Get("dual_tree_prunes");
+  Counter::Enable(false);
+  Counter::Reset();
+  omp_set_num_threads(prevNumThreads);
+
+  // The deepest node combinations are the leaves of the query tree, which are
+  // visited by both searches.
+  BOOST_REQUIRE_GT(serialVisits.size(), (size_t) 3);
+  BOOST_REQUIRE_EQUAL(parallelVisits.size(), serialVisits.size());
+  BOOST_REQUIRE_CLOSE(parallelVisits.back(), serialVisits.back(), 1e-5);
+
+  // The parallel search splits the query tree into at most 8 subtrees per
+  // thread, so it skips fewer than 32 nodes.
+  double skipped = 0.0;
+  for (size_t i = 0; i < serialVisits.size(); ++i)
+  {
+    BOOST_REQUIRE_LE(parallelVisits[i], serialVisits[i]);
+    skipped += serialVisits[i] - parallelVisits[i];
+  }
+  BOOST_REQUIRE_LT(skipped, 32.0);
+
+  BOOST_REQUIRE(serialPrunes.empty());
+  BOOST_REQUIRE(parallelPrunes.empty());
+}
+#endif
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that the parallel single-tree search returns exactly the same
+ * results as the serial single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 1500);
+
+  KNN knn(referenceData, SINGLE_TREE_MODE);
+
+  arma::Mat<size_t> parallelNeighbors, parallelMonoNeighbors;
+  arma::mat parallelDistances, parallelMonoDistances;
+  knn.Search(queryData, 10, parallelNeighbors, parallelDistances);
+  knn.Search(10, parallelMonoNeighbors, parallelMonoDistances);
+
+  // Now perform the same searches with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  arma::Mat<size_t> serialNeighbors, serialMonoNeighbors;
+  arma::mat serialDistances, serialMonoDistances;
+  knn.Search(queryData, 10, serialNeighbors, serialDistances);
+  knn.Search(10, serialMonoNeighbors, serialMonoDistances);
+
+  omp_set_num_threads(prevNumThreads);
+
+  CheckMatrices(parallelNeighbors, serialNeighbors);
+  CheckMatrices(parallelDistances, serialDistances);
+  CheckMatrices(parallelMonoNeighbors, serialMonoNeighbors);
+  CheckMatrices(parallelMonoDistances, serialMonoDistances);
+}
+#endif
+
+/**
+ * Make sure that the traversal and tree profiling counters are recorded when
+ * counters are enabled, and not when they are disabled.
+ */
+BOOST_AUTO_TEST_CASE(ProfilingCountersTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+
+  Counter::Reset();
+  KNN knn(dataset);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(5, neighbors, distances);
+  BOOST_REQUIRE(Counter::Get("dual_tree_visits").empty());
+
+  // The reference tree is described when it is built, so searching several
+  // times must not count it again.
+  Counter::Enable();
+  knn.Train(dataset);
+  knn.Search(5, neighbors, distances);
+  knn.Search(5, neighbors, distances);
+  const std::vector<double> visits = Counter::Get("dual_tree_visits");
+  const std::vector<double> prunes = Counter::Get("dual_tree_prunes");
+  const std::vector<double> nodes = Counter::Get("reference_tree_nodes");
+  const std::vector<double> leafSizes =
+      Counter::Get("reference_tree_leaf_sizes");
+  Counter::Enable(false);
+  Counter::Reset();
+
+  BOOST_REQUIRE_GT(visits.size(), 1);
+  BOOST_REQUIRE_GE(visits[0], 1.0);
+  BOOST_REQUIRE_LE(prunes.size(), visits.size());
+  BOOST_REQUIRE_GT(nodes.size(), 1);
+  BOOST_REQUIRE_CLOSE(nodes[0], 1.0, 1e-5);
+
+  // Every point is held in exactly one leaf of a kd-tree.
+  double numPoints = 0.0;
+  for (size_t i = 0; i < leafSizes.size(); ++i)
+    numPoints += i * leafSizes[i];
+  BOOST_REQUIRE_CLOSE(numPoints, 1000.0, 1e-5);
+}
+
+/**
+ * Save the reference tree of a KNNModel to a flat tree file, load it into
+ * another KNNModel, and make sure that both models give the same results.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelTreeFileTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat queryData = arma::randu<arma::mat>(10, 50);
+  arma::mat referenceData = arma::randu<arma::mat>(10, 200);
+
+  for (size_t t = 0; t < 2; ++t)
+  {
+    const KNNModel::TreeTypes treeType = (t == 0) ?
+        KNNModel::TreeTypes::KD_TREE : KNNModel::TreeTypes::BALL_TREE;
+
+    KNNModel model(treeType, false);
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), 20, DUAL_TREE_MODE);
+    model.SaveTree("knn_tree.bin");
+
+    KNNModel loadedModel(treeType, false);
+    loadedModel.LoadTree("knn_tree.bin", DUAL_TREE_MODE);
+    BOOST_REQUIRE_EQUAL(loadedModel.Dimensionality(), (size_t) 10);
+
+    arma::Mat<size_t> neighbors, loadedNeighbors;
+    arma::mat distances, loadedDistances;
+    arma::mat queryCopy(queryData);
+    model.Search(std::move(queryCopy), 3, neighbors, distances);
+    queryCopy = queryData;
+    loadedModel.Search(std::move(queryCopy), 3, loadedNeighbors,
+        loadedDistances);
+
+    BOOST_REQUIRE_EQUAL(loadedNeighbors.n_elem, neighbors.n_elem);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(loadedNeighbors[i], neighbors[i]);
+      BOOST_REQUIRE_CLOSE(loadedDistances[i], distances[i], 1e-5);
+    }
+  }
+
+  // Trees other than kd-trees and ball trees can't be saved.
+  KNNModel coverModel(KNNModel::TreeTypes::COVER_TREE, false);
+  arma::mat referenceCopy(referenceData);
+  coverModel.BuildModel(std::move(referenceCopy), 20, DUAL_TREE_MODE);
+  BOOST_REQUIRE_THROW(coverModel.SaveTree("knn_tree.bin"),
+      std::invalid_argument);
+
+  remove("knn_tree.bin");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -715,4 +715,53 @@ BOOST_AUTO_TEST_CASE(RAModelTest)
   }
 }
 
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+
+/**
+ * Make sure that parallel single-tree search gives the same results as serial
+ * search for the same random seed, and that parallel dual-tree search is
+ * reproducible for the same random seed and number of threads.
+ */
+BOOST_AUTO_TEST_CASE(ParallelReproducibilityTest)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  RASearch<> singleRann(refData, false, true, 1.0, 0.95, false, false);
+  RASearch<> dualRann(refData, false, false, 1.0, 0.95, false, false);
+
+  arma::Mat<size_t> parallelNeighbors, dualNeighbors1, dualNeighbors2;
+  arma::mat parallelDistances, dualDistances1, dualDistances2;
+
+  math::RandomSeed(1234);
+  singleRann.Search(queryData, 3, parallelNeighbors, parallelDistances);
+  math::RandomSeed(5678);
+  dualRann.Search(queryData, 3, dualNeighbors1, dualDistances1);
+  math::RandomSeed(5678);
+  dualRann.Search(queryData, 3, dualNeighbors2, dualDistances2);
+
+  CheckMatrices(dualNeighbors1, dualNeighbors2);
+  CheckMatrices(dualDistances1, dualDistances2);
+
+  // Now perform the single-tree search with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  arma::Mat<size_t> serialNeighbors;
+  arma::mat serialDistances;
+  math::RandomSeed(1234);
+  singleRann.Search(queryData, 3, serialNeighbors, serialDistances);
+
+  omp_set_num_threads(prevNumThreads);
+
+  CheckMatrices(parallelNeighbors, serialNeighbors);
+  CheckMatrices(parallelDistances, serialDistances);
+}
+
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
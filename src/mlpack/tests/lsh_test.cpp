@@ -14,6 +14,7 @@
 #include "test_tools.hpp"
 
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/lsh/lsh_tuner.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 using namespace std;
@@ -907,4 +908,219 @@ BOOST_AUTO_TEST_CASE(MoveOperatorTest)
   CheckMatrices(distances, distances2);
 }
 
+/**
+ * Make sure that inserting points into a model gives the same results as
+ * training the model on all of the points at once.
+ */
+BOOST_AUTO_TEST_CASE(InsertTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 1000);
+  arma::mat queries = arma::randu<arma::mat>(5, 100);
+  arma::cube projections = arma::randn<arma::cube>(5, 4, 6);
+
+  // Use the same random seed, so that both models get the same offsets and
+  // second hash weights; and unlimited buckets, so that no point is dropped.
+  math::RandomSeed(1234);
+  LSHSearch<> lsh(dataset, projections, 0.5, 99901, 0);
+
+  arma::mat firstHalf = dataset.cols(0, 499);
+  math::RandomSeed(1234);
+  LSHSearch<> lsh2(firstHalf, projections, 0.5, 99901, 0);
+  lsh2.Insert(dataset.cols(500, 749));
+
+  // The first insertion leaves room for twice the original points, so the
+  // second one must not move the reference set.
+  const double* referenceMemory = lsh2.ReferenceSet().memptr();
+  lsh2.Insert(dataset.cols(750, 999));
+  BOOST_REQUIRE(lsh2.ReferenceSet().memptr() == referenceMemory);
+
+  arma::mat referenceSet = lsh2.ReferenceSet();
+  BOOST_REQUIRE_EQUAL(referenceSet.n_cols, 1000);
+  CheckMatrices(referenceSet, dataset);
+  BOOST_REQUIRE_EQUAL(lsh2.NumBuckets(), lsh.NumBuckets());
+
+  arma::Mat<size_t> neighbors, neighbors2;
+  arma::mat distances, distances2;
+  lsh.Search(queries, 5, neighbors, distances);
+  lsh2.Search(queries, 5, neighbors2, distances2);
+
+  CheckMatrices(neighbors, neighbors2);
+  CheckMatrices(distances, distances2);
+}
+
+/**
+ * The candidate stamps are kept between searches.  Make sure that searching
+ * again, with a different query set, after an insertion, and monochromatically,
+ * gives the same results as a fresh model.
+ */
+BOOST_AUTO_TEST_CASE(RepeatedSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 1000);
+  arma::mat queries = arma::randu<arma::mat>(5, 300);
+  arma::mat otherQueries = arma::randu<arma::mat>(5, 100);
+  arma::cube projections = arma::randn<arma::cube>(5, 4, 6);
+
+  math::RandomSeed(1234);
+  LSHSearch<> lsh(dataset, projections, 0.5, 99901, 0);
+
+  arma::Mat<size_t> neighbors, neighbors2;
+  arma::mat distances, distances2;
+  lsh.Search(queries, 5, neighbors, distances);
+  lsh.Search(otherQueries, 5, neighbors2, distances2);
+  lsh.Search(queries, 5, neighbors2, distances2, 0, 3);
+  lsh.Search(queries, 5, neighbors2, distances2);
+  CheckMatrices(neighbors, neighbors2);
+  CheckMatrices(distances, distances2);
+
+  // Insert points, and compare with a model trained on all of them.
+  arma::mat newPoints = arma::randu<arma::mat>(5, 200);
+  lsh.Insert(newPoints);
+  arma::mat allPoints = arma::join_rows(dataset, newPoints);
+  math::RandomSeed(1234);
+  LSHSearch<> lsh2(allPoints, projections, 0.5, 99901, 0);
+
+  lsh.Search(queries, 5, neighbors, distances);
+  lsh2.Search(queries, 5, neighbors2, distances2);
+  CheckMatrices(neighbors, neighbors2);
+  CheckMatrices(distances, distances2);
+
+  lsh.Search(5, neighbors, distances);
+  lsh2.Search(5, neighbors2, distances2);
+  CheckMatrices(neighbors, neighbors2);
+  CheckMatrices(distances, distances2);
+}
+
+/**
+ * Make sure that removed points are never returned, and that compacting the
+ * buckets does not change the results.
+ */
+BOOST_AUTO_TEST_CASE(RemoveAndCompactTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 1000);
+  arma::mat queries = arma::randu<arma::mat>(5, 100);
+
+  LSHSearch<> lsh(dataset, 4, 6, 0.5, 99901, 0);
+  lsh.Insert(arma::randu<arma::mat>(5, 200));
+
+  lsh.Remove(arma::linspace<arma::Col<size_t>>(0, 99, 100));
+  lsh.Remove(arma::linspace<arma::Col<size_t>>(1100, 1199, 100));
+
+  arma::Mat<size_t> neighbors, neighbors2;
+  arma::mat distances, distances2;
+  lsh.Search(queries, 5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE(neighbors[i] >= 100);
+    BOOST_REQUIRE(neighbors[i] < 1100 || neighbors[i] >= 1200);
+  }
+
+  lsh.Compact();
+
+  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
+      arma::accu(lsh.BucketContentSize()));
+  for (size_t i = 0; i < lsh.NumBuckets(); ++i)
+  {
+    BOOST_REQUIRE_GT(lsh.BucketContentSize()[i], 0);
+    BOOST_REQUIRE_EQUAL(lsh.BucketCapacities()[i],
+        lsh.BucketContentSize()[i]);
+  }
+
+  lsh.Search(queries, 5, neighbors2, distances2);
+
+  CheckMatrices(neighbors, neighbors2);
+  CheckMatrices(distances, distances2);
+}
+
+/**
+ * With a huge hash width, every point is hashed into the same bucket, so LSH
+ * search is exact.  Make sure the batched search then gives the same results
+ * as KNN, for a query set that spans several blocks of queries, and for
+ * monochromatic search.
+ */
+BOOST_AUTO_TEST_CASE(SingleBucketExactTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 700);
+  arma::mat queries = arma::randu<arma::mat>(4, 600);
+
+  LSHSearch<> lsh(dataset, 3, 2, 1e8, 99901, 0);
+  KNN knn(dataset);
+
+  arma::Mat<size_t> lshNeighbors, knnNeighbors;
+  arma::mat lshDistances, knnDistances;
+  lsh.Search(queries, 5, lshNeighbors, lshDistances);
+  knn.Search(queries, 5, knnNeighbors, knnDistances);
+
+  BOOST_REQUIRE_EQUAL(lsh.DistanceEvaluations(), 700 * 600);
+  CheckMatrices(lshNeighbors, knnNeighbors);
+  for (size_t i = 0; i < lshDistances.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(lshDistances[i], knnDistances[i], 1e-5);
+
+  lsh.Search(5, lshNeighbors, lshDistances);
+  knn.Search(5, knnNeighbors, knnDistances);
+
+  CheckMatrices(lshNeighbors, knnNeighbors);
+  for (size_t i = 0; i < lshDistances.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(lshDistances[i], knnDistances[i], 1e-5);
+}
+
+/**
+ * Make sure that the tuner evaluates every setting, and that its Pareto
+ * frontier and best settings are consistent with the results.
+ */
+BOOST_AUTO_TEST_CASE(LSHTunerTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 1000);
+  arma::mat queries = arma::randu<arma::mat>(5, 50);
+
+  LSHTuner<> tuner(dataset, queries, 5);
+  BOOST_REQUIRE_EQUAL(tuner.TrueNeighbors().n_rows, 5);
+  BOOST_REQUIRE_EQUAL(tuner.TrueNeighbors().n_cols, 50);
+
+  // T = 10 is more than the maximum for 3 projections, so it is skipped.
+  tuner.Tune({ 3, 6 }, { 1, 4 }, { 1.0, 4.0 }, { 0, 2, 10 }, { 0 });
+  const std::vector<LSHTuningResult>& results = tuner.Results();
+  BOOST_REQUIRE_EQUAL(results.size(), 20);
+
+  double maxRecall = 0.0;
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    BOOST_REQUIRE_GE(results[i].recall, 0.0);
+    BOOST_REQUIRE_LE(results[i].recall, 1.0);
+    BOOST_REQUIRE_GT(results[i].memory, 0.0);
+    maxRecall = std::max(maxRecall, results[i].recall);
+  }
+
+  // More tables take more memory.
+  BOOST_REQUIRE_EQUAL(results[0].numTables, 1);
+  BOOST_REQUIRE_EQUAL(results[2].numTables, 4);
+  BOOST_REQUIRE_LT(results[0].memory, results[2].memory);
+
+  // No result of the frontier is dominated by another result.
+  const std::vector<LSHTuningResult> frontier = tuner.ParetoFrontier();
+  BOOST_REQUIRE(!frontier.empty());
+  BOOST_REQUIRE_CLOSE(frontier.back().recall, maxRecall, 1e-5);
+  for (size_t i = 0; i < frontier.size(); ++i)
+  {
+    if (i > 0)
+      BOOST_REQUIRE_GE(frontier[i].recall, frontier[i - 1].recall);
+
+    for (size_t j = 0; j < results.size(); ++j)
+    {
+      BOOST_REQUIRE(!(results[j].recall > frontier[i].recall &&
+          results[j].queryTime < frontier[i].queryTime &&
+          results[j].memory < frontier[i].memory));
+    }
+  }
+
+  // The best settings must reach the target recall.
+  const LSHTuningResult& fastest = tuner.Best(maxRecall);
+  BOOST_REQUIRE_GE(fastest.recall, maxRecall);
+  const LSHTuningResult& smallest = tuner.Best(0.0, true);
+  for (size_t i = 0; i < results.size(); ++i)
+    BOOST_REQUIRE_LE(smallest.memory, results[i].memory);
+
+  BOOST_REQUIRE_THROW(tuner.Best(1.1), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -12,6 +12,8 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/octree.hpp>
 
+#include <stack>
+
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
 #include "serialization.hpp"
@@ -344,4 +346,48 @@ BOOST_AUTO_TEST_CASE(SerializationTest)
   delete textTree;
 }
 
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that building an octree with several threads gives exactly the same
+ * tree as building it with one thread.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBuildTest)
+{
+  // The dataset must be large enough that subtrees are built in parallel.
+  arma::mat dataset(3, 50000, arma::fill::randu);
+
+  std::vector<size_t> parallelOldFromNew;
+  Octree<> parallelTree(dataset, parallelOldFromNew, 10);
+
+  // Now build the same tree with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  std::vector<size_t> serialOldFromNew;
+  Octree<> serialTree(dataset, serialOldFromNew, 10);
+
+  omp_set_num_threads(prevNumThreads);
+
+  BOOST_REQUIRE_EQUAL(parallelOldFromNew.size(), serialOldFromNew.size());
+  for (size_t i = 0; i < serialOldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(parallelOldFromNew[i], serialOldFromNew[i]);
+  CheckMatrices(parallelTree.Dataset(), serialTree.Dataset());
+
+  std::stack<std::pair<Octree<>*, Octree<>*>> nodes;
+  nodes.push(std::make_pair(&serialTree, &parallelTree));
+  while (!nodes.empty())
+  {
+    Octree<>* serialNode = nodes.top().first;
+    Octree<>* parallelNode = nodes.top().second;
+    nodes.pop();
+
+    CheckSameNode(*serialNode, *parallelNode);
+    for (size_t i = 0; i < serialNode->NumChildren(); ++i)
+      nodes.push(std::make_pair(&serialNode->Child(i),
+          &parallelNode->Child(i)));
+  }
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
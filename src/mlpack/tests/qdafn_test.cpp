@@ -208,4 +208,37 @@ BOOST_AUTO_TEST_CASE(SparseTest)
   BOOST_REQUIRE_EQUAL(distances.n_cols, 1000);
 }
 
+/**
+ * Make sure that training on a dataset that is read in chunks gives the same
+ * tables as training on the dataset in memory.
+ */
+BOOST_AUTO_TEST_CASE(StreamingTrainTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 1000);
+  dataset.save("qdafn_stream.bin", arma::arma_binary);
+
+  // Both models must draw the same random lines.
+  math::RandomSeed(42);
+  QDAFN<> qdafn(dataset, 6, 10);
+
+  data::ChunkReader<> reader("qdafn_stream.bin");
+  math::RandomSeed(42);
+  QDAFN<> streamingQdafn(6, 10);
+  streamingQdafn.Train(reader, 0, 0, 128);
+
+  remove("qdafn_stream.bin");
+
+  BOOST_REQUIRE_EQUAL(streamingQdafn.NumProjections(), 6);
+  for (size_t i = 0; i < 6; ++i)
+    CheckMatrices(qdafn.CandidateSet(i), streamingQdafn.CandidateSet(i));
+
+  arma::Mat<size_t> neighbors, streamingNeighbors;
+  arma::mat distances, streamingDistances;
+  qdafn.Search(dataset, 3, neighbors, distances);
+  streamingQdafn.Search(dataset, 3, streamingNeighbors, streamingDistances);
+
+  CheckMatrices(neighbors, streamingNeighbors);
+  CheckMatrices(distances, streamingDistances);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -15,6 +15,7 @@
 #include <mlpack/methods/range_search/rs_model.hpp>
 #include <boost/test/unit_test.hpp>
 #include "test_tools.hpp"
+#include "serialization.hpp"
 
 using namespace mlpack;
 using namespace mlpack::range;
@@ -1696,4 +1697,502 @@ BOOST_AUTO_TEST_CASE(MoveOperatorNaiveTest)
   }
 }
 
+/**
+ * Make sure that range search works on single-precision data, by comparing
+ * tree-based search with naive search on the same data.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionTest)
+{
+  arma::fmat referenceData = arma::randu<arma::fmat>(5, 1000);
+  arma::fmat queryData = arma::randu<arma::fmat>(5, 200);
+
+  typedef RangeSearch<EuclideanDistance, arma::fmat, KDTree> FloatRS;
+  FloatRS naive(referenceData, true);
+  FloatRS singleTree(referenceData, false, true);
+  FloatRS dualTree(referenceData);
+
+  vector<vector<size_t>> naiveNeighbors, singleNeighbors, dualNeighbors;
+  vector<vector<double>> naiveDistances, singleDistances, dualDistances;
+  const math::Range range(0.2, 0.4);
+  naive.Search(queryData, range, naiveNeighbors, naiveDistances);
+  singleTree.Search(queryData, range, singleNeighbors, singleDistances);
+  dualTree.Search(queryData, range, dualNeighbors, dualDistances);
+
+  BOOST_REQUIRE_EQUAL(singleNeighbors.size(), naiveNeighbors.size());
+  BOOST_REQUIRE_EQUAL(dualNeighbors.size(), naiveNeighbors.size());
+  for (size_t i = 0; i < naiveNeighbors.size(); ++i)
+  {
+    // The results may be in a different order, so sort them by index.
+    vector<pair<size_t, double>> naiveResults, singleResults, dualResults;
+    for (size_t j = 0; j < naiveNeighbors[i].size(); ++j)
+      naiveResults.push_back(make_pair(naiveNeighbors[i][j],
+          naiveDistances[i][j]));
+    for (size_t j = 0; j < singleNeighbors[i].size(); ++j)
+      singleResults.push_back(make_pair(singleNeighbors[i][j],
+          singleDistances[i][j]));
+    for (size_t j = 0; j < dualNeighbors[i].size(); ++j)
+      dualResults.push_back(make_pair(dualNeighbors[i][j],
+          dualDistances[i][j]));
+    sort(naiveResults.begin(), naiveResults.end());
+    sort(singleResults.begin(), singleResults.end());
+    sort(dualResults.begin(), dualResults.end());
+
+    BOOST_REQUIRE_EQUAL(singleResults.size(), naiveResults.size());
+    BOOST_REQUIRE_EQUAL(dualResults.size(), naiveResults.size());
+    for (size_t j = 0; j < naiveResults.size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(singleResults[j].first, naiveResults[j].first);
+      BOOST_REQUIRE_EQUAL(dualResults[j].first, naiveResults[j].first);
+      BOOST_REQUIRE_CLOSE(singleResults[j].second, naiveResults[j].second,
+          1e-5);
+      BOOST_REQUIRE_CLOSE(dualResults[j].second, naiveResults[j].second,
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that an RSModel holding single-precision data gives the same
+ * results as naive search on single-precision data, for kd-trees and ball trees
+ * and for every search mode, and that it survives serialization.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionModelTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500);
+  arma::mat queryData = arma::randu<arma::mat>(5, 100);
+  arma::fmat fReferenceData = arma::conv_to<arma::fmat>::from(referenceData);
+  arma::fmat fQueryData = arma::conv_to<arma::fmat>::from(queryData);
+
+  const math::Range range(0.2, 0.4);
+  RangeSearch<EuclideanDistance, arma::fmat, KDTree> naive(fReferenceData,
+      true);
+  vector<vector<size_t>> trueNeighbors;
+  vector<vector<double>> trueDistances;
+  naive.Search(fQueryData, range, trueNeighbors, trueDistances);
+
+  const RSModel::TreeTypes treeTypes[] = { RSModel::KD_TREE,
+                                           RSModel::BALL_TREE };
+  for (size_t t = 0; t < 2; ++t)
+  {
+    // Naive search, single-tree search, and dual-tree search.
+    for (size_t m = 0; m < 3; ++m)
+    {
+      RSModel model(treeTypes[t]);
+      model.SinglePrecision() = true;
+      model.BuildModel(arma::mat(referenceData), 10, (m == 0), (m == 1));
+
+      BOOST_REQUIRE_EQUAL(model.Dimensionality(), (size_t) 5);
+      BOOST_REQUIRE_EQUAL(model.NumPoints(), (size_t) 500);
+      BOOST_REQUIRE_THROW(model.Dataset(), std::invalid_argument);
+
+      RSModel xmlModel, textModel, binaryModel;
+      SerializeObjectAll(model, xmlModel, textModel, binaryModel);
+
+      RSModel* models[] = { &model, &xmlModel, &textModel, &binaryModel };
+      for (size_t i = 0; i < 4; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(models[i]->SinglePrecision(), true);
+        models[i]->LeafSize() = 10;
+
+        vector<vector<size_t>> neighbors;
+        vector<vector<double>> distances;
+        models[i]->Search(arma::mat(queryData), range, neighbors, distances);
+
+        BOOST_REQUIRE_EQUAL(neighbors.size(), trueNeighbors.size());
+        for (size_t j = 0; j < neighbors.size(); ++j)
+        {
+          // The results may be in a different order, so sort them by index.
+          vector<pair<size_t, double>> results, trueResults;
+          for (size_t l = 0; l < neighbors[j].size(); ++l)
+            results.push_back(make_pair(neighbors[j][l], distances[j][l]));
+          for (size_t l = 0; l < trueNeighbors[j].size(); ++l)
+            trueResults.push_back(make_pair(trueNeighbors[j][l],
+                trueDistances[j][l]));
+          sort(results.begin(), results.end());
+          sort(trueResults.begin(), trueResults.end());
+
+          BOOST_REQUIRE_EQUAL(results.size(), trueResults.size());
+          for (size_t l = 0; l < results.size(); ++l)
+          {
+            BOOST_REQUIRE_EQUAL(results[l].first, trueResults[l].first);
+            BOOST_REQUIRE_CLOSE(results[l].second, trueResults[l].second,
+                1e-5);
+          }
+        }
+      }
+    }
+  }
+
+  // Other tree types can't hold single-precision data.
+  RSModel coverModel(RSModel::COVER_TREE);
+  coverModel.SinglePrecision() = true;
+  BOOST_REQUIRE_THROW(coverModel.BuildModel(arma::mat(referenceData), 10,
+      false, false), std::invalid_argument);
+}
+
+/**
+ * Make sure that counting the results gives the sizes of the results of a full
+ * search, in every search mode, with a tree that rearranges the dataset and
+ * with a tree whose first point is the centroid.
+ */
+template<typename RangeSearchType>
+void CheckCounts(RangeSearchType& rs,
+                 const arma::mat& queryData,
+                 const Range& range)
+{
+  vector<vector<size_t>> neighbors;
+  vector<vector<double>> distances;
+  arma::Col<size_t> counts;
+
+  rs.Search(queryData, range, neighbors, distances);
+  rs.Search(queryData, range, counts);
+  BOOST_REQUIRE_EQUAL(counts.n_elem, neighbors.size());
+  for (size_t i = 0; i < neighbors.size(); ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], neighbors[i].size());
+
+  rs.Search(range, neighbors, distances);
+  rs.Search(range, counts);
+  BOOST_REQUIRE_EQUAL(counts.n_elem, neighbors.size());
+  for (size_t i = 0; i < neighbors.size(); ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], neighbors[i].size());
+}
+
+BOOST_AUTO_TEST_CASE(CountTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RangeSearch<> rs(referenceData, mode == 0, mode == 1);
+    CheckCounts(rs, queryData, Range(0.0, 0.3));
+    CheckCounts(rs, queryData, Range(0.1, 0.25));
+
+    RangeSearch<EuclideanDistance, arma::mat, StandardCoverTree> crs(
+        referenceData, mode == 0, mode == 1);
+    CheckCounts(crs, queryData, Range(0.0, 0.3));
+    CheckCounts(crs, queryData, Range(0.1, 0.25));
+  }
+}
+
+/**
+ * Make sure that the sink receives the results of a full search, sorted by
+ * neighbor index, for each query point in order, when the query points are
+ * searched in batches.
+ */
+BOOST_AUTO_TEST_CASE(SinkTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RangeSearch<> rs(referenceData, mode == 0, mode == 1);
+
+    for (size_t mono = 0; mono < 2; ++mono)
+    {
+      vector<vector<size_t>> neighbors;
+      vector<vector<double>> distances;
+      if (mono == 1)
+        rs.Search(Range(0.0, 0.2), neighbors, distances);
+      else
+        rs.Search(queryData, Range(0.0, 0.2), neighbors, distances);
+
+      vector<vector<pair<double, size_t>>> sortedResults;
+      SortResults(neighbors, distances, sortedResults);
+
+      size_t nextQuery = 0;
+      auto sink = [&](const size_t queryIndex,
+                      const vector<size_t>& queryNeighbors,
+                      const vector<double>& queryDistances)
+      {
+        BOOST_REQUIRE_EQUAL(queryIndex, nextQuery);
+        ++nextQuery;
+
+        vector<pair<size_t, double>> expected;
+        for (size_t j = 0; j < sortedResults[queryIndex].size(); ++j)
+          expected.push_back(make_pair(sortedResults[queryIndex][j].second,
+              sortedResults[queryIndex][j].first));
+        sort(expected.begin(), expected.end());
+
+        BOOST_REQUIRE_EQUAL(queryNeighbors.size(), expected.size());
+        BOOST_REQUIRE_EQUAL(queryDistances.size(), expected.size());
+        for (size_t j = 0; j < expected.size(); ++j)
+        {
+          BOOST_REQUIRE_EQUAL(queryNeighbors[j], expected[j].first);
+          BOOST_REQUIRE_CLOSE(queryDistances[j], expected[j].second, 1e-5);
+        }
+      };
+
+      if (mono == 1)
+        rs.Search(Range(0.0, 0.2), sink, 37);
+      else
+        rs.Search(queryData, Range(0.0, 0.2), sink, 37);
+
+      BOOST_REQUIRE_EQUAL(nextQuery, neighbors.size());
+    }
+  }
+}
+
+/**
+ * Make sure that the compressed results hold the results of a full search,
+ * with and without delta encoding.
+ */
+BOOST_AUTO_TEST_CASE(CompressedResultsTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 200);
+
+  RangeSearch<> rs(referenceData);
+
+  vector<vector<size_t>> neighbors;
+  vector<vector<double>> distances;
+  rs.Search(queryData, Range(0.0, 0.4), neighbors, distances);
+
+  RangeSearchResults results;
+  RangeSearchResults encodedResults(true);
+  rs.Search(queryData, Range(0.0, 0.4), results, 64);
+  rs.Search(queryData, Range(0.0, 0.4), encodedResults, 64);
+
+  BOOST_REQUIRE(!results.DeltaEncoded());
+  BOOST_REQUIRE(encodedResults.DeltaEncoded());
+  BOOST_REQUIRE_EQUAL(results.NumQueries(), queryData.n_cols);
+  BOOST_REQUIRE_EQUAL(encodedResults.NumQueries(), queryData.n_cols);
+
+  size_t totalResults = 0;
+  vector<size_t> queryNeighbors, encodedNeighbors;
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    vector<pair<size_t, double>> expected;
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+      expected.push_back(make_pair(neighbors[i][j], distances[i][j]));
+    sort(expected.begin(), expected.end());
+    totalResults += expected.size();
+
+    results.Neighbors(i, queryNeighbors);
+    encodedResults.Neighbors(i, encodedNeighbors);
+    BOOST_REQUIRE_EQUAL(results.NumResults(i), expected.size());
+    BOOST_REQUIRE_EQUAL(queryNeighbors.size(), expected.size());
+    BOOST_REQUIRE_EQUAL(encodedNeighbors.size(), expected.size());
+
+    for (size_t j = 0; j < expected.size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(queryNeighbors[j], expected[j].first);
+      BOOST_REQUIRE_EQUAL(encodedNeighbors[j], expected[j].first);
+      BOOST_REQUIRE_CLOSE((double) results.Distances(i)[j],
+          expected[j].second, 1e-4);
+      BOOST_REQUIRE_CLOSE((double) encodedResults.Distances(i)[j],
+          expected[j].second, 1e-4);
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(results.NumResults(), totalResults);
+  BOOST_REQUIRE_LT(encodedResults.MemoryUsage(), results.MemoryUsage());
+
+  // The monochromatic search must leave each point out of its own results.
+  rs.Search(Range(0.0, 0.1), neighbors, distances);
+  rs.Search(Range(0.0, 0.1), results, 100);
+  BOOST_REQUIRE_EQUAL(results.NumQueries(), referenceData.n_cols);
+  for (size_t i = 0; i < neighbors.size(); ++i)
+  {
+    vector<pair<size_t, double>> expected;
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+      expected.push_back(make_pair(neighbors[i][j], distances[i][j]));
+    sort(expected.begin(), expected.end());
+
+    results.Neighbors(i, queryNeighbors);
+    BOOST_REQUIRE_EQUAL(queryNeighbors.size(), expected.size());
+    for (size_t j = 0; j < expected.size(); ++j)
+    {
+      BOOST_REQUIRE_NE(queryNeighbors[j], i);
+      BOOST_REQUIRE_EQUAL(queryNeighbors[j], expected[j].first);
+      BOOST_REQUIRE_CLOSE((double) results.Distances(i)[j],
+          expected[j].second, 1e-4);
+    }
+  }
+
+  // Unsorted neighbors can't be appended.
+  const vector<size_t> unsortedNeighbors = { 3, 1 };
+  const vector<double> unsortedDistances = { 0.5, 0.2 };
+  BOOST_REQUIRE_THROW(results.Append(unsortedNeighbors, unsortedDistances),
+      std::invalid_argument);
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that parallel single-tree range search gives the same results as
+ * serial single-tree range search, for both the bichromatic and monochromatic
+ * cases.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 800);
+
+  RangeSearch<> rs(referenceData, false, true);
+
+  vector<vector<size_t>> parallelNeighbors, parallelMonoNeighbors;
+  vector<vector<double>> parallelDistances, parallelMonoDistances;
+  rs.Search(queryData, Range(0.1, 0.3), parallelNeighbors, parallelDistances);
+  rs.Search(Range(0.1, 0.3), parallelMonoNeighbors, parallelMonoDistances);
+
+  // Now perform the same searches with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  vector<vector<size_t>> serialNeighbors, serialMonoNeighbors;
+  vector<vector<double>> serialDistances, serialMonoDistances;
+  rs.Search(queryData, Range(0.1, 0.3), serialNeighbors, serialDistances);
+  rs.Search(Range(0.1, 0.3), serialMonoNeighbors, serialMonoDistances);
+
+  omp_set_num_threads(prevNumThreads);
+
+  BOOST_REQUIRE_EQUAL(parallelNeighbors.size(), serialNeighbors.size());
+  for (size_t i = 0; i < parallelNeighbors.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelNeighbors[i].size(), serialNeighbors[i].size());
+    for (size_t j = 0; j < parallelNeighbors[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(parallelNeighbors[i][j], serialNeighbors[i][j]);
+      BOOST_REQUIRE_CLOSE(parallelDistances[i][j], serialDistances[i][j],
+          1e-5);
+    }
+  }
+
+  BOOST_REQUIRE_EQUAL(parallelMonoNeighbors.size(), serialMonoNeighbors.size());
+  for (size_t i = 0; i < parallelMonoNeighbors.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelMonoNeighbors[i].size(),
+        serialMonoNeighbors[i].size());
+    for (size_t j = 0; j < parallelMonoNeighbors[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(parallelMonoNeighbors[i][j],
+          serialMonoNeighbors[i][j]);
+      BOOST_REQUIRE_CLOSE(parallelMonoDistances[i][j],
+          serialMonoDistances[i][j], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that the streaming search gives the same results with several
+ * threads (when the batches are searched in parallel) as with one thread, and
+ * still passes the points to the sink in order.  Each batch is searched in the
+ * same way whatever the number of threads, so the number of base cases is the
+ * same too.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSinkTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 700);
+
+  const size_t prevNumThreads = omp_get_max_threads();
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RangeSearch<> rs(referenceData, mode == 0, mode == 1);
+
+    for (size_t mono = 0; mono < 2; ++mono)
+    {
+      vector<vector<size_t>> neighbors[2];
+      vector<vector<double>> distances[2];
+      size_t baseCases[2];
+      for (size_t t = 0; t < 2; ++t)
+      {
+        omp_set_num_threads(t == 0 ? 1 : 4);
+
+        auto sink = [&](const size_t queryIndex,
+                        const vector<size_t>& queryNeighbors,
+                        const vector<double>& queryDistances)
+        {
+          BOOST_REQUIRE_EQUAL(queryIndex, neighbors[t].size());
+          neighbors[t].push_back(queryNeighbors);
+          distances[t].push_back(queryDistances);
+        };
+
+        if (mono == 1)
+          rs.Search(Range(0.1, 0.3), sink, 53);
+        else
+          rs.Search(queryData, Range(0.1, 0.3), sink, 53);
+        baseCases[t] = rs.BaseCases();
+      }
+
+      BOOST_REQUIRE_EQUAL(neighbors[0].size(), (mono == 1) ?
+          referenceData.n_cols : queryData.n_cols);
+      BOOST_REQUIRE_EQUAL(neighbors[1].size(), neighbors[0].size());
+      BOOST_REQUIRE_EQUAL(baseCases[1], baseCases[0]);
+      for (size_t i = 0; i < neighbors[0].size(); ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[1][i].size(), neighbors[0][i].size());
+        for (size_t j = 0; j < neighbors[0][i].size(); ++j)
+        {
+          BOOST_REQUIRE_EQUAL(neighbors[1][i][j], neighbors[0][i][j]);
+          BOOST_REQUIRE_CLOSE(distances[1][i][j], distances[0][i][j], 1e-5);
+        }
+      }
+    }
+  }
+  omp_set_num_threads(prevNumThreads);
+}
+#endif
+
+/**
+ * Save the reference tree of an RSModel to a flat tree file, load it into
+ * another RSModel, and make sure that both models give the same results.
+ */
+BOOST_AUTO_TEST_CASE(RSModelTreeFileTest)
+{
+  arma::mat queryData = arma::randu<arma::mat>(10, 50);
+  arma::mat referenceData = arma::randu<arma::mat>(10, 200);
+
+  for (size_t t = 0; t < 2; ++t)
+  {
+    const RSModel::TreeTypes treeType = (t == 0) ? RSModel::TreeTypes::KD_TREE :
+        RSModel::TreeTypes::BALL_TREE;
+
+    RSModel model(treeType, false);
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), 5, false, false);
+    model.SaveTree("rs_tree.bin");
+
+    RSModel loadedModel(treeType, false);
+    loadedModel.LoadTree("rs_tree.bin", false, false);
+    BOOST_REQUIRE_EQUAL(loadedModel.Dimensionality(), (size_t) 10);
+
+    vector<vector<size_t>> neighbors, loadedNeighbors;
+    vector<vector<double>> distances, loadedDistances;
+    arma::mat queryCopy(queryData);
+    model.Search(std::move(queryCopy), math::Range(0.25, 0.75), neighbors,
+        distances);
+    queryCopy = queryData;
+    loadedModel.Search(std::move(queryCopy), math::Range(0.25, 0.75),
+        loadedNeighbors, loadedDistances);
+
+    vector<vector<pair<double, size_t>>> sorted, loadedSorted;
+    SortResults(neighbors, distances, sorted);
+    SortResults(loadedNeighbors, loadedDistances, loadedSorted);
+
+    BOOST_REQUIRE_EQUAL(loadedSorted.size(), sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(loadedSorted[i].size(), sorted[i].size());
+      for (size_t j = 0; j < sorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(loadedSorted[i][j].second, sorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(loadedSorted[i][j].first, sorted[i][j].first,
+            1e-5);
+      }
+    }
+  }
+
+  // Trees other than kd-trees and ball trees can't be saved.
+  RSModel coverModel(RSModel::TreeTypes::COVER_TREE, false);
+  arma::mat referenceCopy(referenceData);
+  coverModel.BuildModel(std::move(referenceCopy), 5, false, false);
+  BOOST_REQUIRE_THROW(coverModel.SaveTree("rs_tree.bin"),
+      std::invalid_argument);
+
+  remove("rs_tree.bin");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
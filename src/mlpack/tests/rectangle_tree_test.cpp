@@ -1382,4 +1382,226 @@ BOOST_AUTO_TEST_CASE(RectangleTreeMoveDatasetTest)
   BOOST_REQUIRE_EQUAL(tree.Dataset().n_cols, 1000);
 }
 
+/**
+ * Count the leaves of the tree, and check that each of them is full.
+ */
+template<typename TreeType>
+size_t CountFullLeaves(const TreeType& tree)
+{
+  if (tree.IsLeaf())
+  {
+    BOOST_REQUIRE_EQUAL(tree.Count(), tree.MaxLeafSize());
+    return 1;
+  }
+
+  size_t numLeaves = 0;
+  for (size_t i = 0; i < tree.NumChildren(); i++)
+    numLeaves += CountFullLeaves(tree.Child(i));
+
+  return numLeaves;
+}
+
+/**
+ * Bulk-load a tree of the given type, check that it is valid and packed, then
+ * insert some points and make sure that nearest neighbor search still gives the
+ * same results as a naive search.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckBulkLoad()
+{
+  typedef TreeType<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> Tree;
+
+  const size_t numIter = 50;
+  arma::mat dataset;
+  dataset.randu(8, 1000); // 1000 points in 8 dimensions.
+
+  Tree tree(dataset, BulkLoad(), 20, 6, 5, 2);
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckHierarchy(tree);
+  CheckFills(tree);
+  CheckNumDescendants(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+  BOOST_REQUIRE_EQUAL(tree.TreeDepth(), GetMinLevel(tree));
+
+  // 1000 points fit exactly into 50 full leaves (with two children at the
+  // root, and five children at every other level).
+  BOOST_REQUIRE_EQUAL(CountFullLeaves(tree), 50);
+  BOOST_REQUIRE_EQUAL(tree.NumChildren(), 2);
+
+  // Make sure that points can still be inserted.
+  tree.Dataset().reshape(8, 1000 + numIter);
+  dataset.reshape(8, 1000 + numIter);
+  arma::mat tmpData;
+  tmpData.randu(8, numIter);
+  for (size_t i = 0; i < numIter; i++)
+  {
+    tree.Dataset().col(1000 + i) = tmpData.col(i);
+    dataset.col(1000 + i) = tmpData.col(i);
+    tree.InsertPoint(1000 + i);
+  }
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000 + numIter);
+  CheckContainment(tree);
+  CheckExactContainment(tree);
+  CheckHierarchy(tree);
+  CheckNumDescendants(tree);
+
+  arma::Mat<size_t> neighbors1;
+  arma::mat distances1;
+  arma::Mat<size_t> neighbors2;
+  arma::mat distances2;
+
+  NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, arma::mat,
+      TreeType> knn1(std::move(tree), SINGLE_TREE_MODE);
+  knn1.Search(5, neighbors1, distances1);
+
+  KNN knn2(dataset, NAIVE_MODE);
+  knn2.Search(5, neighbors2, distances2);
+
+  for (size_t i = 0; i < neighbors1.size(); i++)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+    BOOST_REQUIRE_EQUAL(distances1[i], distances2[i]);
+  }
+}
+
+// Make sure that bulk-loading works for every type of rectangle tree.
+BOOST_AUTO_TEST_CASE(BulkLoadTest)
+{
+  CheckBulkLoad<RTree>();
+  CheckBulkLoad<RStarTree>();
+  CheckBulkLoad<XTree>();
+  CheckBulkLoad<HilbertRTree>();
+  CheckBulkLoad<RPlusTree>();
+  CheckBulkLoad<RPlusPlusTree>();
+}
+
+// Check the properties that are specific to bulk-loaded Hilbert R trees, R+
+// trees and R++ trees.
+BOOST_AUTO_TEST_CASE(BulkLoadInvariantsTest)
+{
+  arma::mat dataset;
+  dataset.randu(8, 1037);
+
+  HilbertRTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> hilbertRTree(dataset, BulkLoad(), 20, 6, 5, 2);
+  CheckHilbertOrdering(hilbertRTree);
+  CheckDiscreteHilbertValueSync(hilbertRTree);
+  CheckFills(hilbertRTree);
+
+  RPlusTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> rPlusTree(dataset, BulkLoad(), 20, 6, 5, 2);
+  CheckOverlap(rPlusTree);
+  CheckFills(rPlusTree);
+
+  RPlusPlusTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> rPlusPlusTree(dataset, BulkLoad(), 20, 6, 5, 2);
+  CheckRPlusPlusTreeBound(rPlusPlusTree);
+  CheckFills(rPlusPlusTree);
+  CheckNumDescendants(rPlusPlusTree);
+}
+
+// Make sure that queries on a ConcurrentRectangleTree give correct results
+// while points are inserted and deleted.  Without OpenMP the readers and the
+// writer simply take turns.
+BOOST_AUTO_TEST_CASE(ConcurrentRectangleTreeTest)
+{
+  typedef RTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance, TreeType>
+      RuleType;
+
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+  arma::mat querySet;
+  querySet.randu(3, 50);
+
+  ConcurrentRectangleTree<TreeType> tree(TreeType(dataset, 20, 6, 5, 2, 0));
+
+  const int numBatches = 10;
+  const int numTasks = 40;
+  size_t numErrors = 0;
+  size_t maxPoints = 0;
+
+  #pragma omp parallel for schedule(dynamic) reduction(+:numErrors)
+  for (int task = 0; task < numTasks; ++task)
+  {
+    if (task == 0)
+    {
+      // The writer inserts batches of points, and deletes some of the
+      // original points.
+      for (int b = 0; b < numBatches; ++b)
+      {
+        arma::mat newPoints;
+        newPoints.randu(3, 20);
+        tree.Insert(newPoints);
+        tree.Delete(arma::linspace<arma::Col<size_t>>(10 * b, 10 * b + 9,
+            10));
+      }
+      continue;
+    }
+
+    // Each reader searches the pinned copy of the tree, and compares with a
+    // brute-force search over the points that are in that copy.
+    ConcurrentRectangleTree<TreeType>::Reader reader = tree.Read();
+    const TreeType& snapshot = reader.Tree();
+
+    EuclideanDistance metric;
+    RuleType rules(snapshot.Dataset(), querySet, 1, metric);
+    TreeType::SingleTreeTraverser<RuleType> traverser(rules);
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(i, snapshot);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    rules.GetResults(neighbors, distances);
+
+    std::vector<size_t> points;
+    std::vector<const TreeType*> stack(1, &snapshot);
+    while (!stack.empty())
+    {
+      const TreeType* node = stack.back();
+      stack.pop_back();
+      for (size_t i = 0; i < node->NumChildren(); ++i)
+        stack.push_back(&node->Child(i));
+      for (size_t i = 0; i < node->NumPoints(); ++i)
+        points.push_back(node->Point(i));
+    }
+
+    if (points.size() != snapshot.NumDescendants())
+      ++numErrors;
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      double best = DBL_MAX;
+      for (size_t j = 0; j < points.size(); ++j)
+        best = std::min(best, arma::norm(querySet.col(i) -
+            snapshot.Dataset().col(points[j])));
+
+      if (std::abs(best - distances(0, i)) > 1e-10)
+        ++numErrors;
+    }
+
+    #pragma omp critical
+    maxPoints = std::max(maxPoints, (size_t) snapshot.Dataset().n_cols);
+  }
+
+  BOOST_REQUIRE_EQUAL(numErrors, 0);
+  BOOST_REQUIRE_LE(maxPoints, 1000 + 20 * numBatches);
+
+  // After all the updates, both copies must hold the same points.
+  ConcurrentRectangleTree<TreeType>::Reader reader = tree.Read();
+  BOOST_REQUIRE_EQUAL(reader.Tree().Dataset().n_cols, 1000 + 20 * numBatches);
+  BOOST_REQUIRE_EQUAL(reader.Tree().NumDescendants(),
+      1000 + 10 * numBatches);
+  CheckContainment(reader.Tree());
+  CheckNumDescendants(reader.Tree());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -1232,16 +1232,21 @@ BOOST_AUTO_TEST_CASE(LSHTest)
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), textLsh.BucketSize());
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), binaryLsh.BucketSize());
 
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      xmlLsh.SecondHashTable().size());
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      textLsh.SecondHashTable().size());
-  BOOST_REQUIRE_EQUAL(lsh.SecondHashTable().size(),
-      binaryLsh.SecondHashTable().size());
-
-  for (size_t i = 0; i < lsh.SecondHashTable().size(); ++i)
-  CheckMatrices(lsh.SecondHashTable()[i], xmlLsh.SecondHashTable()[i],
-      textLsh.SecondHashTable()[i], binaryLsh.SecondHashTable()[i]);
+  BOOST_REQUIRE_EQUAL(lsh.NumBuckets(), xmlLsh.NumBuckets());
+  BOOST_REQUIRE_EQUAL(lsh.NumBuckets(), textLsh.NumBuckets());
+  BOOST_REQUIRE_EQUAL(lsh.NumBuckets(), binaryLsh.NumBuckets());
+
+  CheckMatrices(lsh.BucketOffsets(), xmlLsh.BucketOffsets(),
+      textLsh.BucketOffsets(), binaryLsh.BucketOffsets());
+  CheckMatrices(lsh.BucketCapacities(), xmlLsh.BucketCapacities(),
+      textLsh.BucketCapacities(), binaryLsh.BucketCapacities());
+  CheckMatrices(lsh.BucketContentSize(), xmlLsh.BucketContentSize(),
+      textLsh.BucketContentSize(), binaryLsh.BucketContentSize());
+
+  const arma::Col<size_t> table(lsh.SecondHashTable());
+  CheckMatrices(table, arma::Col<size_t>(xmlLsh.SecondHashTable()),
+      arma::Col<size_t>(textLsh.SecondHashTable()),
+      arma::Col<size_t>(binaryLsh.SecondHashTable()));
 }
 
 // Make sure serialization works for the decision stump.
@@ -90,4 +90,51 @@ BOOST_AUTO_TEST_CASE(TwiceStartTimerTest)
   BOOST_REQUIRE_THROW(Timer::Start("test_timer"), std::runtime_error);
 }
 
+/**
+ * Make sure that counters are only recorded once they are enabled, and that
+ * values added to a counter accumulate.
+ */
+BOOST_AUTO_TEST_CASE(CounterAddTest)
+{
+  Counter::Reset();
+  Counter::Add("test_counter", 1.0);
+  BOOST_REQUIRE(Counter::Get("test_counter").empty());
+
+  Counter::Enable();
+  Counter::Add("test_counter", 1.0);
+  Counter::Add("test_counter", 2.0, 2);
+  Counter::Add("test_counter", std::vector<double>(4, 1.0));
+  const std::vector<double> values = Counter::Get("test_counter");
+  Counter::Enable(false);
+  Counter::Reset();
+
+  BOOST_REQUIRE_EQUAL(values.size(), 4);
+  BOOST_REQUIRE_CLOSE(values[0], 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(values[1], 1.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(values[2], 3.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(values[3], 1.0, 1e-5);
+}
+
+/**
+ * Make sure that counters and timers are written as JSON.
+ */
+BOOST_AUTO_TEST_CASE(CounterJSONTest)
+{
+  Counters counters;
+  counters.Enabled() = true;
+  counters.GetAllCounters()["scalar"].push_back(3.0);
+  counters.GetAllCounters()["vector"] = std::vector<double>(2, 1.5);
+
+  std::map<std::string, std::chrono::microseconds> timers;
+  timers["timer"] = std::chrono::microseconds(2500000);
+
+  std::ostringstream stream;
+  counters.WriteJSON(stream, timers);
+
+  const std::string json = stream.str();
+  BOOST_REQUIRE_NE(json.find("\"timer\": 2.5"), std::string::npos);
+  BOOST_REQUIRE_NE(json.find("\"scalar\": 3"), std::string::npos);
+  BOOST_REQUIRE_NE(json.find("\"vector\": [1.5, 1.5]"), std::string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
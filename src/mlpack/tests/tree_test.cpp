@@ -15,6 +15,9 @@
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
 
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <queue>
 #include <stack>
 
@@ -2253,4 +2256,293 @@ BOOST_AUTO_TEST_CASE(CoverTreeDescendantTest)
   CheckDescendants(&tree);
 }
 
+//! Make sure that two binary space trees have identical structure and bounds.
+template<typename TreeType>
+void CheckFlatTreeNodes(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Begin(), b.Begin());
+  BOOST_REQUIRE_EQUAL(a.Count(), b.Count());
+  BOOST_REQUIRE_EQUAL(a.NumChildren(), b.NumChildren());
+  BOOST_REQUIRE_CLOSE(a.ParentDistance(), b.ParentDistance(), 1e-5);
+  BOOST_REQUIRE_CLOSE(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance(), 1e-5);
+  BOOST_REQUIRE_CLOSE(a.MinimumBoundDistance(), b.MinimumBoundDistance(),
+      1e-5);
+
+  // Every node must point at the same dataset as the root.
+  if (b.Parent())
+    BOOST_REQUIRE_EQUAL(&b.Dataset(), &b.Parent()->Dataset());
+
+  for (size_t d = 0; d < a.Bound().Dim(); ++d)
+  {
+    BOOST_REQUIRE_CLOSE(a.Bound()[d].Lo(), b.Bound()[d].Lo(), 1e-5);
+    BOOST_REQUIRE_CLOSE(a.Bound()[d].Hi(), b.Bound()[d].Hi(), 1e-5);
+  }
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(b.Child(i).Parent(), &b);
+    CheckFlatTreeNodes(a.Child(i), b.Child(i));
+  }
+}
+
+/**
+ * Save a kd-tree to a flat tree file, map it back, and make sure that the tree
+ * and the dataset are unchanged.
+ */
+BOOST_AUTO_TEST_CASE(FlatTreeFileKDTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 1000);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 10);
+
+  FlatTreeFile<TreeType>::Save("flat_tree.bin", tree, oldFromNew);
+
+  {
+    FlatTreeFile<TreeType> file("flat_tree.bin");
+
+    BOOST_REQUIRE_EQUAL(file.OldFromNew().size(), oldFromNew.size());
+    for (size_t i = 0; i < oldFromNew.size(); ++i)
+      BOOST_REQUIRE_EQUAL(file.OldFromNew()[i], oldFromNew[i]);
+
+    CheckMatrices(tree.Dataset(), file.Tree().Dataset());
+    CheckFlatTreeNodes(tree, file.Tree());
+  }
+
+  remove("flat_tree.bin");
+}
+
+/**
+ * Make sure that loading a file that does not hold the right type of tree
+ * throws an exception.
+ */
+BOOST_AUTO_TEST_CASE(FlatTreeFileWrongTypeTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 100);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  typedef BallTree<EuclideanDistance, EmptyStatistic, arma::mat> BallTreeType;
+  TreeType tree(dataset);
+
+  FlatTreeFile<TreeType>::Save("flat_tree.bin", tree);
+
+  BOOST_REQUIRE_THROW(FlatTreeFile<BallTreeType> file("flat_tree.bin"),
+      std::runtime_error);
+
+  remove("flat_tree.bin");
+}
+
+/**
+ * Make sure that loading a flat tree file whose header or node records are
+ * corrupt throws an exception instead of reading out of bounds.
+ */
+BOOST_AUTO_TEST_CASE(FlatTreeFileCorruptTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 100);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew, 10);
+  FlatTreeFile<TreeType>::Save("flat_tree.bin", tree, oldFromNew);
+
+  std::ifstream ifs("flat_tree.bin", std::ios::binary);
+  const std::vector<char> original((std::istreambuf_iterator<char>(ifs)),
+      std::istreambuf_iterator<char>());
+  ifs.close();
+
+  // Overwrite the 64-bit value at the given byte offset, and try to load the
+  // file.  The header is the magic bytes followed by 64-bit fields, and the
+  // node records start at byte 128.
+  auto checkCorrupt = [&](const size_t offset, const uint64_t value)
+  {
+    std::vector<char> contents(original);
+    std::memcpy(contents.data() + offset, &value, sizeof(uint64_t));
+    std::ofstream ofs("flat_tree.bin", std::ios::binary | std::ios::trunc);
+    ofs.write(contents.data(), contents.size());
+    ofs.close();
+
+    BOOST_REQUIRE_THROW(FlatTreeFile<TreeType> file("flat_tree.bin"),
+        std::runtime_error);
+  };
+
+  checkCorrupt(40, 1000000); // Too many nodes.
+  checkCorrupt(80, uint64_t(1) << 62); // Dataset past the end of the file.
+  checkCorrupt(88, original.size() - 8); // Mapping past the end of the file.
+  checkCorrupt(128 + 8, 101); // Root holds more points than the dataset.
+  checkCorrupt(128 + 24, 1000000); // Root's left child doesn't exist.
+  checkCorrupt(128 + 32, 0); // Root's right child is missing.
+
+  remove("flat_tree.bin");
+}
+
+/**
+ * Make sure that linearizing a binary space tree keeps the structure of the
+ * tree, and stores sibling nodes next to each other.
+ */
+BOOST_AUTO_TEST_CASE(BinarySpaceTreeLinearizeTest)
+{
+  arma::mat dataset;
+  dataset.randu(4, 1000);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  TreeType tree(dataset, 5);
+  TreeType linearTree(tree);
+
+  BOOST_REQUIRE(!linearTree.IsLinearized());
+  linearTree.Linearize();
+  BOOST_REQUIRE(linearTree.IsLinearized());
+
+  CheckFlatTreeNodes(tree, linearTree);
+
+  // Every pair of siblings must be adjacent.
+  std::queue<TreeType*> queue;
+  queue.push(&linearTree);
+  while (!queue.empty())
+  {
+    TreeType* node = queue.front();
+    queue.pop();
+
+    if (node->NumChildren() == 2)
+      BOOST_REQUIRE_EQUAL(node->Right(), node->Left() + 1);
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      queue.push(&node->Child(i));
+  }
+
+  // A linearized tree can still be moved and copied.
+  TreeType movedTree(std::move(linearTree));
+  BOOST_REQUIRE(movedTree.IsLinearized());
+  BOOST_REQUIRE(!linearTree.IsLinearized());
+  CheckFlatTreeNodes(tree, movedTree);
+
+  TreeType copiedTree(movedTree);
+  BOOST_REQUIRE(!copiedTree.IsLinearized());
+  CheckFlatTreeNodes(tree, copiedTree);
+
+  // Linearizing a child is not allowed.
+  BOOST_REQUIRE_THROW(movedTree.Left()->Linearize(), std::invalid_argument);
+}
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that building binary space trees with several threads gives
+ * exactly the same trees as building them with one thread.
+ */
+BOOST_AUTO_TEST_CASE(ParallelBinarySpaceTreeBuildTest)
+{
+  // The dataset must be large enough that subtrees are built in parallel.
+  arma::mat dataset;
+  dataset.randu(3, 50000);
+
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  typedef BallTree<EuclideanDistance, EmptyStatistic, arma::mat> BallTreeType;
+  std::vector<size_t> parallelOldFromNew, parallelBallOldFromNew;
+  TreeType parallelTree(dataset, parallelOldFromNew, 10);
+  BallTreeType parallelBallTree(dataset, parallelBallOldFromNew, 10);
+
+  // Now build the same trees with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  std::vector<size_t> serialOldFromNew, serialBallOldFromNew;
+  TreeType serialTree(dataset, serialOldFromNew, 10);
+  BallTreeType serialBallTree(dataset, serialBallOldFromNew, 10);
+
+  omp_set_num_threads(prevNumThreads);
+
+  BOOST_REQUIRE_EQUAL(parallelOldFromNew.size(), serialOldFromNew.size());
+  for (size_t i = 0; i < serialOldFromNew.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelOldFromNew[i], serialOldFromNew[i]);
+    BOOST_REQUIRE_EQUAL(parallelBallOldFromNew[i], serialBallOldFromNew[i]);
+  }
+
+  CheckMatrices(parallelTree.Dataset(), serialTree.Dataset());
+  CheckMatrices(parallelBallTree.Dataset(), serialBallTree.Dataset());
+  CheckFlatTreeNodes(serialTree, parallelTree);
+
+  std::stack<std::pair<BallTreeType*, BallTreeType*>> nodes;
+  nodes.push(std::make_pair(&serialBallTree, &parallelBallTree));
+  while (!nodes.empty())
+  {
+    BallTreeType* serialNode = nodes.top().first;
+    BallTreeType* parallelNode = nodes.top().second;
+    nodes.pop();
+
+    BOOST_REQUIRE_EQUAL(serialNode->Begin(), parallelNode->Begin());
+    BOOST_REQUIRE_EQUAL(serialNode->Count(), parallelNode->Count());
+    BOOST_REQUIRE_EQUAL(serialNode->NumChildren(), parallelNode->NumChildren());
+    BOOST_REQUIRE_EQUAL(serialNode->Bound().Radius(),
+        parallelNode->Bound().Radius());
+    for (size_t i = 0; i < serialNode->NumChildren(); ++i)
+      nodes.push(std::make_pair(&serialNode->Child(i),
+          &parallelNode->Child(i)));
+  }
+}
+#endif
+
+// This test is only compiled if the user has specified OpenMP to be used.
+#ifdef HAS_OPENMP
+/**
+ * Make sure that building a cover tree with several threads gives exactly the
+ * same tree as building it with one thread.  The points are in well-separated
+ * clusters, so that there are large subtrees that are built in parallel.
+ */
+BOOST_AUTO_TEST_CASE(ParallelCoverTreeBuildTest)
+{
+  arma::mat dataset(5, 20000);
+  for (size_t c = 0; c < 10; ++c)
+  {
+    const arma::vec center = 10000 * arma::randu<arma::vec>(5);
+    for (size_t i = 0; i < 2000; ++i)
+      dataset.col(2000 * c + i) = center + arma::randn<arma::vec>(5);
+  }
+
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType parallelTree(dataset);
+
+  // Now build the same tree with one thread.
+  const size_t prevNumThreads = omp_get_max_threads();
+  omp_set_num_threads(1);
+
+  TreeType serialTree(dataset);
+
+  omp_set_num_threads(prevNumThreads);
+
+  BOOST_REQUIRE_EQUAL(serialTree.DistanceComps(), parallelTree.DistanceComps());
+
+  std::stack<std::pair<TreeType*, TreeType*>> nodes;
+  nodes.push(std::make_pair(&serialTree, &parallelTree));
+  while (!nodes.empty())
+  {
+    TreeType* serialNode = nodes.top().first;
+    TreeType* parallelNode = nodes.top().second;
+    nodes.pop();
+
+    BOOST_REQUIRE_EQUAL(serialNode->Point(), parallelNode->Point());
+    BOOST_REQUIRE_EQUAL(serialNode->Scale(), parallelNode->Scale());
+    BOOST_REQUIRE_EQUAL(serialNode->NumDescendants(),
+        parallelNode->NumDescendants());
+    BOOST_REQUIRE_EQUAL(serialNode->NumChildren(), parallelNode->NumChildren());
+    BOOST_REQUIRE_EQUAL(serialNode->ParentDistance(),
+        parallelNode->ParentDistance());
+    BOOST_REQUIRE_EQUAL(serialNode->FurthestDescendantDistance(),
+        parallelNode->FurthestDescendantDistance());
+    for (size_t i = 0; i < serialNode->NumChildren(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(&parallelNode->Child(i).Parent()->Child(i),
+          &parallelNode->Child(i));
+      nodes.push(std::make_pair(&serialNode->Child(i),
+          &parallelNode->Child(i)));
+    }
+  }
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();